@@ -5,6 +5,7 @@
 #include "beatrice/Metrics.hpp"
 #include <iostream>
 #include <memory>
+#include <span>
 #include <chrono>
 #include <random>
 #include <iomanip>
@@ -102,6 +103,9 @@ int main() {
         
         // Performance test
         BEATRICE_INFO("Starting performance test...");
+        
+        // Keep per-packet plugin logging out of the measurement
+        beatrice::Logger::get().setLevel(beatrice::LogLevel::WARN);
         auto startTime = std::chrono::high_resolution_clock::now();
         
         for (size_t batch = 0; batch < numBatches; ++batch) {
@@ -125,6 +129,18 @@ int main() {
         auto endTime = std::chrono::high_resolution_clock::now();
         auto totalDuration = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
         
+        // Same batches through the batch API: one onBatch() call per plugin and batch
+        std::vector<beatrice::PluginVerdict> verdicts(testPackets.size());
+        auto batchApiStartTime = std::chrono::high_resolution_clock::now();
+        
+        for (size_t batch = 0; batch < numBatches; ++batch) {
+            pluginMgr->processPackets(std::span<beatrice::Packet>(testPackets), verdicts);
+        }
+        
+        auto batchApiEndTime = std::chrono::high_resolution_clock::now();
+        auto batchApiDuration = std::chrono::duration_cast<std::chrono::microseconds>(batchApiEndTime - batchApiStartTime);
+        beatrice::Logger::get().setLevel(beatrice::LogLevel::INFO);
+        
         // Calculate results
         double totalSeconds = totalDuration.count() / 1000000.0;
         double packetsPerSecond = numPackets / totalSeconds;
@@ -147,6 +163,17 @@ int main() {
         std::cout << "Number of batches: " << numBatches << "\n";
         std::cout << std::string(60, '=') << "\n";
         
+        // Per-packet vs batch API
+        double batchApiSeconds = batchApiDuration.count() / 1000000.0;
+        double batchApiPacketsPerSecond = numPackets / batchApiSeconds;
+        std::cout << "PER-PACKET VS BATCH API\n";
+        std::cout << std::string(60, '=') << "\n";
+        std::cout << "processPacket():  " << std::fixed << std::setprecision(2) << packetsPerSecond << " packets/sec\n";
+        std::cout << "processPackets(): " << std::fixed << std::setprecision(2) << batchApiPacketsPerSecond << " packets/sec\n";
+        std::cout << "Speedup: " << std::fixed << std::setprecision(2)
+                  << (batchApiPacketsPerSecond / packetsPerSecond) << "x\n";
+        std::cout << std::string(60, '=') << "\n";
+        
         // Print metrics
         BEATRICE_INFO("Performance test completed");
         BEATRICE_INFO("Total packets: {}", totalPackets->getValue());
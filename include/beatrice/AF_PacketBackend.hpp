@@ -2,14 +2,16 @@
 #define BEATRICE_AF_PACKETBACKEND_HPP
 
 #include "beatrice/ICaptureBackend.hpp"
+#include "beatrice/BpfProgram.hpp"
 #include <memory>
 #include <thread>
-#include <queue>
 #include <mutex>
-#include <condition_variable>
 #include <functional>
 #include <vector>
 #include <string>
+#include <atomic>
+#include <optional>
+#include <sys/types.h>
 
 namespace beatrice {
 
@@ -26,6 +28,14 @@ public:
     std::vector<Packet> getPackets(size_t maxPackets = 64, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
     void setPacketCallback(std::function<void(Packet)> callback) override;
     void removePacketCallback() override;
+
+    /**
+     * @brief Attach the filter chain to every socket with SO_ATTACH_FILTER
+     *
+     * Sockets opened later get the same program before they are bound.
+     * A chain with nothing to offload detaches the current filter.
+     */
+    Result<void> setKernelFilter(const PacketFilter& filter) override;
     Statistics getStatistics() const override;
     void resetStatistics() override;
     std::string getName() const override;
@@ -57,16 +67,58 @@ public:
     size_t getBufferSize() const;
     bool isBlockingMode() const;
 
+    /**
+     * @brief Get number of receive queues
+     *
+     * Each socket of a PACKET_FANOUT group has its own receive thread and
+     * queue; without fanout there is a single queue.
+     *
+     * @return Number of receive queues
+     */
+    size_t getQueueCount() const override;
+
+    /**
+     * @brief Get packets received by one socket of the fanout group
+     * @param queueId Queue index, less than getQueueCount()
+     * @param maxPackets Maximum number of packets to return
+     * @param timeout Time to wait for the first packet
+     * @return Packets from that queue only
+     */
+    std::vector<Packet> getPackets(size_t queueId, size_t maxPackets, std::chrono::milliseconds timeout) override;
+
+    /**
+     * @brief PACKET_FANOUT socket option value for a group
+     * @return Group id in the low 16 bits, fanout type and flags above
+     */
+    static int fanoutArgument(uint16_t fanoutGroup, FanoutMode mode);
+
+    /**
+     * @brief Fanout group the sockets join
+     *
+     * 0 is a valid kernel group id, so a pid that is a multiple of 65536
+     * still gets a fanout group.
+     *
+     * @param socketCount Sockets opened, fanout needs more than one
+     * @param configured Config::fanoutGroupId, 0 derives one from processId
+     * @param processId Process id the derived group comes from
+     * @return Group id, or nullopt when no fanout group is joined
+     */
+    static std::optional<uint16_t> fanoutGroup(size_t socketCount, uint16_t configured, pid_t processId);
+
 private:
-    bool running_;
+    struct RxSocket;
+
+    std::atomic<bool> running_;
     bool initialized_;
     Config config_;
     
     // AF_PACKET specific members
-    int socketFd_;
+    std::vector<std::unique_ptr<RxSocket>> sockets_;
+    std::atomic<size_t> nextQueue_;
     bool promiscuousMode_;
     size_t bufferSize_;
     bool blockingMode_;
+    BpfProgram kernelFilter_;
 
     // DMA and zero-copy members
     bool zeroCopyEnabled_;
@@ -77,27 +129,26 @@ private:
     size_t dmaBufferCount_;
     int dmaFd_;
     
-    std::thread processingThread_;
-    
-    std::queue<Packet> packetQueue_;
-    std::mutex packetQueueMutex_;
-    std::condition_variable packetCondition_;
-    
     std::function<void(Packet)> packetCallback_;
     std::mutex callbackMutex_;
     
-    mutable std::mutex statsMutex_;
-    Statistics stats_;
-    
     mutable std::mutex errorMutex_;
     std::string lastError_;
     
     bool validateInterface(const std::string& interface);
-    bool createSocket();
-    bool bindToInterface();
-    bool setSocketOptions();
-    void packetProcessingLoop();
-    void processPackets();
+    bool openSocket(RxSocket& sock, std::optional<uint16_t> fanoutGroup);
+    bool createSocket(RxSocket& sock);
+    bool bindToInterface(RxSocket& sock);
+    bool joinFanoutGroup(RxSocket& sock, uint16_t fanoutGroup);
+    bool setSocketOptions(RxSocket& sock);
+    bool setupRxRing(RxSocket& sock);
+    void pinThread(size_t index);
+    void packetProcessingLoop(RxSocket& sock);
+    void ringProcessingLoop(RxSocket& sock);
+    void deliverPackets(RxSocket& sock, std::vector<Packet>& packets, uint64_t bytes);
+    void updateKernelStatistics(RxSocket& sock) const;
+    std::vector<Packet> drainQueue(RxSocket& sock, size_t maxPackets, std::chrono::milliseconds timeout);
+    void setLastError(const std::string& error);
     void shutdown();
     
     AF_PacketBackend(const AF_PacketBackend&) = delete;
@@ -3,15 +3,15 @@
 
 #include "beatrice/ICaptureBackend.hpp"
 #include "beatrice/XDPLoader.hpp"
+#include "beatrice/UmemFrameAllocator.hpp"
 #include <memory>
 #include <thread>
-#include <queue>
 #include <mutex>
-#include <condition_variable>
 #include <functional>
+#include <atomic>
+#include <vector>
 
 // Forward declarations for Linux kernel structures
-struct xdp_ring;
 struct xdp_umem_reg;
 struct xdp_mmap_offsets;
 
@@ -31,6 +31,14 @@ public:
     std::vector<Packet> getPackets(size_t maxPackets = 64, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
     void setPacketCallback(std::function<void(Packet)> callback) override;
     void removePacketCallback() override;
+
+    /**
+     * @brief Install the filter chain as XDP rule tables
+     *
+     * Rules set before an XDP program is loaded are installed when it is.
+     * Programs without rule tables keep filtering in user space.
+     */
+    Result<void> setKernelFilter(const PacketFilter& filter) override;
     Statistics getStatistics() const override;
     void resetStatistics() override;
     std::string getName() const override;
@@ -69,43 +77,61 @@ public:
     bool isXdpProgramLoaded() const;
     std::string getXdpProgramStats() const;
 
+    /**
+     * @brief Get number of receive queues
+     *
+     * One XSK socket is bound per NIC RX queue, each with its own rings,
+     * worker thread and packet queue.
+     *
+     * @return Number of receive queues
+     */
+    size_t getQueueCount() const override;
+
+    /**
+     * @brief Get packets received on one NIC RX queue
+     * @param queueId Queue index, less than getQueueCount()
+     * @param maxPackets Maximum number of packets to return
+     * @param timeout Time to wait for the first packet
+     * @return Packets from that queue only
+     */
+    std::vector<Packet> getPackets(size_t queueId, size_t maxPackets, std::chrono::milliseconds timeout) override;
+
+    /**
+     * @brief Get UMEM frame ownership counters summed over all queues
+     * @return Frame statistics, all zero in stub mode
+     */
+    UmemFrameAllocator::Statistics getFrameStatistics() const;
+
+    /**
+     * @brief sxdp_flags tried in turn when binding the socket that owns a UMEM
+     * @param zeroCopy Try XDP_ZEROCOPY before XDP_COPY
+     * @param needWakeup Try XDP_USE_NEED_WAKEUP before binding without it
+     */
+    static std::vector<uint16_t> bindFlagOrder(bool zeroCopy, bool needWakeup);
+
 private:
+    struct UmemRegion;
+    struct XskSocket;
+
     // XDP-specific members
-    int socket_;
-    void* umem_;
-    size_t umemSize_;
-    struct xdp_ring* fillQueue_;
-    struct xdp_ring* completionQueue_;
-    struct xdp_ring* rxQueue_;
-    struct xdp_ring* txQueue_;
-    uint32_t idx_;
+    std::vector<std::unique_ptr<XskSocket>> sockets_;  ///< One per bound RX queue
+    std::atomic<size_t> nextQueue_;
     
     // XDP program loader
     std::unique_ptr<XDPLoader> xdpLoader_;
     std::string xdpProgramName_;
     bool xdpProgramLoaded_;
+    XDPLoader::FilterRules filterRules_;  ///< Offloaded filters, reinstalled on every load
     
     // State management
-    bool running_;
+    std::atomic<bool> running_;
     bool initialized_;
     Config config_;
     
-    // Threading
-    std::thread processingThread_;
-    
-    // Packet queue
-    std::queue<Packet> packetQueue_;
-    std::mutex packetQueueMutex_;
-    std::condition_variable packetCondition_;
-    
     // Callback management
     std::function<void(Packet)> packetCallback_;
     std::mutex callbackMutex_;
     
-    // Backend-specific metrics
-    mutable std::mutex statsMutex_;
-    Statistics stats_;
-    
     // Error handling
     mutable std::mutex errorMutex_;
     std::string lastError_;
@@ -125,20 +151,31 @@ private:
     
     // Get interface index using ioctl
     int getInterfaceIndex(const std::string& interfaceName);
-    bool initializeUmem();
-    bool createSocket();
-    bool bindToInterface();
-    bool initializeRingBuffers();
+    size_t getRxQueueCount(const std::string& interfaceName);
+    bool checkInterfaceSupport();
+    std::shared_ptr<UmemRegion> createUmem(size_t frameCount);
+    bool registerUmem(XskSocket& sock);
+    bool createSocket(XskSocket& sock);
+    bool bindToInterface(XskSocket& sock, int ifIndex, int sharedUmemFd);
+    bool initializeRingBuffers(XskSocket& sock);
+    bool setBusyPollOptions(XskSocket& sock);
     
     // Packet processing
-    void packetProcessingLoop();
-    void processRxQueue();
-    void processCompletionQueue();
-    void refillQueue();
+    void packetProcessingLoop(XskSocket& sock);
+    size_t processRxQueue(XskSocket& sock);
+    void processCompletionQueue(XskSocket& sock);
+    void refillQueue(XskSocket& sock);
+    void waitForPackets(XskSocket& sock);
+    void kick(XskSocket& sock);
+    void enqueuePacket(XskSocket& sock, Packet packet);
+    std::vector<Packet> drainQueue(XskSocket& sock, size_t maxPackets, std::chrono::milliseconds timeout);
     Packet parsePacketMetadata(const uint8_t* data, size_t length);
+    Packet createZeroCopyPacket(XskSocket& sock, uint64_t addr, size_t length);
+    void pinThread(size_t index);
+    void closeSocket(XskSocket& sock);
     
     // Test packet generation (stub mode)
-    void generateTestPackets();
+    void generateTestPackets(XskSocket& sock);
     Packet createTestPacket();
     
     // Cleanup
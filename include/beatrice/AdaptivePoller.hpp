@@ -0,0 +1,131 @@
+#ifndef BEATRICE_ADAPTIVE_POLLER_HPP
+#define BEATRICE_ADAPTIVE_POLLER_HPP
+
+#include "beatrice/Packet.hpp"
+#include "beatrice/PacketRing.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beatrice {
+
+class Counter;
+
+/**
+ * @brief Spin, then yield, then park: how a worker waits for its next batch
+ *
+ * While packets keep coming the worker polls again right away. Once the
+ * backend runs dry it keeps polling without blocking for spinBudget (CPU
+ * pause hint between polls), then for yieldBudget giving the core away
+ * between polls, and only then parks in a blocking getPackets() call,
+ * which sleeps on the backend queue's futex until the capture thread
+ * publishes packets. Bursty traffic is therefore picked up without a
+ * syscall on either side, and an idle worker costs nothing.
+ *
+ * With a name, time spent spinning and parked is exported as the
+ * `<name>_spin_us_total` and `<name>_park_us_total` counters, and the
+ * number of parks as `<name>_parks_total`.
+ */
+class AdaptivePoller {
+public:
+    /**
+     * @brief Wait budgets
+     */
+    struct Config {
+        std::chrono::microseconds spinBudget{50};      ///< Busy-poll with a pause hint this long
+        std::chrono::microseconds yieldBudget{200};    ///< Then poll and yield this long
+        std::chrono::milliseconds parkTimeout{100};    ///< Longest single park, bounds shutdown latency
+    };
+
+    /**
+     * @brief Poller statistics
+     */
+    struct Statistics {
+        std::chrono::nanoseconds spinTime{0};   ///< Time spent polling an empty backend
+        std::chrono::nanoseconds parkTime{0};   ///< Time spent blocked in the backend
+        uint64_t parks = 0;                     ///< Number of blocking polls
+        uint64_t batches = 0;                   ///< Non-empty batches returned
+    };
+
+    /**
+     * @brief Create a poller
+     * @param config Wait budgets
+     * @param name Metric name prefix, metrics are skipped if empty
+     */
+    explicit AdaptivePoller(const Config& config, const std::string& name = "");
+
+    /**
+     * @brief Get the next batch
+     * @param poll Callable taking a timeout and returning a std::vector<Packet>,
+     *        typically a getPackets() call on the backend
+     * @return Packets, empty if a park timed out so the caller can check for shutdown
+     */
+    template <typename Poll>
+    std::vector<Packet> next(Poll&& poll) {
+        auto packets = poll(std::chrono::milliseconds(0));
+        if (!packets.empty()) {
+            ++stats_.batches;
+            return packets;
+        }
+
+        // Backend ran dry: spin, then yield, polling without blocking
+        const auto idleStart = std::chrono::steady_clock::now();
+        const auto spinEnd = idleStart + config_.spinBudget;
+        const auto yieldEnd = spinEnd + config_.yieldBudget;
+        auto now = idleStart;
+        while (now < yieldEnd) {
+            if (now < spinEnd) {
+                for (int i = 0; i < kPausesPerPoll; ++i) {
+                    ringPause();
+                }
+            } else {
+                std::this_thread::yield();
+            }
+            packets = poll(std::chrono::milliseconds(0));
+            now = std::chrono::steady_clock::now();
+            if (!packets.empty()) {
+                recordSpin(now - idleStart);
+                ++stats_.batches;
+                return packets;
+            }
+        }
+        recordSpin(now - idleStart);
+
+        // Still nothing: sleep in the backend until the capture thread wakes us
+        packets = poll(config_.parkTimeout);
+        recordPark(std::chrono::steady_clock::now() - now);
+        if (!packets.empty()) {
+            ++stats_.batches;
+        }
+        return packets;
+    }
+
+    /**
+     * @brief Get poller statistics (owning thread only)
+     * @return Current statistics
+     */
+    const Statistics& getStatistics() const noexcept { return stats_; }
+
+    const Config& getConfig() const noexcept { return config_; }
+
+private:
+    // Each pause is tens of cycles; polling a queue between them is cheap
+    static constexpr int kPausesPerPoll = 16;
+
+    void recordSpin(std::chrono::steady_clock::duration elapsed);
+    void recordPark(std::chrono::steady_clock::duration elapsed);
+
+    Config config_;
+    Statistics stats_;
+
+    std::shared_ptr<Counter> spinCounter_;
+    std::shared_ptr<Counter> parkCounter_;
+    std::shared_ptr<Counter> parksCounter_;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_ADAPTIVE_POLLER_HPP
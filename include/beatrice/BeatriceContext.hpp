@@ -6,7 +6,9 @@
 #include "beatrice/Logger.hpp"
 #include "beatrice/Config.hpp"
 #include "beatrice/Metrics.hpp"
+#include "beatrice/AdaptivePoller.hpp"
 #include <memory>
+#include <span>
 #include <string>
 #include <thread>
 #include <atomic>
@@ -66,11 +68,14 @@ private:
     void setupSignalHandlers();
     
     // Execution modes
-    void runSingleThreaded(size_t batchSize);
-    void runMultiThreaded(size_t numThreads, size_t batchSize, bool pinThreads, const nlohmann::json& cpuAffinity);
+    void runSingleThreaded(size_t batchSize, const AdaptivePoller::Config& pollConfig);
+    void runMultiThreaded(size_t numThreads, size_t batchSize, bool pinThreads, const nlohmann::json& cpuAffinity,
+                          const AdaptivePoller::Config& pollConfig);
+    void runToCompletion();
     
     // Packet processing
     void processPacket(Packet& packet);
+    void processBatch(std::span<Packet> packets);
     void loadPluginsFromDirectory(const std::string& directory);
     
     // Disable copying
@@ -0,0 +1,138 @@
+#ifndef BEATRICE_BPF_PROGRAM_HPP
+#define BEATRICE_BPF_PROGRAM_HPP
+
+#include "beatrice/Error.hpp"
+#include "beatrice/Packet.hpp"
+#include <linux/filter.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace beatrice {
+
+/**
+ * @brief Classic BPF program compiled from a tcpdump-style filter expression
+ *
+ * Supported primitives, for Ethernet frames:
+ *
+ *     ip, ip6, arp, tcp, udp, sctp, icmp, icmp6
+ *     ip proto P, ip6 proto P, ether proto P
+ *     [src|dst] host ADDR              IPv4 or IPv6 address
+ *     [src|dst] net ADDR/LEN           also "net ADDR mask MASK" for IPv4
+ *     [tcp|udp|sctp] [src|dst] port N
+ *     [tcp|udp|sctp] [src|dst] portrange LOW-HIGH
+ *     ether [src|dst] host MAC
+ *     vlan [ID]                        later primitives look past the tag
+ *     len OP N, greater N, less N
+ *     PROTO[OFF] or PROTO[OFF:SIZE], optionally "& MASK", then OP VALUE
+ *
+ * PROTO is one of ether, ip, ip6, tcp, udp, sctp, icmp and OP one of
+ * =, ==, !=, <, <=, >, >=. Primitives combine with and/&&, or/||, not/! and
+ * parentheses; as in pcap-filter, "and" and "or" have equal precedence and
+ * group left to right. Like tcpdump, port and transport header accesses skip IPv4
+ * fragments after the first, and IPv6 extension headers are not walked.
+ *
+ * The bytecode uses the kernel's struct sock_filter layout, so the same
+ * program runs in the userspace interpreter, in the x86-64 JIT and, via
+ * attachToSocket(), as an AF_PACKET socket filter. Copies share JIT code.
+ */
+class BpfProgram {
+public:
+    /// Largest program accepted, the kernel's BPF_MAXINSNS
+    static constexpr size_t kMaxInstructions = 4096;
+
+    /// Accepted length returned for matching packets by compiled programs
+    static constexpr uint32_t kDefaultSnapLength = 262144;
+
+    /**
+     * @brief An empty program, rejects every packet
+     */
+    BpfProgram() = default;
+
+    /**
+     * @brief Compile a filter expression
+     * @param expression tcpdump-style expression, empty matches everything
+     * @param snapLength Value returned for matching packets
+     * @return The program, or INVALID_ARGUMENT describing the error
+     */
+    static Result<BpfProgram> compile(const std::string& expression,
+                                      uint32_t snapLength = kDefaultSnapLength);
+
+    /**
+     * @brief Wrap existing bytecode after checking it like the kernel does
+     * @param instructions Program, every path must end in a return
+     * @return The program, or INVALID_ARGUMENT for bytecode the kernel would refuse
+     */
+    static Result<BpfProgram> fromInstructions(std::vector<sock_filter> instructions);
+
+    /**
+     * @brief Run the program, through the JIT when it is enabled
+     * @param data Frame starting at the Ethernet header
+     * @param length Frame length
+     * @return Bytes to accept, 0 to reject
+     */
+    uint32_t run(const uint8_t* data, size_t length) const noexcept {
+        return jitEntry_ ? jitEntry_(data, length) : interpret(data, length);
+    }
+
+    /**
+     * @brief Run the program in the interpreter
+     */
+    uint32_t interpret(const uint8_t* data, size_t length) const noexcept;
+
+    /**
+     * @brief Check whether a packet passes the filter
+     */
+    bool matches(const Packet& packet) const noexcept {
+        return run(packet.data(), packet.length()) != 0;
+    }
+
+    /**
+     * @brief Translate the program to x86-64 machine code
+     *
+     * Programs using scratch memory stay on the interpreter.
+     *
+     * @return true if run() now uses native code
+     */
+    bool enableJit();
+
+    /**
+     * @brief Check whether run() uses native code
+     */
+    bool isJitted() const noexcept { return jitEntry_ != nullptr; }
+
+    /**
+     * @brief Attach the program to a socket with SO_ATTACH_FILTER
+     * @param fd Socket, typically AF_PACKET
+     * @return Success, or NETWORK_ERROR with the reason
+     */
+    Result<void> attachToSocket(int fd) const;
+
+    /**
+     * @brief Remove any socket filter with SO_DETACH_FILTER
+     */
+    static Result<void> detachFromSocket(int fd);
+
+    const std::vector<sock_filter>& instructions() const noexcept { return instructions_; }
+    const std::string& expression() const noexcept { return expression_; }
+    bool empty() const noexcept { return instructions_.empty(); }
+
+    /**
+     * @brief Human-readable listing, one instruction per line like tcpdump -d
+     */
+    std::string dump() const;
+
+private:
+    using JitFunction = uint32_t (*)(const uint8_t*, size_t);
+
+    std::vector<sock_filter> instructions_;
+    std::string expression_;
+    std::shared_ptr<void> jitCode_;
+    JitFunction jitEntry_ = nullptr;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_BPF_PROGRAM_HPP
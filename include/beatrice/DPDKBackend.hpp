@@ -2,15 +2,19 @@
 #define BEATRICE_DPDKBACKEND_HPP
 
 #include "beatrice/ICaptureBackend.hpp"
+#include "beatrice/MbufPacket.hpp"
 #include <memory>
 #include <thread>
-#include <queue>
 #include <mutex>
-#include <condition_variable>
 #include <functional>
+#include <atomic>
 #include <vector>
 #include <string>
 
+struct rte_mempool;
+struct rte_eth_conf;
+struct rte_eth_dev_info;
+
 namespace beatrice {
 
 class DPDKBackend : public ICaptureBackend {
@@ -53,23 +57,64 @@ public:
     Result<void> setEALConfig(const std::string& config);
     bool isDPDKInitialized() const;
 
+    /**
+     * @brief Get number of RSS receive queues
+     * @return Number of RX queues, each served by its own worker
+     */
+    size_t getQueueCount() const override;
+
+    /**
+     * @brief Get packets received on one RX queue
+     * @param queueId Queue index, less than getQueueCount()
+     * @param maxPackets Maximum number of packets to return
+     * @param timeout Time to wait for the first packet
+     * @return Packets from that queue only
+     */
+    std::vector<Packet> getPackets(size_t queueId, size_t maxPackets, std::chrono::milliseconds timeout) override;
+
+    /**
+     * @brief Number of RX queues configured on a port
+     * @param requested Config::rxQueues
+     * @param deviceMax Queues the port supports
+     * @return Requested count capped by the port, at least one
+     */
+    static size_t rxQueueCount(size_t requested, size_t deviceMax);
+
+    /**
+     * @brief Toeplitz key that hashes both directions of a flow alike
+     * @param keySize Key length the driver expects
+     * @return Repeated 0x6d5a pattern of that length
+     */
+    static std::vector<uint8_t> symmetricRssKey(size_t keySize);
+
+    /**
+     * @brief EAL worker lcore for each RX queue
+     * @param lcores Available worker lcores in launch order
+     * @param queueCount Number of RX queues
+     * @return One lcore per queue, empty when workers fall back to pinned threads
+     */
+    static std::vector<unsigned> workerLcores(const std::vector<unsigned>& lcores, size_t queueCount);
+
 private:
-    bool running_;
+    struct RxQueue;
+
+    std::atomic<bool> running_;
     bool initialized_;
     bool dpdkInitialized_;
     Config config_;
     
-    std::thread processingThread_;
+    std::vector<std::unique_ptr<RxQueue>> queues_;
+    std::atomic<size_t> nextQueue_;
+    struct rte_mempool* rxMempool_;
+    std::vector<uint8_t> rssKey_;
     
-    std::queue<Packet> packetQueue_;
-    std::mutex packetQueueMutex_;
-    std::condition_variable packetCondition_;
-    
-    std::function<void(Packet)> packetCallback_;
+    // Copied by each worker once per burst so lcores never hold the lock while
+    // running the callback
+    std::shared_ptr<const std::function<void(Packet)>> packetCallback_;
     std::mutex callbackMutex_;
     
-    mutable std::mutex statsMutex_;
-    Statistics stats_;
+    MbufRefCount mbufsInFlight_;               ///< Mbufs still referenced by packets
+    
     
     mutable std::mutex errorMutex_;
     std::string lastError_;
@@ -89,11 +134,17 @@ private:
     bool validateInterface(const std::string& interface);
     bool initializeDPDK();
     bool initializePort();
+    void configureRss(struct rte_eth_conf& portConf, const struct rte_eth_dev_info& devInfo);
     bool setupQueues();
     bool startPort();
     void stopPort();
-    void packetProcessingLoop();
-    void processPackets();
+    void launchWorkers();
+    void joinWorkers();
+    static int lcoreMain(void* arg);
+    void pinThread(size_t index);
+    void packetProcessingLoop(RxQueue& queue);
+    size_t processPackets(RxQueue& queue);
+    std::vector<Packet> drainQueue(RxQueue& queue, size_t maxPackets, std::chrono::milliseconds timeout);
     void shutdown();
     
     DPDKBackend(const DPDKBackend&) = delete;
@@ -0,0 +1,65 @@
+#ifndef BEATRICE_EPOCH_DOMAIN_HPP
+#define BEATRICE_EPOCH_DOMAIN_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace beatrice {
+
+/**
+ * @brief Epoch-based grace periods for lock-free readers of a snapshot
+ *
+ * Readers hold a Guard while they use a snapshot loaded from an atomic
+ * pointer. A writer swaps in the new snapshot and calls synchronize(); once
+ * it returns, no reader can still hold the old one and it may be freed.
+ *
+ * Entering and leaving a guard is one compare-exchange and one store on a
+ * cache line the thread usually has to itself. Writers wait, readers never do
+ * unless more threads than kReaderSlots read at once.
+ */
+class EpochDomain {
+public:
+    static constexpr size_t kReaderSlots = 64;
+
+    /**
+     * @brief Marks the calling thread as reading until destroyed
+     *
+     * Construct it before loading the snapshot pointer.
+     */
+    class Guard {
+    public:
+        explicit Guard(EpochDomain& domain);
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        std::atomic<uint64_t>* slot_;
+    };
+
+    /**
+     * @brief Wait until every guard entered before this call has been left
+     *
+     * Guards entered meanwhile do not hold it up. Must not be called while
+     * the calling thread holds a guard of the same domain.
+     */
+    void synchronize();
+
+private:
+    // Epoch a reader entered with, or kQuiescent while it is outside
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};
+    };
+
+    static constexpr uint64_t kQuiescent = 0;
+
+    std::atomic<uint64_t> epoch_{1};
+    std::array<ReaderSlot, kReaderSlots> readers_;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_EPOCH_DOMAIN_HPP
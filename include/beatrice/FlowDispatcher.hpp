@@ -0,0 +1,170 @@
+#ifndef BEATRICE_FLOW_DISPATCHER_HPP
+#define BEATRICE_FLOW_DISPATCHER_HPP
+
+#include "beatrice/Packet.hpp"
+#include "beatrice/PacketQueue.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace beatrice {
+
+class Counter;
+
+/**
+ * @brief Software RSS: spreads packets from one receive queue over workers by flow
+ *
+ * For backends with a single receive queue (AF_PACKET without fanout, pcap
+ * replay, stub modes) a dispatcher thread hashes each packet's 5-tuple and
+ * hands it to the worker owning that hash over a single-producer,
+ * single-consumer queue. The hash is symmetric, so both directions of a
+ * connection reach the same worker and flow-stateful plugins see every
+ * packet of a flow, in order, without locking.
+ *
+ * Queues block the dispatcher when full; loss therefore happens in the
+ * backend queue, under its overflow policy, rather than here.
+ *
+ * The busiest flows of each window are tracked with a space-saving sketch.
+ * A flow carrying more than heavyHitterShare of one worker's even share of
+ * the traffic is flagged: logged once, counted in `<name>_heavy_hitters_total`
+ * and listed by getHeavyHitters(), as hashing alone cannot split it.
+ */
+class FlowDispatcher {
+public:
+    /**
+     * @brief Dispatcher settings
+     */
+    struct Config {
+        size_t queueDepth = 4096;               ///< Packets per worker queue
+        double heavyHitterShare = 0.5;          ///< Fraction of a worker's even share that flags a flow
+        uint64_t heavyHitterWindow = 65536;     ///< Packets per heavy hitter window
+    };
+
+    /**
+     * @brief A flow flagged in the last completed window
+     */
+    struct HeavyHitter {
+        uint64_t flowHash = 0;       ///< Symmetric flow hash
+        size_t worker = 0;           ///< Worker the flow is pinned to
+        uint64_t packets = 0;        ///< Packets in the window (upper bound)
+        double share = 0.0;          ///< Fraction of all packets in the window
+    };
+
+    /**
+     * @brief Dispatcher statistics
+     */
+    struct Statistics {
+        uint64_t packetsDispatched = 0;              ///< Packets handed to workers
+        std::vector<uint64_t> workerPackets;         ///< Packets handed to each worker
+        std::vector<size_t> workerHighWatermark;     ///< Most packets queued for each worker
+        uint64_t heavyHitters = 0;                   ///< Flows flagged so far
+    };
+
+    /**
+     * @brief Create a dispatcher
+     * @param workers Number of workers, at least 1
+     * @param config Dispatcher settings
+     * @param name Metric name prefix, metrics are skipped if empty
+     */
+    FlowDispatcher(size_t workers, const Config& config, const std::string& name = "dispatcher");
+
+    FlowDispatcher(const FlowDispatcher&) = delete;
+    FlowDispatcher& operator=(const FlowDispatcher&) = delete;
+
+    /**
+     * @brief Symmetric 5-tuple hash of a packet
+     *
+     * Ethernet with up to two VLAN tags, IPv4 and IPv6; ports are used for
+     * TCP, UDP and SCTP. IPv4 fragments hash without ports so all fragments
+     * of a datagram stay together. Non-IP frames hash on the MAC pair.
+     *
+     * @param packet Packet to hash
+     * @return Hash that is equal for both directions of a flow
+     */
+    static uint64_t flowHash(const Packet& packet);
+
+    /**
+     * @brief Hand packets to their workers (dispatcher thread only)
+     * @param packets Packets to dispatch, moved from
+     * @return Number of packets queued; fewer only if the dispatcher was closed
+     */
+    size_t dispatch(std::vector<Packet>& packets);
+
+    /**
+     * @brief Take packets queued for one worker (that worker only)
+     * @param worker Worker index
+     * @param out Vector the packets are appended to
+     * @param maxPackets Maximum number of packets
+     * @param timeout Maximum time to wait for the first packet
+     * @return Number of packets taken
+     */
+    size_t pop(size_t worker, std::vector<Packet>& out, size_t maxPackets, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Let dispatch() and pop() wait again
+     */
+    void open();
+
+    /**
+     * @brief Release the dispatcher and all workers, e.g. on shutdown
+     */
+    void close();
+
+    size_t workerCount() const noexcept { return workers_.size(); }
+
+    /**
+     * @brief Get flows flagged in the last completed window
+     * @return Heavy hitters, busiest first
+     */
+    std::vector<HeavyHitter> getHeavyHitters() const;
+
+    /**
+     * @brief Get dispatcher statistics
+     * @return Current statistics
+     */
+    Statistics getStatistics() const;
+
+private:
+    // Flows tracked per window; any flow with more than 1/32 of the window is among them
+    static constexpr size_t kTrackedFlows = 32;
+
+    struct Worker {
+        std::unique_ptr<PacketQueue> queue;
+        std::vector<Packet> pending;              ///< Batch being built, dispatcher thread only
+        std::atomic<uint64_t> packets{0};
+    };
+
+    struct FlowCount {
+        uint64_t hash = 0;
+        uint64_t count = 0;
+    };
+
+    size_t workerFor(uint64_t hash) const noexcept { return hash % workers_.size(); }
+    void trackFlow(uint64_t hash);
+    void closeWindow();
+
+    Config config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint64_t> dispatched_{0};
+
+    // Heavy hitter sketch, dispatcher thread only
+    std::array<FlowCount, kTrackedFlows> flows_{};
+    size_t trackedFlows_ = 0;
+    uint64_t windowPackets_ = 0;
+
+    std::vector<HeavyHitter> heavyHitters_;
+    std::atomic<uint64_t> heavyHitterCount_{0};
+    mutable std::mutex heavyHittersMutex_;
+
+    std::shared_ptr<Counter> heavyHittersCounter_;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_FLOW_DISPATCHER_HPP
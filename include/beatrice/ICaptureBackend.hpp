@@ -11,10 +11,50 @@
 
 namespace beatrice {
 
+class PacketFilter;
+
 class ICaptureBackend {
 public:
     virtual ~ICaptureBackend() = default;
 
+    /**
+     * @brief How a PACKET_FANOUT group spreads packets across its sockets
+     */
+    enum class FanoutMode {
+        HASH,           ///< By flow hash, keeps flows on one socket
+        CPU,            ///< By the CPU that received the packet
+        LOAD_BALANCE,   ///< Round-robin across sockets
+        ROLLOVER        ///< Fill one socket, spill to the next when it backs up
+    };
+
+    /**
+     * @brief Frame length distribution of generated traffic
+     */
+    enum class PacketSizeDistribution {
+        FIXED,          ///< Every frame is syntheticPacketSize bytes
+        IMIX,           ///< Simple IMIX, 60/590/1514 byte frames in a 7:4:1 ratio
+        PARETO          ///< Heavy-tailed, syntheticPacketSize minimum up to 1514 bytes
+    };
+
+    /**
+     * @brief Tunnel wrapped around generated traffic
+     */
+    enum class Encapsulation {
+        NONE,           ///< Plain Ethernet/IPv4
+        VXLAN,          ///< Outer IPv4/UDP 4789/VXLAN around the Ethernet frame
+        GRE             ///< Outer IPv4/GRE around the IPv4 packet
+    };
+
+    /**
+     * @brief What a full backend packet queue does with more packets
+     */
+    enum class OverflowPolicy {
+        DEFAULT,        ///< Backend's choice: live capture drops newest, replay and unthrottled generation block
+        DROP_NEWEST,    ///< Discard arriving packets, like a NIC with a full ring
+        DROP_OLDEST,    ///< Discard the longest-waiting packets to make room, favours fresh traffic
+        BLOCK           ///< Stall the producer until consumers catch up, loss moves to the NIC or kernel
+    };
+
     struct Config {
         std::string interface;           ///< Network interface name
         size_t bufferSize = 4096;        ///< Buffer size in bytes
@@ -29,6 +69,56 @@ public:
         bool enableDMAAccess = false;    ///< Enable DMA access for zero-copy
         size_t dmaBufferSize = 0;        ///< DMA buffer size (0 = auto)
         std::string dmaDevice = "";      ///< DMA device path
+
+        // Memory-mapped RX ring (AF_PACKET TPACKET_V3)
+        bool enableRxRing = false;       ///< Receive through a PACKET_RX_RING instead of recv()
+        size_t ringBlockSize = 1 << 20;  ///< Ring block size in bytes (multiple of the page size)
+        size_t ringBlockCount = 64;      ///< Number of ring blocks
+        size_t ringFrameSize = 2048;     ///< Maximum frame size in bytes, longer frames are truncated
+        int ringBlockTimeoutMs = 10;     ///< Retire partially filled blocks after this many ms
+
+        // Multi-socket fanout (AF_PACKET PACKET_FANOUT)
+        size_t fanoutSockets = 1;        ///< Sockets in the fanout group, 1 disables fanout
+        FanoutMode fanoutMode = FanoutMode::HASH; ///< Packet distribution across the group
+        uint16_t fanoutGroupId = 0;      ///< Fanout group id, 0 derives one from the process id
+
+        // Multi-queue AF_XDP
+        size_t xdpQueueCount = 1;        ///< NIC RX queues to bind an XSK socket to, 0 binds all of them
+        uint32_t xdpFirstQueue = 0;      ///< First NIC RX queue to bind
+        bool xdpSharedUmem = true;       ///< One UMEM for all queues (XDP_SHARED_UMEM) instead of one per queue
+
+        // AF_XDP receive loop
+        bool xdpNeedWakeup = true;       ///< Bind with XDP_USE_NEED_WAKEUP and sleep in poll() while idle
+        bool busyPoll = false;           ///< Spin on SO_PREFER_BUSY_POLL instead of sleeping, lowest latency
+        int busyPollTimeoutUs = 20;      ///< SO_BUSY_POLL time per busy-poll call in microseconds
+        int busyPollBudget = 64;         ///< SO_BUSY_POLL_BUDGET, packets per busy-poll call
+
+        // DPDK receive side scaling
+        size_t rxQueues = 1;             ///< RX queues spread with RSS, one worker each
+        bool symmetricRss = true;        ///< Symmetric Toeplitz key so both directions of a flow share a queue
+        bool runToCompletion = false;    ///< Run the packet callback on the RX worker instead of queueing
+
+        // Packet queue between the capture threads and getPackets()
+        size_t queueDepth = 0;           ///< Packets per queue, 0 uses numBuffers (at least 1024)
+        OverflowPolicy queueOverflowPolicy = OverflowPolicy::DEFAULT; ///< Behaviour of a full queue
+
+        // Offline capture file replay
+        std::string captureFile;         ///< pcap or pcapng file read by PcapFileBackend
+        double replaySpeed = 0.0;        ///< 0 replays as fast as possible, otherwise a multiple of the recorded pace
+        size_t replayLoops = 1;          ///< Passes over the file, 0 repeats until stopped
+
+        // Synthetic traffic generation
+        size_t syntheticFlows = 1024;    ///< Distinct 5-tuples, one prebuilt template set per flow
+        PacketSizeDistribution syntheticSizeDistribution = PacketSizeDistribution::IMIX; ///< Frame lengths
+        size_t syntheticPacketSize = 64; ///< Frame length for FIXED, minimum for PARETO
+        double syntheticParetoShape = 1.2; ///< Pareto shape, smaller values give a heavier tail
+        unsigned syntheticTcpPercent = 60; ///< Share of TCP flows
+        unsigned syntheticUdpPercent = 35; ///< Share of UDP flows, the remainder is ICMP echo
+        uint16_t syntheticVlanId = 0;    ///< 802.1Q tag on the outer frame, 0 leaves frames untagged
+        Encapsulation syntheticEncapsulation = Encapsulation::NONE; ///< Tunnel around every frame
+        uint64_t syntheticRatePps = 0;   ///< Target rate in packets per second, 0 generates unthrottled
+        uint64_t syntheticPacketLimit = 0; ///< Stop after this many packets, 0 runs until stopped
+        uint64_t syntheticSeed = 1;      ///< Seed for flows, sizes and payloads
     };
 
     struct Statistics {
@@ -38,6 +128,7 @@ public:
         uint64_t bytesDropped = 0;       ///< Total bytes dropped
         double captureRate = 0.0;        ///< Packets per second
         double dropRate = 0.0;           ///< Drop rate percentage
+        size_t queueHighWatermark = 0;   ///< Most packets waiting in a backend queue at once
         std::chrono::steady_clock::time_point lastUpdate; ///< Last statistics update
     };
 
@@ -48,9 +139,48 @@ public:
     virtual std::optional<Packet> nextPacket(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) = 0;
     virtual std::vector<Packet> getPackets(size_t maxPackets = 64, 
                                           std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) = 0;
+
+    /**
+     * @brief Get number of independent receive queues
+     *
+     * Backends that spread capture over several queues (fanout groups, RSS)
+     * expose them so each consumer can own queues of its own instead of
+     * sharing one. Packets of a flow stay on one queue.
+     *
+     * @return Number of receive queues, 1 unless overridden
+     */
+    virtual size_t getQueueCount() const { return 1; }
+
+    /**
+     * @brief Get packets from one receive queue
+     * @param queueId Queue index, less than getQueueCount()
+     * @param maxPackets Maximum number of packets to return
+     * @param timeout Time to wait for the first packet
+     * @return Packets from that queue only
+     */
+    virtual std::vector<Packet> getPackets(size_t queueId, size_t maxPackets, std::chrono::milliseconds timeout) {
+        return queueId == 0 ? getPackets(maxPackets, timeout) : std::vector<Packet>{};
+    }
     virtual void setPacketCallback(std::function<void(Packet)> callback) = 0;
     virtual void removePacketCallback() = 0;
 
+    /**
+     * @brief Push the offloadable part of a filter chain into the kernel
+     *
+     * Packets the kernel filter rejects are dropped before they are copied
+     * to user space. The kernel filter is never stricter than the chain, but
+     * may be looser (PAYLOAD and CUSTOM filters stay in user space), so
+     * callers keep running PacketFilter::applyFilters() on what arrives.
+     * Call again after changing the chain.
+     *
+     * @param filter Filter chain to offload
+     * @return NOT_IMPLEMENTED for backends without kernel filtering
+     */
+    virtual Result<void> setKernelFilter(const PacketFilter& filter) {
+        (void)filter;
+        return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, "Kernel filtering not supported by " + getName());
+    }
+
     virtual Statistics getStatistics() const = 0;
     virtual void resetStatistics() = 0;
 
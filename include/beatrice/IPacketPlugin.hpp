@@ -2,10 +2,20 @@
 #define BEATRICE_IPACKETPLUGIN_HPP
 
 #include "Packet.hpp"
+#include <cstdint>
+#include <span>
 #include <string>
 
 namespace beatrice {
 
+// What the plugin chain should do with a packet after a plugin has seen it
+enum class PluginVerdict : uint8_t {
+    Continue,   // hand the packet to the next plugin
+    Drop,       // discard the packet, later plugins never see it
+    StopChain,  // keep the packet but skip the remaining plugins
+    Forward     // mark the packet for forwarding and skip the remaining plugins
+};
+
 class IPacketPlugin {
 public:
     virtual ~IPacketPlugin() = default;
@@ -15,7 +25,16 @@ public:
     virtual void onStop() = 0;
     
     // Packet processing
-    virtual void onPacket(Packet& packet) = 0;
+    virtual PluginVerdict onPacket(Packet& packet) = 0;
+    
+    // Batch processing, override to prefetch or amortize per-call work;
+    // verdicts[i] belongs to packets[i] and arrives set to Continue.
+    // The default hands each packet to onPacket()
+    virtual void onBatch(std::span<Packet> packets, std::span<PluginVerdict> verdicts) {
+        for (size_t i = 0; i < packets.size(); ++i) {
+            verdicts[i] = onPacket(packets[i]);
+        }
+    }
     
     // Plugin information
     virtual std::string getName() const = 0;
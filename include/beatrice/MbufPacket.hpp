@@ -0,0 +1,57 @@
+#ifndef BEATRICE_MBUF_PACKET_HPP
+#define BEATRICE_MBUF_PACKET_HPP
+
+#include "beatrice/Packet.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct rte_mbuf;
+
+namespace beatrice {
+
+/**
+ * @brief Number of mbufs still referenced by packets of one backend
+ *
+ * DPDK backends must not tear down the EAL (and with it the mempools) while
+ * this is non-zero.
+ */
+using MbufRefCount = std::shared_ptr<std::atomic<uint64_t>>;
+
+/**
+ * @brief Number of mbufs requested per rte_eth_rx_burst() call
+ *
+ * rte_eth_rx_burst() takes a 16-bit count, so the configured batch size is
+ * clamped to [1, UINT16_MAX].
+ *
+ * @param batchSize Configured batch size
+ * @return Burst buffer length
+ */
+inline size_t mbufBurstSize(size_t batchSize) noexcept {
+    return std::clamp<size_t>(batchSize, 1, UINT16_MAX);
+}
+
+/**
+ * @brief Wrap a received mbuf in a Packet
+ *
+ * With @p zeroCopy the packet points straight into the mbuf data room and
+ * rte_pktmbuf_free() runs when the last copy of the packet is destroyed.
+ * Chained mbufs are first linearized in place; if the first segment has no
+ * room for that, or zero-copy is off, the data is copied and the mbuf freed
+ * right away. Ownership of @p mbuf always passes to this function.
+ *
+ * @param mbuf Received mbuf, may be chained
+ * @param zeroCopy Reference the mbuf instead of copying it
+ * @param inFlight Counter of referenced mbufs, incremented while the packet lives
+ * @param timestamp Capture timestamp
+ * @return Packet holding the full frame
+ */
+Packet packetFromMbuf(struct rte_mbuf* mbuf, bool zeroCopy, const MbufRefCount& inFlight,
+                      std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now());
+
+} // namespace beatrice
+
+#endif // BEATRICE_MBUF_PACKET_HPP
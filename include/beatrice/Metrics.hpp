@@ -83,6 +83,9 @@ public:
     double getMax() const { return max_.load(std::memory_order_relaxed); }
     
     double getQuantile(double quantile) const;
+    
+    /// Quantiles are computed over the most recent kWindowSize observations
+    static constexpr size_t kWindowSize = 65536;
 
 private:
     std::atomic<uint64_t> count_{0};
@@ -91,6 +94,7 @@ private:
     std::atomic<double> max_{std::numeric_limits<double>::lowest()};
     mutable std::mutex valuesMutex_;
     std::vector<double> values_;
+    size_t nextValue_{0};
 };
 
 class MetricsRegistry {
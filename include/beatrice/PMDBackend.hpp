@@ -2,11 +2,11 @@
 #define BEATRICE_PMDBACKEND_HPP
 
 #include "beatrice/ICaptureBackend.hpp"
+#include "beatrice/MbufPacket.hpp"
+#include "beatrice/PacketQueue.hpp"
 #include <memory>
 #include <thread>
-#include <queue>
 #include <mutex>
-#include <condition_variable>
 #include <functional>
 #include <vector>
 #include <string>
@@ -25,6 +25,7 @@ public:
     bool isRunning() const noexcept override;
     std::optional<Packet> nextPacket(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
     std::vector<Packet> getPackets(size_t maxPackets = 64, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
+    using ICaptureBackend::getPackets;  ///< Keep the per-queue overload visible
     void setPacketCallback(std::function<void(Packet)> callback) override;
     void removePacketCallback() override;
     Statistics getStatistics() const override;
@@ -68,13 +69,14 @@ private:
     
     std::thread processingThread_;
     
-    std::queue<Packet> packetQueue_;
-    std::mutex packetQueueMutex_;
-    std::condition_variable packetCondition_;
+    std::unique_ptr<PacketQueue> packetQueue_;     ///< Created from the config in initialize()
     
     std::function<void(Packet)> packetCallback_;
     std::mutex callbackMutex_;
     
+    std::vector<struct rte_mbuf*> rxBurst_;     ///< Burst buffer, Config::batchSize entries
+    MbufRefCount mbufsInFlight_;               ///< Mbufs still referenced by packets
+    
     mutable std::mutex statsMutex_;
     Statistics stats_;
     
@@ -108,7 +110,7 @@ private:
     bool startPort();
     void stopPort();
     void packetProcessingLoop();
-    void processPackets();
+    size_t processPackets();
     void shutdown();
     
     // PMD helper methods
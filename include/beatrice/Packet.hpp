@@ -1,12 +1,15 @@
 #ifndef BEATRICE_PACKET_HPP
 #define BEATRICE_PACKET_HPP
 
+#include "beatrice/PacketPool.hpp"
 #include <cstdint>
 #include <chrono>
 #include <string>
 #include <memory>
 #include <vector>
 #include <optional>
+#include <type_traits>
+#include <utility>
 
 namespace beatrice {
 
@@ -53,6 +56,39 @@ public:
     Packet(std::shared_ptr<const uint8_t[]> data, size_t length, 
            std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now());
 
+    /**
+     * @brief Zero-copy constructor referencing an externally owned buffer
+     *
+     * The packet does not copy or free @p data. Instead @p release is invoked
+     * exactly once, with @p data as argument, when the last copy of the packet
+     * is destroyed. Backends use this to hand capture buffers (e.g. AF_XDP UMEM
+     * frames) back to the kernel only after every consumer is done with them.
+     *
+     * @tparam Releaser Copy-constructible callable taking a const uint8_t*
+     * @param data Pointer to the packet data, must stay valid until released
+     * @param length Data length
+     * @param release Callable invoked when the last reference is dropped
+     * @param timestamp Capture timestamp
+     */
+    template<typename Releaser>
+        requires std::is_invocable_v<Releaser&, const uint8_t*>
+    Packet(const uint8_t* data, size_t length, Releaser release,
+           std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now())
+        : data_(data, std::move(release)), view_(data), length_(length), timestamp_(timestamp), zeroCopy_(true) {}
+
+    /**
+     * @brief Constructor taking ownership of a pooled buffer
+     *
+     * No heap allocation takes place; the buffer goes back to its PacketPool
+     * when the last copy of the packet is destroyed.
+     *
+     * @param buffer Pool buffer holding the packet data
+     * @param length Data length, must not exceed the buffer capacity
+     * @param timestamp Capture timestamp
+     */
+    Packet(PacketBuffer buffer, size_t length,
+           std::chrono::steady_clock::time_point timestamp = std::chrono::steady_clock::now());
+
     /**
      * @brief Copy constructor
      * @param other Packet to copy
@@ -63,7 +99,10 @@ public:
      * @brief Move constructor
      * @param other Packet to move from
      */
-    Packet(Packet&& other) noexcept = default;
+    Packet(Packet&& other) noexcept
+        : data_(std::move(other.data_)), buffer_(std::move(other.buffer_)),
+          view_(std::exchange(other.view_, nullptr)), length_(std::exchange(other.length_, 0)),
+          timestamp_(other.timestamp_), metadata_(std::move(other.metadata_)), zeroCopy_(other.zeroCopy_) {}
 
     /**
      * @brief Copy assignment operator
@@ -77,7 +116,18 @@ public:
      * @param other Packet to move from
      * @return Reference to this packet
      */
-    Packet& operator=(Packet&& other) noexcept = default;
+    Packet& operator=(Packet&& other) noexcept {
+        if (this != &other) {
+            data_ = std::move(other.data_);
+            buffer_ = std::move(other.buffer_);
+            view_ = std::exchange(other.view_, nullptr);
+            length_ = std::exchange(other.length_, 0);
+            timestamp_ = other.timestamp_;
+            metadata_ = std::move(other.metadata_);
+            zeroCopy_ = other.zeroCopy_;
+        }
+        return *this;
+    }
 
     /**
      * @brief Destructor
@@ -88,13 +138,17 @@ public:
      * @brief Get packet data
      * @return Pointer to packet data
      */
-    const uint8_t* data() const noexcept { return data_.get(); }
+    const uint8_t* data() const noexcept { return view_; }
 
     /**
      * @brief Get packet data as shared pointer
+     *
+     * For pool-backed packets this allocates a small control block that keeps
+     * the pool buffer referenced; prefer data() on hot paths.
+     *
      * @return Shared pointer to packet data
      */
-    std::shared_ptr<const uint8_t[]> getData() const noexcept { return data_; }
+    std::shared_ptr<const uint8_t[]> getData() const;
 
     /**
      * @brief Get packet length
@@ -130,7 +184,7 @@ public:
      * @brief Check if packet is empty
      * @return true if packet has no data
      */
-    bool empty() const noexcept { return !data_ || length_ == 0; }
+    bool empty() const noexcept { return !view_ || length_ == 0; }
 
     /**
      * @brief Get packet size
@@ -207,11 +261,26 @@ public:
      */
     bool isIPv4() const noexcept { return !metadata_.is_ipv6; }
 
+    /**
+     * @brief Check if packet references a backend buffer instead of a private copy
+     * @return true if packet was created through the zero-copy constructor
+     */
+    bool isZeroCopy() const noexcept { return zeroCopy_; }
+
+    /**
+     * @brief Check if packet data lives in a PacketPool buffer
+     * @return true if packet was created from a PacketBuffer
+     */
+    bool isPooled() const noexcept { return static_cast<bool>(buffer_); }
+
 private:
-    std::shared_ptr<const uint8_t[]> data_;                    ///< Packet data
+    std::shared_ptr<const uint8_t[]> data_;                    ///< Packet data (heap or zero-copy)
+    PacketBuffer buffer_;                                       ///< Packet data (pooled)
+    const uint8_t* view_{nullptr};                              ///< Start of data_ or buffer_
     size_t length_{0};                                          ///< Data length
     std::chrono::steady_clock::time_point timestamp_;           ///< Capture timestamp
     Metadata metadata_;                                          ///< Packet metadata
+    bool zeroCopy_{false};                                      ///< Data references a backend buffer
 };
 
 } // namespace beatrice
@@ -3,9 +3,19 @@
 
 #include "Packet.hpp"
 #include "Error.hpp"
+#include "BpfProgram.hpp"
+#include "EpochDomain.hpp"
+#include "XDPLoader.hpp"
+#include "PrefixTable.hpp"
+#include "PatternMatcher.hpp"
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <unordered_map>
 #include <regex>
@@ -43,14 +53,50 @@ public:
     PacketFilter();
     ~PacketFilter();
 
+    /**
+     * @brief Add a filter
+     *
+     * An IP_RANGE expression is a single IPv4 network, or a comma separated
+     * list of IPv4 and IPv6 prefixes. With parameters["file"] the prefixes
+     * are loaded from that file instead (see PrefixTable::loadFile()), tagged
+     * with parameters["tag"] where a line has no tag. List and file filters
+     * pass packets whose source or destination falls in a prefix, and report
+     * the prefix's tag as metadata["<name>.tag"].
+     *
+     * A PAYLOAD expression is a regex over the first bytes of the IP
+     * payload. With parameters["patterns"], "ID PATTERN" rules one per line,
+     * or parameters["file"] holding such rules (see
+     * PatternMatcher::parseRules()), the expression is ignored and the whole
+     * TCP or UDP payload is searched for every pattern in one pass instead.
+     * The filter passes packets where any pattern occurs and reports the IDs
+     * found as a comma separated metadata["<name>.matches"]. With
+     * parameters["stream"] set to "true", a match may span consecutive
+     * segments of a TCP flow. At most parameters["stream_flows"] flows
+     * (default 262144) are followed; past that the flows idle longest are
+     * dropped and counted in packet_filter_<name>_stream_evictions_total.
+     */
     Result<void> addFilter(const std::string& name, const FilterConfig& config);
 
     Result<void> removeFilter(const std::string& name);
     Result<void> setFilterEnabled(const std::string& name, bool enabled);
+
+    /**
+     * @brief Run a packet through the enabled filters, highest priority first
+     *
+     * Lock-free: the filters are compiled into an immutable chain whenever
+     * they change, and statistics go to per-thread counters merged by
+     * getStats(). Stream PAYLOAD filters are the exception, they lock the
+     * part of their flow table a packet's flow lives in. Safe to call from
+     * any number of threads. Only one packet in kTimingInterval per thread
+     * is timed, the others report a zero processingTime.
+     */
     FilterResult applyFilters(const Packet& packet);
     std::vector<FilterResult> applyFilters(const std::vector<Packet>& packets);
     std::vector<std::string> getActiveFilters() const;
 
+    /// Packets per thread between two processing time samples
+    static constexpr uint64_t kTimingInterval = 64;
+
     struct FilterStats {
         uint64_t packetsProcessed = 0;
         uint64_t packetsPassed = 0;
@@ -59,13 +105,77 @@ public:
         std::unordered_map<std::string, uint64_t> filterCounts;
     };
     FilterStats getStats() const;
+
+    /**
+     * @brief Compile the enabled filters into one socket filter
+     *
+     * BPF, PROTOCOL, IP_RANGE and PORT_RANGE filters are translated; PAYLOAD
+     * and CUSTOM filters, and BPF expressions using "vlan", are left out.
+     * A packet has to pass every filter, so the program accepts at least
+     * what applyFilters() accepts and the user-space chain stays the final
+     * word.
+     *
+     * @return Program for BpfProgram::attachToSocket(), empty if nothing can be offloaded
+     */
+    BpfProgram compileSocketFilter() const;
+
+    /**
+     * @brief Translate the enabled filters into XDP rule tables
+     *
+     * PROTOCOL filters intersect into the protocol table; the first IP_RANGE
+     * and PORT_RANGE filter by priority fill the network and port tables.
+     * Further ranges, prefix tables and BPF, PAYLOAD and CUSTOM filters are
+     * not offloaded, and the rules only ever drop IPv4 packets arriving on
+     * an RX queue with an AF_XDP socket bound; other queues keep passing
+     * everything to the host stack. Like compileSocketFilter(), they never
+     * reject a packet that applyFilters() would pass.
+     *
+     * @param userSpaceOnly If set, receives the names of enabled filters not offloaded
+     * @return Rules for XDPLoader::setFilterRules(), empty if nothing can be offloaded
+     */
+    XDPLoader::FilterRules compileXdpRules(std::vector<std::string>* userSpaceOnly = nullptr) const;
+
+    /**
+     * @brief Prefix table behind a list or file IP_RANGE filter
+     * @return The table, nullptr for other filters
+     */
+    std::shared_ptr<const PrefixTable> getPrefixTable(const std::string& name) const;
+
+    /**
+     * @brief Swap in a new prefix table for an IP_RANGE filter
+     *
+     * Build the table beforehand, e.g. with PrefixTable::loadFile() or
+     * getPrefixTable()->update(); packets keep being matched against the old
+     * table until the swap.
+     */
+    Result<void> setPrefixTable(const std::string& name, std::shared_ptr<const PrefixTable> table);
+
+    /**
+     * @brief Pattern set behind a rule set PAYLOAD filter
+     * @return The matcher, nullptr for other filters
+     */
+    std::shared_ptr<const PatternMatcher> getPatternMatcher(const std::string& name) const;
+
+    /**
+     * @brief Swap in a new pattern set for a PAYLOAD filter
+     *
+     * Flows a stream filter was following start over with the new patterns.
+     */
+    Result<void> setPatternMatcher(const std::string& name, std::shared_ptr<const PatternMatcher> matcher);
     void resetStats();
     Result<void> setCustomFilter(const std::string& name, 
                                 std::function<bool(const Packet&)> filterFunc);
 
 private:
+    // Automaton positions of the TCP flows a stream PAYLOAD filter follows
+    struct StreamTable;
+
     struct FilterEntry {
         FilterConfig config;
+        BpfProgram bpfProgram;           ///< Compiled expression for BPF filters
+        std::shared_ptr<const PrefixTable> prefixTable; ///< List and file IP_RANGE filters
+        std::shared_ptr<const PatternMatcher> patternMatcher; ///< Rule set PAYLOAD filters
+        std::shared_ptr<StreamTable> streams;           ///< Stream PAYLOAD filters
         std::function<bool(const Packet&)> customFunc;
         uint64_t packetsProcessed = 0;
         uint64_t packetsPassed = 0;
@@ -73,24 +183,105 @@ private:
         std::chrono::microseconds totalTime{0};
     };
 
+    // Per-thread share of a counter, merged on read
+    struct alignas(64) ShardCounter {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static constexpr size_t kShards = 64;
+    using ShardedCounter = std::array<ShardCounter, kShards>;
+
+    struct alignas(64) StatsShard {
+        std::atomic<uint64_t> packetsPassed{0};
+        std::atomic<uint64_t> packetsDropped{0};
+        std::atomic<uint64_t> timedPackets{0};
+        std::atomic<uint64_t> processingNanos{0};
+    };
+
+    // Ethernet and IPv4 fields the rules look at, read once per packet
+    struct PacketView {
+        bool ipv4 = false;
+        bool ipv6 = false;
+        bool hasPorts = false;
+        bool tcp = false;                // sequence and tcpFlags are set
+        uint8_t protocol = 0;
+        uint32_t srcAddress = 0;         // host order
+        uint32_t dstAddress = 0;
+        const uint8_t* srcAddress6 = nullptr;
+        const uint8_t* dstAddress6 = nullptr;
+        uint16_t srcPort = 0;
+        uint16_t dstPort = 0;
+        const uint8_t* payload = nullptr;
+        size_t payloadLength = 0;
+        uint32_t sequence = 0;
+        uint8_t tcpFlags = 0;
+        const uint8_t* segment = nullptr;  // TCP or UDP payload, whole
+        size_t segmentLength = 0;
+    };
+
+    // One enabled filter with its expression parsed up front
+    struct CompiledRule {
+        std::string name;
+        std::string rejectReason;
+        std::string tagKey;
+        FilterType type = FilterType::PROTOCOL;
+        bool matchAll = false;           // empty expression
+        bool valid = true;               // false rejects every packet
+        BpfProgram bpfProgram;
+        std::bitset<256> protocols;
+        uint32_t network = 0;
+        uint32_t netmask = 0;
+        uint16_t lowPort = 0;
+        uint16_t highPort = 0;
+        std::shared_ptr<const PrefixTable> prefixTable;
+        std::regex pattern;
+        std::shared_ptr<const PatternMatcher> patternMatcher;
+        std::shared_ptr<StreamTable> streams;
+        std::string matchKey;
+        std::function<bool(const Packet&)> customFunc;
+        std::shared_ptr<ShardedCounter> decisions;
+
+        bool matches(const Packet& packet, const PacketView& view, FilterResult& result) const;
+        bool matchPatterns(const PacketView& view, FilterResult& result) const;
+    };
+
+    // Immutable once published, rules in evaluation order
+    struct CompiledChain {
+        std::vector<CompiledRule> rules;
+        std::shared_ptr<ShardedCounter> emptyDecisions;  // no filter enabled
+    };
+
+    // Pins the current chain for the duration of one applyFilters() call
+    class ReadGuard {
+    public:
+        explicit ReadGuard(PacketFilter& filter) : epoch_(filter.readers_), chain_(filter.chain_.load()) {}
+
+        const CompiledChain& chain() const { return *chain_; }
+
+    private:
+        EpochDomain::Guard epoch_;
+        const CompiledChain* chain_;
+    };
+
     std::unordered_map<std::string, FilterEntry> filters_;
+    std::unordered_map<std::string, std::shared_ptr<ShardedCounter>> decisionCounts_;
+    
+    // Serializes rule changes, never taken on the packet path
     mutable std::mutex filtersMutex_;
-    FilterStats stats_;
-    mutable std::mutex statsMutex_;
-
-    // Internal filter methods
-    bool applyBPFFilter(const Packet& packet, const FilterConfig& config);
-    bool applyProtocolFilter(const Packet& packet, const FilterConfig& config);
-    bool applyIPRangeFilter(const Packet& packet, const FilterConfig& config);
-    bool applyPortRangeFilter(const Packet& packet, const FilterConfig& config);
-    bool applyPayloadFilter(const Packet& packet, const FilterConfig& config);
-    bool applyCustomFilter(const Packet& packet, const FilterEntry& entry);
-
-    // Helper methods
-    std::vector<uint8_t> parseIPAddress(const std::string& ipStr);
-    bool isIPInRange(const std::vector<uint8_t>& ip, const std::string& range);
-    bool isPortInRange(uint16_t port, const std::string& range);
-    void updateStats(const std::string& filterName, bool passed, std::chrono::microseconds time);
+    
+    std::atomic<CompiledChain*> chain_;
+    EpochDomain readers_;
+    std::array<StatsShard, kShards> stats_;
+
+    static PacketView parsePacket(const Packet& packet);
+    CompiledRule compileRule(const std::string& name, const FilterEntry& entry);
+    std::shared_ptr<ShardedCounter> decisionCounterLocked(const std::string& name);
+    void rebuildLocked();
+    std::vector<std::pair<std::string, const FilterEntry*>> enabledFiltersLocked() const;
+
+    // Disable copying
+    PacketFilter(const PacketFilter&) = delete;
+    PacketFilter& operator=(const PacketFilter&) = delete;
 };
 
 } // namespace beatrice
@@ -0,0 +1,244 @@
+#ifndef BEATRICE_PACKET_POOL_HPP
+#define BEATRICE_PACKET_POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace beatrice {
+
+class PacketPool;
+class Counter;
+class Gauge;
+
+/**
+ * @brief Header of a single pooled buffer
+ *
+ * Slot headers live in a separate array from the data area so that the
+ * buffers themselves stay cache-line aligned and densely packed.
+ */
+struct PacketBufferSlot {
+    PacketPool* pool{nullptr};            ///< Owning pool
+    std::atomic<uint32_t> refs{0};        ///< Number of live PacketBuffer handles
+    PacketBufferSlot* next{nullptr};      ///< Free-list link
+    uint8_t* data{nullptr};               ///< Start of the buffer
+};
+
+/**
+ * @brief Reference-counted handle to a buffer owned by a PacketPool
+ *
+ * Copying a handle only bumps the slot reference count. When the last handle
+ * goes away the buffer is returned to its pool, from whichever thread that
+ * happens on.
+ */
+class PacketBuffer {
+public:
+    /**
+     * @brief Default constructor, creates an empty handle
+     */
+    PacketBuffer() = default;
+
+    /**
+     * @brief Copy constructor
+     * @param other Handle to share the buffer with
+     */
+    PacketBuffer(const PacketBuffer& other) noexcept : slot_(other.slot_) { retain(); }
+
+    /**
+     * @brief Move constructor
+     * @param other Handle to take the buffer from
+     */
+    PacketBuffer(PacketBuffer&& other) noexcept : slot_(other.slot_) { other.slot_ = nullptr; }
+
+    /**
+     * @brief Copy assignment operator
+     * @param other Handle to share the buffer with
+     * @return Reference to this handle
+     */
+    PacketBuffer& operator=(const PacketBuffer& other) noexcept {
+        if (slot_ != other.slot_) {
+            PacketBuffer(other).swap(*this);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator
+     * @param other Handle to take the buffer from
+     * @return Reference to this handle
+     */
+    PacketBuffer& operator=(PacketBuffer&& other) noexcept {
+        PacketBuffer(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    /**
+     * @brief Destructor, returns the buffer to its pool on last release
+     */
+    ~PacketBuffer() { release(); }
+
+    /**
+     * @brief Get writable buffer memory
+     * @return Pointer to the buffer, nullptr for an empty handle
+     */
+    uint8_t* data() const noexcept { return slot_ ? slot_->data : nullptr; }
+
+    /**
+     * @brief Get buffer capacity
+     * @return Buffer size in bytes, 0 for an empty handle
+     */
+    size_t capacity() const noexcept;
+
+    /**
+     * @brief Check if handle refers to a buffer
+     * @return true if handle is not empty
+     */
+    explicit operator bool() const noexcept { return slot_ != nullptr; }
+
+    /**
+     * @brief Swap two handles
+     * @param other Handle to swap with
+     */
+    void swap(PacketBuffer& other) noexcept {
+        PacketBufferSlot* tmp = slot_;
+        slot_ = other.slot_;
+        other.slot_ = tmp;
+    }
+
+private:
+    friend class PacketPool;
+
+    explicit PacketBuffer(PacketBufferSlot* slot) noexcept : slot_(slot) {}
+
+    void retain() noexcept {
+        if (slot_) {
+            slot_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void release() noexcept;
+
+    PacketBufferSlot* slot_{nullptr};
+};
+
+/**
+ * @brief Fixed-size packet buffer pool owned by a single receive thread
+ *
+ * All buffers are carved out of one mapping at creation time, so the receive
+ * path never touches the heap allocator. Only the owning thread may call
+ * acquire(); buffers may be released from any thread and are handed back to
+ * the owner through a lock-free stack. The pool memory stays alive until both
+ * the owner has dropped its reference and every buffer has been returned.
+ *
+ * Occupancy and exhaustion are exported as the `<name>_buffers_in_use` gauge
+ * and the `<name>_exhausted_total` counter.
+ */
+class PacketPool {
+public:
+    /**
+     * @brief Pool statistics
+     */
+    struct Statistics {
+        size_t capacity = 0;           ///< Total number of buffers
+        size_t bufferSize = 0;         ///< Size of each buffer in bytes
+        size_t inUse = 0;              ///< Buffers currently referenced
+        uint64_t acquired = 0;         ///< Successful acquisitions
+        uint64_t exhausted = 0;        ///< Acquisitions that found the pool empty
+    };
+
+    /**
+     * @brief Create a pool
+     * @param bufferSize Size of each buffer in bytes
+     * @param bufferCount Number of buffers
+     * @param name Metric name prefix, metrics are skipped if empty
+     * @return Shared pointer to the pool, nullptr if the memory could not be mapped
+     */
+    static std::shared_ptr<PacketPool> create(size_t bufferSize, size_t bufferCount,
+                                              const std::string& name = "");
+
+    /**
+     * @brief Take a buffer from the pool (owner thread only)
+     * @return Buffer handle, empty if the pool is exhausted
+     */
+    PacketBuffer acquire();
+
+    /**
+     * @brief Get buffer size
+     * @return Size of each buffer in bytes
+     */
+    size_t bufferSize() const noexcept { return bufferSize_; }
+
+    /**
+     * @brief Get number of buffers
+     * @return Total number of buffers in the pool
+     */
+    size_t capacity() const noexcept { return capacity_; }
+
+    /**
+     * @brief Get number of buffers currently referenced
+     * @return Buffers handed out and not yet returned
+     */
+    size_t inUse() const noexcept;
+
+    /**
+     * @brief Get pool statistics
+     * @return Current statistics
+     */
+    Statistics getStatistics() const;
+
+    /**
+     * @brief Refresh the occupancy gauge
+     *
+     * acquire() already does this; receive loops call it when idle so the
+     * gauge also reflects buffers returned while no packets arrive.
+     */
+    void publishMetrics();
+
+private:
+    friend class PacketBuffer;
+
+    PacketPool(size_t bufferSize, size_t bufferCount, const std::string& name);
+    ~PacketPool();
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    bool map();
+    void recycle(PacketBufferSlot* slot) noexcept;
+    void unref() noexcept;
+
+    size_t bufferSize_;
+    size_t stride_;
+    size_t capacity_;
+    std::string name_;
+
+    void* area_{nullptr};
+    size_t areaSize_{0};
+    std::unique_ptr<PacketBufferSlot[]> slots_;
+
+    PacketBufferSlot* localFree_{nullptr};                    ///< Owner-only free list
+    alignas(64) std::atomic<PacketBufferSlot*> remoteFree_{nullptr};  ///< Buffers released by any thread
+    alignas(64) std::atomic<size_t> refs_{1};                 ///< Owner reference + outstanding buffers
+    std::atomic<uint64_t> acquired_{0};
+    std::atomic<uint64_t> exhausted_{0};
+
+    std::shared_ptr<Gauge> inUseGauge_;
+    std::shared_ptr<Counter> exhaustedCounter_;
+};
+
+inline size_t PacketBuffer::capacity() const noexcept {
+    return slot_ ? slot_->pool->bufferSize() : 0;
+}
+
+inline void PacketBuffer::release() noexcept {
+    if (slot_ && slot_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        slot_->pool->recycle(slot_);
+    }
+    slot_ = nullptr;
+}
+
+} // namespace beatrice
+
+#endif // BEATRICE_PACKET_POOL_HPP
@@ -0,0 +1,138 @@
+#ifndef BEATRICE_PACKET_QUEUE_HPP
+#define BEATRICE_PACKET_QUEUE_HPP
+
+#include "beatrice/ICaptureBackend.hpp"
+#include "beatrice/PacketRing.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace beatrice {
+
+class Counter;
+class Gauge;
+
+/**
+ * @brief Bounded packet queue between one capture thread and its consumers
+ *
+ * Wraps a single-producer PacketRing and decides what happens
+ * when it is full according to an OverflowPolicy: drop the arriving packets,
+ * evict the oldest queued ones, or block the producer until consumers make
+ * room. Overload therefore shows up as counted loss or as backpressure on
+ * the NIC instead of unbounded memory and latency.
+ *
+ * A queue starts closed: pop() returns at once and a blocking push() does not
+ * wait. Backends open() it in start() and close() it in stop().
+ *
+ * With a name, drops and the high watermark are exported as the
+ * `<name>_queue_dropped_total` counter and `<name>_queue_high_watermark` gauge.
+ */
+class PacketQueue {
+public:
+    using OverflowPolicy = ICaptureBackend::OverflowPolicy;
+
+    /**
+     * @brief Queue statistics
+     */
+    struct Statistics {
+        size_t capacity = 0;           ///< Maximum number of queued packets
+        size_t depth = 0;              ///< Packets currently queued
+        size_t highWatermark = 0;      ///< Most packets queued at once
+        uint64_t dropped = 0;          ///< Packets discarded by the overflow policy
+        uint64_t bytesDropped = 0;     ///< Bytes of those packets
+    };
+
+    /**
+     * @brief Create a queue sized and configured from a backend config
+     * @param config Backend config, queueDepth and queueOverflowPolicy are used
+     * @param fallback Policy used when the config leaves it at DEFAULT
+     * @param name Metric name prefix, metrics are skipped if empty
+     * @param consumers RingSync::SINGLE if only one thread ever pops; ignored
+     *        for DROP_OLDEST, where the producer evicts from the consumer side
+     */
+    PacketQueue(const ICaptureBackend::Config& config, OverflowPolicy fallback, const std::string& name = "",
+                RingSync consumers = RingSync::MULTI);
+
+    PacketQueue(const PacketQueue&) = delete;
+    PacketQueue& operator=(const PacketQueue&) = delete;
+
+    /**
+     * @brief Queue a batch of packets (capture thread only)
+     * @param packets Packets to queue, accepted ones are moved from
+     * @param count Number of packets
+     * @return Number of packets accepted; the rest were dropped, or the
+     *         queue was closed while blocked
+     */
+    size_t push(Packet* packets, size_t count);
+
+    size_t push(std::vector<Packet>& packets) { return push(packets.data(), packets.size()); }
+    bool push(Packet&& packet) { return push(&packet, 1) == 1; }
+
+    /**
+     * @brief Take up to maxPackets packets, waiting while the queue is empty
+     * @param out Vector the packets are appended to
+     * @param maxPackets Maximum number of packets
+     * @param timeout Maximum time to wait for the first packet
+     * @return Number of packets taken
+     */
+    size_t pop(std::vector<Packet>& out, size_t maxPackets, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Let pop() and a blocking push() wait again
+     */
+    void open();
+
+    /**
+     * @brief Mark the producer as done, waiting consumers return with what is left
+     */
+    void finish();
+
+    /**
+     * @brief Stop all waiting on both sides, e.g. on backend stop
+     */
+    void close();
+
+    bool empty() const noexcept { return ring_.empty(); }
+    size_t size() const noexcept { return ring_.size(); }
+    size_t capacity() const noexcept { return ring_.capacity(); }
+    OverflowPolicy policy() const noexcept { return policy_; }
+
+    /**
+     * @brief Get queue statistics
+     * @return Current statistics
+     */
+    Statistics getStatistics() const;
+
+    /**
+     * @brief Reset drop counters, the high watermark restarts at the current depth
+     */
+    void resetStatistics();
+
+private:
+    void countDrops(const Packet* packets, size_t count);
+    void updateHighWatermark();
+
+    PacketRing<Packet> ring_;
+    OverflowPolicy policy_;
+
+    RingNotifier dataNotifier_;                   ///< Packets queued, finished or closed
+    RingNotifier spaceNotifier_;                  ///< Room in the queue, BLOCK only
+    std::atomic<bool> closed_{true};
+    std::atomic<bool> finished_{false};
+
+    std::atomic<size_t> highWatermark_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> bytesDropped_{0};
+    std::vector<Packet> evicted_;                 ///< DROP_OLDEST scratch, capture thread only
+
+    std::shared_ptr<Gauge> highWatermarkGauge_;
+    std::shared_ptr<Counter> droppedCounter_;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_PACKET_QUEUE_HPP
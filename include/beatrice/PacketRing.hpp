@@ -0,0 +1,285 @@
+#ifndef BEATRICE_PACKET_RING_HPP
+#define BEATRICE_PACKET_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace beatrice {
+
+/**
+ * @brief Whether one or several threads use a side of a ring
+ */
+enum class RingSync {
+    SINGLE,     ///< Exactly one thread, no atomic read-modify-write
+    MULTI       ///< Any number of threads, one CAS per burst
+};
+
+/**
+ * @brief Spin-wait hint for busy loops
+ */
+inline void ringPause() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Bounded lock-free ring with burst enqueue and dequeue
+ *
+ * Producer and consumer side each keep a head (reserved) and tail (published)
+ * index on their own cache line. A single-threaded side just advances its
+ * head; a multi-threaded side reserves a range with one CAS, moves the items
+ * and then publishes in reservation order. A burst of n items therefore costs
+ * the same synchronization as a single item, and producers never wait for
+ * consumers or the other way round.
+ *
+ * Capacity is rounded up to a power of two. Dequeued slots are left in the
+ * moved-from state, so a ring of Packet does not pin buffers it already
+ * handed out.
+ */
+template <typename T>
+class PacketRing {
+public:
+    /**
+     * @brief Create a ring
+     * @param capacity Minimum number of items, rounded up to a power of two
+     * @param producers Producer side synchronization
+     * @param consumers Consumer side synchronization
+     */
+    explicit PacketRing(size_t capacity, RingSync producers = RingSync::SINGLE,
+                        RingSync consumers = RingSync::SINGLE)
+        : capacity_(roundUp(capacity))
+        , mask_(capacity_ - 1)
+        , multiProducer_(producers == RingSync::MULTI)
+        , multiConsumer_(consumers == RingSync::MULTI)
+        , slots_(std::make_unique<T[]>(capacity_)) {
+    }
+
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+
+    /**
+     * @brief Move up to count items into the ring
+     * @param items Items to enqueue, the first n are moved from
+     * @param count Number of items
+     * @return Number of items enqueued, less than count if the ring filled up
+     */
+    size_t enqueueBurst(T* items, size_t count) {
+        uint32_t head;
+        const uint32_t n = reserve(producer_, consumer_, capacity_, multiProducer_, count, head);
+        for (uint32_t i = 0; i < n; ++i) {
+            slots_[(head + i) & mask_] = std::move(items[i]);
+        }
+        publish(producer_, head, head + n, multiProducer_);
+        return n;
+    }
+
+    /**
+     * @brief Move one item into the ring
+     * @param item Item to enqueue, moved from on success
+     * @return false if the ring is full
+     */
+    bool enqueue(T&& item) {
+        return enqueueBurst(&item, 1) == 1;
+    }
+
+    /**
+     * @brief Move up to maxItems items out of the ring
+     * @param out Vector the items are appended to
+     * @param maxItems Maximum number of items
+     * @return Number of items dequeued
+     */
+    size_t dequeueBurst(std::vector<T>& out, size_t maxItems) {
+        uint32_t head;
+        const uint32_t n = reserve(consumer_, producer_, 0, multiConsumer_, maxItems, head);
+        out.reserve(out.size() + n);
+        for (uint32_t i = 0; i < n; ++i) {
+            out.push_back(std::move(slots_[(head + i) & mask_]));
+        }
+        publish(consumer_, head, head + n, multiConsumer_);
+        return n;
+    }
+
+    /**
+     * @brief Move one item out of the ring
+     * @param out Destination
+     * @return false if the ring is empty
+     */
+    bool dequeue(T& out) {
+        uint32_t head;
+        if (reserve(consumer_, producer_, 0, multiConsumer_, 1, head) == 0) {
+            return false;
+        }
+        out = std::move(slots_[head & mask_]);
+        publish(consumer_, head, head + 1, multiConsumer_);
+        return true;
+    }
+
+    /**
+     * @brief Get number of items in the ring
+     * @return Published items not yet dequeued, a snapshot under concurrency
+     */
+    size_t size() const noexcept {
+        // Consumer first: the producer tail can only be ahead of it, but may
+        // have moved on by up to a full ring since
+        const uint32_t tail = consumer_.tail.load(std::memory_order_acquire);
+        return std::min<uint32_t>(producer_.tail.load(std::memory_order_acquire) - tail, capacity_);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+    bool full() const noexcept { return size() >= capacity_; }
+    size_t capacity() const noexcept { return capacity_; }
+
+private:
+    struct alignas(64) HeadTail {
+        std::atomic<uint32_t> head{0};   ///< Next index to reserve
+        std::atomic<uint32_t> tail{0};   ///< Indices below are published to the other side
+    };
+
+    static uint32_t roundUp(size_t capacity) {
+        uint32_t size = 1;
+        while (size < capacity && size < (1u << 31)) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    // Available entries are computed as offset + other.tail - head: the free
+    // space for producers (offset = capacity), the fill level for consumers
+    static uint32_t reserve(HeadTail& self, const HeadTail& other, uint32_t offset, bool multi,
+                            size_t wanted, uint32_t& head) {
+        head = self.head.load(std::memory_order_acquire);
+        while (true) {
+            const uint32_t available = offset + other.tail.load(std::memory_order_acquire) - head;
+            const uint32_t n = static_cast<uint32_t>(std::min<size_t>(wanted, available));
+            if (n == 0) {
+                return 0;
+            }
+            if (!multi) {
+                self.head.store(head + n, std::memory_order_relaxed);
+                return n;
+            }
+            if (self.head.compare_exchange_weak(head, head + n, std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+                return n;
+            }
+        }
+    }
+
+    static void publish(HeadTail& self, uint32_t head, uint32_t next, bool multi) {
+        if (head == next) {
+            return;
+        }
+        if (multi) {
+            // Earlier reservations publish first; acquire so their slot
+            // accesses are ordered before our release to the other side
+            unsigned spins = 0;
+            while (self.tail.load(std::memory_order_acquire) != head) {
+                if (++spins < 64) {
+                    ringPause();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        self.tail.store(next, std::memory_order_release);
+    }
+
+    const uint32_t capacity_;
+    const uint32_t mask_;
+    const bool multiProducer_;
+    const bool multiConsumer_;
+    std::unique_ptr<T[]> slots_;
+
+    HeadTail producer_;
+    HeadTail consumer_;
+};
+
+/**
+ * @brief Wakeup channel for threads waiting on a ring
+ *
+ * Waiters register before they re-check the ring and then sleep on a futex;
+ * notify() only enters the kernel while someone is registered, so a busy
+ * producer pays one atomic per burst instead of a syscall. Wakeups
+ * go to all waiters and cannot be lost between the check and the sleep.
+ */
+class RingNotifier {
+public:
+    RingNotifier() = default;
+
+    RingNotifier(const RingNotifier&) = delete;
+    RingNotifier& operator=(const RingNotifier&) = delete;
+
+    /**
+     * @brief Wake parked waiters, call after publishing to the ring
+     */
+    void notify() noexcept {
+        // An RMW, not a plain load: ordered against the waiter's increment,
+        // so either the waiter sees the new items or we see the waiter
+        if (waiters_.fetch_add(0, std::memory_order_seq_cst) != 0) {
+            wakeAll();
+        }
+    }
+
+    /**
+     * @brief Wake all waiters unconditionally, e.g. on shutdown
+     */
+    void wakeAll() noexcept;
+
+    /**
+     * @brief Wait until a condition holds
+     * @param ready Condition, typically "ring not empty or stopped"
+     * @param timeout Maximum time to wait
+     * @return Result of the last ready() check
+     */
+    template <typename Predicate>
+    bool wait(Predicate ready, std::chrono::milliseconds timeout) {
+        if (ready()) {
+            return true;
+        }
+        if (timeout.count() <= 0) {
+            // Non-blocking poll, no need to register as a waiter
+            return false;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (true) {
+            const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            if (ready()) {
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                waiters_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            park(sequence, std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now));
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+
+            if (ready()) {
+                return true;
+            }
+        }
+    }
+
+private:
+    void park(uint32_t sequence, std::chrono::nanoseconds timeout) noexcept;
+
+    alignas(64) std::atomic<uint32_t> sequence_{0};   ///< Futex word, bumped on every wakeup
+    std::atomic<uint32_t> waiters_{0};
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_PACKET_RING_HPP
@@ -0,0 +1,199 @@
+#ifndef BEATRICE_PATTERN_MATCHER_HPP
+#define BEATRICE_PATTERN_MATCHER_HPP
+
+#include "beatrice/Error.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace beatrice {
+
+/**
+ * @brief Literal multi-pattern matcher for packet payloads
+ *
+ * The patterns compile into one Aho-Corasick automaton, a dense DFA over
+ * the byte classes the patterns use, so every pattern is found in a single
+ * pass. While the automaton sits in its start state, a prefilter skips to
+ * the next position where a pattern could begin. enablePrefilter() turns on
+ * a Teddy-style SSSE3 prefilter that checks 16 positions at once against
+ * nibble masks built from the first three bytes of every pattern; otherwise
+ * a first-byte table is used.
+ *
+ * StreamState carries a match across buffers, so a pattern split over
+ * consecutive TCP segments is still found.
+ */
+class PatternMatcher {
+public:
+    /// Largest automaton accepted, in transition table entries
+    static constexpr size_t kMaxTransitions = size_t{1} << 26;
+
+    struct Pattern {
+        uint32_t id = 0;                 ///< Reported on a match, several patterns may share one
+        std::string bytes;
+    };
+
+    /**
+     * @brief Automaton position between two scanned buffers
+     */
+    struct StreamState {
+        uint32_t state = 0;
+        uint64_t offset = 0;             ///< Bytes scanned so far
+    };
+
+    /**
+     * @brief An empty matcher, finds nothing
+     */
+    PatternMatcher();
+
+    /**
+     * @brief Build the automaton
+     * @return The matcher, INVALID_ARGUMENT for an empty pattern or
+     *         RESOURCE_UNAVAILABLE past kMaxTransitions
+     */
+    static Result<PatternMatcher> compile(const std::vector<Pattern>& patterns);
+
+    /**
+     * @brief Parse a pattern written with Snort-style hex blocks
+     *
+     * "GET |2f 61|dmin" is the bytes "GET /admin"; a backslash takes the
+     * next character literally.
+     *
+     * @return The bytes, or INVALID_ARGUMENT
+     */
+    static Result<std::string> parsePattern(const std::string& text);
+
+    /**
+     * @brief Compile rules written one "ID PATTERN" per line
+     *
+     * Blank lines and lines starting with '#' are skipped; PATTERN runs to
+     * the end of the line and goes through parsePattern().
+     *
+     * @return The matcher, or INVALID_ARGUMENT naming the first bad line
+     */
+    static Result<PatternMatcher> parseRules(const std::string& rules);
+
+    /**
+     * @brief Compile a rule file in the parseRules() format
+     * @return The matcher, RESOURCE_UNAVAILABLE if the file cannot be read
+     */
+    static Result<PatternMatcher> loadFile(const std::string& path);
+
+    /**
+     * @brief Build the SSSE3 prefilter
+     *
+     * Left off when the CPU lacks SSSE3 or the patterns are so many that
+     * most positions would pass the prefilter anyway.
+     *
+     * @return true if scans now use it
+     */
+    bool enablePrefilter();
+
+    /**
+     * @brief Check whether scans use the SSSE3 prefilter
+     */
+    bool isPrefiltered() const noexcept { return prefiltered_; }
+
+    /**
+     * @brief Report every match in one buffer
+     * @param onMatch Called as onMatch(id, end) with the offset just past the
+     *                match; returning false stops the scan
+     */
+    template <typename Callback>
+    void scan(const uint8_t* data, size_t length, Callback&& onMatch) const {
+        StreamState stream;
+        scan(stream, data, length, onMatch);
+    }
+
+    /**
+     * @brief Report every match in the next buffer of a stream
+     *
+     * Match ends are offsets into the whole stream.
+     */
+    template <typename Callback>
+    void scan(StreamState& stream, const uint8_t* data, size_t length, Callback&& onMatch) const {
+        if (transitions_.empty()) {
+            stream.offset += length;
+            return;
+        }
+
+        uint32_t row = stream.state;
+        size_t position = 0;
+        while (position < length) {
+            // No partial match in progress, jump to where one could start
+            if (row == 0) {
+                position = nextCandidate(data, position, length);
+                if (position == length) {
+                    break;
+                }
+            }
+
+            uint32_t next = transitions_[row + classes_[data[position++]]];
+            row = next & ~kOutputFlag;
+            if (next & kOutputFlag) {
+                const uint32_t state = row / classCount_;
+                for (uint32_t i = outputOffsets_[state]; i < outputOffsets_[state + 1]; ++i) {
+                    if (!onMatch(outputs_[i], stream.offset + position)) {
+                        stream.state = row;
+                        stream.offset += position;
+                        return;
+                    }
+                }
+            }
+        }
+
+        stream.state = row;
+        stream.offset += length;
+    }
+
+    /**
+     * @brief Check whether any pattern occurs in a buffer
+     */
+    bool matches(const uint8_t* data, size_t length) const {
+        bool found = false;
+        scan(data, length, [&found](uint32_t, uint64_t) {
+            found = true;
+            return false;
+        });
+        return found;
+    }
+
+    size_t size() const noexcept { return patternCount_; }
+    bool empty() const noexcept { return patternCount_ == 0; }
+    size_t stateCount() const noexcept { return classCount_ ? transitions_.size() / classCount_ : 0; }
+
+    /**
+     * @brief Bytes used by the automaton and prefilter
+     */
+    size_t memoryUsage() const noexcept;
+
+private:
+    static constexpr uint32_t kOutputFlag = 0x80000000u;
+    static constexpr size_t kTeddyBuckets = 8;
+    static constexpr size_t kTeddyWidth = 3;
+
+    // Nibble masks, bit b set if a pattern in bucket b allows the nibble
+    struct Teddy {
+        size_t width = 0;
+        std::array<std::array<uint8_t, 16>, kTeddyWidth> low{};
+        std::array<std::array<uint8_t, 16>, kTeddyWidth> high{};
+    };
+
+    size_t nextCandidate(const uint8_t* data, size_t position, size_t length) const noexcept;
+
+    std::array<uint8_t, 256> classes_{};
+    uint32_t classCount_ = 0;
+    std::vector<uint32_t> transitions_;  // row of the next state | kOutputFlag, rows of classCount_
+    std::vector<uint32_t> outputOffsets_;
+    std::vector<uint32_t> outputs_;
+    std::array<bool, 256> firstBytes_{};
+    std::vector<std::string> prefixes_;  // first kTeddyWidth bytes of each pattern
+    Teddy teddy_;
+    bool prefiltered_ = false;
+    size_t patternCount_ = 0;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_PATTERN_MATCHER_HPP
@@ -0,0 +1,122 @@
+#ifndef BEATRICE_PCAP_FILE_BACKEND_HPP
+#define BEATRICE_PCAP_FILE_BACKEND_HPP
+
+#include "beatrice/ICaptureBackend.hpp"
+#include "beatrice/PacketQueue.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beatrice {
+
+/**
+ * @brief Capture backend that replays a pcap or pcapng file
+ *
+ * The file is memory-mapped and every Packet points straight into the
+ * mapping, which stays alive until the last packet is released. A reader
+ * thread either replays as fast as consumers take packets (replaySpeed 0) or
+ * paces packets by their recorded timestamps scaled by replaySpeed. Packet
+ * timestamps keep the recorded inter-packet gaps in both modes, so replays
+ * are deterministic.
+ *
+ * The reader blocks instead of dropping when consumers fall behind. The file
+ * comes from Config::captureFile, falling back to Config::interface.
+ */
+class PcapFileBackend : public ICaptureBackend {
+public:
+    PcapFileBackend();
+    ~PcapFileBackend();
+    
+    Result<void> initialize(const Config& config) override;
+    Result<void> start() override;
+    Result<void> stop() override;
+    bool isRunning() const noexcept override;
+    std::optional<Packet> nextPacket(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
+    std::vector<Packet> getPackets(size_t maxPackets = 64, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
+    using ICaptureBackend::getPackets;  ///< Keep the per-queue overload visible
+    void setPacketCallback(std::function<void(Packet)> callback) override;
+    void removePacketCallback() override;
+    Statistics getStatistics() const override;
+    void resetStatistics() override;
+    std::string getName() const override;
+    std::string getVersion() const override;
+    std::vector<std::string> getSupportedFeatures() const override;
+    bool isFeatureSupported(const std::string& feature) const override;
+    Config getConfig() const override;
+    Result<void> updateConfig(const Config& config) override;
+    std::string getLastError() const override;
+    bool isHealthy() const override;
+    Result<void> healthCheck() override;
+
+    // Zero-copy DMA access methods
+    bool isZeroCopyEnabled() const override;
+    bool isDMAAccessEnabled() const override;
+    Result<void> enableZeroCopy(bool enabled) override;
+    Result<void> enableDMAAccess(bool enabled, const std::string& device = "") override;
+    Result<void> setDMABufferSize(size_t size) override;
+    size_t getDMABufferSize() const override;
+    std::string getDMADevice() const override;
+    Result<void> allocateDMABuffers(size_t count) override;
+    Result<void> freeDMABuffers() override;
+
+    /**
+     * @brief Check if the replay is complete
+     * @return true once every loop has been read and all packets were consumed
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief Get the file format
+     * @return "pcap" or "pcapng", empty before initialize()
+     */
+    std::string getFileFormat() const;
+
+    /**
+     * @brief Get the link-layer type of the capture
+     * @return LINKTYPE_* value of the file (first interface for pcapng)
+     */
+    uint32_t getLinkType() const;
+
+private:
+    struct MappedFile;
+    class Reader;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> readerDone_;
+    bool initialized_;
+    bool zeroCopyEnabled_;
+    Config config_;
+    
+    std::shared_ptr<MappedFile> file_;
+    std::unique_ptr<Reader> reader_;
+    
+    std::thread readerThread_;
+    
+    std::unique_ptr<PacketQueue> packetQueue_;     ///< Created from the config in initialize()
+    
+    std::function<void(Packet)> packetCallback_;
+    std::mutex callbackMutex_;
+    
+    mutable std::mutex statsMutex_;
+    Statistics stats_;
+    
+    mutable std::mutex errorMutex_;
+    std::string lastError_;
+    
+    bool mapFile(const std::string& path);
+    void replayLoop();
+    Packet makePacket(const uint8_t* data, size_t length, std::chrono::steady_clock::time_point timestamp);
+    void deliver(std::vector<Packet>& batch);
+    void setLastError(const std::string& error);
+    
+    PcapFileBackend(const PcapFileBackend&) = delete;
+    PcapFileBackend& operator=(const PcapFileBackend&) = delete;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_PCAP_FILE_BACKEND_HPP
@@ -1,41 +1,159 @@
 #ifndef BEATRICE_PLUGINMANAGER_HPP
 #define BEATRICE_PLUGINMANAGER_HPP
 
+#include "EpochDomain.hpp"
 #include "IPacketPlugin.hpp"
+#include "Metrics.hpp"
+#include <array>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <vector>
 #include <string>
-#include <unordered_map>
 #include <dlfcn.h>
 
 namespace beatrice {
 
+// How often a plugin ended the chain early, by verdict
+struct PluginVerdictStats {
+    uint64_t dropped{0};
+    uint64_t stopped{0};
+    uint64_t forwarded{0};
+};
+
+// What happens to a plugin that exceeds its time budget
+enum class PluginBudgetAction : uint8_t {
+    Disable,    // stop calling the plugin until its budget is set again
+    Shed        // call it on half as many batches each time it is over budget
+};
+
+// Average time a plugin may spend per packet of traffic. Checked against the
+// sampled latency; with shedding, skipped packets count as free
+struct PluginBudget {
+    double maxNanosPerPacket{0.0};  // 0 means no budget
+    PluginBudgetAction action{PluginBudgetAction::Shed};
+};
+
+// Sampled latency of a plugin and the state of its budget
+struct PluginProfile {
+    uint64_t samples{0};
+    double averageNanosPerPacket{0.0};  // moving average over the samples
+    uint32_t shedLevel{0};              // plugin runs on 1 in 2^shedLevel calls
+    bool disabled{false};
+};
+
+// The active plugin chain is an immutable snapshot. Packet processing reads it
+// without a lock; load, unload and reload build a new snapshot, publish it and
+// only stop, destroy and dlclose a removed plugin once every thread that could
+// still see the old snapshot has left processPacket(s) (an epoch-based grace
+// period). Plugin lifecycle calls must not be made from inside a plugin.
 class PluginManager {
 public:
     PluginManager();
     ~PluginManager();
     
-    // Plugin lifecycle management
+    // Plugin lifecycle management, safe while packets are being processed
     bool loadPlugin(const std::string& path);
+    bool addPlugin(std::unique_ptr<IPacketPlugin> plugin);
     void unloadPlugin(const std::string& name);
-    void reloadPlugin(const std::string& name);
+    bool replacePlugin(const std::string& name, const std::string& path);
+    bool reloadPlugin(const std::string& name);
+    
+    // Packet processing, returns Continue if every plugin let the packet through
+    PluginVerdict processPacket(Packet& packet);
     
-    // Packet processing
-    void processPacket(Packet& packet);
-    void processPackets(const std::vector<Packet>& packets);
+    // Batch processing. verdicts must be as long as packets and receives the
+    // final verdict per packet. Packets that leave the chain early are moved
+    // behind the ones still travelling it, so the batch is reordered; packets[i]
+    // and verdicts[i] always stay paired
+    void processPackets(std::span<Packet> packets, std::span<PluginVerdict> verdicts);
     
     // Plugin information
     bool hasPlugin(const std::string& name) const;
     std::vector<std::string> getLoadedPluginNames() const;
     size_t getPluginCount() const;
+    PluginVerdictStats getVerdictStats(const std::string& name) const;
+    
+    // Profiling. One in interval processPacket(s) calls per thread is timed
+    // with the TSC and recorded into the plugin_<name>_latency_ns histogram
+    // of every plugin it runs; 0 turns profiling and budgets off
+    void setProfilingInterval(uint32_t interval);
+    uint32_t getProfilingInterval() const;
+    bool setPluginBudget(const std::string& name, const PluginBudget& budget);
+    PluginProfile getPluginProfile(const std::string& name) const;
     
     // Configuration
     void setMaxPlugins(size_t max);
     size_t getMaxPlugins() const;
-
+    
 private:
-    std::vector<std::unique_ptr<IPacketPlugin>> plugins_;
-    std::unordered_map<std::string, void*> handles_;
+    struct VerdictCounters {
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> stopped{0};
+        std::atomic<uint64_t> forwarded{0};
+    
+        void record(PluginVerdict verdict, uint64_t count = 1);
+    };
+    
+    struct ProfileState {
+        std::shared_ptr<Histogram> latency;
+        std::atomic<uint64_t> samples{0};
+        std::atomic<double> averageNanos{0.0};
+        std::atomic<double> budgetNanos{0.0};
+        std::atomic<PluginBudgetAction> action{PluginBudgetAction::Shed};
+        std::atomic<uint32_t> shedLevel{0};
+        std::atomic<bool> disabled{false};
+    };
+    
+    // A plugin together with the shared library it came from
+    struct LoadedPlugin {
+        std::unique_ptr<IPacketPlugin> plugin;
+        std::string name;
+        std::string path;            // empty for in-process plugins
+        void* handle{nullptr};       // nullptr for in-process plugins
+        VerdictCounters counters;
+        ProfileState profile;
+    
+        ~LoadedPlugin();
+    };
+    
+    // Immutable once published
+    struct PluginChain {
+        std::vector<std::shared_ptr<LoadedPlugin>> plugins;
+    };
+    
+    static constexpr uint32_t kMaxShedLevel = 10;
+    
+    // Pins the current chain for the duration of one processPacket(s) call
+    class ReadGuard {
+    public:
+        explicit ReadGuard(PluginManager& manager) : epoch_(manager.readers_), chain_(manager.chain_.load()) {}
+    
+        const PluginChain& chain() const { return *chain_; }
+    
+    private:
+        EpochDomain::Guard epoch_;
+        const PluginChain* chain_;
+    };
+    
+    std::shared_ptr<LoadedPlugin> openPlugin(const std::string& path);
+    bool startPlugin(LoadedPlugin& loaded);
+    void publish(std::unique_ptr<PluginChain> chain);
+    void retire(std::vector<std::shared_ptr<LoadedPlugin>> removed);
+    bool hasPluginLocked(const std::string& name) const;
+    LoadedPlugin* findPluginLocked(const std::string& name) const;
+    
+    static bool shouldRun(const LoadedPlugin& loaded, uint64_t tick);
+    static void recordSample(LoadedPlugin& loaded, uint64_t cycles, size_t packets);
+    static void reportBudgetAction(const LoadedPlugin& loaded, const std::string& action, double nanos);
+    
+    std::atomic<PluginChain*> chain_;
+    EpochDomain readers_;
+    std::atomic<uint32_t> profilingInterval_{64};
+    
+    // Serializes lifecycle changes, never taken on the packet path
+    mutable std::mutex writerMutex_;
     size_t maxPlugins_{10};
     
     // Disable copying
@@ -0,0 +1,194 @@
+#ifndef BEATRICE_PREFIX_TABLE_HPP
+#define BEATRICE_PREFIX_TABLE_HPP
+
+#include "beatrice/Error.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace beatrice {
+
+/**
+ * @brief Longest-prefix-match table for large IPv4 and IPv6 prefix lists
+ *
+ * Each address family is a Poptrie: a 2^16 entry direct table for the top
+ * 16 bits, then nodes of 6 bit stride whose children and leaves are packed
+ * and indexed by popcount. IPv4 lookups touch at most four nodes, IPv6
+ * lookups at most twenty, whatever the number of prefixes.
+ *
+ * A table is immutable once built. Reloads build a new table next to the
+ * running one, typically on a control thread, and swap it in; lookups on
+ * the old table carry on meanwhile.
+ */
+class PrefixTable {
+public:
+    /**
+     * @brief One prefix with its tag, e.g. "10.0.0.0/8 customer-a"
+     */
+    struct Prefix {
+        std::array<uint8_t, 16> address{};  ///< Network order, IPv4 in the first four bytes
+        uint8_t length = 0;
+        bool ipv6 = false;
+        std::string tag;
+    };
+
+    /**
+     * @brief Longest prefix covering a looked up address
+     *
+     * The tag points into the table and stays valid as long as the table.
+     */
+    struct Match {
+        std::string_view tag;
+        uint8_t prefixLength = 0;
+    };
+
+    /**
+     * @brief An empty table, every lookup misses
+     */
+    PrefixTable();
+
+    /**
+     * @brief Parse "ADDR[/LEN]", IPv4 or IPv6, host bits are cleared
+     * @return The prefix, or INVALID_ARGUMENT
+     */
+    static Result<Prefix> parsePrefix(const std::string& text, const std::string& tag = "");
+
+    /**
+     * @brief Build a table, a prefix listed twice keeps its last tag
+     */
+    static Result<PrefixTable> build(const std::vector<Prefix>& prefixes);
+
+    /**
+     * @brief Build a table from a prefix list file
+     *
+     * One "PREFIX [TAG]" per line; blank lines and text after '#' are
+     * ignored. Prefixes without a tag get defaultTag.
+     *
+     * @return The table, RESOURCE_UNAVAILABLE if the file cannot be read or
+     *         INVALID_ARGUMENT naming the first bad line
+     */
+    static Result<PrefixTable> loadFile(const std::string& path, const std::string& defaultTag = "");
+
+    /**
+     * @brief Build the table that results from a bulk change
+     *
+     * This table is left untouched, so lookups can keep using it until the
+     * new one is published.
+     *
+     * @param additions Prefixes to add or retag
+     * @param removals Prefixes to drop, tags are ignored
+     */
+    Result<PrefixTable> update(const std::vector<Prefix>& additions,
+                               const std::vector<Prefix>& removals) const;
+
+    /**
+     * @brief Look up an IPv4 address given in host order
+     */
+    std::optional<Match> lookupV4(uint32_t address) const noexcept {
+        return toMatch(lookup(v4_, static_cast<Key>(address) << 96));
+    }
+
+    /**
+     * @brief Look up an IPv6 address, 16 bytes in network order
+     */
+    std::optional<Match> lookupV6(const uint8_t* address) const noexcept {
+        Key key = 0;
+        for (size_t i = 0; i < 16; ++i) {
+            key = key << 8 | address[i];
+        }
+        return toMatch(lookup(v6_, key));
+    }
+
+    size_t size() const noexcept { return prefixes_.size(); }
+    bool empty() const noexcept { return prefixes_.empty(); }
+
+    /**
+     * @brief Bytes used by the lookup structures
+     */
+    size_t memoryUsage() const noexcept;
+
+    /**
+     * @brief The prefixes the table was built from, sorted
+     */
+    std::vector<Prefix> prefixes() const;
+
+private:
+    __extension__ typedef unsigned __int128 Key;
+
+    static constexpr unsigned kDirectBits = 16;
+    static constexpr unsigned kStride = 6;
+    static constexpr uint32_t kLeafFlag = 0x80000000u;
+
+    // Poptrie node: bit i of vector marks a child in slot i, leafvec marks
+    // where a run of equal leaves starts among the other slots
+    struct Node {
+        uint64_t vector = 0;
+        uint64_t leafvec = 0;
+        uint32_t base0 = 0;                  // first leaf in leaves
+        uint32_t base1 = 0;                  // first child in nodes
+    };
+
+    struct Trie {
+        std::vector<uint32_t> direct;        // leaf | kLeafFlag, or root node index
+        std::vector<Node> nodes;
+        std::vector<uint32_t> leaves;        // 0 for no match, else result index + 1
+    };
+
+    // Source prefix, address left-aligned in the key
+    struct Entry {
+        Key key = 0;
+        uint8_t length = 0;
+        bool ipv6 = false;
+        uint32_t tag = 0;
+    };
+
+    // What a leaf resolves to, shared by every prefix with the same tag and length
+    struct LeafResult {
+        uint32_t tag = 0;
+        uint8_t prefixLength = 0;
+    };
+
+    struct Builder;
+
+    static uint32_t lookup(const Trie& trie, Key key) noexcept {
+        if (trie.direct.empty()) {
+            return 0;
+        }
+        uint32_t slot = trie.direct[static_cast<uint32_t>(key >> (128 - kDirectBits))];
+        if (slot & kLeafFlag) {
+            return slot & ~kLeafFlag;
+        }
+
+        unsigned offset = kDirectBits;
+        const Node* node = &trie.nodes[slot];
+        unsigned index = static_cast<unsigned>((key << offset) >> (128 - kStride));
+        while (node->vector & (uint64_t{1} << index)) {
+            node = &trie.nodes[node->base1 + __builtin_popcountll(node->vector << (63 - index)) - 1];
+            offset += kStride;
+            index = static_cast<unsigned>((key << offset) >> (128 - kStride));
+        }
+        return trie.leaves[node->base0 + __builtin_popcountll(node->leafvec << (63 - index)) - 1];
+    }
+
+    std::optional<Match> toMatch(uint32_t leaf) const noexcept {
+        if (leaf == 0) {
+            return std::nullopt;
+        }
+        const LeafResult& result = results_[leaf - 1];
+        return Match{tags_[result.tag], result.prefixLength};
+    }
+
+    Trie v4_;
+    Trie v6_;
+    std::vector<Entry> prefixes_;            // sorted by family, key, length
+    std::vector<std::string> tags_;
+    std::vector<LeafResult> results_;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_PREFIX_TABLE_HPP
@@ -0,0 +1,126 @@
+#ifndef BEATRICE_SYNTHETIC_BACKEND_HPP
+#define BEATRICE_SYNTHETIC_BACKEND_HPP
+
+#include "beatrice/ICaptureBackend.hpp"
+#include "beatrice/PacketQueue.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beatrice {
+
+/**
+ * @brief Capture backend that generates traffic instead of receiving it
+ *
+ * All frames are built up front from the synthetic* fields of the Config:
+ * per-flow Ethernet/IPv4/TCP|UDP|ICMP headers with valid checksums, optional
+ * 802.1Q tag and VXLAN or GRE tunnel, payload padding drawn from the size
+ * distribution. The templates live in one arena and generated packets share
+ * it, so the generator thread only hands out references and a run is fully
+ * reproducible from syntheticSeed.
+ *
+ * With syntheticRatePps set the generator paces itself and drops like a NIC
+ * when consumers fall behind. Unthrottled, it blocks on a full queue instead,
+ * keeping the pipeline saturated without losing packets. Needs neither a NIC
+ * nor privileges.
+ */
+class SyntheticBackend : public ICaptureBackend {
+public:
+    SyntheticBackend();
+    ~SyntheticBackend();
+
+    Result<void> initialize(const Config& config) override;
+    Result<void> start() override;
+    Result<void> stop() override;
+    bool isRunning() const noexcept override;
+    std::optional<Packet> nextPacket(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
+    std::vector<Packet> getPackets(size_t maxPackets = 64, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) override;
+    using ICaptureBackend::getPackets;  ///< Keep the per-queue overload visible
+    void setPacketCallback(std::function<void(Packet)> callback) override;
+    void removePacketCallback() override;
+    Statistics getStatistics() const override;
+    void resetStatistics() override;
+    std::string getName() const override;
+    std::string getVersion() const override;
+    std::vector<std::string> getSupportedFeatures() const override;
+    bool isFeatureSupported(const std::string& feature) const override;
+    Config getConfig() const override;
+    Result<void> updateConfig(const Config& config) override;
+    std::string getLastError() const override;
+    bool isHealthy() const override;
+    Result<void> healthCheck() override;
+
+    // Zero-copy DMA access methods
+    bool isZeroCopyEnabled() const override;
+    bool isDMAAccessEnabled() const override;
+    Result<void> enableZeroCopy(bool enabled) override;
+    Result<void> enableDMAAccess(bool enabled, const std::string& device = "") override;
+    Result<void> setDMABufferSize(size_t size) override;
+    size_t getDMABufferSize() const override;
+    std::string getDMADevice() const override;
+    Result<void> allocateDMABuffers(size_t count) override;
+    Result<void> freeDMABuffers() override;
+
+    /**
+     * @brief Check if generation is complete
+     * @return true once syntheticPacketLimit packets were generated and consumed
+     */
+    bool isFinished() const;
+
+    /**
+     * @brief Get number of prebuilt frames
+     * @return Template count, 0 before initialize()
+     */
+    size_t getTemplateCount() const;
+
+    /**
+     * @brief Get mean frame length of the template set
+     * @return Average frame length in bytes
+     */
+    double getAverageFrameSize() const;
+
+private:
+    struct Template {
+        size_t offset;      ///< Start of the frame in the arena
+        size_t length;      ///< Frame length in bytes
+    };
+
+    std::atomic<bool> running_;
+    std::atomic<bool> generatorDone_;
+    bool initialized_;
+    bool zeroCopyEnabled_;
+    Config config_;
+
+    std::shared_ptr<uint8_t[]> arena_;
+    std::vector<Template> templates_;
+
+    std::thread generatorThread_;
+
+    std::unique_ptr<PacketQueue> packetQueue_;     ///< Created from the config in initialize()
+
+    std::function<void(Packet)> packetCallback_;
+    std::mutex callbackMutex_;
+
+    mutable std::mutex statsMutex_;
+    Statistics stats_;
+
+    mutable std::mutex errorMutex_;
+    std::string lastError_;
+
+    Result<void> buildTemplates();
+    void generatorLoop();
+    Packet makePacket(const Template& frame, std::chrono::steady_clock::time_point timestamp) const;
+    void deliver(std::vector<Packet>& batch);
+    void setLastError(const std::string& error);
+
+    SyntheticBackend(const SyntheticBackend&) = delete;
+    SyntheticBackend& operator=(const SyntheticBackend&) = delete;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_SYNTHETIC_BACKEND_HPP
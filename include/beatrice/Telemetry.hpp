@@ -42,6 +42,7 @@ public:
         BACKEND_ERROR,
         PLUGIN_LOADED,
         PLUGIN_ERROR,
+        PLUGIN_BUDGET_EXCEEDED,
         PERFORMANCE_MEASUREMENT,
         SYSTEM_HEALTH_CHECK,
         CUSTOM
@@ -0,0 +1,187 @@
+#ifndef BEATRICE_UMEM_FRAME_ALLOCATOR_HPP
+#define BEATRICE_UMEM_FRAME_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace beatrice {
+
+class Counter;
+class Gauge;
+
+/**
+ * @brief Free-list and ownership tracker for the frames of an AF_XDP UMEM slice
+ *
+ * Every frame is in exactly one place at a time: on the free-list, with the
+ * kernel (fill ring or RX in flight), held by the application, or queued for
+ * transmit until it shows up on the completion ring. Transitions are checked,
+ * so a frame can never be posted to the fill ring while a packet still points
+ * at it; a transition from the wrong state is counted and ignored instead of
+ * corrupting the ring.
+ *
+ * Only the socket worker thread (the owner) may call allocate(), onReceive(),
+ * submitTx() and onCompletion(). release() may be called from any thread and
+ * hands the frame back to the owner through a lock-free stack.
+ *
+ * Free and in-flight frames are exported as the `<name>_free_frames` and
+ * `<name>_application_frames` gauges, fill ring starvation as the
+ * `<name>_starvation_total` counter.
+ */
+class UmemFrameAllocator {
+public:
+    /**
+     * @brief Owner of a frame
+     */
+    enum class FrameState : uint8_t {
+        FREE,           ///< On the free-list
+        KERNEL,         ///< Posted to the fill ring or being received into
+        APPLICATION,    ///< Delivered through the RX ring, referenced by packets
+        TX              ///< Posted to the TX ring, waiting for completion
+    };
+
+    /**
+     * @brief Allocator statistics
+     */
+    struct Statistics {
+        size_t frameCount = 0;         ///< Frames in this slice
+        size_t frameSize = 0;          ///< Size of each frame in bytes
+        size_t free = 0;               ///< Frames on the free-list
+        size_t kernel = 0;             ///< Frames owned by the kernel
+        size_t application = 0;        ///< Frames held by the application
+        size_t tx = 0;                 ///< Frames waiting for TX completion
+        uint64_t allocated = 0;        ///< Frames handed to the fill ring
+        uint64_t starvations = 0;      ///< Times the kernel ran out of frames
+        uint64_t ownershipErrors = 0;  ///< Rejected transitions (double release, stray address)
+    };
+
+    /**
+     * @brief Create an allocator for a contiguous slice of a UMEM
+     * @param baseAddr UMEM offset of the first frame
+     * @param frameCount Number of frames in the slice
+     * @param frameSize Size of each frame in bytes
+     * @param name Metric name prefix, metrics are skipped if empty
+     * @param umem Optional handle that keeps the UMEM mapped while frames are referenced
+     * @return Shared pointer to the allocator, nullptr on invalid arguments
+     */
+    static std::shared_ptr<UmemFrameAllocator> create(uint64_t baseAddr, size_t frameCount, size_t frameSize,
+                                                      const std::string& name = "",
+                                                      std::shared_ptr<void> umem = nullptr);
+
+    ~UmemFrameAllocator();
+
+    UmemFrameAllocator(const UmemFrameAllocator&) = delete;
+    UmemFrameAllocator& operator=(const UmemFrameAllocator&) = delete;
+
+    /**
+     * @brief Take free frames for the fill ring (owner thread only)
+     * @param addrs Output array of frame addresses
+     * @param maxFrames Capacity of addrs
+     * @return Number of frames written, now owned by the kernel
+     */
+    size_t allocate(uint64_t* addrs, size_t maxFrames);
+
+    /**
+     * @brief Record a frame coming out of the RX ring (owner thread only)
+     * @param addr Descriptor address, may include a headroom offset
+     * @return true if the frame was owned by the kernel
+     */
+    bool onReceive(uint64_t addr);
+
+    /**
+     * @brief Return a received frame once the application is done with it
+     * @param addr Any address inside the frame
+     *
+     * Safe to call from any thread.
+     */
+    void release(uint64_t addr) noexcept;
+
+    /**
+     * @brief Record a received frame being posted to the TX ring (owner thread only)
+     * @param addr Any address inside the frame
+     * @return true if the frame was held by the application
+     */
+    bool submitTx(uint64_t addr);
+
+    /**
+     * @brief Record a frame read from the completion ring (owner thread only)
+     * @param addr Any address inside the frame
+     */
+    void onCompletion(uint64_t addr);
+
+    /**
+     * @brief Get the owner of a frame
+     * @param addr Any address inside the frame
+     * @return Current frame state, FREE for addresses outside the slice
+     */
+    FrameState state(uint64_t addr) const;
+
+    /**
+     * @brief Get number of free frames
+     * @return Frames available to allocate()
+     */
+    size_t freeFrames() const noexcept { return free_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get number of frames in the slice
+     * @return Frame count
+     */
+    size_t frameCount() const noexcept { return frameCount_; }
+
+    /**
+     * @brief Get frame size
+     * @return Size of each frame in bytes
+     */
+    size_t frameSize() const noexcept { return frameSize_; }
+
+    /**
+     * @brief Get allocator statistics
+     * @return Current statistics
+     */
+    Statistics getStatistics() const;
+
+    /**
+     * @brief Refresh the frame gauges
+     */
+    void publishMetrics();
+
+private:
+    UmemFrameAllocator(uint64_t baseAddr, size_t frameCount, size_t frameSize,
+                       const std::string& name, std::shared_ptr<void> umem);
+
+    static constexpr uint32_t kNoFrame = UINT32_MAX;
+
+    bool frameIndex(uint64_t addr, uint32_t& index) const noexcept;
+    bool transition(uint32_t index, FrameState from, FrameState to) noexcept;
+    void pushLocal(uint32_t index) noexcept;
+
+    uint64_t baseAddr_;
+    size_t frameCount_;
+    size_t frameSize_;
+    std::string name_;
+    std::shared_ptr<void> umem_;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> states_;
+    std::unique_ptr<uint32_t[]> next_;                       ///< Free-list links, one per frame
+
+    uint32_t localFree_{kNoFrame};                           ///< Owner-only free list
+    alignas(64) std::atomic<uint32_t> remoteFree_{kNoFrame}; ///< Frames released by any thread
+    alignas(64) std::atomic<size_t> free_{0};
+    std::atomic<size_t> kernel_{0};
+    std::atomic<size_t> application_{0};
+    std::atomic<size_t> tx_{0};
+    std::atomic<uint64_t> allocated_{0};
+    std::atomic<uint64_t> starvations_{0};
+    mutable std::atomic<uint64_t> ownershipErrors_{0};
+    bool starved_{false};
+
+    std::shared_ptr<Gauge> freeGauge_;
+    std::shared_ptr<Gauge> applicationGauge_;
+    std::shared_ptr<Counter> starvationCounter_;
+};
+
+} // namespace beatrice
+
+#endif // BEATRICE_UMEM_FRAME_ALLOCATOR_HPP
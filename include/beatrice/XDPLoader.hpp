@@ -5,7 +5,10 @@
 #include <optional>
 #include <string>
 #include <memory>
+#include <utility>
 #include <vector>
+#include <mutex>
+#include <cstdint>
 
 namespace beatrice {
 
@@ -28,6 +31,36 @@ public:
         bool forceReload = false;        ///< Force program reload
         std::string pinPath = "/sys/fs/bpf"; ///< BPF filesystem path
         int priority = 0;                ///< XDP program priority
+        uint32_t maxQueues = 64;         ///< XSKMAP entries, one per NIC RX queue
+    };
+
+    /**
+     * @brief Allow-lists the XDP program consults before redirecting
+     *
+     * An IPv4 packet is redirected only if it passes every enabled table:
+     * its protocol, its source or destination network, and its TCP/UDP
+     * source or destination port. Packets failing a table are dropped in
+     * the driver. Non-IPv4 traffic is never filtered.
+     */
+    struct FilterRules {
+        bool matchProtocols = false;     ///< Enable the protocol table
+        std::vector<uint8_t> protocols;  ///< Allowed IPv4 protocol numbers
+        bool matchNetworks = false;      ///< Enable the network table
+        std::vector<std::pair<uint32_t, uint8_t>> networks; ///< Allowed prefixes, host byte order, with length
+        bool matchPorts = false;         ///< Enable the port table
+        std::vector<std::pair<uint16_t, uint16_t>> portRanges; ///< Allowed ports, inclusive ranges
+
+        bool empty() const noexcept { return !matchProtocols && !matchNetworks && !matchPorts; }
+    };
+
+    /**
+     * @brief Filter maps of a program, -1 if the program has none
+     */
+    struct FilterMaps {
+        int rules = -1;                  ///< Two rule tables, one live and one being written
+        int active = -1;                 ///< Index of the live rule table
+        int networks = -1;               ///< LPM trie of allowed IPv4 networks
+        int stats = -1;                  ///< Per-CPU count of filtered packets
     };
 
     /**
@@ -35,7 +68,8 @@ public:
      */
     struct ProgramInfo {
         int programFd;                   ///< Program file descriptor
-        int mapFd;                       ///< Map file descriptor
+        int mapFd;                       ///< XSKMAP file descriptor, indexed by RX queue
+        FilterMaps filterMaps;           ///< Rule tables of the generic program
         std::string programName;         ///< Program name
         std::string interface;           ///< Attached interface
         bool isAttached;                 ///< Whether program is attached
@@ -75,6 +109,48 @@ public:
      */
     Result<void> unloadProgram(const std::string& programName);
 
+    /**
+     * @brief Redirect an RX queue to an AF_XDP socket
+     *
+     * Stores the socket in the program's XSKMAP under the queue index, so
+     * packets arriving on that queue are redirected to it.
+     *
+     * @param programName Program name
+     * @param queueId NIC RX queue index
+     * @param xskFd AF_XDP socket file descriptor
+     * @return Result indicating success or failure
+     */
+    Result<void> registerXskSocket(const std::string& programName, uint32_t queueId, int xskFd);
+
+    /**
+     * @brief Stop redirecting an RX queue
+     * @param programName Program name
+     * @param queueId NIC RX queue index
+     * @return Result indicating success or failure
+     */
+    Result<void> unregisterXskSocket(const std::string& programName, uint32_t queueId);
+
+    /**
+     * @brief Replace the filter rules of a program
+     *
+     * The rules are written to the idle rule table, which then becomes the
+     * live one, so the data path never sees a half-written table. New
+     * networks are added before the switch and stale ones removed after it;
+     * during an update packets are only ever let through, never dropped.
+     *
+     * @param programName Program name
+     * @param rules Rules to install, empty rules let everything through
+     * @return Result indicating success or failure
+     */
+    Result<void> setFilterRules(const std::string& programName, const FilterRules& rules);
+
+    /**
+     * @brief Get packets dropped by the filter rules of a program
+     * @param programName Program name
+     * @return Packets dropped on all CPUs, 0 if the program has no filter maps
+     */
+    uint64_t getFilteredPacketCount(const std::string& programName) const;
+
     /**
      * @brief Get loaded program information
      * @param programName Program name
@@ -109,8 +185,9 @@ public:
 
 private:
     // BPF program management
-    Result<int> loadBpfProgram(const std::string& programPath, const std::string& programName);
-    Result<int> createBpfMap();
+    Result<int> loadBpfProgram(const std::string& programPath, const std::string& programName, int& xskMapFd,
+                               FilterMaps& filterMaps);
+    Result<int> createBpfMap(uint32_t maxEntries);
     Result<void> pinProgram(const std::string& programName, int programFd);
     Result<void> pinMap(const std::string& mapName, int mapFd);
     
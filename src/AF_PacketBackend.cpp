@@ -1,8 +1,11 @@
 #include "beatrice/AF_PacketBackend.hpp"
 #include "beatrice/Logger.hpp"
 #include "beatrice/Error.hpp"
+#include "beatrice/PacketQueue.hpp"
+#include "beatrice/PacketFilter.hpp"
 #include <chrono>
 #include <algorithm>
+#include <iterator>
 #include <sys/socket.h>
 #include <linux/if_packet.h>
 #include <linux/if_ether.h>
@@ -13,14 +16,103 @@
 #include <cstring>
 #include <arpa/inet.h>
 #include <sys/mman.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 
 namespace beatrice {
 
+/**
+ * @brief One AF_PACKET socket with its receive thread, ring and queue
+ *
+ * Without fanout there is exactly one; with fanout every member of the
+ * PACKET_FANOUT group is independent so receive threads and consumers of
+ * different sockets never share a lock. The receive thread is the only
+ * producer of its queue, consumers may be several threads.
+ */
+struct AF_PacketBackend::RxSocket {
+    RxSocket(size_t socketIndex, const Config& config)
+        : index(socketIndex)
+        , queue(config, OverflowPolicy::DROP_NEWEST,
+                "af_packet_" + config.interface + "_rx" + std::to_string(socketIndex)) {
+    }
+    
+    size_t index = 0;
+    int fd = -1;
+    
+    // TPACKET_V3 RX ring
+    uint8_t* ring = nullptr;
+    size_t ringSize = 0;
+    
+    std::thread thread;
+    
+    PacketQueue queue;
+    
+    mutable std::mutex statsMutex;
+    Statistics stats;
+    
+    // Last PACKET_STATISTICS read by the receive thread
+    std::chrono::steady_clock::time_point kernelStatsRead;
+};
+
+namespace {
+
+// How often a busy receive thread collects the kernel's drop counter
+constexpr auto kKernelStatsInterval = std::chrono::milliseconds(100);
+
+// Kernel receive time of a ring frame, moved onto the steady clock packets use
+std::chrono::steady_clock::time_point toSteadyTime(const struct tpacket3_hdr& hdr,
+                                                   std::chrono::steady_clock::time_point steadyNow,
+                                                   std::chrono::system_clock::time_point realNow) {
+    const auto received = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::seconds(hdr.tp_sec) + std::chrono::nanoseconds(hdr.tp_nsec)));
+    if (received >= realNow) {
+        return steadyNow;
+    }
+    return steadyNow - std::chrono::duration_cast<std::chrono::steady_clock::duration>(realNow - received);
+}
+
+} // anonymous namespace
+
+std::optional<uint16_t> AF_PacketBackend::fanoutGroup(size_t socketCount, uint16_t configured, pid_t processId) {
+    if (socketCount <= 1) {
+        return std::nullopt;
+    }
+    if (configured != 0) {
+        return configured;
+    }
+    // Group ids are system wide, keep concurrent captures apart
+    return static_cast<uint16_t>(processId & 0xffff);
+}
+
+int AF_PacketBackend::fanoutArgument(uint16_t fanoutGroup, FanoutMode mode) {
+    int type = PACKET_FANOUT_HASH;
+    switch (mode) {
+        case FanoutMode::CPU:
+            type = PACKET_FANOUT_CPU;
+            break;
+        case FanoutMode::LOAD_BALANCE:
+            type = PACKET_FANOUT_LB;
+            break;
+        case FanoutMode::ROLLOVER:
+            type = PACKET_FANOUT_ROLLOVER;
+            break;
+        case FanoutMode::HASH:
+        default:
+            // Reassemble fragments first so all of them hash to the same socket
+            type = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+            break;
+    }
+    return fanoutGroup | (type << 16);
+}
+
 AF_PacketBackend::AF_PacketBackend()
     : running_(false)
     , initialized_(false)
     , config_()
-    , socketFd_(-1)
+    , sockets_()
+    , nextQueue_(0)
     , promiscuousMode_(true)
     , bufferSize_(65536)
     , blockingMode_(false)
@@ -31,14 +123,8 @@ AF_PacketBackend::AF_PacketBackend()
     , dmaBuffers_(nullptr)
     , dmaBufferCount_(0)
     , dmaFd_(-1)
-    , processingThread_()
-    , packetQueue_()
-    , packetQueueMutex_()
-    , packetCondition_()
     , packetCallback_(nullptr)
     , callbackMutex_()
-    , statsMutex_()
-    , stats_()
     , errorMutex_()
     , lastError_() {
 }
@@ -58,16 +144,23 @@ Result<void> AF_PacketBackend::initialize(const Config& config) {
         return Result<void>::error(beatrice::ErrorCode::INVALID_ARGUMENT, "Invalid interface: " + config_.interface);
     }
 
-    if (!createSocket()) {
-        return Result<void>::error(beatrice::ErrorCode::INITIALIZATION_FAILED, "Failed to create AF_PACKET socket");
-    }
+    const size_t socketCount = std::max<size_t>(config_.fanoutSockets, 1);
+    const std::optional<uint16_t> group = fanoutGroup(socketCount, config_.fanoutGroupId, getpid());
 
-    if (!bindToInterface()) {
-        return Result<void>::error(beatrice::ErrorCode::INITIALIZATION_FAILED, "Failed to bind to interface");
+    for (size_t i = 0; i < socketCount; ++i) {
+        auto sock = std::make_unique<RxSocket>(i, config_);
+        sockets_.push_back(std::move(sock));
+        
+        if (!openSocket(*sockets_.back(), group)) {
+            std::string error = getLastError();
+            shutdown();
+            return Result<void>::error(beatrice::ErrorCode::INITIALIZATION_FAILED,
+                                       "Failed to set up AF_PACKET socket " + std::to_string(i) + ": " + error);
+        }
     }
 
-    if (!setSocketOptions()) {
-        return Result<void>::error(beatrice::ErrorCode::INITIALIZATION_FAILED, "Failed to set socket options");
+    if (group) {
+        BEATRICE_INFO("AF_PACKET fanout group {} ready with {} sockets on {}", *group, socketCount, config_.interface);
     }
 
     initialized_ = true;
@@ -84,7 +177,18 @@ Result<void> AF_PacketBackend::start() {
     }
 
     running_ = true;
-    processingThread_ = std::thread(&AF_PacketBackend::packetProcessingLoop, this);
+    for (auto& sock : sockets_) {
+        RxSocket& rx = *sock;
+        rx.queue.open();
+        rx.thread = std::thread([this, &rx]() {
+            pinThread(rx.index);
+            if (rx.ring) {
+                ringProcessingLoop(rx);
+            } else {
+                packetProcessingLoop(rx);
+            }
+        });
+    }
 
     return Result<void>::success();
 }
@@ -95,10 +199,14 @@ Result<void> AF_PacketBackend::stop() {
     }
 
     running_ = false;
-    packetCondition_.notify_all();
+    for (auto& sock : sockets_) {
+        sock->queue.close();
+    }
 
-    if (processingThread_.joinable()) {
-        processingThread_.join();
+    for (auto& sock : sockets_) {
+        if (sock->thread.joinable()) {
+            sock->thread.join();
+        }
     }
 
     return Result<void>::success();
@@ -109,30 +217,52 @@ bool AF_PacketBackend::isRunning() const noexcept {
 }
 
 std::optional<Packet> AF_PacketBackend::nextPacket(std::chrono::milliseconds timeout) {
-    std::unique_lock<std::mutex> lock(packetQueueMutex_);
-    
-    if (packetCondition_.wait_for(lock, timeout, [this] { return !packetQueue_.empty(); })) {
-        if (!packetQueue_.empty()) {
-            Packet packet = packetQueue_.front();
-            packetQueue_.pop();
-            return packet;
-        }
+    auto packets = getPackets(1, timeout);
+    if (packets.empty()) {
+        return std::nullopt;
     }
-    
-    return std::nullopt;
+    return std::move(packets.front());
 }
 
 std::vector<Packet> AF_PacketBackend::getPackets(size_t maxPackets, std::chrono::milliseconds timeout) {
-    std::vector<Packet> packets;
-    std::unique_lock<std::mutex> lock(packetQueueMutex_);
+    if (sockets_.empty()) {
+        return {};
+    }
     
-    if (packetCondition_.wait_for(lock, timeout, [this] { return !packetQueue_.empty(); })) {
-        while (!packetQueue_.empty() && packets.size() < maxPackets) {
-            packets.push_back(packetQueue_.front());
-            packetQueue_.pop();
-        }
+    if (sockets_.size() == 1) {
+        return drainQueue(*sockets_.front(), maxPackets, timeout);
+    }
+    
+    // Shared consumers rotate over the fanout queues; dedicated consumers
+    // should use getPackets(queueId, ...) instead
+    const size_t start = nextQueue_.fetch_add(1, std::memory_order_relaxed) % sockets_.size();
+    std::vector<Packet> packets;
+    for (size_t i = 0; i < sockets_.size() && packets.size() < maxPackets; ++i) {
+        auto more = drainQueue(*sockets_[(start + i) % sockets_.size()], maxPackets - packets.size(),
+                               std::chrono::milliseconds(0));
+        std::move(more.begin(), more.end(), std::back_inserter(packets));
     }
     
+    if (packets.empty()) {
+        return drainQueue(*sockets_[start], maxPackets, timeout);
+    }
+    return packets;
+}
+
+size_t AF_PacketBackend::getQueueCount() const {
+    return sockets_.size();
+}
+
+std::vector<Packet> AF_PacketBackend::getPackets(size_t queueId, size_t maxPackets, std::chrono::milliseconds timeout) {
+    if (queueId >= sockets_.size()) {
+        return {};
+    }
+    return drainQueue(*sockets_[queueId], maxPackets, timeout);
+}
+
+std::vector<Packet> AF_PacketBackend::drainQueue(RxSocket& sock, size_t maxPackets, std::chrono::milliseconds timeout) {
+    std::vector<Packet> packets;
+    sock.queue.pop(packets, maxPackets, timeout);
     return packets;
 }
 
@@ -146,14 +276,58 @@ void AF_PacketBackend::removePacketCallback() {
     packetCallback_ = nullptr;
 }
 
+Result<void> AF_PacketBackend::setKernelFilter(const PacketFilter& filter) {
+    kernelFilter_ = filter.compileSocketFilter();
+
+    for (auto& sock : sockets_) {
+        if (sock->fd < 0) {
+            continue;
+        }
+        auto result = kernelFilter_.empty() ? BpfProgram::detachFromSocket(sock->fd)
+                                            : kernelFilter_.attachToSocket(sock->fd);
+        if (result.isError()) {
+            setLastError(result.getErrorMessage());
+            return result;
+        }
+    }
+
+    if (kernelFilter_.empty()) {
+        BEATRICE_INFO("No filters to offload on {}, filtering stays in user space", config_.interface);
+    } else {
+        BEATRICE_INFO("Socket filter on {}: {} ({} instructions)", config_.interface,
+                      kernelFilter_.expression(), kernelFilter_.instructions().size());
+    }
+    return Result<void>::success();
+}
+
 AF_PacketBackend::Statistics AF_PacketBackend::getStatistics() const {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    return stats_;
+    Statistics total;
+    for (const auto& sock : sockets_) {
+        if (running_) {
+            updateKernelStatistics(*sock);
+        }
+        
+        std::lock_guard<std::mutex> lock(sock->statsMutex);
+        total.packetsCaptured += sock->stats.packetsCaptured;
+        total.packetsDropped += sock->stats.packetsDropped;
+        total.bytesCaptured += sock->stats.bytesCaptured;
+        total.bytesDropped += sock->stats.bytesDropped;
+        total.lastUpdate = std::max(total.lastUpdate, sock->stats.lastUpdate);
+        
+        const auto queueStats = sock->queue.getStatistics();
+        total.packetsDropped += queueStats.dropped;
+        total.bytesDropped += queueStats.bytesDropped;
+        total.queueHighWatermark = std::max(total.queueHighWatermark, queueStats.highWatermark);
+    }
+    return total;
 }
 
 void AF_PacketBackend::resetStatistics() {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    stats_ = Statistics{};
+    for (auto& sock : sockets_) {
+        std::lock_guard<std::mutex> lock(sock->statsMutex);
+        sock->stats = Statistics{};
+        sock->queue.resetStatistics();
+    }
 }
 
 std::string AF_PacketBackend::getName() const {
@@ -171,7 +345,11 @@ std::vector<std::string> AF_PacketBackend::getSupportedFeatures() const {
         "Configurable buffer size",
         "Blocking/non-blocking mode",
         "Real-time packet processing",
-        "Statistics collection"
+        "Statistics collection",
+        "Pooled packet buffers",
+        "TPACKET_V3 RX ring",
+        "PACKET_FANOUT",
+        "Kernel socket filter"
     };
 }
 
@@ -199,7 +377,10 @@ std::string AF_PacketBackend::getLastError() const {
 }
 
 bool AF_PacketBackend::isHealthy() const {
-    return initialized_ && socketFd_ >= 0;
+    if (!initialized_ || sockets_.empty()) {
+        return false;
+    }
+    return std::all_of(sockets_.begin(), sockets_.end(), [](const auto& sock) { return sock->fd >= 0; });
 }
 
 Result<void> AF_PacketBackend::healthCheck() {
@@ -207,7 +388,7 @@ Result<void> AF_PacketBackend::healthCheck() {
         return Result<void>::error(beatrice::ErrorCode::INITIALIZATION_FAILED, "Backend not initialized");
     }
 
-    if (socketFd_ < 0) {
+    if (!isHealthy()) {
         return Result<void>::error(beatrice::ErrorCode::INITIALIZATION_FAILED, "Socket not valid");
     }
 
@@ -258,17 +439,47 @@ bool AF_PacketBackend::validateInterface(const std::string& interface) {
     return !interface.empty() && interface.length() < IFNAMSIZ;
 }
 
-bool AF_PacketBackend::createSocket() {
-    socketFd_ = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
-    if (socketFd_ < 0) {
-        std::lock_guard<std::mutex> lock(errorMutex_);
-        lastError_ = "Failed to create AF_PACKET socket: " + std::string(strerror(errno));
+bool AF_PacketBackend::openSocket(RxSocket& sock, std::optional<uint16_t> fanoutGroup) {
+    if (!createSocket(sock)) {
+        return false;
+    }
+
+    // Filter before binding so no unfiltered packet is queued
+    if (!kernelFilter_.empty()) {
+        auto attached = kernelFilter_.attachToSocket(sock.fd);
+        if (attached.isError()) {
+            setLastError(attached.getErrorMessage());
+            return false;
+        }
+    }
+
+    // The ring has to be configured before the socket is bound
+    if (config_.enableRxRing && !setupRxRing(sock)) {
+        return false;
+    }
+
+    if (!bindToInterface(sock)) {
+        return false;
+    }
+
+    // Fanout membership requires a bound socket
+    if (fanoutGroup && !joinFanoutGroup(sock, *fanoutGroup)) {
+        return false;
+    }
+
+    return setSocketOptions(sock);
+}
+
+bool AF_PacketBackend::createSocket(RxSocket& sock) {
+    sock.fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (sock.fd < 0) {
+        setLastError("Failed to create AF_PACKET socket: " + std::string(strerror(errno)));
         return false;
     }
     return true;
 }
 
-bool AF_PacketBackend::bindToInterface() {
+bool AF_PacketBackend::bindToInterface(RxSocket& sock) {
     struct sockaddr_ll addr = {};
     addr.sll_family = AF_PACKET;
     addr.sll_protocol = htons(ETH_P_ALL);
@@ -277,37 +488,42 @@ bool AF_PacketBackend::bindToInterface() {
     struct ifreq ifr = {};
     strncpy(ifr.ifr_name, config_.interface.c_str(), IFNAMSIZ - 1);
     
-    if (ioctl(socketFd_, SIOCGIFINDEX, &ifr) < 0) {
-        std::lock_guard<std::mutex> lock(errorMutex_);
-        lastError_ = "Failed to get interface index: " + std::string(strerror(errno));
+    if (ioctl(sock.fd, SIOCGIFINDEX, &ifr) < 0) {
+        setLastError("Failed to get interface index: " + std::string(strerror(errno)));
         return false;
     }
     
     addr.sll_ifindex = ifr.ifr_ifindex;
     
-    if (bind(socketFd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        std::lock_guard<std::mutex> lock(errorMutex_);
-        lastError_ = "Failed to bind to interface: " + std::string(strerror(errno));
+    if (bind(sock.fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        setLastError("Failed to bind to interface: " + std::string(strerror(errno)));
         return false;
     }
     
     return true;
 }
 
-bool AF_PacketBackend::setSocketOptions() {
+bool AF_PacketBackend::joinFanoutGroup(RxSocket& sock, uint16_t fanoutGroup) {
+    int arg = fanoutArgument(fanoutGroup, config_.fanoutMode);
+    if (setsockopt(sock.fd, SOL_PACKET, PACKET_FANOUT, &arg, sizeof(arg)) < 0) {
+        setLastError("Failed to join PACKET_FANOUT group " + std::to_string(fanoutGroup) + ": " + std::string(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+bool AF_PacketBackend::setSocketOptions(RxSocket& sock) {
     // Set buffer size
-    if (setsockopt(socketFd_, SOL_SOCKET, SO_RCVBUF, &bufferSize_, sizeof(bufferSize_)) < 0) {
-        std::lock_guard<std::mutex> lock(errorMutex_);
-        lastError_ = "Failed to set receive buffer size: " + std::string(strerror(errno));
+    if (setsockopt(sock.fd, SOL_SOCKET, SO_RCVBUF, &bufferSize_, sizeof(bufferSize_)) < 0) {
+        setLastError("Failed to set receive buffer size: " + std::string(strerror(errno)));
         return false;
     }
     
     // Set non-blocking mode if requested
     if (!blockingMode_) {
-        int flags = fcntl(socketFd_, F_GETFL, 0);
-        if (flags < 0 || fcntl(socketFd_, F_SETFL, flags | O_NONBLOCK) < 0) {
-            std::lock_guard<std::mutex> lock(errorMutex_);
-            lastError_ = "Failed to set non-blocking mode: " + std::string(strerror(errno));
+        int flags = fcntl(sock.fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(sock.fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            setLastError("Failed to set non-blocking mode: " + std::string(strerror(errno)));
             return false;
         }
     }
@@ -315,32 +531,65 @@ bool AF_PacketBackend::setSocketOptions() {
     return true;
 }
 
-void AF_PacketBackend::packetProcessingLoop() {
-    std::vector<uint8_t> buffer(bufferSize_);
+void AF_PacketBackend::pinThread(size_t index) {
+    std::string threadName = "af_packet-rx-" + std::to_string(index);
+    pthread_setname_np(pthread_self(), threadName.c_str());
+    
+    if (config_.cpuAffinity.empty()) {
+        return;
+    }
+    
+    // Socket i runs on cpuAffinity[i], wrapping when there are more sockets than CPUs
+    int cpu = config_.cpuAffinity[index % config_.cpuAffinity.size()];
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0) {
+        BEATRICE_WARN("Failed to pin AF_PACKET receive thread {} to CPU {}", index, cpu);
+    } else {
+        BEATRICE_DEBUG("AF_PACKET receive thread {} pinned to CPU {}", index, cpu);
+    }
+}
+
+void AF_PacketBackend::packetProcessingLoop(RxSocket& sock) {
+    // Each receive thread owns its own pool so acquiring a buffer never contends;
+    // consumers hand buffers back when they drop the packet
+    auto pool = PacketPool::create(bufferSize_, config_.numBuffers,
+                                   "af_packet_" + config_.interface + "_rx" + std::to_string(sock.index));
+    std::vector<uint8_t> scratch(bufferSize_);
+    PacketBuffer buffer;
     
     while (running_) {
-        ssize_t bytesRead = recv(socketFd_, buffer.data(), buffer.size(), 0);
+        const auto now = std::chrono::steady_clock::now();
+        if (now - sock.kernelStatsRead >= kKernelStatsInterval) {
+            sock.kernelStatsRead = now;
+            updateKernelStatistics(sock);
+        }
+        
+        if (!buffer && pool) {
+            buffer = pool->acquire();
+        }
+        
+        // Fall back to the scratch buffer and a heap copy when the pool is exhausted
+        uint8_t* target = buffer ? buffer.data() : scratch.data();
+        ssize_t bytesRead = recv(sock.fd, target, bufferSize_, 0);
         
         if (bytesRead > 0) {
-            // Create packet data
-            auto dataPtr = std::make_shared<uint8_t[]>(bytesRead);
-            std::copy(buffer.begin(), buffer.begin() + bytesRead, dataPtr.get());
-            
-            Packet packet(dataPtr, bytesRead);
-            
-            // Update statistics
-            {
-                std::lock_guard<std::mutex> lock(statsMutex_);
-                stats_.packetsCaptured++;
-                stats_.bytesCaptured += bytesRead;
-                stats_.lastUpdate = std::chrono::steady_clock::now();
+            Packet packet;
+            if (buffer) {
+                packet = Packet(std::move(buffer), bytesRead);
+            } else {
+                auto dataPtr = std::make_shared<uint8_t[]>(bytesRead);
+                std::copy(scratch.begin(), scratch.begin() + bytesRead, dataPtr.get());
+                packet = Packet(dataPtr, bytesRead);
             }
             
-            // Add to queue
+            // Update statistics
             {
-                std::lock_guard<std::mutex> lock(packetQueueMutex_);
-                packetQueue_.push(packet);
-                packetCondition_.notify_one();
+                std::lock_guard<std::mutex> lock(sock.statsMutex);
+                sock.stats.packetsCaptured++;
+                sock.stats.bytesCaptured += bytesRead;
+                sock.stats.lastUpdate = std::chrono::steady_clock::now();
             }
             
             // Call callback if set
@@ -350,11 +599,15 @@ void AF_PacketBackend::packetProcessingLoop() {
                     packetCallback_(packet);
                 }
             }
+            
+            // Add to queue, a full queue applies the configured overflow policy
+            sock.queue.push(std::move(packet));
         } else if (bytesRead < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
             // Error occurred
-            std::lock_guard<std::mutex> lock(errorMutex_);
-            lastError_ = "Error reading from socket: " + std::string(strerror(errno));
+            setLastError("Error reading from socket: " + std::string(strerror(errno)));
             break;
+        } else if (pool) {
+            pool->publishMetrics();
         }
         
         // Small delay to prevent busy waiting
@@ -362,18 +615,176 @@ void AF_PacketBackend::packetProcessingLoop() {
     }
 }
 
-void AF_PacketBackend::processPackets() {
-    // This method is called from the processing thread
-    // The actual processing is done in packetProcessingLoop
+bool AF_PacketBackend::setupRxRing(RxSocket& sock) {
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    
+    if (config_.ringBlockSize == 0 || config_.ringBlockSize % pageSize != 0 ||
+        config_.ringFrameSize < TPACKET3_HDRLEN || config_.ringFrameSize % TPACKET_ALIGNMENT != 0 ||
+        config_.ringBlockSize % config_.ringFrameSize != 0 || config_.ringBlockCount == 0) {
+        setLastError("Invalid RX ring geometry: block size must be a multiple of the page size and of the frame size");
+        return false;
+    }
+    
+    int version = TPACKET_V3;
+    if (setsockopt(sock.fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        setLastError("Failed to select TPACKET_V3: " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    struct tpacket_req3 req = {};
+    req.tp_block_size = static_cast<unsigned int>(config_.ringBlockSize);
+    req.tp_block_nr = static_cast<unsigned int>(config_.ringBlockCount);
+    req.tp_frame_size = static_cast<unsigned int>(config_.ringFrameSize);
+    req.tp_frame_nr = static_cast<unsigned int>((config_.ringBlockSize / config_.ringFrameSize) * config_.ringBlockCount);
+    req.tp_retire_blk_tov = static_cast<unsigned int>(config_.ringBlockTimeoutMs);
+    req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+    
+    if (setsockopt(sock.fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        setLastError("Failed to create PACKET_RX_RING: " + std::string(strerror(errno)));
+        return false;
+    }
+    
+    sock.ringSize = config_.ringBlockSize * config_.ringBlockCount;
+    void* ring = mmap(nullptr, sock.ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, sock.fd, 0);
+    if (ring == MAP_FAILED) {
+        // MAP_LOCKED needs RLIMIT_MEMLOCK headroom, retry without it
+        ring = mmap(nullptr, sock.ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, sock.fd, 0);
+    }
+    if (ring == MAP_FAILED) {
+        setLastError("Failed to map RX ring: " + std::string(strerror(errno)));
+        sock.ringSize = 0;
+        return false;
+    }
+    
+    sock.ring = static_cast<uint8_t*>(ring);
+    BEATRICE_INFO("TPACKET_V3 RX ring {} ready: {} blocks of {} bytes, frame size {}, block timeout {} ms",
+                  sock.index, config_.ringBlockCount, config_.ringBlockSize, config_.ringFrameSize, config_.ringBlockTimeoutMs);
+    return true;
+}
+
+void AF_PacketBackend::ringProcessingLoop(RxSocket& sock) {
+    auto pool = PacketPool::create(config_.ringFrameSize, config_.numBuffers,
+                                   "af_packet_" + config_.interface + "_ring" + std::to_string(sock.index));
+    std::vector<Packet> batch;
+    batch.reserve(config_.ringBlockSize / config_.ringFrameSize);
+    
+    struct pollfd pfd = {};
+    pfd.fd = sock.fd;
+    pfd.events = POLLIN | POLLERR;
+    
+    size_t blockIndex = 0;
+    
+    while (running_) {
+        // Under sustained load the ring never idles, and that is when the kernel drops
+        const auto now = std::chrono::steady_clock::now();
+        if (now - sock.kernelStatsRead >= kKernelStatsInterval) {
+            sock.kernelStatsRead = now;
+            updateKernelStatistics(sock);
+        }
+        
+        auto* block = reinterpret_cast<struct tpacket_block_desc*>(sock.ring + blockIndex * config_.ringBlockSize);
+        
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+            // Nothing retired yet: sleep in the kernel until a block is handed over
+            poll(&pfd, 1, 100);
+            if (pool) {
+                pool->publishMetrics();
+            }
+            continue;
+        }
+        
+        // Walk the whole retired block, then give it back before delivering
+        const uint32_t numPackets = block->hdr.bh1.num_pkts;
+        auto* hdr = reinterpret_cast<struct tpacket3_hdr*>(
+            reinterpret_cast<uint8_t*>(block) + block->hdr.bh1.offset_to_first_pkt);
+        const auto realNow = std::chrono::system_clock::now();
+        uint64_t bytes = 0;
+        
+        for (uint32_t i = 0; i < numPackets; ++i) {
+            const uint8_t* frame = reinterpret_cast<const uint8_t*>(hdr) + hdr->tp_mac;
+            const size_t length = hdr->tp_snaplen;
+            // A block may sit for the whole retire timeout, stamp each frame with its own time
+            const auto timestamp = toSteadyTime(*hdr, now, realNow);
+            
+            PacketBuffer buffer = pool ? pool->acquire() : PacketBuffer();
+            if (buffer && length <= buffer.capacity()) {
+                std::memcpy(buffer.data(), frame, length);
+                batch.emplace_back(std::move(buffer), length, timestamp);
+            } else {
+                auto dataPtr = std::make_shared<uint8_t[]>(length);
+                std::memcpy(dataPtr.get(), frame, length);
+                batch.emplace_back(dataPtr, length, timestamp);
+            }
+            bytes += length;
+            
+            hdr = reinterpret_cast<struct tpacket3_hdr*>(reinterpret_cast<uint8_t*>(hdr) + hdr->tp_next_offset);
+        }
+        
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        blockIndex = (blockIndex + 1) % config_.ringBlockCount;
+        
+        deliverPackets(sock, batch, bytes);
+        batch.clear();
+    }
+}
+
+void AF_PacketBackend::deliverPackets(RxSocket& sock, std::vector<Packet>& packets, uint64_t bytes) {
+    if (packets.empty()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(sock.statsMutex);
+        sock.stats.packetsCaptured += packets.size();
+        sock.stats.bytesCaptured += bytes;
+        sock.stats.lastUpdate = std::chrono::steady_clock::now();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        if (packetCallback_) {
+            for (const auto& packet : packets) {
+                packetCallback_(packet);
+            }
+        }
+    }
+    
+    // One reservation and at most one wakeup for the whole block
+    sock.queue.push(packets);
+}
+
+void AF_PacketBackend::updateKernelStatistics(RxSocket& sock) const {
+    struct tpacket_stats_v3 kstats = {};
+    socklen_t len = sizeof(kstats);
+    
+    // Reading PACKET_STATISTICS resets the kernel counters, so accumulate
+    if (getsockopt(sock.fd, SOL_PACKET, PACKET_STATISTICS, &kstats, &len) == 0 && kstats.tp_drops > 0) {
+        std::lock_guard<std::mutex> lock(sock.statsMutex);
+        sock.stats.packetsDropped += kstats.tp_drops;
+    }
+}
+
+void AF_PacketBackend::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    lastError_ = error;
 }
 
 void AF_PacketBackend::shutdown() {
     stop();
     
-    if (socketFd_ >= 0) {
-        close(socketFd_);
-        socketFd_ = -1;
+    for (auto& sock : sockets_) {
+        if (sock->ring) {
+            munmap(sock->ring, sock->ringSize);
+            sock->ring = nullptr;
+            sock->ringSize = 0;
+        }
+        
+        if (sock->fd >= 0) {
+            close(sock->fd);
+            sock->fd = -1;
+        }
     }
+    sockets_.clear();
     
     // Free DMA buffers if allocated
     if (dmaBuffers_) {
@@ -1,15 +1,24 @@
 #include "beatrice/AF_XDPBackend.hpp"
 #include "beatrice/Logger.hpp"
 #include "beatrice/Error.hpp"
+#include "beatrice/Metrics.hpp"
+#include "beatrice/PacketQueue.hpp"
+#include "beatrice/PacketFilter.hpp"
+#include "beatrice/UmemFrameAllocator.hpp"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <cstring>
+#include <bit>
 #include <unistd.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/socket.h>
 #include <sys/mman.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 #include <net/if.h>
 #include <linux/if_link.h>
 #include <linux/if_xdp.h>
@@ -24,36 +33,132 @@
 #include <fstream> // Added for file access
 #include <linux/bpf.h> // Added for bpf_obj_get and bpf_obj_get_info_by_fd
 
-// XDP ring structure definitions (if not available in kernel headers)
-#ifndef XDP_FILL_RING
-#define XDP_FILL_RING 1
-#endif
-
-#ifndef XDP_COMPLETION_RING
-#define XDP_COMPLETION_RING 2
-#endif
-
-#ifndef XDP_PGOFF_FILL_RING
-#define XDP_PGOFF_FILL_RING 0
-#endif
-
-#ifndef XDP_PGOFF_COMPLETION_RING
-#define XDP_PGOFF_COMPLETION_RING 0x80000000
-#endif
-
-// XDP ring structure
-struct xdp_ring {
-    uint32_t producer;
-    uint32_t consumer;
-    uint32_t size;
-    struct xdp_desc desc[];
+namespace beatrice {
+
+namespace {
+
+/**
+ * @brief User-space view of one mmap'ed XSK ring
+ *
+ * Fill and completion rings carry 64-bit UMEM offsets, RX and TX rings carry
+ * struct xdp_desc. Producer and consumer indices are free-running.
+ */
+struct XskRing {
+    uint32_t* producer{nullptr};
+    uint32_t* consumer{nullptr};
+    uint32_t* flags{nullptr};
+    void* descs{nullptr};
+    uint32_t size{0};
+    void* map{nullptr};
+    size_t mapSize{0};
+
+    uint32_t mask() const { return size - 1; }
+    uint64_t* addrs() const { return static_cast<uint64_t*>(descs); }
+    bool needsWakeup() const { return flags && (__atomic_load_n(flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP); }
+    struct xdp_desc* xdpDescs() const { return static_cast<struct xdp_desc*>(descs); }
+
+    void unmap() {
+        if (map) {
+            munmap(map, mapSize);
+        }
+        *this = XskRing{};
+    }
 };
 
-namespace beatrice {
+bool mapRing(int fd, const struct xdp_ring_offset& offsets, uint32_t size, size_t descSize,
+             off_t pgoff, XskRing& ring) {
+    ring.mapSize = offsets.desc + size * descSize;
+    void* map = mmap(nullptr, ring.mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, pgoff);
+    if (map == MAP_FAILED) {
+        ring = XskRing{};
+        return false;
+    }
+    
+    auto* base = static_cast<uint8_t*>(map);
+    ring.map = map;
+    ring.producer = reinterpret_cast<uint32_t*>(base + offsets.producer);
+    ring.consumer = reinterpret_cast<uint32_t*>(base + offsets.consumer);
+    ring.flags = reinterpret_cast<uint32_t*>(base + offsets.flags);
+    ring.descs = base + offsets.desc;
+    ring.size = size;
+    return true;
+}
+
+// Latency histograms take a lock per observation, so only every Nth RX batch is sampled
+constexpr uint64_t kLatencySampleInterval = 16;
+
+// Frames posted to the fill ring per producer update
+constexpr uint32_t kFillBatchSize = 64;
+
+} // anonymous namespace
+
+/**
+ * @brief UMEM area shared between the backend and zero-copy packets
+ *
+ * With a shared UMEM every queue socket references the same region; the
+ * mapping itself is released only once the backend and every outstanding
+ * packet have dropped their reference.
+ */
+struct AF_XDPBackend::UmemRegion {
+    void* area{nullptr};
+    size_t size{0};
+    size_t frameSize{0};
+    int ownerFd{-1};                      ///< Socket the UMEM is registered on
+    bool needWakeup{false};               ///< Owner was bound with XDP_USE_NEED_WAKEUP
+
+    ~UmemRegion() {
+        if (area) {
+            munmap(area, size);
+        }
+    }
+};
+
+/**
+ * @brief One XSK socket bound to a single NIC RX queue
+ *
+ * The queue worker is the only producer of the packet queue; consumers
+ * may be several threads.
+ */
+struct AF_XDPBackend::XskSocket {
+    XskSocket(size_t socketIndex, uint32_t rxQueue, const Config& config)
+        : index(socketIndex)
+        , queueId(rxQueue)
+        , queue(config, OverflowPolicy::DROP_NEWEST,
+                "af_xdp_" + config.interface + "_q" + std::to_string(rxQueue)) {
+    }
+    
+    size_t index{0};
+    uint32_t queueId{0};
+    int fd{-1};
+    
+    std::shared_ptr<UmemRegion> umem;
+    std::shared_ptr<UmemFrameAllocator> frames;
+    
+    XskRing fill;
+    XskRing completion;
+    XskRing rx;
+    
+    std::thread thread;
+    
+    PacketQueue queue;
+    
+    mutable std::mutex statsMutex;
+    Statistics stats;
+    
+    std::chrono::steady_clock::time_point lastTestPacket{std::chrono::steady_clock::now()};
+    
+    // Receive loop mode and its latency histograms
+    bool needWakeup{false};
+    bool busyPoll{false};
+    std::shared_ptr<Histogram> waitLatency;
+    std::shared_ptr<Histogram> deliveryLatency;
+    uint64_t batches{0};
+    
+    bool isReal() const { return fd >= 0 && rx.map; }
+};
 
 AF_XDPBackend::AF_XDPBackend() 
-    : socket_(-1), umem_(nullptr), umemSize_(0), fillQueue_(nullptr), 
-      completionQueue_(nullptr), rxQueue_(nullptr), txQueue_(nullptr),
+    : sockets_(), nextQueue_(0),
       xdpLoader_(std::make_unique<XDPLoader>()), xdpProgramLoaded_(false),
       running_(false), initialized_(false), zeroCopyEnabled_(true), 
       dmaAccessEnabled_(false), dmaDevice_(""), dmaBufferSize_(0), 
@@ -88,8 +193,10 @@ Result<void> AF_XDPBackend::initialize(const Config& config) {
         // NOTE: AF_XDP socket binding is deferred until after XDP program is loaded
         // This is because binding requires the XDP program to be attached first
         
-        // For now, just mark as initialized in stub mode
+        // For now, just mark as initialized in stub mode with a single unbound queue
         // Real initialization will happen in initializeRealMode() after XDP program is loaded
+        sockets_.clear();
+        sockets_.push_back(std::make_unique<XskSocket>(0, 0, config_));
         initialized_ = true;
         BEATRICE_INFO("AF_XDP backend initialized successfully (stub mode - waiting for XDP program)");
         
@@ -113,11 +220,18 @@ Result<void> AF_XDPBackend::start() {
             return Result<void>::success();
         }
         
-        BEATRICE_INFO("Starting AF_XDP backend");
+        BEATRICE_INFO("Starting AF_XDP backend with {} queue worker(s)", sockets_.size());
         
-        // Start packet processing thread
+        // One packet processing thread per bound RX queue
         running_ = true;
-        processingThread_ = std::thread(&AF_XDPBackend::packetProcessingLoop, this);
+        for (auto& sock : sockets_) {
+            XskSocket& xsk = *sock;
+            xsk.queue.open();
+            xsk.thread = std::thread([this, &xsk]() {
+                pinThread(xsk.index);
+                packetProcessingLoop(xsk);
+            });
+        }
         
         BEATRICE_INFO("AF_XDP backend started successfully");
         return Result<void>::success();
@@ -138,8 +252,11 @@ Result<void> AF_XDPBackend::stop() {
         
         running_ = false;
         
-        if (processingThread_.joinable()) {
-            processingThread_.join();
+        for (auto& sock : sockets_) {
+            sock->queue.close();
+            if (sock->thread.joinable()) {
+                sock->thread.join();
+            }
         }
         
         BEATRICE_INFO("AF_XDP backend stopped");
@@ -156,13 +273,53 @@ bool AF_XDPBackend::isRunning() const noexcept {
 }
 
 std::optional<Packet> AF_XDPBackend::nextPacket(std::chrono::milliseconds timeout) {
-    // Stub implementation - return empty packet
-    return std::nullopt;
+    auto packets = getPackets(1, timeout);
+    if (packets.empty()) {
+        return std::nullopt;
+    }
+    return std::move(packets.front());
 }
 
 std::vector<Packet> AF_XDPBackend::getPackets(size_t maxPackets, std::chrono::milliseconds timeout) {
-    // Stub implementation - return empty vector
-    return {};
+    if (sockets_.empty()) {
+        return {};
+    }
+    
+    if (sockets_.size() == 1) {
+        return drainQueue(*sockets_.front(), maxPackets, timeout);
+    }
+    
+    // Shared consumers rotate over the queues; dedicated consumers should use
+    // getPackets(queueId, ...) instead
+    const size_t start = nextQueue_.fetch_add(1, std::memory_order_relaxed) % sockets_.size();
+    std::vector<Packet> packets;
+    for (size_t i = 0; i < sockets_.size() && packets.size() < maxPackets; ++i) {
+        auto more = drainQueue(*sockets_[(start + i) % sockets_.size()], maxPackets - packets.size(),
+                               std::chrono::milliseconds(0));
+        std::move(more.begin(), more.end(), std::back_inserter(packets));
+    }
+    
+    if (packets.empty()) {
+        return drainQueue(*sockets_[start], maxPackets, timeout);
+    }
+    return packets;
+}
+
+size_t AF_XDPBackend::getQueueCount() const {
+    return sockets_.size();
+}
+
+std::vector<Packet> AF_XDPBackend::getPackets(size_t queueId, size_t maxPackets, std::chrono::milliseconds timeout) {
+    if (queueId >= sockets_.size()) {
+        return {};
+    }
+    return drainQueue(*sockets_[queueId], maxPackets, timeout);
+}
+
+std::vector<Packet> AF_XDPBackend::drainQueue(XskSocket& sock, size_t maxPackets, std::chrono::milliseconds timeout) {
+    std::vector<Packet> packets;
+    sock.queue.pop(packets, maxPackets, timeout);
+    return packets;
 }
 
 void AF_XDPBackend::setPacketCallback(std::function<void(Packet)> callback) {
@@ -176,13 +333,47 @@ void AF_XDPBackend::removePacketCallback() {
 }
 
 ICaptureBackend::Statistics AF_XDPBackend::getStatistics() const {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    return stats_;
+    Statistics total;
+    for (const auto& sock : sockets_) {
+        std::lock_guard<std::mutex> lock(sock->statsMutex);
+        total.packetsCaptured += sock->stats.packetsCaptured;
+        total.packetsDropped += sock->stats.packetsDropped;
+        total.bytesCaptured += sock->stats.bytesCaptured;
+        total.bytesDropped += sock->stats.bytesDropped;
+        total.lastUpdate = std::max(total.lastUpdate, sock->stats.lastUpdate);
+        
+        const auto queueStats = sock->queue.getStatistics();
+        total.packetsDropped += queueStats.dropped;
+        total.bytesDropped += queueStats.bytesDropped;
+        total.queueHighWatermark = std::max(total.queueHighWatermark, queueStats.highWatermark);
+    }
+    return total;
+}
+
+UmemFrameAllocator::Statistics AF_XDPBackend::getFrameStatistics() const {
+    UmemFrameAllocator::Statistics total;
+    for (const auto& sock : sockets_) {
+        if (!sock->frames) continue;
+        const auto stats = sock->frames->getStatistics();
+        total.frameCount += stats.frameCount;
+        total.frameSize = stats.frameSize;
+        total.free += stats.free;
+        total.kernel += stats.kernel;
+        total.application += stats.application;
+        total.tx += stats.tx;
+        total.allocated += stats.allocated;
+        total.starvations += stats.starvations;
+        total.ownershipErrors += stats.ownershipErrors;
+    }
+    return total;
 }
 
 void AF_XDPBackend::resetStatistics() {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    stats_ = Statistics{};
+    for (auto& sock : sockets_) {
+        std::lock_guard<std::mutex> lock(sock->statsMutex);
+        sock->stats = Statistics{};
+        sock->queue.resetStatistics();
+    }
 }
 
 std::string AF_XDPBackend::getName() const {
@@ -196,7 +387,12 @@ std::string AF_XDPBackend::getVersion() const {
 std::vector<std::string> AF_XDPBackend::getSupportedFeatures() const {
     return {
         "stub_mode",
-        "basic_packet_processing"
+        "basic_packet_processing",
+        "zero_copy_packets",
+        "multi_queue",
+        "need_wakeup",
+        "busy_poll",
+        "kernel_filter"
     };
 }
 
@@ -249,6 +445,7 @@ Result<void> AF_XDPBackend::healthCheck() {
     }
 }
 
+
 // XDP-specific methods
 
 Result<void> AF_XDPBackend::loadXdpProgram(const std::string& programPath, 
@@ -302,18 +499,35 @@ Result<void> AF_XDPBackend::loadXdpProgram(const std::string& programPath,
         
         BEATRICE_INFO("STEP 3: XDP program attached to interface {} successfully", config_.interface);
 
+        // Filters offloaded before the program existed
+        if (!filterRules_.empty()) {
+            auto rulesResult = xdpLoader_->setFilterRules(programName, filterRules_);
+            if (!rulesResult.isSuccess()) {
+                BEATRICE_WARN("XDP filter rules not installed, filtering stays in user space: {}",
+                              rulesResult.getErrorMessage());
+            }
+        }
+
         // STEP 4: Set program flags BEFORE initializing real mode
         BEATRICE_INFO("STEP 4: Setting program flags...");
         xdpProgramName_ = programName;
         xdpProgramLoaded_ = true;
 
         // STEP 5: Initialize real AF_XDP mode now that XDP program is attached
+        // Queue workers are replaced, so they must not be running meanwhile
         BEATRICE_INFO("STEP 5: Initializing real AF_XDP mode...");
+        const bool wasRunning = running_;
+        if (wasRunning) {
+            stop();
+        }
         if (!initializeRealMode()) {
             BEATRICE_WARN("STEP 5: Failed to initialize real AF_XDP mode, staying in stub mode");
         } else {
             BEATRICE_INFO("STEP 5: Real AF_XDP mode initialized successfully");
         }
+        if (wasRunning) {
+            start();
+        }
 
         BEATRICE_INFO("XDP program {} loaded and attached successfully", programName);
         return Result<void>::success();
@@ -366,6 +580,27 @@ Result<void> AF_XDPBackend::unloadXdpProgram() {
     }
 }
 
+Result<void> AF_XDPBackend::setKernelFilter(const PacketFilter& filter) {
+    std::vector<std::string> userSpaceOnly;
+    filterRules_ = filter.compileXdpRules(&userSpaceOnly);
+    
+    if (!userSpaceOnly.empty()) {
+        std::string names;
+        for (const auto& name : userSpaceOnly) {
+            names += (names.empty() ? "" : ", ") + name;
+        }
+        BEATRICE_INFO("Filters not offloaded to XDP on {}: {}", config_.interface, names);
+    }
+    if (!filterRules_.empty()) {
+        BEATRICE_INFO("XDP rules on {} only apply to IPv4 packets", config_.interface);
+    }
+    if (!xdpProgramLoaded_) {
+        return Result<void>::success();
+    }
+    
+    return xdpLoader_->setFilterRules(xdpProgramName_, filterRules_);
+}
+
 bool AF_XDPBackend::isXdpProgramLoaded() const {
     return xdpProgramLoaded_;
 }
@@ -375,70 +610,62 @@ std::string AF_XDPBackend::getXdpProgramStats() const {
         return "No XDP program loaded";
     }
     
-    return xdpLoader_->getProgramStats(config_.interface);
+    return xdpLoader_->getProgramStats(config_.interface) + ", filtered packets: " +
+           std::to_string(xdpLoader_->getFilteredPacketCount(xdpProgramName_));
 }
 
+
 // Private implementation methods
 
-void AF_XDPBackend::packetProcessingLoop() {
-    BEATRICE_INFO("Starting packet processing loop");
+void AF_XDPBackend::packetProcessingLoop(XskSocket& sock) {
+    BEATRICE_INFO("Starting packet processing loop for queue {}", sock.queueId);
     
     while (running_) {
         try {
-            if (socket_ >= 0 && rxQueue_) {
+            if (sock.isReal()) {
                 // Real XDP mode
-                processRxQueue();
-                processCompletionQueue();
-                refillQueue();
+                const size_t received = processRxQueue(sock);
+                processCompletionQueue(sock);
+                refillQueue(sock);
+                
+                if (received == 0) {
+                    waitForPackets(sock);
+                }
             } else {
                 // Stub mode - generate test packets
-                generateTestPackets();
+                generateTestPackets(sock);
+                
+                // Small delay to prevent busy waiting
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
             }
             
-            // Small delay to prevent busy waiting
-            std::this_thread::sleep_for(std::chrono::microseconds(10));
-            
         } catch (const std::exception& e) {
             BEATRICE_ERROR("Exception in packet processing loop: {}", e.what());
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
     
-    BEATRICE_INFO("Packet processing loop stopped");
+    BEATRICE_INFO("Packet processing loop for queue {} stopped", sock.queueId);
 }
 
-void AF_XDPBackend::generateTestPackets() {
+void AF_XDPBackend::generateTestPackets(XskSocket& sock) {
     // Generate a test packet every 100ms in stub mode
-    static auto lastPacketTime = std::chrono::steady_clock::now();
     auto now = std::chrono::steady_clock::now();
     
-    if (now - lastPacketTime > std::chrono::milliseconds(100)) {
+    if (now - sock.lastTestPacket > std::chrono::milliseconds(100)) {
         // Create a simple test packet
         Packet testPacket = createTestPacket();
         
-        // Add to packet queue
+        // Update statistics
         {
-            std::lock_guard<std::mutex> lock(packetQueueMutex_);
-            packetQueue_.push(testPacket);
+            std::lock_guard<std::mutex> lock(sock.statsMutex);
+            sock.stats.packetsCaptured++;
+            sock.stats.bytesCaptured += testPacket.length();
+            sock.stats.lastUpdate = now;
         }
         
-        // Notify waiting threads
-        packetCondition_.notify_one();
-        
-        // Call callback if set
-        if (packetCallback_) {
-            try {
-                packetCallback_(testPacket);
-            } catch (const std::exception& e) {
-                BEATRICE_ERROR("Exception in packet callback: {}", e.what());
-            }
-        }
-        
-        // Update statistics
-        stats_.packetsCaptured++;
-        stats_.bytesCaptured += testPacket.length();
-        
-        lastPacketTime = now;
+        enqueuePacket(sock, std::move(testPacket));
+        sock.lastTestPacket = now;
     }
 }
 
@@ -473,88 +700,185 @@ Packet AF_XDPBackend::createTestPacket() {
     return Packet(dataPtr, packetData.size(), std::chrono::steady_clock::now());
 }
 
-void AF_XDPBackend::processRxQueue() {
-    if (!rxQueue_) return;
+
+size_t AF_XDPBackend::processRxQueue(XskSocket& sock) {
+    uint32_t idx = *sock.rx.consumer;
+    const uint32_t prod = __atomic_load_n(sock.rx.producer, __ATOMIC_ACQUIRE);
     
-    uint32_t idx = rxQueue_->consumer;
-    const uint32_t prod = rxQueue_->producer;
+    if (idx == prod) {
+        return 0;
+    }
     
-    while (idx != prod && running_) {
-        const struct xdp_desc* desc = &rxQueue_->desc[idx & (rxQueue_->size - 1)];
-        
-        // Create packet from UMEM data
-        uint8_t* data = reinterpret_cast<uint8_t*>(umem_) + desc->addr;
-        size_t length = desc->len;
+    const bool sample = sock.deliveryLatency && (sock.batches++ % kLatencySampleInterval) == 0;
+    const auto batchStart = sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    
+    const uint8_t* area = static_cast<const uint8_t*>(sock.umem->area);
+    const bool zeroCopy = zeroCopyEnabled_ && config_.enableZeroCopy;
+    std::vector<Packet> batch;
+    batch.reserve(prod - idx);
+    uint64_t bytes = 0;
+    
+    while (idx != prod) {
+        const struct xdp_desc& desc = sock.rx.xdpDescs()[idx & sock.rx.mask()];
+        const uint64_t addr = desc.addr;
+        const size_t length = desc.len;
+        
+        // The frame now belongs to userspace; an address this queue never
+        // posted is skipped rather than handed out twice
+        if (!sock.frames->onReceive(addr)) {
+            idx++;
+            continue;
+        }
         
         if (length > 0 && length <= config_.bufferSize) {
-            // Parse packet metadata
-            Packet packet = parsePacketMetadata(data, length);
-            
-            // Add to packet queue for processing
-            {
-                std::lock_guard<std::mutex> lock(packetQueueMutex_);
-                packetQueue_.push(packet);
+            // Reference the frame in place when zero-copy is on, otherwise copy
+            // it out and give the frame straight back to the fill ring
+            if (zeroCopy) {
+                batch.push_back(createZeroCopyPacket(sock, addr, length));
+            } else {
+                batch.push_back(parsePacketMetadata(area + addr, length));
+                sock.frames->release(addr);
             }
-            
-            // Notify waiting threads
-            packetCondition_.notify_one();
-            
-            // Call callback if set
-            if (packetCallback_) {
+            bytes += length;
+        } else {
+            sock.frames->release(addr);
+        }
+        
+        idx++;
+    }
+    
+    // Hand the descriptors back to the kernel before delivering
+    __atomic_store_n(sock.rx.consumer, idx, __ATOMIC_RELEASE);
+    
+    {
+        std::lock_guard<std::mutex> lock(sock.statsMutex);
+        sock.stats.packetsCaptured += batch.size();
+        sock.stats.bytesCaptured += bytes;
+        sock.stats.lastUpdate = std::chrono::steady_clock::now();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        if (packetCallback_) {
+            for (const auto& packet : batch) {
                 try {
                     packetCallback_(packet);
                 } catch (const std::exception& e) {
                     BEATRICE_ERROR("Exception in packet callback: {}", e.what());
                 }
             }
-            
-            // Update statistics
-            stats_.packetsCaptured++;
-            stats_.bytesCaptured += length;
         }
-        
-        idx++;
     }
     
-    rxQueue_->consumer = idx;
+    // One reservation and at most one wakeup for the whole batch; dropped
+    // packets return their frames to the allocator when batch goes out of scope
+    const size_t received = batch.size();
+    sock.queue.push(batch);
+    
+    if (sample) {
+        sock.deliveryLatency->observe(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - batchStart).count());
+    }
+    return received;
 }
 
-void AF_XDPBackend::processCompletionQueue() {
-    if (!completionQueue_) return;
+void AF_XDPBackend::waitForPackets(XskSocket& sock) {
+    const bool sample = sock.waitLatency && (sock.batches % kLatencySampleInterval) == 0;
+    const auto waitStart = sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
     
-    uint32_t idx = completionQueue_->consumer;
-    const uint32_t prod = completionQueue_->producer;
+    if (sock.busyPoll) {
+        // Drive the driver's NAPI loop from this thread; never sleeps
+        recvfrom(sock.fd, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    } else if (sock.needWakeup) {
+        // Sleep in the kernel until the RX ring has data; poll() also wakes
+        // the driver if it stopped processing the fill ring
+        struct pollfd pfd = {};
+        pfd.fd = sock.fd;
+        pfd.events = POLLIN;
+        poll(&pfd, 1, 100);
+    } else {
+        // Kernel without need_wakeup support: the driver runs on its own
+        std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
     
+    if (sample) {
+        sock.waitLatency->observe(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - waitStart).count());
+    }
+}
+
+void AF_XDPBackend::kick(XskSocket& sock) {
+    // Tell the driver new fill descriptors are available
+    if (sock.busyPoll || sock.needWakeup) {
+        recvfrom(sock.fd, nullptr, 0, MSG_DONTWAIT, nullptr, nullptr);
+    }
+}
+
+void AF_XDPBackend::enqueuePacket(XskSocket& sock, Packet packet) {
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        if (packetCallback_) {
+            try {
+                packetCallback_(packet);
+            } catch (const std::exception& e) {
+                BEATRICE_ERROR("Exception in packet callback: {}", e.what());
+            }
+        }
+    }
+    
+    sock.queue.push(std::move(packet));
+}
+
+void AF_XDPBackend::processCompletionQueue(XskSocket& sock) {
+    uint32_t idx = *sock.completion.consumer;
+    const uint32_t prod = __atomic_load_n(sock.completion.producer, __ATOMIC_ACQUIRE);
+    
+    // Transmitted frames are free again
     while (idx != prod) {
-        const uint64_t addr = completionQueue_->desc[idx & (completionQueue_->size - 1)].addr;
-        
-        // Return buffer to fill queue
-        fillQueue_->desc[fillQueue_->producer & (fillQueue_->size - 1)].addr = addr;
-        fillQueue_->producer++;
-        
+        sock.frames->onCompletion(sock.completion.addrs()[idx & sock.completion.mask()]);
         idx++;
     }
     
-    completionQueue_->consumer = idx;
+    __atomic_store_n(sock.completion.consumer, idx, __ATOMIC_RELEASE);
 }
 
-void AF_XDPBackend::refillQueue() {
-    if (!fillQueue_) return;
+void AF_XDPBackend::refillQueue(XskSocket& sock) {
+    if (!sock.fill.map || !sock.frames) return;
     
-    // Check if we need to refill
-    uint32_t fillQueueProd = fillQueue_->producer;
-    uint32_t fillQueueCons = fillQueue_->consumer;
-    uint32_t available = fillQueue_->size - (fillQueueProd - fillQueueCons);
+    const uint32_t fillQueueProd = *sock.fill.producer;
+    const uint32_t fillQueueCons = __atomic_load_n(sock.fill.consumer, __ATOMIC_ACQUIRE);
+    const uint32_t pending = fillQueueProd - fillQueueCons;
+    const uint32_t available = sock.fill.size - pending;
     
-    if (available > 0) {
-        // Allocate new buffers and add to fill queue
-        for (uint32_t i = 0; i < available && i < config_.numBuffers; ++i) {
-            uint64_t addr = reinterpret_cast<uint64_t>(umem_) + 
-                           ((fillQueueProd + i) % config_.numBuffers) * config_.bufferSize;
-            
-            fillQueue_->desc[(fillQueueProd + i) & (fillQueue_->size - 1)].addr = addr;
+    // Post frames in batches to keep producer updates and wakeups rare, but
+    // top up immediately once the kernel is running low
+    if (available == 0 || (available < kFillBatchSize && pending >= kFillBatchSize)) {
+        sock.frames->publishMetrics();
+        return;
+    }
+    
+    uint64_t addrs[kFillBatchSize];
+    uint32_t count = 0;
+    while (count < available) {
+        const size_t want = std::min<size_t>(kFillBatchSize, available - count);
+        const size_t got = sock.frames->allocate(addrs, want);
+        for (size_t i = 0; i < got; ++i) {
+            sock.fill.addrs()[(fillQueueProd + count + i) & sock.fill.mask()] = addrs[i];
         }
-        fillQueue_->producer = fillQueueProd + available;
+        count += static_cast<uint32_t>(got);
+        if (got < want) {
+            break;
+        }
+    }
+    
+    sock.frames->publishMetrics();
+    if (count == 0) {
+        return;
+    }
+    __atomic_store_n(sock.fill.producer, fillQueueProd + count, __ATOMIC_RELEASE);
+    
+    if (sock.fill.needsWakeup()) {
+        kick(sock);
     }
 }
 
@@ -580,50 +904,75 @@ Packet AF_XDPBackend::parsePacketMetadata(const uint8_t* data, size_t length) {
     return packet;
 }
 
+
+Packet AF_XDPBackend::createZeroCopyPacket(XskSocket& sock, uint64_t addr, size_t length) {
+    const uint8_t* data = static_cast<const uint8_t*>(sock.umem->area) + addr;
+    
+    // The deleter keeps the UMEM mapped and returns the frame to the owning
+    // queue once the last copy of the packet (queue, callback, plugins) has
+    // been dropped
+    return Packet(data, length,
+                  [frames = sock.frames, addr](const uint8_t*) { frames->release(addr); },
+                  std::chrono::steady_clock::now());
+}
+
+void AF_XDPBackend::pinThread(size_t index) {
+    std::string threadName = "af_xdp-q" + std::to_string(index);
+    pthread_setname_np(pthread_self(), threadName.c_str());
+    
+    if (config_.cpuAffinity.empty()) {
+        return;
+    }
+    
+    // Queue worker i runs on cpuAffinity[i], wrapping when there are more queues than CPUs
+    int cpu = config_.cpuAffinity[index % config_.cpuAffinity.size()];
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0) {
+        BEATRICE_WARN("Failed to pin AF_XDP queue worker {} to CPU {}", index, cpu);
+    } else {
+        BEATRICE_DEBUG("AF_XDP queue worker {} pinned to CPU {}", index, cpu);
+    }
+}
+
+void AF_XDPBackend::closeSocket(XskSocket& sock) {
+    if (sock.fd >= 0 && xdpProgramLoaded_) {
+        xdpLoader_->unregisterXskSocket(xdpProgramName_, sock.queueId);
+    }
+    
+    // Unmap ring buffers
+    sock.fill.unmap();
+    sock.completion.unmap();
+    sock.rx.unmap();
+    
+    if (sock.fd >= 0) {
+        close(sock.fd);
+        sock.fd = -1;
+    }
+    
+    // Drop our reference to the UMEM; the mapping is released once the
+    // last zero-copy packet still held by the application goes away
+    sock.frames.reset();
+    sock.umem.reset();
+}
+
 void AF_XDPBackend::shutdown() {
     if (initialized_) {
-        // Stop processing thread
+        // Stop processing threads
         if (running_) {
             stop();
         }
         
-        // Unload XDP program if loaded
-        if (xdpProgramLoaded_) {
-            unloadXdpProgram();
-        }
-        
         // Clean up XDP resources
-        if (socket_ >= 0) {
-            close(socket_);
-            socket_ = -1;
+        for (auto& sock : sockets_) {
+            closeSocket(*sock);
         }
+        sockets_.clear();
         
-        // Unmap ring buffers
-        if (fillQueue_) {
-            munmap(fillQueue_, 0); // Size will be determined by kernel
-            fillQueue_ = nullptr;
-        }
-        
-        if (completionQueue_) {
-            munmap(completionQueue_, 0);
-            completionQueue_ = nullptr;
-        }
-        
-        if (rxQueue_) {
-            munmap(rxQueue_, 0);
-            rxQueue_ = nullptr;
-        }
-        
-        if (txQueue_) {
-            munmap(txQueue_, 0);
-            txQueue_ = nullptr;
-        }
-        
-        // Free UMEM
-        if (umem_) {
-            munmap(umem_, umemSize_);
-            umem_ = nullptr;
-            umemSize_ = 0;
+        // Unload XDP program if loaded
+        if (xdpProgramLoaded_) {
+            unloadXdpProgram();
         }
         
         initialized_ = false;
@@ -639,39 +988,118 @@ bool AF_XDPBackend::validateInterface(const std::string& interface) {
     return std::filesystem::exists(path);
 }
 
+
 bool AF_XDPBackend::initializeRealMode() {
     try {
         BEATRICE_INFO("Initializing real AF_XDP mode for interface: {}", config_.interface);
         
-        // STEP 1: Create AF_XDP socket
-        if (!createSocket()) {
-            BEATRICE_ERROR("STEP 1: Failed to create AF_XDP socket");
+        // STEP 1: Check that the interface and kernel can take XSK sockets
+        if (!checkInterfaceSupport()) {
+            BEATRICE_ERROR("STEP 1: Interface {} cannot host AF_XDP sockets", config_.interface);
             return false;
         }
-        BEATRICE_INFO("STEP 1: AF_XDP socket created successfully");
         
-        // STEP 2: Initialize UMEM
-        if (!initializeUmem()) {
-            BEATRICE_ERROR("STEP 2: Failed to initialize UMEM");
+        int ifIndex = getInterfaceIndex(config_.interface);
+        if (ifIndex == -1) {
+            BEATRICE_ERROR("STEP 1: Failed to get interface index for {}", config_.interface);
             return false;
         }
-        BEATRICE_INFO("STEP 2: UMEM initialized successfully");
+        BEATRICE_INFO("STEP 1: Interface {} (index: {}) supports AF_XDP", config_.interface, ifIndex);
         
-        // STEP 3: Bind to interface (now that XDP program is attached)
-        if (!bindToInterface()) {
-            BEATRICE_ERROR("STEP 3: Failed to bind to interface");
-            return false;
+        size_t queueCount = config_.xdpQueueCount;
+        if (queueCount == 0) {
+            size_t available = getRxQueueCount(config_.interface);
+            queueCount = available > config_.xdpFirstQueue ? available - config_.xdpFirstQueue : 1;
         }
-        BEATRICE_INFO("STEP 3: Bound to interface successfully");
-        
-        // STEP 4: Initialize ring buffers
-        if (!initializeRingBuffers()) {
-            BEATRICE_ERROR("STEP 4: Failed to initialize ring buffers");
+        const bool sharedUmem = config_.xdpSharedUmem && queueCount > 1;
+        
+        // STEP 2: Allocate UMEM, one region for all queues or one per queue
+        std::shared_ptr<UmemRegion> shared;
+        if (sharedUmem) {
+            shared = createUmem(config_.numBuffers * queueCount);
+            if (!shared) {
+                BEATRICE_ERROR("STEP 2: Failed to allocate shared UMEM");
+                return false;
+            }
+        }
+        BEATRICE_INFO("STEP 2: Binding {} queue(s) starting at queue {} ({} UMEM)",
+                      queueCount, config_.xdpFirstQueue, sharedUmem ? "shared" : "per-queue");
+        
+        std::vector<std::unique_ptr<XskSocket>> sockets;
+        auto fail = [&](const std::string& step) {
+            BEATRICE_ERROR("{}", step);
+            for (auto& sock : sockets) {
+                closeSocket(*sock);
+            }
             return false;
+        };
+        
+        for (size_t i = 0; i < queueCount; ++i) {
+            auto sock = std::make_unique<XskSocket>(i, config_.xdpFirstQueue + static_cast<uint32_t>(i), config_);
+            sockets.push_back(std::move(sock));
+            XskSocket& xsk = *sockets.back();
+            
+            // STEP 3: Create AF_XDP socket
+            if (!createSocket(xsk)) {
+                return fail("STEP 3: Failed to create AF_XDP socket for queue " + std::to_string(xsk.queueId));
+            }
+            
+            // STEP 4: Register UMEM; on a shared UMEM only the first socket does
+            xsk.umem = sharedUmem ? shared : createUmem(config_.numBuffers);
+            if (!xsk.umem) {
+                return fail("STEP 4: Failed to allocate UMEM for queue " + std::to_string(xsk.queueId));
+            }
+            if (xsk.umem->ownerFd < 0 && !registerUmem(xsk)) {
+                return fail("STEP 4: Failed to register UMEM for queue " + std::to_string(xsk.queueId));
+            }
+            
+            // Each queue owns a disjoint slice of the UMEM frames
+            const size_t firstFrame = sharedUmem ? i * config_.numBuffers : 0;
+            xsk.frames = UmemFrameAllocator::create(
+                firstFrame * config_.bufferSize, config_.numBuffers, config_.bufferSize,
+                "af_xdp_" + config_.interface + "_q" + std::to_string(xsk.queueId) + "_umem", xsk.umem);
+            if (!xsk.frames) {
+                return fail("STEP 4: Failed to create frame allocator for queue " + std::to_string(xsk.queueId));
+            }
+            
+            // STEP 5: Every socket gets its own fill/completion and RX rings
+            if (!initializeRingBuffers(xsk)) {
+                return fail("STEP 5: Failed to initialize ring buffers for queue " + std::to_string(xsk.queueId));
+            }
+            
+            // STEP 6: Bind to the queue (now that XDP program is attached)
+            const bool sharesUmem = xsk.umem->ownerFd != xsk.fd;
+            if (!bindToInterface(xsk, ifIndex, sharesUmem ? xsk.umem->ownerFd : -1)) {
+                if (config_.interface.find("veth") == 0) {
+                    BEATRICE_WARN("AF_XDP binding failed for veth interface - XDP program stays attached in generic mode");
+                }
+                return fail("STEP 6: Failed to bind AF_XDP socket to queue " + std::to_string(xsk.queueId));
+            }
+            xsk.needWakeup = xsk.umem->needWakeup;
+            
+            // STEP 7: Pick the receive loop mode and export its latency histograms
+            if (config_.busyPoll && !setBusyPollOptions(xsk)) {
+                BEATRICE_WARN("Busy polling unavailable on queue {}, falling back to {}",
+                              xsk.queueId, xsk.needWakeup ? "need_wakeup" : "sleep");
+            }
+            const std::string mode = xsk.busyPoll ? "busy_poll" : (xsk.needWakeup ? "need_wakeup" : "sleep");
+            const std::string prefix = "af_xdp_" + config_.interface + "_q" + std::to_string(xsk.queueId) + "_" + mode;
+            xsk.waitLatency = metrics::histogram(prefix + "_wait_us", "Time an idle AF_XDP worker spent waiting for packets (sampled)");
+            xsk.deliveryLatency = metrics::histogram(prefix + "_delivery_us", "Time from RX ring to packet queue per batch (sampled)");
+            refillQueue(xsk);
+            
+            // STEP 8: Let the XDP program redirect this queue to the socket
+            auto mapResult = xdpLoader_->registerXskSocket(xdpProgramName_, xsk.queueId, xsk.fd);
+            if (!mapResult.isSuccess()) {
+                return fail("STEP 7: Failed to add queue " + std::to_string(xsk.queueId) +
+                            " to XSKMAP: " + mapResult.getErrorMessage());
+            }
         }
-        BEATRICE_INFO("STEP 4: Ring buffers initialized successfully");
         
-        BEATRICE_INFO("Real AF_XDP mode initialized successfully");
+        // Replace the stub queue
+        sockets_ = std::move(sockets);
+        
+        BEATRICE_INFO("Real AF_XDP mode initialized successfully on {} queue(s)", sockets_.size());
         return true;
         
     } catch (const std::exception& e) {
@@ -680,61 +1108,73 @@ bool AF_XDPBackend::initializeRealMode() {
     }
 }
 
-bool AF_XDPBackend::initializeUmem() {
+size_t AF_XDPBackend::getRxQueueCount(const std::string& interfaceName) {
+    size_t count = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/class/net/" + interfaceName + "/queues", ec)) {
+        if (entry.path().filename().string().rfind("rx-", 0) == 0) {
+            count++;
+        }
+    }
+    return std::max<size_t>(count, 1);
+}
+
+std::shared_ptr<AF_XDPBackend::UmemRegion> AF_XDPBackend::createUmem(size_t frameCount) {
     // Calculate UMEM size based on config
-    umemSize_ = config_.numBuffers * config_.bufferSize;
+    size_t umemSize = frameCount * config_.bufferSize;
     
     // Align to page size
     size_t pageSize = sysconf(_SC_PAGESIZE);
-    umemSize_ = (umemSize_ + pageSize - 1) & ~(pageSize - 1);
+    umemSize = (umemSize + pageSize - 1) & ~(pageSize - 1);
     
     BEATRICE_DEBUG("Allocating UMEM: {} bytes ({} buffers of {} bytes)", 
-                   umemSize_, config_.numBuffers, config_.bufferSize);
+                   umemSize, frameCount, config_.bufferSize);
     
     // Allocate memory with huge pages if possible
-    umem_ = mmap(nullptr, umemSize_, PROT_READ | PROT_WRITE,
-                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    void* area = mmap(nullptr, umemSize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
     
-    if (umem_ == MAP_FAILED) {
+    if (area == MAP_FAILED) {
         BEATRICE_ERROR("Failed to allocate UMEM: {}", strerror(errno));
-        return false;
+        return nullptr;
     }
     
+    auto region = std::make_shared<UmemRegion>();
+    region->area = area;
+    region->size = umemSize;
+    region->frameSize = config_.bufferSize;
+    return region;
+}
+
+bool AF_XDPBackend::registerUmem(XskSocket& sock) {
     // Register UMEM with kernel
     struct xdp_umem_reg umemReg;
     memset(&umemReg, 0, sizeof(umemReg));
-    umemReg.addr = reinterpret_cast<uint64_t>(umem_);
-    umemReg.len = umemSize_;
+    umemReg.addr = reinterpret_cast<uint64_t>(sock.umem->area);
+    umemReg.len = sock.umem->size;
     umemReg.chunk_size = config_.bufferSize;
     umemReg.headroom = 0;
     
-    if (setsockopt(socket_, SOL_XDP, XDP_UMEM_REG, &umemReg, sizeof(umemReg)) < 0) {
+    if (setsockopt(sock.fd, SOL_XDP, XDP_UMEM_REG, &umemReg, sizeof(umemReg)) < 0) {
         BEATRICE_ERROR("Failed to register UMEM: {}", strerror(errno));
-        munmap(umem_, umemSize_);
-        umem_ = nullptr;
         return false;
     }
     
-    BEATRICE_DEBUG("UMEM registered successfully");
+    sock.umem->ownerFd = sock.fd;
+    BEATRICE_DEBUG("UMEM registered successfully on queue {}", sock.queueId);
     return true;
 }
 
-bool AF_XDPBackend::createSocket() {
-    socket_ = socket(AF_XDP, SOCK_RAW, 0);
-    if (socket_ < 0) {
+bool AF_XDPBackend::createSocket(XskSocket& sock) {
+    sock.fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (sock.fd < 0) {
         BEATRICE_ERROR("Failed to create AF_XDP socket: {}", strerror(errno));
         return false;
     }
     
-    // Set socket options
-    int optval = 1;
-    if (setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0) {
-        BEATRICE_WARN("Failed to set SO_REUSEADDR: {}", strerror(errno));
-    }
-    
     // Set non-blocking mode
-    int flags = fcntl(socket_, F_GETFL, 0);
-    if (flags < 0 || fcntl(socket_, F_SETFL, flags | O_NONBLOCK) < 0) {
+    int flags = fcntl(sock.fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(sock.fd, F_SETFL, flags | O_NONBLOCK) < 0) {
         BEATRICE_WARN("Failed to set non-blocking mode: {}", strerror(errno));
     }
     
@@ -742,222 +1182,193 @@ bool AF_XDPBackend::createSocket() {
     return true;
 }
 
-bool AF_XDPBackend::bindToInterface() {
-    try {
-        BEATRICE_INFO("STEP 3: Attempting to bind AF_XDP socket to interface: {}", config_.interface);
-        
-        // Get interface index
-        int ifIndex = getInterfaceIndex(config_.interface);
-        if (ifIndex == -1) {
-            BEATRICE_ERROR("Failed to get interface index for {}", config_.interface);
-            return false;
-        }
-        BEATRICE_INFO("Interface index: {}", ifIndex);
-        
-        // Verify XDP program is attached
-        if (!xdpLoader_->isProgramAttached(config_.interface)) {
-            BEATRICE_ERROR("XDP program is not attached to interface {}", config_.interface);
-            return false;
-        }
-        BEATRICE_INFO("XDP program is attached to interface {} (index: {})", config_.interface, ifIndex);
-        
-        // Verify XSK map exists and is accessible
-        BEATRICE_INFO("STEP 3.1: Verifying XSK map configuration...");
-        auto programInfo = xdpLoader_->getProgramInfo(xdpProgramName_);
-        if (!programInfo) {
-            BEATRICE_ERROR("Failed to get program info for XSK map verification");
-            return false;
-        }
-        
-        // Check if map is accessible via BPF filesystem
-        std::string mapPinPath = "/sys/fs/bpf/" + xdpProgramName_ + "_map";
-        if (access(mapPinPath.c_str(), F_OK) == 0) {
-            BEATRICE_INFO("XSK map found at: {}", mapPinPath);
-            
-            // Check map file permissions
-            if (access(mapPinPath.c_str(), R_OK) == 0) {
-                BEATRICE_INFO("XSK map is readable");
-            } else {
-                BEATRICE_WARN("XSK map exists but not readable: {}", strerror(errno));
-            }
-        } else {
-            BEATRICE_WARN("XSK map not found at: {}", mapPinPath);
-        }
-        
-        // Check interface XDP mode
-        BEATRICE_INFO("STEP 3.2: Checking interface XDP mode...");
-        std::string xdpModePath = "/sys/class/net/" + config_.interface + "/xdp_mode";
-        if (access(xdpModePath.c_str(), F_OK) == 0) {
-            std::ifstream modeFile(xdpModePath);
-            if (modeFile.is_open()) {
-                std::string mode;
-                std::getline(modeFile, mode);
-                BEATRICE_INFO("Interface XDP mode: {}", mode);
-                modeFile.close();
-            }
-        } else {
-            BEATRICE_WARN("Cannot determine XDP mode for interface {}", config_.interface);
+bool AF_XDPBackend::checkInterfaceSupport() {
+    // Verify XDP program is attached
+    if (!xdpLoader_->isProgramAttached(config_.interface)) {
+        BEATRICE_ERROR("XDP program is not attached to interface {}", config_.interface);
+        return false;
+    }
+    
+    // Verify XSK map exists and is accessible
+    auto programInfo = xdpLoader_->getProgramInfo(xdpProgramName_);
+    if (!programInfo) {
+        BEATRICE_ERROR("Failed to get program info for XSK map verification");
+        return false;
+    }
+    
+    // Check interface XDP mode
+    std::string xdpModePath = "/sys/class/net/" + config_.interface + "/xdp_mode";
+    if (access(xdpModePath.c_str(), F_OK) == 0) {
+        std::ifstream modeFile(xdpModePath);
+        if (modeFile.is_open()) {
+            std::string mode;
+            std::getline(modeFile, mode);
+            BEATRICE_INFO("Interface XDP mode: {}", mode);
         }
-        
-        // Check kernel AF_XDP support
-        BEATRICE_INFO("STEP 3.3: Checking kernel AF_XDP support...");
-        if (access("/sys/fs/bpf", F_OK) == 0) {
-            BEATRICE_INFO("BPF filesystem is mounted");
+    }
+    
+    // Check kernel AF_XDP support
+    if (access("/sys/fs/bpf", F_OK) != 0) {
+        BEATRICE_ERROR("BPF filesystem is not mounted - AF_XDP requires this");
+        return false;
+    }
+    
+    // Check if interface supports XDP
+    std::string xdpPath = "/sys/class/net/" + config_.interface + "/xdp";
+    if (access(xdpPath.c_str(), F_OK) != 0) {
+        // For veth interfaces, we'll try anyway as they might support XDP
+        if (config_.interface.find("veth") == 0) {
+            BEATRICE_WARN("Interface {} is a veth interface - attempting XDP binding anyway", config_.interface);
         } else {
-            BEATRICE_ERROR("BPF filesystem is not mounted - AF_XDP requires this");
+            BEATRICE_ERROR("Interface {} does not support XDP", config_.interface);
             return false;
         }
-        
-        // Check if interface supports XDP
-        std::string xdpPath = "/sys/class/net/" + config_.interface + "/xdp";
-        if (access(xdpPath.c_str(), F_OK) == 0) {
-            BEATRICE_INFO("Interface {} supports XDP", config_.interface);
-        } else {
-            // For veth interfaces, we'll try anyway as they might support XDP
-            if (config_.interface.find("veth") == 0) {
-                BEATRICE_WARN("Interface {} is a veth interface - attempting XDP binding anyway", config_.interface);
-            } else {
-                BEATRICE_ERROR("Interface {} does not support XDP", config_.interface);
-                return false;
-            }
-        }
-        
-        // Prepare sockaddr_xdp structure
-        struct sockaddr_xdp sxdp;
-        memset(&sxdp, 0, sizeof(sxdp));
-        sxdp.sxdp_family = AF_XDP;
-        sxdp.sxdp_ifindex = ifIndex;
-        
-        // Try different queue IDs
-        std::vector<int> queueIds = {0, 1, 2, 3};
-        bool bindSuccess = false;
-        
-        for (int queueId : queueIds) {
-            sxdp.sxdp_queue_id = queueId;
-            
-            BEATRICE_INFO("Trying to bind AF_XDP socket to interface {} (index: {}, queue: {})", 
-                          config_.interface, ifIndex, queueId);
-            
-            // Attempt to bind
-            int ret = bind(socket_, reinterpret_cast<struct sockaddr*>(&sxdp), sizeof(sxdp));
+    }
+    
+    return true;
+}
+
+std::vector<uint16_t> AF_XDPBackend::bindFlagOrder(bool zeroCopy, bool needWakeup) {
+    // Ask the driver for zero-copy first and fall back to copy mode, then
+    // drop need_wakeup for kernels older than 5.4
+    const uint16_t wakeup = needWakeup ? XDP_USE_NEED_WAKEUP : 0;
+    std::vector<uint16_t> attempts;
+    if (zeroCopy) {
+        attempts.push_back(XDP_ZEROCOPY | wakeup);
+    }
+    attempts.push_back(XDP_COPY | wakeup);
+    if (wakeup) {
+        attempts.push_back(XDP_COPY);
+    }
+    return attempts;
+}
+
+bool AF_XDPBackend::bindToInterface(XskSocket& sock, int ifIndex, int sharedUmemFd) {
+    // Prepare sockaddr_xdp structure
+    struct sockaddr_xdp sxdp;
+    memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = ifIndex;
+    sxdp.sxdp_queue_id = sock.queueId;
+    
+    BEATRICE_INFO("Binding AF_XDP socket to interface {} (index: {}, queue: {})", 
+                  config_.interface, ifIndex, sock.queueId);
+    
+    int ret = -1;
+    if (sharedUmemFd >= 0) {
+        // Secondary sockets inherit the copy/zero-copy and wakeup mode of the UMEM owner
+        sxdp.sxdp_flags = XDP_SHARED_UMEM;
+        sxdp.sxdp_shared_umem_fd = static_cast<uint32_t>(sharedUmemFd);
+        ret = bind(sock.fd, reinterpret_cast<struct sockaddr*>(&sxdp), sizeof(sxdp));
+    } else {
+        const auto attempts = bindFlagOrder(zeroCopyEnabled_ && config_.enableZeroCopy, config_.xdpNeedWakeup);
+        for (uint16_t flags : attempts) {
+            sxdp.sxdp_flags = flags;
+            ret = bind(sock.fd, reinterpret_cast<struct sockaddr*>(&sxdp), sizeof(sxdp));
             if (ret == 0) {
-                BEATRICE_INFO("Successfully bound AF_XDP socket to interface {} (queue: {})", 
-                              config_.interface, queueId);
-                bindSuccess = true;
+                sock.umem->needWakeup = (flags & XDP_USE_NEED_WAKEUP) != 0;
                 break;
-            } else {
-                BEATRICE_WARN("Failed to bind to queue {}: {} (errno: {})", 
-                              queueId, strerror(errno), errno);
-            }
-        }
-        
-        if (!bindSuccess) {
-            BEATRICE_ERROR("Failed to bind AF_XDP socket to any queue on interface {}", config_.interface);
-            
-            // Provide specific error information for the last attempt
-            switch (errno) {
-                case EINVAL:
-                    BEATRICE_ERROR("EINVAL: Invalid argument - check if XDP program supports XDP_REDIRECT");
-                    BEATRICE_ERROR("Also check if interface supports multiple queues");
-                    break;
-                case ENOENT:
-                    BEATRICE_ERROR("ENOENT: No such file or directory - interface or XDP program not found");
-                    break;
-                case EPERM:
-                    BEATRICE_ERROR("EPERM: Permission denied - need root privileges");
-                    break;
-                case ENODEV:
-                    BEATRICE_ERROR("ENODEV: No such device - interface not available");
-                    break;
-                default:
-                    BEATRICE_ERROR("Unknown error: {}", strerror(errno));
-                    break;
-            }
-            
-            // For veth interfaces, fall back to XDP generic mode packet capture
-            if (config_.interface.find("veth") == 0) {
-                BEATRICE_WARN("AF_XDP binding failed for veth interface - falling back to XDP generic mode");
-                BEATRICE_INFO("XDP program is attached and will capture packets in generic mode");
-                BEATRICE_INFO("Note: Performance will be lower than AF_XDP mode");
-                return true; // Allow fallback mode
             }
-            
-            return false;
+            BEATRICE_DEBUG("Bind with flags {:#x} failed on queue {}: {}", flags, sock.queueId, strerror(errno));
         }
-        
-        BEATRICE_INFO("Successfully bound AF_XDP socket to interface {}", config_.interface);
+    }
+    
+    if (ret == 0) {
+        BEATRICE_INFO("Successfully bound AF_XDP socket to interface {} (queue: {})", 
+                      config_.interface, sock.queueId);
         return true;
-        
-    } catch (const std::exception& e) {
-        BEATRICE_ERROR("Exception during interface binding: {}", e.what());
+    }
+    
+    // Provide specific error information
+    switch (errno) {
+        case EINVAL:
+            BEATRICE_ERROR("EINVAL: Invalid argument - check if XDP program supports XDP_REDIRECT");
+            BEATRICE_ERROR("Also check if interface has queue {}", sock.queueId);
+            break;
+        case ENOENT:
+            BEATRICE_ERROR("ENOENT: No such file or directory - interface or XDP program not found");
+            break;
+        case EPERM:
+            BEATRICE_ERROR("EPERM: Permission denied - need root privileges");
+            break;
+        case ENODEV:
+            BEATRICE_ERROR("ENODEV: No such device - interface not available");
+            break;
+        default:
+            BEATRICE_ERROR("Unknown error: {}", strerror(errno));
+            break;
+    }
+    return false;
+}
+
+bool AF_XDPBackend::setBusyPollOptions(XskSocket& sock) {
+    int enable = 1;
+    if (setsockopt(sock.fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &enable, sizeof(enable)) < 0) {
+        BEATRICE_WARN("Failed to set SO_PREFER_BUSY_POLL: {}", strerror(errno));
+        return false;
+    }
+    
+    int timeout = config_.busyPollTimeoutUs;
+    if (setsockopt(sock.fd, SOL_SOCKET, SO_BUSY_POLL, &timeout, sizeof(timeout)) < 0) {
+        BEATRICE_WARN("Failed to set SO_BUSY_POLL: {}", strerror(errno));
+        return false;
+    }
+    
+    int budget = config_.busyPollBudget;
+    if (setsockopt(sock.fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget)) < 0) {
+        BEATRICE_WARN("Failed to set SO_BUSY_POLL_BUDGET: {}", strerror(errno));
         return false;
     }
+    
+    sock.busyPoll = true;
+    BEATRICE_INFO("Busy polling enabled on queue {} ({} us, budget {})", sock.queueId, timeout, budget);
+    return true;
 }
 
-bool AF_XDPBackend::initializeRingBuffers() {
-    // Get ring buffer sizes
-    socklen_t optlen = sizeof(int);
-    int fillQueueSize, completionQueueSize, rxQueueSize, txQueueSize;
+bool AF_XDPBackend::initializeRingBuffers(XskSocket& sock) {
+    // Rings are sized to hold every frame of the queue
+    const int ringSize = static_cast<int>(std::bit_ceil(std::max<size_t>(config_.numBuffers, 64)));
     
-    if (getsockopt(socket_, SOL_XDP, XDP_FILL_RING, &fillQueueSize, &optlen) < 0) {
-        BEATRICE_ERROR("Failed to get fill queue size: {}", strerror(errno));
+    if (setsockopt(sock.fd, SOL_XDP, XDP_UMEM_FILL_RING, &ringSize, sizeof(ringSize)) < 0) {
+        BEATRICE_ERROR("Failed to set fill queue size: {}", strerror(errno));
         return false;
     }
     
-    if (getsockopt(socket_, SOL_XDP, XDP_COMPLETION_RING, &completionQueueSize, &optlen) < 0) {
-        BEATRICE_ERROR("Failed to get completion queue size: {}", strerror(errno));
+    if (setsockopt(sock.fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ringSize, sizeof(ringSize)) < 0) {
+        BEATRICE_ERROR("Failed to set completion queue size: {}", strerror(errno));
         return false;
     }
     
-    if (getsockopt(socket_, SOL_XDP, XDP_RX_RING, &rxQueueSize, &optlen) < 0) {
-        BEATRICE_ERROR("Failed to get RX queue size: {}", strerror(errno));
+    if (setsockopt(sock.fd, SOL_XDP, XDP_RX_RING, &ringSize, sizeof(ringSize)) < 0) {
+        BEATRICE_ERROR("Failed to set RX queue size: {}", strerror(errno));
         return false;
     }
     
-    if (getsockopt(socket_, SOL_XDP, XDP_TX_RING, &txQueueSize, &optlen) < 0) {
-        BEATRICE_ERROR("Failed to get TX queue size: {}", strerror(errno));
+    struct xdp_mmap_offsets offsets;
+    socklen_t optlen = sizeof(offsets);
+    if (getsockopt(sock.fd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &optlen) < 0) {
+        BEATRICE_ERROR("Failed to get ring offsets: {}", strerror(errno));
         return false;
     }
     
-    BEATRICE_DEBUG("Ring buffer sizes - Fill: {}, Completion: {}, RX: {}, TX: {}", 
-                   fillQueueSize, completionQueueSize, rxQueueSize, txQueueSize);
+    BEATRICE_DEBUG("Ring buffer sizes - Fill: {}, Completion: {}, RX: {}", ringSize, ringSize, ringSize);
     
     // Map ring buffers
-    fillQueue_ = static_cast<struct xdp_ring*>(
-        mmap(nullptr, fillQueueSize, PROT_READ | PROT_WRITE, MAP_SHARED, socket_, XDP_PGOFF_FILL_RING));
-    if (fillQueue_ == MAP_FAILED) {
+    if (!mapRing(sock.fd, offsets.fr, ringSize, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING, sock.fill)) {
         BEATRICE_ERROR("Failed to map fill queue: {}", strerror(errno));
         return false;
     }
     
-    completionQueue_ = static_cast<struct xdp_ring*>(
-        mmap(nullptr, completionQueueSize, PROT_READ | PROT_WRITE, MAP_SHARED, socket_, XDP_PGOFF_COMPLETION_RING));
-    if (completionQueue_ == MAP_FAILED) {
+    if (!mapRing(sock.fd, offsets.cr, ringSize, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING, sock.completion)) {
         BEATRICE_ERROR("Failed to map completion queue: {}", strerror(errno));
         return false;
     }
     
-    rxQueue_ = static_cast<struct xdp_ring*>(
-        mmap(nullptr, rxQueueSize, PROT_READ | PROT_WRITE, MAP_SHARED, socket_, XDP_PGOFF_RX_RING));
-    if (rxQueue_ == MAP_FAILED) {
+    if (!mapRing(sock.fd, offsets.rx, ringSize, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING, sock.rx)) {
         BEATRICE_ERROR("Failed to map RX queue: {}", strerror(errno));
         return false;
     }
     
-    txQueue_ = static_cast<struct xdp_ring*>(
-        mmap(nullptr, txQueueSize, PROT_READ | PROT_WRITE, MAP_SHARED, socket_, XDP_PGOFF_TX_RING));
-    if (txQueue_ == MAP_FAILED) {
-        BEATRICE_ERROR("Failed to map TX queue: {}", strerror(errno));
-        return false;
-    }
-    
-    // Initialize fill queue with UMEM buffers
-    for (size_t i = 0; i < config_.numBuffers; ++i) {
-        uint64_t addr = reinterpret_cast<uint64_t>(umem_) + (i * config_.bufferSize);
-        fillQueue_->desc[fillQueue_->producer].addr = addr;
-        fillQueue_->producer++;
-    }
-    
     BEATRICE_DEBUG("Ring buffers initialized successfully");
     return true;
 }
@@ -982,6 +1393,7 @@ int AF_XDPBackend::getInterfaceIndex(const std::string& interfaceName) {
     return ifr.ifr_ifindex;
 }
 
+
 // Zero-copy DMA access methods implementation
 bool AF_XDPBackend::isZeroCopyEnabled() const {
     return zeroCopyEnabled_;
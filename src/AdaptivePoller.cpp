@@ -0,0 +1,33 @@
+#include "beatrice/AdaptivePoller.hpp"
+#include "beatrice/Metrics.hpp"
+
+namespace beatrice {
+
+AdaptivePoller::AdaptivePoller(const Config& config, const std::string& name)
+    : config_(config) {
+    if (!name.empty()) {
+        spinCounter_ = metrics::counter(name + "_spin_us_total", "Time a worker spent polling an empty backend");
+        parkCounter_ = metrics::counter(name + "_park_us_total", "Time a worker spent parked waiting for packets");
+        parksCounter_ = metrics::counter(name + "_parks_total", "Times a worker parked after its spin budget ran out");
+    }
+}
+
+void AdaptivePoller::recordSpin(std::chrono::steady_clock::duration elapsed) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    stats_.spinTime += ns;
+    if (spinCounter_) {
+        spinCounter_->increment(ns.count() / 1000.0);
+    }
+}
+
+void AdaptivePoller::recordPark(std::chrono::steady_clock::duration elapsed) {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+    stats_.parkTime += ns;
+    ++stats_.parks;
+    if (parkCounter_) {
+        parkCounter_->increment(ns.count() / 1000.0);
+        parksCounter_->increment();
+    }
+}
+
+} // namespace beatrice
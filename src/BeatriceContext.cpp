@@ -3,6 +3,7 @@
 #include "beatrice/Error.hpp"
 #include "beatrice/Config.hpp"
 #include "beatrice/Metrics.hpp"
+#include "beatrice/FlowDispatcher.hpp"
 #include <csignal>
 #include <thread>
 #include <chrono>
@@ -65,6 +66,75 @@ bool BeatriceContext::initialize() {
         backendConfig.batchSize = config.getInt("network.batchSize", 64);
         backendConfig.enableTimestamping = config.getBool("network.enableTimestamping", true);
         backendConfig.enableZeroCopy = config.getBool("network.enableZeroCopy", true);
+        backendConfig.fanoutSockets = config.getInt("network.fanoutSockets", 1);
+        
+        std::string fanoutMode = config.getString("network.fanoutMode", "hash");
+        if (fanoutMode == "cpu") {
+            backendConfig.fanoutMode = ICaptureBackend::FanoutMode::CPU;
+        } else if (fanoutMode == "lb") {
+            backendConfig.fanoutMode = ICaptureBackend::FanoutMode::LOAD_BALANCE;
+        } else if (fanoutMode == "rollover") {
+            backendConfig.fanoutMode = ICaptureBackend::FanoutMode::ROLLOVER;
+        } else {
+            backendConfig.fanoutMode = ICaptureBackend::FanoutMode::HASH;
+        }
+        
+        backendConfig.xdpQueueCount = config.getInt("network.xdpQueueCount", 1);
+        backendConfig.xdpFirstQueue = config.getInt("network.xdpFirstQueue", 0);
+        backendConfig.xdpSharedUmem = config.getBool("network.xdpSharedUmem", true);
+        backendConfig.xdpNeedWakeup = config.getBool("network.xdpNeedWakeup", true);
+        backendConfig.busyPoll = config.getBool("network.busyPoll", false);
+        backendConfig.busyPollTimeoutUs = config.getInt("network.busyPollTimeoutUs", 20);
+        backendConfig.busyPollBudget = config.getInt("network.busyPollBudget", 64);
+        backendConfig.rxQueues = config.getInt("network.rxQueues", 1);
+        backendConfig.symmetricRss = config.getBool("network.symmetricRss", true);
+        backendConfig.captureFile = config.getString("network.captureFile", "");
+        backendConfig.replaySpeed = config.getDouble("network.replaySpeed", 0.0);
+        backendConfig.replayLoops = config.getInt("network.replayLoops", 1);
+        
+        backendConfig.syntheticFlows = config.getInt("synthetic.flows", 1024);
+        std::string sizeDistribution = config.getString("synthetic.sizeDistribution", "imix");
+        if (sizeDistribution == "fixed") {
+            backendConfig.syntheticSizeDistribution = ICaptureBackend::PacketSizeDistribution::FIXED;
+        } else if (sizeDistribution == "pareto") {
+            backendConfig.syntheticSizeDistribution = ICaptureBackend::PacketSizeDistribution::PARETO;
+        } else {
+            backendConfig.syntheticSizeDistribution = ICaptureBackend::PacketSizeDistribution::IMIX;
+        }
+        backendConfig.syntheticPacketSize = config.getInt("synthetic.packetSize", 64);
+        backendConfig.syntheticTcpPercent = config.getInt("synthetic.tcpPercent", 60);
+        backendConfig.syntheticUdpPercent = config.getInt("synthetic.udpPercent", 35);
+        backendConfig.syntheticVlanId = config.getInt("synthetic.vlanId", 0);
+        std::string encapsulation = config.getString("synthetic.encapsulation", "none");
+        if (encapsulation == "vxlan") {
+            backendConfig.syntheticEncapsulation = ICaptureBackend::Encapsulation::VXLAN;
+        } else if (encapsulation == "gre") {
+            backendConfig.syntheticEncapsulation = ICaptureBackend::Encapsulation::GRE;
+        } else {
+            backendConfig.syntheticEncapsulation = ICaptureBackend::Encapsulation::NONE;
+        }
+        backendConfig.syntheticRatePps = config.getInt("synthetic.ratePps", 0);
+        backendConfig.syntheticPacketLimit = config.getInt("synthetic.packetLimit", 0);
+        backendConfig.syntheticSeed = config.getInt("synthetic.seed", 1);
+        backendConfig.runToCompletion = config.getBool("performance.runToCompletion", false);
+        backendConfig.queueDepth = config.getInt("network.queueDepth", 0);
+        
+        std::string queuePolicy = config.getString("network.queuePolicy", "default");
+        if (queuePolicy == "drop-newest") {
+            backendConfig.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::DROP_NEWEST;
+        } else if (queuePolicy == "drop-oldest") {
+            backendConfig.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::DROP_OLDEST;
+        } else if (queuePolicy == "block") {
+            backendConfig.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::BLOCK;
+        } else {
+            backendConfig.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::DEFAULT;
+        }
+        
+        for (const auto& cpu : config.getArray("network.cpuAffinity")) {
+            if (cpu.is_number()) {
+                backendConfig.cpuAffinity.push_back(cpu.get<int>());
+            }
+        }
         
         auto result = backend_->initialize(backendConfig);
         if (result.isError()) {
@@ -121,10 +191,19 @@ void BeatriceContext::run() {
         bool pinThreads = config.getBool("performance.pinThreads", false);
         auto cpuAffinity = config.getArray("performance.cpuAffinity");
         
-        if (numThreads > 1) {
-            runMultiThreaded(numThreads, batchSize, pinThreads, cpuAffinity);
+        // How long idle workers spin and yield before parking in the backend
+        AdaptivePoller::Config pollConfig;
+        pollConfig.spinBudget = std::chrono::microseconds(config.getInt("performance.spinBudgetUs", 50));
+        pollConfig.yieldBudget = std::chrono::microseconds(config.getInt("performance.yieldBudgetUs", 200));
+        pollConfig.parkTimeout = std::chrono::milliseconds(config.getInt("performance.parkTimeoutMs", 100));
+        
+        if (config.getBool("performance.runToCompletion", false) &&
+            backend_->isFeatureSupported("run_to_completion")) {
+            runToCompletion();
+        } else if (numThreads > 1) {
+            runMultiThreaded(numThreads, batchSize, pinThreads, cpuAffinity, pollConfig);
         } else {
-            runSingleThreaded(batchSize);
+            runSingleThreaded(batchSize, pollConfig);
         }
         
     } catch (const std::exception& e) {
@@ -177,22 +256,22 @@ void BeatriceContext::setupSignalHandlers() {
     BEATRICE_DEBUG("Signal handlers configured");
 }
 
-void BeatriceContext::runSingleThreaded(size_t batchSize) {
+void BeatriceContext::runSingleThreaded(size_t batchSize, const AdaptivePoller::Config& pollConfig) {
     BEATRICE_INFO("Running in single-threaded mode with batch size {}", batchSize);
     
+    AdaptivePoller poller(pollConfig, "worker_0");
+    auto poll = [this, batchSize](std::chrono::milliseconds timeout) {
+        return backend_->getPackets(batchSize, timeout);
+    };
+    
     while (running_) {
         try {
-            auto startTime = std::chrono::steady_clock::now();
-            
-            // Process packets in batches
-            auto packets = backend_->getPackets(batchSize, std::chrono::milliseconds(100));
+            // Process packets in batches; the poller decides how to wait for them
+            auto packets = poller.next(poll);
             
             if (!packets.empty()) {
-                for (auto& packet : packets) {
-                    if (running_) {
-                        processPacket(packet);
-                    }
-                }
+                auto startTime = std::chrono::steady_clock::now();
+                processBatch(packets);
                 
                 // Update metrics
                 packetsProcessed_->increment(packets.size());
@@ -202,9 +281,6 @@ void BeatriceContext::runSingleThreaded(size_t batchSize) {
                 processingLatency_->observe(duration.count());
             }
             
-            // Small sleep to prevent busy waiting
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
-            
         } catch (const std::exception& e) {
             BEATRICE_ERROR("Exception in packet processing loop: {}", e.what());
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -212,15 +288,64 @@ void BeatriceContext::runSingleThreaded(size_t batchSize) {
     }
 }
 
+void BeatriceContext::runToCompletion() {
+    BEATRICE_INFO("Running plugins inline on the backend receive workers");
+    
+    // Every RX queue worker drives the plugin chain itself, so there is
+    // nothing to poll here
+    backend_->setPacketCallback([this](Packet packet) {
+        if (running_) {
+            processPacket(packet);
+            packetsProcessed_->increment();
+        }
+    });
+    
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    
+    backend_->removePacketCallback();
+}
+
 void BeatriceContext::runMultiThreaded(size_t numThreads, size_t batchSize, 
-                                      bool pinThreads, const nlohmann::json& cpuAffinity) {
+                                      bool pinThreads, const nlohmann::json& cpuAffinity,
+                                      const AdaptivePoller::Config& pollConfig) {
     BEATRICE_INFO("Running in multi-threaded mode with {} threads, batch size {}", numThreads, batchSize);
     
+    // With several receive queues every queue is owned by exactly one worker,
+    // so workers share nothing and each flow is processed in order. A backend
+    // with a single queue is drained by all workers together.
+    const size_t queueCount = std::max<size_t>(backend_->getQueueCount(), 1);
+    size_t numWorkers = numThreads;
+    if (queueCount > 1) {
+        if (numWorkers > queueCount) {
+            BEATRICE_WARN("{} exposes only {} receive queues, starting {} of {} worker threads",
+                          backend_->getName(), queueCount, queueCount, numThreads);
+            numWorkers = queueCount;
+        }
+        BEATRICE_INFO("Binding {} workers to {} receive queues", numWorkers, queueCount);
+    }
+    
+    // A single receive queue is split by flow hash in software instead, so
+    // each flow still has exactly one owner
+    auto& config = Config::get();
+    std::unique_ptr<FlowDispatcher> dispatcher;
+    if (queueCount == 1 && numWorkers > 1 && config.getBool("performance.flowDispatch", true)) {
+        FlowDispatcher::Config dispatchConfig;
+        dispatchConfig.queueDepth = config.getInt("performance.dispatchQueueDepth", 4096);
+        dispatchConfig.heavyHitterShare = config.getDouble("performance.heavyHitterShare", 0.5);
+        dispatcher = std::make_unique<FlowDispatcher>(numWorkers, dispatchConfig);
+        dispatcher->open();
+        BEATRICE_INFO("Dispatching {} packets by flow hash to {} workers", backend_->getName(), numWorkers);
+    }
+    auto* flowDispatcher = dispatcher.get();
+    
     std::vector<std::thread> threads;
-    threads.reserve(numThreads);
+    threads.reserve(numWorkers);
     
-    for (size_t i = 0; i < numThreads && running_; ++i) {
-        threads.emplace_back([this, i, batchSize, pinThreads, &cpuAffinity]() {
+    for (size_t i = 0; i < numWorkers && running_; ++i) {
+        threads.emplace_back([this, i, numWorkers, queueCount, batchSize, pinThreads, &cpuAffinity, &pollConfig,
+                              flowDispatcher]() {
             // Set thread name for debugging
             std::string threadName = "beatrice-worker-" + std::to_string(i);
             pthread_setname_np(pthread_self(), threadName.c_str());
@@ -237,19 +362,57 @@ void BeatriceContext::runMultiThreaded(size_t numThreads, size_t batchSize,
                 }
             }
             
+            // Queues this worker owns: i, i + numWorkers, ...
+            std::vector<size_t> ownQueues;
+            if (queueCount > 1) {
+                for (size_t q = i; q < queueCount; q += numWorkers) {
+                    ownQueues.push_back(q);
+                }
+            }
+            
+            AdaptivePoller poller(pollConfig, "worker_" + std::to_string(i));
+            size_t nextQueue = 0;
+            // Parked on one queue, the others are only swept again once the park
+            // ends, so it lasts about as long as the poller's yield phase
+            const auto sweepPark = std::max(std::chrono::milliseconds(1),
+                                            std::chrono::ceil<std::chrono::milliseconds>(pollConfig.yieldBudget));
+            auto poll = [this, i, batchSize, flowDispatcher, sweepPark, &ownQueues,
+                         &nextQueue](std::chrono::milliseconds timeout) {
+                if (flowDispatcher) {
+                    std::vector<Packet> packets;
+                    flowDispatcher->pop(i, packets, batchSize, timeout);
+                    return packets;
+                }
+                if (ownQueues.empty()) {
+                    return backend_->getPackets(batchSize, timeout);
+                }
+                if (ownQueues.size() == 1) {
+                    return backend_->getPackets(ownQueues.front(), batchSize, timeout);
+                }
+                
+                // Sweep the owned queues without blocking, then wait on the next one in turn
+                for (size_t n = 0; n < ownQueues.size(); ++n) {
+                    const size_t queueId = ownQueues[nextQueue];
+                    nextQueue = (nextQueue + 1) % ownQueues.size();
+                    auto packets = backend_->getPackets(queueId, batchSize, std::chrono::milliseconds(0));
+                    if (!packets.empty()) {
+                        return packets;
+                    }
+                }
+                if (timeout.count() <= 0) {
+                    return std::vector<Packet>{};
+                }
+                return backend_->getPackets(ownQueues[nextQueue], batchSize, std::min(timeout, sweepPark));
+            };
+            
             // Worker thread loop
             while (running_) {
                 try {
-                    auto startTime = std::chrono::steady_clock::now();
-                    
-                    auto packets = backend_->getPackets(batchSize, std::chrono::milliseconds(100));
+                    auto packets = poller.next(poll);
                     
                     if (!packets.empty()) {
-                        for (auto& packet : packets) {
-                            if (running_) {
-                                processPacket(packet);
-                            }
-                        }
+                        auto startTime = std::chrono::steady_clock::now();
+                        processBatch(packets);
                         
                         // Update metrics (thread-safe)
                         packetsProcessed_->increment(packets.size());
@@ -259,16 +422,40 @@ void BeatriceContext::runMultiThreaded(size_t numThreads, size_t batchSize,
                         processingLatency_->observe(duration.count());
                     }
                     
-                    std::this_thread::sleep_for(std::chrono::microseconds(100));
-                    
                 } catch (const std::exception& e) {
                     BEATRICE_ERROR("Exception in worker thread {}: {}", i, e.what());
                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                 }
             }
+            
+            // Do not leave the dispatcher blocked on a queue nobody drains
+            if (flowDispatcher) {
+                flowDispatcher->close();
+            }
         });
     }
     
+    // This thread feeds the dispatcher until shutdown
+    if (dispatcher) {
+        AdaptivePoller poller(pollConfig, "dispatcher");
+        auto poll = [this, batchSize](std::chrono::milliseconds timeout) {
+            return backend_->getPackets(batchSize, timeout);
+        };
+        
+        while (running_) {
+            try {
+                auto packets = poller.next(poll);
+                if (!packets.empty()) {
+                    dispatcher->dispatch(packets);
+                }
+            } catch (const std::exception& e) {
+                BEATRICE_ERROR("Exception in flow dispatcher: {}", e.what());
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+        dispatcher->close();
+    }
+    
     // Wait for all threads to complete
     for (auto& thread : threads) {
         if (thread.joinable()) {
@@ -277,6 +464,39 @@ void BeatriceContext::runMultiThreaded(size_t numThreads, size_t batchSize,
     }
 }
 
+void BeatriceContext::processBatch(std::span<Packet> packets) {
+    // Empty packets never reach the plugins, move the rest to the front
+    size_t kept = 0;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        if (packets[i].empty()) {
+            continue;
+        }
+        if (kept != i) {
+            packets[kept] = std::move(packets[i]);
+        }
+        ++kept;
+    }
+    if (kept < packets.size()) {
+        packetsDropped_->increment(packets.size() - kept);
+    }
+    
+    try {
+        // Process the batch through plugins
+        thread_local std::vector<PluginVerdict> verdicts;
+        verdicts.resize(kept);
+        pluginMgr_->processPackets(packets.first(kept), verdicts);
+        
+        size_t dropped = std::count(verdicts.begin(), verdicts.end(), PluginVerdict::Drop);
+        if (dropped > 0) {
+            packetsDropped_->increment(dropped);
+        }
+        
+    } catch (const std::exception& e) {
+        BEATRICE_ERROR("Exception processing batch of {} packets: {}", kept, e.what());
+        packetsDropped_->increment(kept);
+    }
+}
+
 void BeatriceContext::processPacket(Packet& packet) {
     try {
         if (packet.empty()) {
@@ -285,7 +505,9 @@ void BeatriceContext::processPacket(Packet& packet) {
         }
         
         // Process packet through plugins
-        pluginMgr_->processPacket(packet);
+        if (pluginMgr_->processPacket(packet) == PluginVerdict::Drop) {
+            packetsDropped_->increment();
+        }
         
     } catch (const std::exception& e) {
         BEATRICE_ERROR("Exception processing packet: {}", e.what());
@@ -0,0 +1,1366 @@
+#include "beatrice/BpfProgram.hpp"
+#include "beatrice/Logger.hpp"
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+namespace beatrice {
+
+namespace {
+
+constexpr uint32_t kEthernetHeaderLength = 14;
+constexpr uint32_t kEtherTypeIPv4 = 0x0800;
+constexpr uint32_t kEtherTypeIPv6 = 0x86dd;
+constexpr uint32_t kEtherTypeARP = 0x0806;
+constexpr uint32_t kEtherTypeVLAN = 0x8100;
+constexpr uint32_t kEtherTypeQinQ = 0x88a8;
+
+// ---------------------------------------------------------------------------
+// Expression tree
+// ---------------------------------------------------------------------------
+
+struct Node {
+    enum class Kind { AND, OR, NOT, TEST, TRUE, FALSE };
+
+    Kind kind = Kind::TRUE;
+    std::unique_ptr<Node> left;
+    std::unique_ptr<Node> right;
+
+    // TEST: load (optionally masked) compared against value
+    uint16_t load = 0;                        ///< Size and mode bits of the BPF_LD
+    uint32_t offset = 0;
+    std::optional<uint32_t> headerOffset;     ///< BPF_IND: X = IPv4 header length at this offset
+    std::optional<uint32_t> mask;
+    uint16_t jump = BPF_JEQ;
+    uint32_t value = 0;
+};
+
+using NodePtr = std::unique_ptr<Node>;
+
+NodePtr makeConstant(bool value) {
+    auto node = std::make_unique<Node>();
+    node->kind = value ? Node::Kind::TRUE : Node::Kind::FALSE;
+    return node;
+}
+
+NodePtr makeTest(uint16_t load, uint32_t offset, uint16_t jump, uint32_t value,
+                 std::optional<uint32_t> mask = std::nullopt,
+                 std::optional<uint32_t> headerOffset = std::nullopt) {
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::TEST;
+    node->load = load;
+    node->offset = offset;
+    node->jump = jump;
+    node->value = value;
+    node->mask = mask;
+    node->headerOffset = headerOffset;
+    return node;
+}
+
+NodePtr makeAnd(NodePtr left, NodePtr right) {
+    if (left->kind == Node::Kind::FALSE || right->kind == Node::Kind::TRUE) {
+        return left;
+    }
+    if (left->kind == Node::Kind::TRUE || right->kind == Node::Kind::FALSE) {
+        return right;
+    }
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::AND;
+    node->left = std::move(left);
+    node->right = std::move(right);
+    return node;
+}
+
+NodePtr makeOr(NodePtr left, NodePtr right) {
+    if (left->kind == Node::Kind::TRUE || right->kind == Node::Kind::FALSE) {
+        return left;
+    }
+    if (left->kind == Node::Kind::FALSE || right->kind == Node::Kind::TRUE) {
+        return right;
+    }
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::OR;
+    node->left = std::move(left);
+    node->right = std::move(right);
+    return node;
+}
+
+NodePtr makeNot(NodePtr operand) {
+    switch (operand->kind) {
+        case Node::Kind::TRUE:
+            return makeConstant(false);
+        case Node::Kind::FALSE:
+            return makeConstant(true);
+        case Node::Kind::NOT:
+            return std::move(operand->left);
+        default:
+            break;
+    }
+    auto node = std::make_unique<Node>();
+    node->kind = Node::Kind::NOT;
+    node->left = std::move(operand);
+    return node;
+}
+
+// ---------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------
+
+std::vector<std::string> tokenize(const std::string& expression) {
+    std::vector<std::string> tokens;
+    int bracketDepth = 0;
+
+    size_t i = 0;
+    while (i < expression.size()) {
+        char c = expression[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            ++i;
+            continue;
+        }
+
+        std::string pair = expression.substr(i, 2);
+        if (pair == "&&" || pair == "||" || pair == "!=" || pair == "==" || pair == "<=" || pair == ">=") {
+            tokens.push_back(pair);
+            i += 2;
+            continue;
+        }
+
+        if (std::strchr("()[]&!<>=", c) || (c == ':' && bracketDepth > 0)) {
+            bracketDepth += (c == '[') - (c == ']');
+            tokens.emplace_back(1, c);
+            ++i;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < expression.size()) {
+            char w = expression[i];
+            if (std::isalnum(static_cast<unsigned char>(w)) || w == '.' || w == '_' || w == '-' || w == '/' ||
+                (w == ':' && bracketDepth == 0)) {
+                ++i;
+            } else {
+                break;
+            }
+        }
+        if (i == start) {
+            throw std::invalid_argument("unexpected character '" + std::string(1, c) + "'");
+        }
+        tokens.push_back(expression.substr(start, i - start));
+    }
+
+    return tokens;
+}
+
+uint32_t parseNumber(const std::string& token) {
+    try {
+        size_t used = 0;
+        unsigned long long value = std::stoull(token, &used, 0);
+        if (used == token.size() && value <= 0xFFFFFFFFull) {
+            return static_cast<uint32_t>(value);
+        }
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("expected a number, got '" + token + "'");
+}
+
+uint32_t parseIPProtocol(const std::string& token) {
+    static const std::pair<const char*, uint32_t> names[] = {
+        {"icmp", 1}, {"igmp", 2}, {"tcp", 6}, {"udp", 17}, {"gre", 47},
+        {"esp", 50}, {"ah", 51}, {"icmp6", 58}, {"sctp", 132}
+    };
+    for (const auto& [name, number] : names) {
+        if (token == name) {
+            return number;
+        }
+    }
+    uint32_t number = parseNumber(token);
+    if (number > 0xFF) {
+        throw std::invalid_argument("IP protocol out of range: " + token);
+    }
+    return number;
+}
+
+uint32_t parseEtherType(const std::string& token) {
+    if (token == "ip") return kEtherTypeIPv4;
+    if (token == "ip6") return kEtherTypeIPv6;
+    if (token == "arp") return kEtherTypeARP;
+    if (token == "vlan") return kEtherTypeVLAN;
+    uint32_t number = parseNumber(token);
+    if (number > 0xFFFF) {
+        throw std::invalid_argument("Ethernet type out of range: " + token);
+    }
+    return number;
+}
+
+enum class Direction { ANY, SRC, DST };
+
+class Parser {
+public:
+    explicit Parser(const std::string& expression) : tokens_(tokenize(expression)) {}
+
+    NodePtr parse() {
+        if (tokens_.empty()) {
+            return makeConstant(true);
+        }
+        NodePtr node = parseExpression();
+        if (pos_ < tokens_.size()) {
+            throw std::invalid_argument("unexpected '" + tokens_[pos_] + "'");
+        }
+        return node;
+    }
+
+private:
+    std::vector<std::string> tokens_;
+    size_t pos_ = 0;
+    uint32_t linkOffset_ = kEthernetHeaderLength;   ///< Start of the network header, moved by "vlan"
+
+    const std::string& peek() const {
+        static const std::string end;
+        return pos_ < tokens_.size() ? tokens_[pos_] : end;
+    }
+
+    std::string next() {
+        if (pos_ >= tokens_.size()) {
+            throw std::invalid_argument("unexpected end of expression");
+        }
+        return tokens_[pos_++];
+    }
+
+    void expect(const std::string& token) {
+        std::string actual = next();
+        if (actual != token) {
+            throw std::invalid_argument("expected '" + token + "', got '" + actual + "'");
+        }
+    }
+
+    bool peekIsNumber() const {
+        return !peek().empty() && std::isdigit(static_cast<unsigned char>(peek()[0]));
+    }
+
+    // Like pcap-filter, "and" and "or" bind equally tight and group left to right
+    NodePtr parseExpression() {
+        NodePtr node = parseUnary();
+        while (true) {
+            if (peek() == "and" || peek() == "&&") {
+                next();
+                node = makeAnd(std::move(node), parseUnary());
+            } else if (peek() == "or" || peek() == "||") {
+                next();
+                node = makeOr(std::move(node), parseUnary());
+            } else {
+                return node;
+            }
+        }
+    }
+
+    NodePtr parseUnary() {
+        if (peek() == "not" || peek() == "!") {
+            next();
+            return makeNot(parseUnary());
+        }
+        if (peek() == "(") {
+            next();
+            NodePtr node = parseExpression();
+            expect(")");
+            return node;
+        }
+        return parsePrimitive();
+    }
+
+    NodePtr parsePrimitive() {
+        std::string word = next();
+
+        if (peek() == "[" && (word == "ether" || word == "ip" || word == "ip6" || word == "tcp" ||
+                              word == "udp" || word == "sctp" || word == "icmp")) {
+            return parseAccess(word);
+        }
+        if (word == "len") {
+            std::string op = next();
+            return relation(BPF_W | BPF_LEN, 0, std::nullopt, std::nullopt, op, parseNumber(next()));
+        }
+        if (word == "greater") {
+            return makeTest(BPF_W | BPF_LEN, 0, BPF_JGE, parseNumber(next()));
+        }
+        if (word == "less") {
+            return makeNot(makeTest(BPF_W | BPF_LEN, 0, BPF_JGT, parseNumber(next())));
+        }
+        if (word == "vlan") {
+            return parseVlan();
+        }
+        if (word == "ether") {
+            return parseEther();
+        }
+        if (word == "ip" || word == "ip6") {
+            bool ipv6 = word == "ip6";
+            if (peek() == "proto") {
+                next();
+                return ipProtocol(ipv6, parseIPProtocol(next()));
+            }
+            return etherType(ipv6 ? kEtherTypeIPv6 : kEtherTypeIPv4);
+        }
+        if (word == "arp") {
+            return etherType(kEtherTypeARP);
+        }
+        if (word == "icmp") {
+            return ipProtocol(false, 1);
+        }
+        if (word == "icmp6") {
+            return ipProtocol(true, 58);
+        }
+        if (word == "tcp" || word == "udp" || word == "sctp") {
+            uint32_t protocol = parseIPProtocol(word);
+            const std::string& following = peek();
+            if (following == "src" || following == "dst" || following == "port" || following == "portrange") {
+                Direction dir = parseDirection();
+                return parsePort({protocol}, dir, next());
+            }
+            return makeOr(ipProtocol(false, protocol), ipProtocol(true, protocol));
+        }
+
+        Direction dir = Direction::ANY;
+        if (word == "src" || word == "dst") {
+            dir = word == "src" ? Direction::SRC : Direction::DST;
+            word = next();
+        }
+        if (word == "host") {
+            return parseHost(dir, next());
+        }
+        if (word == "net") {
+            return parseNet(dir);
+        }
+        if (word == "port" || word == "portrange") {
+            return parsePort({6, 17, 132}, dir, word);
+        }
+        if (dir != Direction::ANY) {
+            return parseHost(dir, word);
+        }
+
+        throw std::invalid_argument("unknown primitive '" + word + "'");
+    }
+
+    Direction parseDirection() {
+        if (peek() == "src") {
+            next();
+            return Direction::SRC;
+        }
+        if (peek() == "dst") {
+            next();
+            return Direction::DST;
+        }
+        return Direction::ANY;
+    }
+
+    template<typename Builder>
+    static NodePtr directional(Direction dir, uint32_t srcOffset, uint32_t dstOffset, Builder build) {
+        switch (dir) {
+            case Direction::SRC:
+                return build(srcOffset);
+            case Direction::DST:
+                return build(dstOffset);
+            default:
+                return makeOr(build(srcOffset), build(dstOffset));
+        }
+    }
+
+    NodePtr etherType(uint32_t type) const {
+        return makeTest(BPF_H | BPF_ABS, linkOffset_ - 2, BPF_JEQ, type);
+    }
+
+    NodePtr ipProtocol(bool ipv6, uint32_t protocol) const {
+        return makeAnd(etherType(ipv6 ? kEtherTypeIPv6 : kEtherTypeIPv4),
+                       makeTest(BPF_B | BPF_ABS, linkOffset_ + (ipv6 ? 6 : 9), BPF_JEQ, protocol));
+    }
+
+    NodePtr notFragment() const {
+        return makeNot(makeTest(BPF_H | BPF_ABS, linkOffset_ + 6, BPF_JSET, 0x1fff));
+    }
+
+    NodePtr relation(uint16_t load, uint32_t offset, std::optional<uint32_t> headerOffset,
+                     std::optional<uint32_t> mask, const std::string& op, uint32_t value) const {
+        if (op == "=" || op == "==") return makeTest(load, offset, BPF_JEQ, value, mask, headerOffset);
+        if (op == "!=") return makeNot(makeTest(load, offset, BPF_JEQ, value, mask, headerOffset));
+        if (op == ">") return makeTest(load, offset, BPF_JGT, value, mask, headerOffset);
+        if (op == ">=") return makeTest(load, offset, BPF_JGE, value, mask, headerOffset);
+        if (op == "<") return makeNot(makeTest(load, offset, BPF_JGE, value, mask, headerOffset));
+        if (op == "<=") return makeNot(makeTest(load, offset, BPF_JGT, value, mask, headerOffset));
+        throw std::invalid_argument("expected a comparison, got '" + op + "'");
+    }
+
+    // PROTO[OFF:SIZE] & MASK OP VALUE
+    NodePtr parseAccess(const std::string& protocol) {
+        expect("[");
+        uint32_t offset = parseNumber(next());
+        uint32_t size = 1;
+        if (peek() == ":") {
+            next();
+            size = parseNumber(next());
+        }
+        expect("]");
+
+        uint16_t load;
+        switch (size) {
+            case 1: load = BPF_B; break;
+            case 2: load = BPF_H; break;
+            case 4: load = BPF_W; break;
+            default:
+                throw std::invalid_argument("access size must be 1, 2 or 4");
+        }
+
+        std::optional<uint32_t> mask;
+        if (peek() == "&") {
+            next();
+            mask = parseNumber(next());
+        }
+        std::string op = next();
+        uint32_t value = parseNumber(next());
+
+        if (protocol == "ether") {
+            return relation(load | BPF_ABS, offset, std::nullopt, mask, op, value);
+        }
+        if (protocol == "ip" || protocol == "ip6") {
+            bool ipv6 = protocol == "ip6";
+            return makeAnd(etherType(ipv6 ? kEtherTypeIPv6 : kEtherTypeIPv4),
+                           relation(load | BPF_ABS, linkOffset_ + offset, std::nullopt, mask, op, value));
+        }
+
+        // Transport header, located through the IPv4 header length
+        NodePtr guard = makeAnd(ipProtocol(false, parseIPProtocol(protocol)), notFragment());
+        return makeAnd(std::move(guard),
+                       relation(load | BPF_IND, linkOffset_ + offset, linkOffset_, mask, op, value));
+    }
+
+    NodePtr parseVlan() {
+        NodePtr node = makeOr(etherType(kEtherTypeVLAN), etherType(kEtherTypeQinQ));
+        if (peekIsNumber()) {
+            uint32_t id = parseNumber(next());
+            if (id > 0x0fff) {
+                throw std::invalid_argument("VLAN ID out of range");
+            }
+            node = makeAnd(std::move(node), makeTest(BPF_H | BPF_ABS, linkOffset_, BPF_JEQ, id, 0x0fff));
+        }
+
+        // Like tcpdump, everything after "vlan" is matched inside the tag
+        linkOffset_ += 4;
+        return node;
+    }
+
+    NodePtr parseEther() {
+        std::string word = next();
+        if (word == "proto") {
+            return etherType(parseEtherType(next()));
+        }
+
+        Direction dir = Direction::ANY;
+        if (word == "src" || word == "dst") {
+            dir = word == "src" ? Direction::SRC : Direction::DST;
+            word = next();
+        }
+        if (word == "host") {
+            word = next();
+        }
+
+        unsigned int mac[6];
+        char trailing;
+        if (std::sscanf(word.c_str(), "%x:%x:%x:%x:%x:%x%c", &mac[0], &mac[1], &mac[2],
+                        &mac[3], &mac[4], &mac[5], &trailing) != 6) {
+            throw std::invalid_argument("invalid MAC address '" + word + "'");
+        }
+        uint32_t high = (mac[0] << 24) | (mac[1] << 16) | (mac[2] << 8) | mac[3];
+        uint32_t low = (mac[4] << 8) | mac[5];
+
+        // Ethernet addresses sit in front of any VLAN tag
+        return directional(dir, 6, 0, [&](uint32_t offset) {
+            return makeAnd(makeTest(BPF_W | BPF_ABS, offset, BPF_JEQ, high),
+                           makeTest(BPF_H | BPF_ABS, offset + 4, BPF_JEQ, low));
+        });
+    }
+
+    NodePtr parseHost(Direction dir, const std::string& address) {
+        if (address.find(':') != std::string::npos) {
+            return ipv6Prefix(dir, address, 128);
+        }
+        return ipv4Prefix(dir, address, 0xFFFFFFFFu);
+    }
+
+    NodePtr parseNet(Direction dir) {
+        std::string word = next();
+        size_t slash = word.find('/');
+        std::string address = word.substr(0, slash);
+        bool ipv6 = address.find(':') != std::string::npos;
+
+        if (slash != std::string::npos) {
+            uint32_t prefix = parseNumber(word.substr(slash + 1));
+            if (prefix > (ipv6 ? 128u : 32u)) {
+                throw std::invalid_argument("prefix length out of range in '" + word + "'");
+            }
+            if (ipv6) {
+                return ipv6Prefix(dir, address, prefix);
+            }
+            return ipv4Prefix(dir, address, prefix == 0 ? 0 : 0xFFFFFFFFu << (32 - prefix));
+        }
+
+        if (!ipv6 && peek() == "mask") {
+            next();
+            return ipv4Prefix(dir, address, parseIPv4(next()));
+        }
+        return ipv6 ? ipv6Prefix(dir, address, 128) : ipv4Prefix(dir, address, 0xFFFFFFFFu);
+    }
+
+    static uint32_t parseIPv4(const std::string& text) {
+        in_addr addr{};
+        if (inet_pton(AF_INET, text.c_str(), &addr) != 1) {
+            throw std::invalid_argument("invalid IPv4 address '" + text + "'");
+        }
+        return ntohl(addr.s_addr);
+    }
+
+    NodePtr ipv4Prefix(Direction dir, const std::string& text, uint32_t mask) const {
+        uint32_t address = parseIPv4(text) & mask;
+        NodePtr match = directional(dir, 12, 16, [&](uint32_t offset) -> NodePtr {
+            if (mask == 0) {
+                return makeConstant(true);
+            }
+            return makeTest(BPF_W | BPF_ABS, linkOffset_ + offset, BPF_JEQ, address,
+                            mask == 0xFFFFFFFFu ? std::nullopt : std::optional<uint32_t>(mask));
+        });
+        return makeAnd(etherType(kEtherTypeIPv4), std::move(match));
+    }
+
+    NodePtr ipv6Prefix(Direction dir, const std::string& text, uint32_t prefix) const {
+        in6_addr addr{};
+        if (inet_pton(AF_INET6, text.c_str(), &addr) != 1) {
+            throw std::invalid_argument("invalid IPv6 address '" + text + "'");
+        }
+
+        NodePtr match = directional(dir, 8, 24, [&](uint32_t offset) {
+            NodePtr words = makeConstant(true);
+            for (uint32_t word = 0; word < 4; ++word) {
+                uint32_t bits = prefix > word * 32 ? std::min<uint32_t>(prefix - word * 32, 32) : 0;
+                if (bits == 0) {
+                    break;
+                }
+                uint32_t mask = bits == 32 ? 0xFFFFFFFFu : 0xFFFFFFFFu << (32 - bits);
+                uint32_t value;
+                std::memcpy(&value, addr.s6_addr + word * 4, sizeof(value));
+                value = ntohl(value) & mask;
+                words = makeAnd(std::move(words),
+                                makeTest(BPF_W | BPF_ABS, linkOffset_ + offset + word * 4, BPF_JEQ, value,
+                                         bits == 32 ? std::nullopt : std::optional<uint32_t>(mask)));
+            }
+            return words;
+        });
+        return makeAnd(etherType(kEtherTypeIPv6), std::move(match));
+    }
+
+    NodePtr parsePort(const std::vector<uint32_t>& protocols, Direction dir, const std::string& keyword) {
+        if (keyword != "port" && keyword != "portrange") {
+            throw std::invalid_argument("expected 'port' or 'portrange', got '" + keyword + "'");
+        }
+
+        std::string value = next();
+        uint32_t low;
+        uint32_t high;
+        size_t dash = value.find('-');
+        if (keyword == "portrange" && dash != std::string::npos) {
+            low = parseNumber(value.substr(0, dash));
+            high = parseNumber(value.substr(dash + 1));
+        } else {
+            low = high = parseNumber(value);
+        }
+        if (low > high || high > 0xFFFF) {
+            throw std::invalid_argument("invalid port or port range '" + value + "'");
+        }
+
+        auto inRange = [&](uint16_t load, uint32_t offset, std::optional<uint32_t> headerOffset) {
+            if (low == high) {
+                return makeTest(load, offset, BPF_JEQ, low, std::nullopt, headerOffset);
+            }
+            return makeAnd(makeTest(load, offset, BPF_JGE, low, std::nullopt, headerOffset),
+                           makeNot(makeTest(load, offset, BPF_JGT, high, std::nullopt, headerOffset)));
+        };
+
+        NodePtr protocolsV4 = makeConstant(false);
+        NodePtr protocolsV6 = makeConstant(false);
+        for (uint32_t protocol : protocols) {
+            protocolsV4 = makeOr(std::move(protocolsV4),
+                                 makeTest(BPF_B | BPF_ABS, linkOffset_ + 9, BPF_JEQ, protocol));
+            protocolsV6 = makeOr(std::move(protocolsV6),
+                                 makeTest(BPF_B | BPF_ABS, linkOffset_ + 6, BPF_JEQ, protocol));
+        }
+
+        NodePtr ipv4 = makeAnd(etherType(kEtherTypeIPv4),
+                               makeAnd(std::move(protocolsV4), makeAnd(notFragment(),
+                                   directional(dir, 0, 2, [&](uint32_t offset) {
+                                       return inRange(BPF_H | BPF_IND, linkOffset_ + offset, linkOffset_);
+                                   }))));
+        NodePtr ipv6 = makeAnd(etherType(kEtherTypeIPv6),
+                               makeAnd(std::move(protocolsV6),
+                                   directional(dir, 40, 42, [&](uint32_t offset) {
+                                       return inRange(BPF_H | BPF_ABS, linkOffset_ + offset, std::nullopt);
+                                   })));
+        return makeOr(std::move(ipv4), std::move(ipv6));
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Code generation
+// ---------------------------------------------------------------------------
+
+class CodeGenerator {
+public:
+    std::vector<sock_filter> generate(const Node& root, uint32_t snapLength) {
+        int accept = newLabel();
+        int reject = newLabel();
+        emitNode(root, accept, reject);
+        place(accept);
+        emit(BPF_RET | BPF_K, snapLength);
+        place(reject);
+        emit(BPF_RET | BPF_K, 0);
+        return resolve();
+    }
+
+private:
+    struct Instruction {
+        sock_filter insn;
+        int trueLabel = -1;
+        int falseLabel = -1;
+    };
+
+    std::vector<Instruction> code_;
+    std::vector<size_t> labels_;
+
+    int newLabel() {
+        labels_.push_back(0);
+        return static_cast<int>(labels_.size() - 1);
+    }
+
+    void place(int label) { labels_[label] = code_.size(); }
+
+    void emit(uint16_t code, uint32_t k) { code_.push_back({{code, 0, 0, k}}); }
+
+    void emitJump(uint16_t code, uint32_t k, int onTrue, int onFalse) {
+        code_.push_back({{code, 0, 0, k}, onTrue, onFalse});
+    }
+
+    // Every label lies after the code jumping to it, so all jumps are forward
+    void emitNode(const Node& node, int onTrue, int onFalse) {
+        switch (node.kind) {
+            case Node::Kind::AND: {
+                int middle = newLabel();
+                emitNode(*node.left, middle, onFalse);
+                place(middle);
+                emitNode(*node.right, onTrue, onFalse);
+                break;
+            }
+            case Node::Kind::OR: {
+                int middle = newLabel();
+                emitNode(*node.left, onTrue, middle);
+                place(middle);
+                emitNode(*node.right, onTrue, onFalse);
+                break;
+            }
+            case Node::Kind::NOT:
+                emitNode(*node.left, onFalse, onTrue);
+                break;
+            case Node::Kind::TRUE:
+                emitJump(BPF_JMP | BPF_JA, 0, onTrue, -1);
+                break;
+            case Node::Kind::FALSE:
+                emitJump(BPF_JMP | BPF_JA, 0, onFalse, -1);
+                break;
+            case Node::Kind::TEST:
+                if (node.headerOffset) {
+                    emit(BPF_LDX | BPF_B | BPF_MSH, *node.headerOffset);
+                }
+                emit(BPF_LD | node.load, node.offset);
+                if (node.mask) {
+                    emit(BPF_ALU | BPF_AND | BPF_K, *node.mask);
+                }
+                emitJump(BPF_JMP | node.jump | BPF_K, node.value, onTrue, onFalse);
+                break;
+        }
+    }
+
+    // A conditional jump reaches at most 255 instructions ahead; a farther
+    // target is reached through a BPF_JA placed right after the jump, as
+    // libpcap does. Trampolines push later code further, so repeat until
+    // every short jump fits.
+    std::vector<sock_filter> resolve() const {
+        std::vector<uint8_t> farTrue(code_.size()), farFalse(code_.size());
+        std::vector<size_t> address(code_.size());
+        auto target = [&](int label) { return address[labels_[label]]; };
+
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (size_t pc = 0, at = 0; pc < code_.size(); ++pc) {
+                address[pc] = at;
+                at += 1 + farTrue[pc] + farFalse[pc];
+            }
+            for (size_t pc = 0; pc < code_.size(); ++pc) {
+                const Instruction& jump = code_[pc];
+                if (jump.trueLabel < 0 || BPF_OP(jump.insn.code) == BPF_JA) {
+                    continue;
+                }
+                if (!farTrue[pc] && target(jump.trueLabel) - address[pc] - 1 > 0xFF) {
+                    farTrue[pc] = changed = true;
+                }
+                if (!farFalse[pc] && target(jump.falseLabel) - address[pc] - 1 > 0xFF) {
+                    farFalse[pc] = changed = true;
+                }
+            }
+        }
+
+        std::vector<sock_filter> program;
+        program.reserve(address.empty() ? 0 : address.back() + 1 + farTrue.back() + farFalse.back());
+        auto trampoline = [&](int label) {
+            program.push_back({BPF_JMP | BPF_JA, 0, 0, static_cast<uint32_t>(target(label) - program.size() - 1)});
+        };
+
+        for (size_t pc = 0; pc < code_.size(); ++pc) {
+            sock_filter insn = code_[pc].insn;
+            if (code_[pc].trueLabel >= 0) {
+                size_t jumpTrue = target(code_[pc].trueLabel) - (address[pc] + 1);
+                if (BPF_OP(insn.code) == BPF_JA) {
+                    insn.k = static_cast<uint32_t>(jumpTrue);
+                } else {
+                    size_t jumpFalse = target(code_[pc].falseLabel) - (address[pc] + 1);
+                    insn.jt = static_cast<uint8_t>(farTrue[pc] ? 0 : jumpTrue);
+                    insn.jf = static_cast<uint8_t>(farFalse[pc] ? farTrue[pc] : jumpFalse);
+                }
+            }
+            program.push_back(insn);
+            if (farTrue[pc]) {
+                trampoline(code_[pc].trueLabel);
+            }
+            if (farFalse[pc]) {
+                trampoline(code_[pc].falseLabel);
+            }
+        }
+
+        return program;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Validation and interpretation
+// ---------------------------------------------------------------------------
+
+inline bool loadBytes(const uint8_t* data, size_t length, uint64_t offset, uint32_t size, uint32_t& out) {
+    if (offset + size > length) {
+        return false;
+    }
+    const uint8_t* p = data + offset;
+    switch (size) {
+        case 4:
+            out = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+            break;
+        case 2:
+            out = (uint32_t(p[0]) << 8) | p[1];
+            break;
+        default:
+            out = p[0];
+            break;
+    }
+    return true;
+}
+
+inline uint32_t loadSize(uint16_t code) {
+    switch (BPF_SIZE(code)) {
+        case BPF_W: return 4;
+        case BPF_H: return 2;
+        default: return 1;
+    }
+}
+
+std::string validate(const std::vector<sock_filter>& program) {
+    if (program.empty() || program.size() > BpfProgram::kMaxInstructions) {
+        return "program must have between 1 and " + std::to_string(BpfProgram::kMaxInstructions) + " instructions";
+    }
+
+    for (size_t pc = 0; pc < program.size(); ++pc) {
+        const sock_filter& insn = program[pc];
+        std::string where = "instruction " + std::to_string(pc) + ": ";
+        size_t remaining = program.size() - pc - 1;
+
+        switch (insn.code) {
+            case BPF_LD | BPF_W | BPF_ABS: case BPF_LD | BPF_H | BPF_ABS: case BPF_LD | BPF_B | BPF_ABS:
+            case BPF_LD | BPF_W | BPF_IND: case BPF_LD | BPF_H | BPF_IND: case BPF_LD | BPF_B | BPF_IND:
+            case BPF_LD | BPF_W | BPF_LEN: case BPF_LD | BPF_IMM:
+            case BPF_LDX | BPF_W | BPF_IMM: case BPF_LDX | BPF_W | BPF_LEN: case BPF_LDX | BPF_B | BPF_MSH:
+            case BPF_ALU | BPF_ADD | BPF_K: case BPF_ALU | BPF_ADD | BPF_X:
+            case BPF_ALU | BPF_SUB | BPF_K: case BPF_ALU | BPF_SUB | BPF_X:
+            case BPF_ALU | BPF_MUL | BPF_K: case BPF_ALU | BPF_MUL | BPF_X:
+            case BPF_ALU | BPF_DIV | BPF_X: case BPF_ALU | BPF_MOD | BPF_X:
+            case BPF_ALU | BPF_AND | BPF_K: case BPF_ALU | BPF_AND | BPF_X:
+            case BPF_ALU | BPF_OR | BPF_K: case BPF_ALU | BPF_OR | BPF_X:
+            case BPF_ALU | BPF_XOR | BPF_K: case BPF_ALU | BPF_XOR | BPF_X:
+            case BPF_ALU | BPF_LSH | BPF_K: case BPF_ALU | BPF_LSH | BPF_X:
+            case BPF_ALU | BPF_RSH | BPF_K: case BPF_ALU | BPF_RSH | BPF_X:
+            case BPF_ALU | BPF_NEG:
+            case BPF_RET | BPF_K: case BPF_RET | BPF_A:
+            case BPF_MISC | BPF_TAX: case BPF_MISC | BPF_TXA:
+                break;
+            case BPF_ALU | BPF_DIV | BPF_K: case BPF_ALU | BPF_MOD | BPF_K:
+                if (insn.k == 0) {
+                    return where + "division by zero";
+                }
+                break;
+            case BPF_LD | BPF_MEM: case BPF_LDX | BPF_MEM: case BPF_ST: case BPF_STX:
+                if (insn.k >= BPF_MEMWORDS) {
+                    return where + "scratch memory index out of range";
+                }
+                break;
+            case BPF_JMP | BPF_JA:
+                if (insn.k >= remaining) {
+                    return where + "jump out of range";
+                }
+                break;
+            case BPF_JMP | BPF_JEQ | BPF_K: case BPF_JMP | BPF_JEQ | BPF_X:
+            case BPF_JMP | BPF_JGT | BPF_K: case BPF_JMP | BPF_JGT | BPF_X:
+            case BPF_JMP | BPF_JGE | BPF_K: case BPF_JMP | BPF_JGE | BPF_X:
+            case BPF_JMP | BPF_JSET | BPF_K: case BPF_JMP | BPF_JSET | BPF_X:
+                if (insn.jt >= remaining || insn.jf >= remaining) {
+                    return where + "jump out of range";
+                }
+                break;
+            default:
+                return where + "unknown opcode " + std::to_string(insn.code);
+        }
+    }
+
+    if (BPF_CLASS(program.back().code) != BPF_RET) {
+        return "last instruction must be a return";
+    }
+    return "";
+}
+
+// ---------------------------------------------------------------------------
+// x86-64 JIT
+// ---------------------------------------------------------------------------
+
+#if defined(__x86_64__)
+
+// A = eax, X = ecx, packet = rdi, length = rsi; only caller-saved registers
+// are touched, so the code needs no prologue. Out-of-bounds loads and
+// division by zero jump to a shared "return 0" tail.
+class JitCompiler {
+public:
+    bool compile(const std::vector<sock_filter>& program, std::vector<uint8_t>& out) {
+        offsets_.assign(program.size(), 0);
+
+        for (size_t pc = 0; pc < program.size(); ++pc) {
+            offsets_[pc] = code_.size();
+            if (!emitInstruction(program[pc], pc)) {
+                return false;
+            }
+        }
+
+        size_t rejectOffset = code_.size();
+        bytes({0x31, 0xC0, 0xC3});                          // xor eax, eax; ret
+
+        for (const auto& fixup : fixups_) {
+            size_t target = fixup.target == kReject ? rejectOffset : offsets_[fixup.target];
+            int32_t rel = static_cast<int32_t>(target - (fixup.at + 4));
+            std::memcpy(code_.data() + fixup.at, &rel, sizeof(rel));
+        }
+
+        out = std::move(code_);
+        return true;
+    }
+
+private:
+    static constexpr size_t kReject = static_cast<size_t>(-1);
+
+    struct Fixup {
+        size_t at;
+        size_t target;
+    };
+
+    std::vector<uint8_t> code_;
+    std::vector<size_t> offsets_;
+    std::vector<Fixup> fixups_;
+
+    void bytes(std::initializer_list<uint8_t> values) { code_.insert(code_.end(), values); }
+
+    void imm32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            code_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    void rel32(size_t target) {
+        fixups_.push_back({code_.size(), target});
+        imm32(0);
+    }
+
+    void jumpIf(uint8_t condition, size_t target) {
+        bytes({0x0F, condition});
+        rel32(target);
+    }
+
+    void jump(size_t target) {
+        bytes({0xE9});
+        rel32(target);
+    }
+
+    // Reject unless [0, end) lies inside the packet
+    void checkAbsolute(uint64_t end) {
+        if (end > 0x7FFFFFFF) {
+            jump(kReject);
+            return;
+        }
+        bytes({0x48, 0x81, 0xFE});                          // cmp rsi, end
+        imm32(static_cast<uint32_t>(end));
+        jumpIf(0x82, kReject);                              // jb reject
+    }
+
+    bool emitInstruction(const sock_filter& insn, size_t pc) {
+        uint32_t size = loadSize(insn.code);
+
+        switch (insn.code) {
+            case BPF_LD | BPF_W | BPF_ABS:
+            case BPF_LD | BPF_H | BPF_ABS:
+            case BPF_LD | BPF_B | BPF_ABS:
+                checkAbsolute(uint64_t(insn.k) + size);
+                if (uint64_t(insn.k) + size > 0x7FFFFFFF) {
+                    return true;
+                }
+                if (size == 4) {
+                    bytes({0x8B, 0x87}); imm32(insn.k);     // mov eax, [rdi + k]
+                    bytes({0x0F, 0xC8});                    // bswap eax
+                } else if (size == 2) {
+                    bytes({0x0F, 0xB7, 0x87}); imm32(insn.k);   // movzx eax, word [rdi + k]
+                    bytes({0x66, 0xC1, 0xC0, 0x08});            // rol ax, 8
+                } else {
+                    bytes({0x0F, 0xB6, 0x87}); imm32(insn.k);   // movzx eax, byte [rdi + k]
+                }
+                return true;
+
+            case BPF_LD | BPF_W | BPF_IND:
+            case BPF_LD | BPF_H | BPF_IND:
+            case BPF_LD | BPF_B | BPF_IND:
+                if (insn.k > 0x7FFFFFF0) {
+                    return false;
+                }
+                bytes({0x89, 0xCA});                        // mov edx, ecx
+                bytes({0x48, 0x81, 0xC2}); imm32(insn.k);   // add rdx, k
+                bytes({0x48, 0x8D, 0x42, static_cast<uint8_t>(size)});  // lea rax, [rdx + size]
+                bytes({0x48, 0x39, 0xF0});                  // cmp rax, rsi
+                jumpIf(0x87, kReject);                      // ja reject
+                if (size == 4) {
+                    bytes({0x8B, 0x04, 0x17});              // mov eax, [rdi + rdx]
+                    bytes({0x0F, 0xC8});                    // bswap eax
+                } else if (size == 2) {
+                    bytes({0x0F, 0xB7, 0x04, 0x17});        // movzx eax, word [rdi + rdx]
+                    bytes({0x66, 0xC1, 0xC0, 0x08});        // rol ax, 8
+                } else {
+                    bytes({0x0F, 0xB6, 0x04, 0x17});        // movzx eax, byte [rdi + rdx]
+                }
+                return true;
+
+            case BPF_LD | BPF_W | BPF_LEN:
+                bytes({0x89, 0xF0});                        // mov eax, esi
+                return true;
+            case BPF_LD | BPF_IMM:
+                bytes({0xB8}); imm32(insn.k);               // mov eax, k
+                return true;
+            case BPF_LDX | BPF_W | BPF_IMM:
+                bytes({0xB9}); imm32(insn.k);               // mov ecx, k
+                return true;
+            case BPF_LDX | BPF_W | BPF_LEN:
+                bytes({0x89, 0xF1});                        // mov ecx, esi
+                return true;
+            case BPF_LDX | BPF_B | BPF_MSH:
+                checkAbsolute(uint64_t(insn.k) + 1);
+                if (uint64_t(insn.k) + 1 > 0x7FFFFFFF) {
+                    return true;
+                }
+                bytes({0x0F, 0xB6, 0x8F}); imm32(insn.k);   // movzx ecx, byte [rdi + k]
+                bytes({0x83, 0xE1, 0x0F});                  // and ecx, 0xf
+                bytes({0xC1, 0xE1, 0x02});                  // shl ecx, 2
+                return true;
+
+            case BPF_ALU | BPF_ADD | BPF_K: bytes({0x05}); imm32(insn.k); return true;
+            case BPF_ALU | BPF_SUB | BPF_K: bytes({0x2D}); imm32(insn.k); return true;
+            case BPF_ALU | BPF_AND | BPF_K: bytes({0x25}); imm32(insn.k); return true;
+            case BPF_ALU | BPF_OR | BPF_K:  bytes({0x0D}); imm32(insn.k); return true;
+            case BPF_ALU | BPF_XOR | BPF_K: bytes({0x35}); imm32(insn.k); return true;
+            case BPF_ALU | BPF_MUL | BPF_K: bytes({0x69, 0xC0}); imm32(insn.k); return true;
+            case BPF_ALU | BPF_LSH | BPF_K: bytes({0xC1, 0xE0, static_cast<uint8_t>(insn.k & 31)}); return true;
+            case BPF_ALU | BPF_RSH | BPF_K: bytes({0xC1, 0xE8, static_cast<uint8_t>(insn.k & 31)}); return true;
+            case BPF_ALU | BPF_DIV | BPF_K:
+            case BPF_ALU | BPF_MOD | BPF_K:
+                bytes({0x31, 0xD2});                        // xor edx, edx
+                bytes({0x41, 0xB8}); imm32(insn.k);         // mov r8d, k
+                bytes({0x41, 0xF7, 0xF0});                  // div r8d
+                if (BPF_OP(insn.code) == BPF_MOD) {
+                    bytes({0x89, 0xD0});                    // mov eax, edx
+                }
+                return true;
+            case BPF_ALU | BPF_NEG:
+                bytes({0xF7, 0xD8});                        // neg eax
+                return true;
+
+            case BPF_ALU | BPF_ADD | BPF_X: bytes({0x01, 0xC8}); return true;
+            case BPF_ALU | BPF_SUB | BPF_X: bytes({0x29, 0xC8}); return true;
+            case BPF_ALU | BPF_AND | BPF_X: bytes({0x21, 0xC8}); return true;
+            case BPF_ALU | BPF_OR | BPF_X:  bytes({0x09, 0xC8}); return true;
+            case BPF_ALU | BPF_XOR | BPF_X: bytes({0x31, 0xC8}); return true;
+            case BPF_ALU | BPF_MUL | BPF_X: bytes({0x0F, 0xAF, 0xC1}); return true;
+            case BPF_ALU | BPF_LSH | BPF_X: bytes({0xD3, 0xE0}); return true;   // shl eax, cl
+            case BPF_ALU | BPF_RSH | BPF_X: bytes({0xD3, 0xE8}); return true;   // shr eax, cl
+            case BPF_ALU | BPF_DIV | BPF_X:
+            case BPF_ALU | BPF_MOD | BPF_X:
+                bytes({0x85, 0xC9});                        // test ecx, ecx
+                jumpIf(0x84, kReject);                      // je reject
+                bytes({0x31, 0xD2});                        // xor edx, edx
+                bytes({0xF7, 0xF1});                        // div ecx
+                if (BPF_OP(insn.code) == BPF_MOD) {
+                    bytes({0x89, 0xD0});                    // mov eax, edx
+                }
+                return true;
+
+            case BPF_JMP | BPF_JA:
+                jump(pc + 1 + insn.k);
+                return true;
+
+            case BPF_JMP | BPF_JEQ | BPF_K: case BPF_JMP | BPF_JGT | BPF_K:
+            case BPF_JMP | BPF_JGE | BPF_K: case BPF_JMP | BPF_JSET | BPF_K:
+            case BPF_JMP | BPF_JEQ | BPF_X: case BPF_JMP | BPF_JGT | BPF_X:
+            case BPF_JMP | BPF_JGE | BPF_X: case BPF_JMP | BPF_JSET | BPF_X: {
+                bool jset = BPF_OP(insn.code) == BPF_JSET;
+                if (BPF_SRC(insn.code) == BPF_K) {
+                    bytes({static_cast<uint8_t>(jset ? 0xA9 : 0x3D)});   // test/cmp eax, k
+                    imm32(insn.k);
+                } else {
+                    bytes({static_cast<uint8_t>(jset ? 0x85 : 0x39), 0xC8});  // test/cmp eax, ecx
+                }
+
+                uint8_t condition;
+                switch (BPF_OP(insn.code)) {
+                    case BPF_JEQ: condition = 0x84; break;  // je
+                    case BPF_JGT: condition = 0x87; break;  // ja
+                    case BPF_JGE: condition = 0x83; break;  // jae
+                    default:      condition = 0x85; break;  // jne
+                }
+
+                size_t onTrue = pc + 1 + insn.jt;
+                size_t onFalse = pc + 1 + insn.jf;
+                if (insn.jt == 0 && insn.jf == 0) {
+                    return true;
+                }
+                if (insn.jf == 0) {
+                    jumpIf(condition, onTrue);
+                } else if (insn.jt == 0) {
+                    jumpIf(condition ^ 1, onFalse);
+                } else {
+                    jumpIf(condition, onTrue);
+                    jump(onFalse);
+                }
+                return true;
+            }
+
+            case BPF_RET | BPF_K:
+                bytes({0xB8}); imm32(insn.k);               // mov eax, k
+                bytes({0xC3});                              // ret
+                return true;
+            case BPF_RET | BPF_A:
+                bytes({0xC3});
+                return true;
+            case BPF_MISC | BPF_TAX:
+                bytes({0x89, 0xC1});                        // mov ecx, eax
+                return true;
+            case BPF_MISC | BPF_TXA:
+                bytes({0x89, 0xC8});                        // mov eax, ecx
+                return true;
+
+            default:
+                // Scratch memory stays on the interpreter
+                return false;
+        }
+    }
+};
+
+#endif
+
+const char* loadSizeName(uint16_t code) {
+    switch (BPF_SIZE(code)) {
+        case BPF_W: return "";
+        case BPF_H: return "h";
+        default: return "b";
+    }
+}
+
+} // anonymous namespace
+
+Result<BpfProgram> BpfProgram::compile(const std::string& expression, uint32_t snapLength) {
+    std::vector<sock_filter> instructions;
+    try {
+        Parser parser(expression);
+        NodePtr root = parser.parse();
+        instructions = CodeGenerator().generate(*root, snapLength);
+    } catch (const std::invalid_argument& e) {
+        return Result<BpfProgram>::error(ErrorCode::INVALID_ARGUMENT,
+                                         "Invalid filter '" + expression + "': " + e.what());
+    }
+
+    auto result = fromInstructions(std::move(instructions));
+    if (result.isError()) {
+        return result;
+    }
+
+    BpfProgram program = result.getValue();
+    program.expression_ = expression;
+    return Result<BpfProgram>::success(std::move(program));
+}
+
+Result<BpfProgram> BpfProgram::fromInstructions(std::vector<sock_filter> instructions) {
+    std::string error = validate(instructions);
+    if (!error.empty()) {
+        return Result<BpfProgram>::error(ErrorCode::INVALID_ARGUMENT, "Invalid BPF program: " + error);
+    }
+
+    BpfProgram program;
+    program.instructions_ = std::move(instructions);
+    return Result<BpfProgram>::success(std::move(program));
+}
+
+uint32_t BpfProgram::interpret(const uint8_t* data, size_t length) const noexcept {
+    uint32_t a = 0;
+    uint32_t x = 0;
+    uint32_t mem[BPF_MEMWORDS] = {};
+    uint32_t value = 0;
+
+    const sock_filter* program = instructions_.data();
+    size_t count = instructions_.size();
+
+    for (size_t pc = 0; pc < count; ++pc) {
+        const sock_filter& insn = program[pc];
+        switch (insn.code) {
+            case BPF_LD | BPF_W | BPF_ABS:
+            case BPF_LD | BPF_H | BPF_ABS:
+            case BPF_LD | BPF_B | BPF_ABS:
+                if (!loadBytes(data, length, insn.k, loadSize(insn.code), a)) {
+                    return 0;
+                }
+                break;
+            case BPF_LD | BPF_W | BPF_IND:
+            case BPF_LD | BPF_H | BPF_IND:
+            case BPF_LD | BPF_B | BPF_IND:
+                if (!loadBytes(data, length, uint64_t(x) + insn.k, loadSize(insn.code), a)) {
+                    return 0;
+                }
+                break;
+            case BPF_LD | BPF_W | BPF_LEN: a = static_cast<uint32_t>(length); break;
+            case BPF_LD | BPF_IMM:         a = insn.k; break;
+            case BPF_LD | BPF_MEM:         a = mem[insn.k]; break;
+            case BPF_LDX | BPF_W | BPF_IMM: x = insn.k; break;
+            case BPF_LDX | BPF_W | BPF_LEN: x = static_cast<uint32_t>(length); break;
+            case BPF_LDX | BPF_MEM:         x = mem[insn.k]; break;
+            case BPF_LDX | BPF_B | BPF_MSH:
+                if (!loadBytes(data, length, insn.k, 1, value)) {
+                    return 0;
+                }
+                x = (value & 0x0F) << 2;
+                break;
+            case BPF_ST:  mem[insn.k] = a; break;
+            case BPF_STX: mem[insn.k] = x; break;
+
+            case BPF_ALU | BPF_ADD | BPF_K: a += insn.k; break;
+            case BPF_ALU | BPF_SUB | BPF_K: a -= insn.k; break;
+            case BPF_ALU | BPF_MUL | BPF_K: a *= insn.k; break;
+            case BPF_ALU | BPF_DIV | BPF_K: a /= insn.k; break;
+            case BPF_ALU | BPF_MOD | BPF_K: a %= insn.k; break;
+            case BPF_ALU | BPF_AND | BPF_K: a &= insn.k; break;
+            case BPF_ALU | BPF_OR | BPF_K:  a |= insn.k; break;
+            case BPF_ALU | BPF_XOR | BPF_K: a ^= insn.k; break;
+            case BPF_ALU | BPF_LSH | BPF_K: a <<= (insn.k & 31); break;
+            case BPF_ALU | BPF_RSH | BPF_K: a >>= (insn.k & 31); break;
+            case BPF_ALU | BPF_ADD | BPF_X: a += x; break;
+            case BPF_ALU | BPF_SUB | BPF_X: a -= x; break;
+            case BPF_ALU | BPF_MUL | BPF_X: a *= x; break;
+            case BPF_ALU | BPF_DIV | BPF_X:
+                if (x == 0) {
+                    return 0;
+                }
+                a /= x;
+                break;
+            case BPF_ALU | BPF_MOD | BPF_X:
+                if (x == 0) {
+                    return 0;
+                }
+                a %= x;
+                break;
+            case BPF_ALU | BPF_AND | BPF_X: a &= x; break;
+            case BPF_ALU | BPF_OR | BPF_X:  a |= x; break;
+            case BPF_ALU | BPF_XOR | BPF_X: a ^= x; break;
+            case BPF_ALU | BPF_LSH | BPF_X: a <<= (x & 31); break;
+            case BPF_ALU | BPF_RSH | BPF_X: a >>= (x & 31); break;
+            case BPF_ALU | BPF_NEG:         a = 0u - a; break;
+
+            case BPF_JMP | BPF_JA:                pc += insn.k; break;
+            case BPF_JMP | BPF_JEQ | BPF_K:       pc += (a == insn.k) ? insn.jt : insn.jf; break;
+            case BPF_JMP | BPF_JGT | BPF_K:       pc += (a > insn.k) ? insn.jt : insn.jf; break;
+            case BPF_JMP | BPF_JGE | BPF_K:       pc += (a >= insn.k) ? insn.jt : insn.jf; break;
+            case BPF_JMP | BPF_JSET | BPF_K:      pc += (a & insn.k) ? insn.jt : insn.jf; break;
+            case BPF_JMP | BPF_JEQ | BPF_X:       pc += (a == x) ? insn.jt : insn.jf; break;
+            case BPF_JMP | BPF_JGT | BPF_X:       pc += (a > x) ? insn.jt : insn.jf; break;
+            case BPF_JMP | BPF_JGE | BPF_X:       pc += (a >= x) ? insn.jt : insn.jf; break;
+            case BPF_JMP | BPF_JSET | BPF_X:      pc += (a & x) ? insn.jt : insn.jf; break;
+
+            case BPF_RET | BPF_K: return insn.k;
+            case BPF_RET | BPF_A: return a;
+            case BPF_MISC | BPF_TAX: x = a; break;
+            case BPF_MISC | BPF_TXA: a = x; break;
+
+            default:
+                return 0;
+        }
+    }
+
+    return 0;
+}
+
+bool BpfProgram::enableJit() {
+    if (jitEntry_) {
+        return true;
+    }
+    if (instructions_.empty()) {
+        return false;
+    }
+
+#if defined(__x86_64__)
+    std::vector<uint8_t> code;
+    if (!JitCompiler().compile(instructions_, code)) {
+        BEATRICE_DEBUG("BPF program '{}' uses instructions the JIT does not support", expression_);
+        return false;
+    }
+
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t mappingSize = (code.size() + pageSize - 1) / pageSize * pageSize;
+    void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        BEATRICE_WARN("BPF JIT disabled, cannot map code: {}", std::strerror(errno));
+        return false;
+    }
+
+    std::memcpy(mapping, code.data(), code.size());
+    if (mprotect(mapping, mappingSize, PROT_READ | PROT_EXEC) != 0) {
+        BEATRICE_WARN("BPF JIT disabled, cannot make code executable: {}", std::strerror(errno));
+        munmap(mapping, mappingSize);
+        return false;
+    }
+
+    jitCode_ = std::shared_ptr<void>(mapping, [mappingSize](void* p) { munmap(p, mappingSize); });
+    jitEntry_ = reinterpret_cast<JitFunction>(mapping);
+    return true;
+#else
+    return false;
+#endif
+}
+
+Result<void> BpfProgram::attachToSocket(int fd) const {
+    if (instructions_.empty()) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Cannot attach an empty BPF program");
+    }
+
+    sock_fprog program{};
+    program.len = static_cast<unsigned short>(instructions_.size());
+    program.filter = const_cast<sock_filter*>(instructions_.data());
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) < 0) {
+        return Result<void>::error(ErrorCode::NETWORK_ERROR,
+                                   "Failed to attach socket filter: " + std::string(std::strerror(errno)));
+    }
+    return Result<void>::success();
+}
+
+Result<void> BpfProgram::detachFromSocket(int fd) {
+    int unused = 0;
+    if (setsockopt(fd, SOL_SOCKET, SO_DETACH_FILTER, &unused, sizeof(unused)) < 0 && errno != ENOENT) {
+        return Result<void>::error(ErrorCode::NETWORK_ERROR,
+                                   "Failed to detach socket filter: " + std::string(std::strerror(errno)));
+    }
+    return Result<void>::success();
+}
+
+std::string BpfProgram::dump() const {
+    std::ostringstream out;
+
+    for (size_t pc = 0; pc < instructions_.size(); ++pc) {
+        const sock_filter& insn = instructions_[pc];
+        out << '(' << std::setw(3) << std::setfill('0') << pc << ") " << std::setfill(' ');
+
+        std::string op;
+        std::string operand;
+        switch (BPF_CLASS(insn.code)) {
+            case BPF_LD:
+            case BPF_LDX: {
+                bool ldx = BPF_CLASS(insn.code) == BPF_LDX;
+                op = std::string(ldx ? "ldx" : "ld") + loadSizeName(insn.code);
+                switch (BPF_MODE(insn.code)) {
+                    case BPF_ABS: operand = "[" + std::to_string(insn.k) + "]"; break;
+                    case BPF_IND: operand = "[x + " + std::to_string(insn.k) + "]"; break;
+                    case BPF_LEN: op = ldx ? "ldx" : "ld"; operand = "#pktlen"; break;
+                    case BPF_MEM: op = ldx ? "ldx" : "ld"; operand = "M[" + std::to_string(insn.k) + "]"; break;
+                    case BPF_MSH: op = "ldxb"; operand = "4*([" + std::to_string(insn.k) + "]&0xf)"; break;
+                    default: op = ldx ? "ldx" : "ld"; operand = "#" + std::to_string(insn.k); break;
+                }
+                break;
+            }
+            case BPF_ST:
+            case BPF_STX:
+                op = BPF_CLASS(insn.code) == BPF_ST ? "st" : "stx";
+                operand = "M[" + std::to_string(insn.k) + "]";
+                break;
+            case BPF_ALU: {
+                static const char* names[] = {"add", "sub", "mul", "div", "or", "and", "lsh", "rsh",
+                                              "neg", "mod", "xor"};
+                size_t index = BPF_OP(insn.code) >> 4;
+                op = index < std::size(names) ? names[index] : "alu?";
+                if (BPF_OP(insn.code) != BPF_NEG) {
+                    operand = BPF_SRC(insn.code) == BPF_X ? "x" : "#" + std::to_string(insn.k);
+                }
+                break;
+            }
+            case BPF_JMP: {
+                std::ostringstream target;
+                if (BPF_OP(insn.code) == BPF_JA) {
+                    op = "ja";
+                    target << pc + 1 + insn.k;
+                } else {
+                    static const char* names[] = {"ja", "jeq", "jgt", "jge", "jset"};
+                    op = names[BPF_OP(insn.code) >> 4];
+                    if (BPF_SRC(insn.code) == BPF_X) {
+                        target << "x";
+                    } else {
+                        target << "#0x" << std::hex << insn.k << std::dec;
+                    }
+                    target << "\tjt " << pc + 1 + insn.jt << "\tjf " << pc + 1 + insn.jf;
+                }
+                operand = target.str();
+                break;
+            }
+            case BPF_RET:
+                op = "ret";
+                operand = BPF_RVAL(insn.code) == BPF_A ? "a" : "#" + std::to_string(insn.k);
+                break;
+            default:
+                op = BPF_MISCOP(insn.code) == BPF_TAX ? "tax" : "txa";
+                break;
+        }
+
+        out << std::left << std::setw(9) << op << std::right << operand << '\n';
+    }
+
+    return out.str();
+}
+
+} // namespace beatrice
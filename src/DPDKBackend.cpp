@@ -1,12 +1,20 @@
 #include "beatrice/DPDKBackend.hpp"
 #include "beatrice/Logger.hpp"
 #include "beatrice/Error.hpp"
+#include "beatrice/MbufPacket.hpp"
+#include "beatrice/PacketQueue.hpp"
 #include <chrono>
 #include <algorithm>
+#include <climits>
+#include <iterator>
+#include <pthread.h>
+#include <sched.h>
 
 extern "C" {
 #include <rte_eal.h>
 #include <rte_ethdev.h>
+#include <rte_lcore.h>
+#include <rte_launch.h>
 #include <rte_mbuf.h>
 #include <rte_mempool.h>
 #include <rte_ring.h>
@@ -16,19 +24,53 @@ extern "C" {
 
 namespace beatrice {
 
+namespace {
+
+constexpr unsigned kNoLcore = UINT_MAX;
+
+// Default Toeplitz key length used when the driver does not report one
+constexpr size_t kDefaultRssKeySize = 40;
+
+} // anonymous namespace
+
+/**
+ * @brief One RSS receive queue and the worker polling it
+ *
+ * Workers run on dedicated EAL lcores when enough are available and fall back
+ * to pinned threads otherwise. Queues never share a lock on the receive path:
+ * the worker is the only producer of its packet ring.
+ */
+struct DPDKBackend::RxQueue {
+    RxQueue(uint16_t queueId, const Config& config)
+        : id(queueId)
+        , queue(config, OverflowPolicy::DROP_NEWEST, "dpdk_q" + std::to_string(queueId)) {
+    }
+    
+    DPDKBackend* backend = nullptr;
+    uint16_t id = 0;
+    unsigned lcore = kNoLcore;              ///< EAL worker lcore, kNoLcore for a std::thread
+    
+    std::thread thread;
+    std::vector<struct rte_mbuf*> burst;    ///< Burst buffer, Config::batchSize entries
+    
+    PacketQueue queue;
+    
+    mutable std::mutex statsMutex;
+    Statistics stats;
+};
+
 DPDKBackend::DPDKBackend()
     : running_(false)
     , initialized_(false)
     , dpdkInitialized_(false)
     , config_()
-    , processingThread_()
-    , packetQueue_()
-    , packetQueueMutex_()
-    , packetCondition_()
+    , queues_()
+    , nextQueue_(0)
+    , rxMempool_(nullptr)
+    , rssKey_()
     , packetCallback_(nullptr)
     , callbackMutex_()
-    , statsMutex_()
-    , stats_()
+    , mbufsInFlight_(std::make_shared<std::atomic<uint64_t>>(0))
     , errorMutex_()
     , lastError_()
     , dpdkArgs_()
@@ -87,7 +129,7 @@ Result<void> DPDKBackend::start() {
     }
 
     running_ = true;
-    processingThread_ = std::thread(&DPDKBackend::packetProcessingLoop, this);
+    launchWorkers();
 
     return Result<void>::success();
 }
@@ -98,12 +140,11 @@ Result<void> DPDKBackend::stop() {
     }
 
     running_ = false;
-    packetCondition_.notify_all();
-
-    if (processingThread_.joinable()) {
-        processingThread_.join();
+    for (auto& queue : queues_) {
+        queue->queue.close();
     }
 
+    joinWorkers();
     stopPort();
     return Result<void>::success();
 }
@@ -113,50 +154,58 @@ bool DPDKBackend::isRunning() const noexcept {
 }
 
 std::optional<Packet> DPDKBackend::nextPacket(std::chrono::milliseconds timeout) {
-    std::unique_lock<std::mutex> lock(packetQueueMutex_);
-    
-    if (packetQueue_.empty()) {
-        if (packetCondition_.wait_for(lock, timeout, [this] { return !packetQueue_.empty() || !running_; })) {
-            if (!running_) {
-                return std::nullopt;
-            }
-        } else {
-            return std::nullopt;
-        }
-    }
-
-    if (packetQueue_.empty()) {
+    auto packets = getPackets(1, timeout);
+    if (packets.empty()) {
         return std::nullopt;
     }
-
-    Packet packet = std::move(packetQueue_.front());
-    packetQueue_.pop();
-    
-    return packet;
+    return std::move(packets.front());
 }
 
 std::vector<Packet> DPDKBackend::getPackets(size_t maxPackets, std::chrono::milliseconds timeout) {
+    if (queues_.empty()) {
+        return {};
+    }
+    
+    if (queues_.size() == 1) {
+        return drainQueue(*queues_.front(), maxPackets, timeout);
+    }
+    
+    // Shared consumers rotate over the RSS queues; dedicated consumers
+    // should use getPackets(queueId, ...) instead
+    const size_t start = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
     std::vector<Packet> packets;
-    packets.reserve(maxPackets);
+    for (size_t i = 0; i < queues_.size() && packets.size() < maxPackets; ++i) {
+        auto more = drainQueue(*queues_[(start + i) % queues_.size()], maxPackets - packets.size(),
+                               std::chrono::milliseconds(0));
+        std::move(more.begin(), more.end(), std::back_inserter(packets));
+    }
+    
+    if (packets.empty()) {
+        return drainQueue(*queues_[start], maxPackets, timeout);
+    }
+    return packets;
+}
 
-    auto start = std::chrono::steady_clock::now();
-    auto end = start + timeout;
+size_t DPDKBackend::getQueueCount() const {
+    return queues_.size();
+}
 
-    while (packets.size() < maxPackets && std::chrono::steady_clock::now() < end) {
-        auto packet = nextPacket(std::chrono::milliseconds(100));
-        if (packet) {
-            packets.push_back(std::move(*packet));
-        } else if (!running_) {
-            break;
-        }
+std::vector<Packet> DPDKBackend::getPackets(size_t queueId, size_t maxPackets, std::chrono::milliseconds timeout) {
+    if (queueId >= queues_.size()) {
+        return {};
     }
+    return drainQueue(*queues_[queueId], maxPackets, timeout);
+}
 
+std::vector<Packet> DPDKBackend::drainQueue(RxQueue& queue, size_t maxPackets, std::chrono::milliseconds timeout) {
+    std::vector<Packet> packets;
+    queue.queue.pop(packets, maxPackets, timeout);
     return packets;
 }
 
 void DPDKBackend::setPacketCallback(std::function<void(Packet)> callback) {
     std::lock_guard<std::mutex> lock(callbackMutex_);
-    packetCallback_ = callback;
+    packetCallback_ = callback ? std::make_shared<const std::function<void(Packet)>>(std::move(callback)) : nullptr;
 }
 
 void DPDKBackend::removePacketCallback() {
@@ -165,13 +214,36 @@ void DPDKBackend::removePacketCallback() {
 }
 
 DPDKBackend::Statistics DPDKBackend::getStatistics() const {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    return stats_;
+    Statistics total;
+    for (const auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->statsMutex);
+        total.packetsCaptured += queue->stats.packetsCaptured;
+        total.bytesCaptured += queue->stats.bytesCaptured;
+        
+        const auto queueStats = queue->queue.getStatistics();
+        total.packetsDropped += queueStats.dropped;
+        total.bytesDropped += queueStats.bytesDropped;
+        total.queueHighWatermark = std::max(total.queueHighWatermark, queueStats.highWatermark);
+        total.lastUpdate = std::max(total.lastUpdate, queue->stats.lastUpdate);
+    }
+    
+    // Most drops happen in the NIC: descriptor ring full or mempool exhausted
+    struct rte_eth_stats portStats;
+    if (initialized_ && rte_eth_stats_get(0, &portStats) == 0) {
+        total.packetsDropped += portStats.imissed + portStats.rx_nombuf;
+    }
+    return total;
 }
 
 void DPDKBackend::resetStatistics() {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    stats_ = Statistics{};
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->statsMutex);
+        queue->stats = Statistics{};
+        queue->queue.resetStatistics();
+    }
+    if (initialized_) {
+        rte_eth_stats_reset(0);
+    }
 }
 
 std::string DPDKBackend::getName() const {
@@ -189,7 +261,10 @@ std::vector<std::string> DPDKBackend::getSupportedFeatures() const {
         "multi_queue",
         "cpu_affinity",
         "batch_processing",
-        "high_performance"
+        "high_performance",
+        "rss",
+        "symmetric_rss",
+        "run_to_completion"
     };
 }
 
@@ -319,32 +394,96 @@ bool DPDKBackend::initializePort() {
     portConf.rxmode.offloads = 0;
     portConf.txmode.offloads = 0;
 
-    if (rte_eth_dev_configure(portId, 1, 1, &portConf) < 0) {
+    // One RX queue per worker, capped by what the NIC offers
+    const size_t rxQueues = rxQueueCount(config_.rxQueues, devInfo.max_rx_queues);
+    if (config_.rxQueues > rxQueues) {
+        BEATRICE_WARN("Port {} supports only {} RX queues, {} requested", portId, devInfo.max_rx_queues,
+                      config_.rxQueues);
+    }
+    if (rxQueues > 1) {
+        configureRss(portConf, devInfo);
+    }
+
+    if (rte_eth_dev_configure(portId, static_cast<uint16_t>(rxQueues), 1, &portConf) < 0) {
         std::lock_guard<std::mutex> lock(errorMutex_);
         lastError_ = "Failed to configure DPDK port " + std::to_string(portId);
         return false;
     }
 
+    queues_.clear();
+    for (size_t i = 0; i < rxQueues; ++i) {
+        auto queue = std::make_unique<RxQueue>(static_cast<uint16_t>(i), config_);
+        queue->backend = this;
+        queue->burst.assign(mbufBurstSize(config_.batchSize), nullptr);
+        queues_.push_back(std::move(queue));
+    }
+
     return true;
 }
 
+size_t DPDKBackend::rxQueueCount(size_t requested, size_t deviceMax) {
+    return std::max<size_t>(std::min(requested, deviceMax), 1);
+}
+
+std::vector<uint8_t> DPDKBackend::symmetricRssKey(size_t keySize) {
+    // The repeated 16-bit pattern 0x6d5a makes the Toeplitz hash invariant
+    // under swapping source and destination address/port, so both directions
+    // of a connection are handled by the same worker
+    std::vector<uint8_t> key(keySize);
+    for (size_t i = 0; i < key.size(); ++i) {
+        key[i] = (i % 2 == 0) ? 0x6d : 0x5a;
+    }
+    return key;
+}
+
+std::vector<unsigned> DPDKBackend::workerLcores(const std::vector<unsigned>& lcores, size_t queueCount) {
+    // Dedicated EAL lcores when the EAL was started with enough of them,
+    // pinned threads otherwise
+    if (lcores.size() < queueCount) {
+        return {};
+    }
+    return std::vector<unsigned>(lcores.begin(), lcores.begin() + static_cast<std::ptrdiff_t>(queueCount));
+}
+
+void DPDKBackend::configureRss(struct rte_eth_conf& portConf, const struct rte_eth_dev_info& devInfo) {
+    portConf.rxmode.mq_mode = RTE_ETH_MQ_RX_RSS;
+    portConf.rx_adv_conf.rss_conf.rss_hf =
+        (RTE_ETH_RSS_IP | RTE_ETH_RSS_TCP | RTE_ETH_RSS_UDP) & devInfo.flow_type_rss_offloads;
+
+    if (!config_.symmetricRss) {
+        // Driver default key: the two directions of a flow may land on different queues
+        portConf.rx_adv_conf.rss_conf.rss_key = nullptr;
+        return;
+    }
+
+    rssKey_ = symmetricRssKey(devInfo.hash_key_size ? devInfo.hash_key_size : kDefaultRssKeySize);
+    portConf.rx_adv_conf.rss_conf.rss_key = rssKey_.data();
+    portConf.rx_adv_conf.rss_conf.rss_key_len = static_cast<uint8_t>(rssKey_.size());
+}
+
 bool DPDKBackend::setupQueues() {
     uint16_t portId = 0;
     
-    struct rte_mempool* rxMempool = rte_pktmbuf_pool_create("rx_mempool", 
-        config_.numBuffers, 0, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+    // Each queue needs a full descriptor ring plus headroom for mbufs still
+    // referenced by packets in flight
+    const unsigned poolSize = static_cast<unsigned>(queues_.size() * config_.numBuffers * 2);
+    const unsigned cacheSize = std::min<unsigned>(256, poolSize / 8);
+    rxMempool_ = rte_pktmbuf_pool_create("rx_mempool", poolSize, cacheSize, 0,
+                                         RTE_MBUF_DEFAULT_BUF_SIZE, rte_eth_dev_socket_id(portId));
     
-    if (!rxMempool) {
+    if (!rxMempool_) {
         std::lock_guard<std::mutex> lock(errorMutex_);
         lastError_ = "Failed to create RX memory pool";
         return false;
     }
 
-    if (rte_eth_rx_queue_setup(portId, 0, config_.numBuffers, 
-        rte_eth_dev_socket_id(portId), nullptr, rxMempool) < 0) {
-        std::lock_guard<std::mutex> lock(errorMutex_);
-        lastError_ = "Failed to setup RX queue";
-        return false;
+    for (const auto& queue : queues_) {
+        if (rte_eth_rx_queue_setup(portId, queue->id, config_.numBuffers, 
+            rte_eth_dev_socket_id(portId), nullptr, rxMempool_) < 0) {
+            std::lock_guard<std::mutex> lock(errorMutex_);
+            lastError_ = "Failed to setup RX queue " + std::to_string(queue->id);
+            return false;
+        }
     }
 
     if (rte_eth_tx_queue_setup(portId, 0, config_.numBuffers, 
@@ -354,6 +493,8 @@ bool DPDKBackend::setupQueues() {
         return false;
     }
 
+    BEATRICE_INFO("DPDK port {} configured with {} RX queues ({} RSS)", portId, queues_.size(),
+                  queues_.size() > 1 ? (config_.symmetricRss ? "symmetric" : "default") : "no");
     return true;
 }
 
@@ -376,41 +517,152 @@ void DPDKBackend::stopPort() {
     rte_eth_dev_close(portId);
 }
 
-void DPDKBackend::packetProcessingLoop() {
-    while (running_) {
-        processPackets();
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
+void DPDKBackend::launchWorkers() {
+    std::vector<unsigned> lcores;
+    unsigned lcore;
+    RTE_LCORE_FOREACH_WORKER(lcore) {
+        lcores.push_back(lcore);
+    }
+
+    const std::vector<unsigned> assigned = workerLcores(lcores, queues_.size());
+    if (assigned.empty()) {
+        BEATRICE_WARN("{} EAL worker lcores for {} RX queues, using threads instead", lcores.size(), queues_.size());
+    }
+
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        RxQueue& queue = *queues_[i];
+        queue.queue.open();
+        if (!assigned.empty() && rte_eal_remote_launch(&DPDKBackend::lcoreMain, &queue, assigned[i]) == 0) {
+            queue.lcore = assigned[i];
+            BEATRICE_DEBUG("RX queue {} running on lcore {}", queue.id, queue.lcore);
+        } else {
+            queue.lcore = kNoLcore;
+            queue.thread = std::thread([this, &queue, i] {
+                pinThread(i);
+                packetProcessingLoop(queue);
+            });
+        }
     }
 }
 
-void DPDKBackend::processPackets() {
-    if (!running_) {
+void DPDKBackend::joinWorkers() {
+    for (auto& queue : queues_) {
+        if (queue->lcore != kNoLcore) {
+            rte_eal_wait_lcore(queue->lcore);
+            queue->lcore = kNoLcore;
+        } else if (queue->thread.joinable()) {
+            queue->thread.join();
+        }
+    }
+}
+
+int DPDKBackend::lcoreMain(void* arg) {
+    auto* queue = static_cast<RxQueue*>(arg);
+    queue->backend->packetProcessingLoop(*queue);
+    return 0;
+}
+
+void DPDKBackend::pinThread(size_t index) {
+    std::string threadName = "dpdk-rx-" + std::to_string(index);
+    pthread_setname_np(pthread_self(), threadName.c_str());
+    
+    if (config_.cpuAffinity.empty()) {
         return;
     }
+    
+    // Queue worker i runs on cpuAffinity[i], wrapping when there are more queues than CPUs
+    int cpu = config_.cpuAffinity[index % config_.cpuAffinity.size()];
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0) {
+        BEATRICE_WARN("Failed to pin DPDK queue worker {} to CPU {}", index, cpu);
+    }
+}
 
-    uint16_t portId = 0;
-    struct rte_mbuf* pkts[32];
-    uint16_t nbRx = rte_eth_rx_burst(portId, 0, pkts, 32);
+void DPDKBackend::packetProcessingLoop(RxQueue& queue) {
+    while (running_) {
+        if (processPackets(queue) > 0) {
+            continue;
+        }
+        // A dedicated lcore keeps polling; a shared thread backs off
+        if (queue.lcore != kNoLcore) {
+            rte_pause();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+}
+
+size_t DPDKBackend::processPackets(RxQueue& queue) {
+    const uint16_t nbRx = rte_eth_rx_burst(0, queue.id, queue.burst.data(), static_cast<uint16_t>(queue.burst.size()));
+    if (nbRx == 0) {
+        return 0;
+    }
+
+    // Packets reference the mbufs directly; they go back to the mempool when
+    // the last consumer drops them
+    const auto now = std::chrono::steady_clock::now();
+    const bool zeroCopy = zeroCopyEnabled_ && config_.enableZeroCopy;
+    std::vector<Packet> batch;
+    batch.reserve(nbRx);
+    uint64_t bytes = 0;
 
     for (uint16_t i = 0; i < nbRx; i++) {
-        struct rte_mbuf* pkt = pkts[i];
-        
-        if (pkt) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.packetsCaptured++;
-            stats_.bytesCaptured += pkt->data_len;
-            stats_.lastUpdate = std::chrono::steady_clock::now();
-            
-            rte_pktmbuf_free(pkt);
+        bytes += rte_pktmbuf_pkt_len(queue.burst[i]);
+        batch.push_back(packetFromMbuf(queue.burst[i], zeroCopy, mbufsInFlight_, now));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue.statsMutex);
+        queue.stats.packetsCaptured += nbRx;
+        queue.stats.bytesCaptured += bytes;
+        queue.stats.lastUpdate = now;
+    }
+
+    std::shared_ptr<const std::function<void(Packet)>> callback;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        callback = packetCallback_;
+    }
+
+    if (callback) {
+        for (const auto& packet : batch) {
+            try {
+                (*callback)(packet);
+            } catch (const std::exception& e) {
+                BEATRICE_ERROR("Exception in packet callback: {}", e.what());
+            }
+        }
+        // Run-to-completion: the callback consumed the burst on this core
+        if (config_.runToCompletion) {
+            return nbRx;
         }
     }
+
+    // Dropped packets free their mbufs when batch goes out of scope
+    queue.queue.push(batch);
+
+    return nbRx;
 }
 
 void DPDKBackend::shutdown() {
     stop();
     
+    for (auto& queue : queues_) {
+        // Queued packets still hold mbufs from the RX mempool
+        std::vector<Packet> stale;
+        queue->queue.pop(stale, queue->queue.capacity(), std::chrono::milliseconds(0));
+    }
+    
     if (dpdkInitialized_) {
-        rte_eal_cleanup();
+        const uint64_t inFlight = mbufsInFlight_->load(std::memory_order_relaxed);
+        if (inFlight > 0) {
+            // Freeing these mbufs after EAL cleanup would touch unmapped hugepages
+            BEATRICE_WARN("{} packets still reference DPDK mbufs, skipping EAL cleanup", inFlight);
+        } else {
+            rte_eal_cleanup();
+        }
         dpdkInitialized_ = false;
     }
     
@@ -0,0 +1,52 @@
+#include "beatrice/EpochDomain.hpp"
+#include <thread>
+
+namespace beatrice {
+
+namespace {
+
+// Hands each thread a distinct home reader slot
+std::atomic<size_t> nextReaderSlot{0};
+
+} // anonymous namespace
+
+EpochDomain::Guard::Guard(EpochDomain& domain) {
+    thread_local const size_t home = nextReaderSlot.fetch_add(1, std::memory_order_relaxed);
+    
+    // Announce the epoch we read under before the snapshot is loaded, so a
+    // writer either sees us in the slot or we see its new snapshot
+    for (size_t attempt = 0;; ++attempt) {
+        ReaderSlot& slot = domain.readers_[(home + attempt) % kReaderSlots];
+        uint64_t expected = kQuiescent;
+        if (slot.epoch.compare_exchange_strong(expected, domain.epoch_.load())) {
+            slot_ = &slot.epoch;
+            break;
+        }
+    
+        // More concurrent readers than slots, let one of them finish
+        if ((attempt + 1) % kReaderSlots == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+EpochDomain::Guard::~Guard() {
+    slot_->store(kQuiescent, std::memory_order_release);
+}
+
+void EpochDomain::synchronize() {
+    uint64_t target = epoch_.fetch_add(1) + 1;
+    
+    // Readers that entered under an older epoch may still hold the old snapshot
+    for (auto& slot : readers_) {
+        for (;;) {
+            uint64_t epoch = slot.epoch.load();
+            if (epoch == kQuiescent || epoch >= target) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace beatrice
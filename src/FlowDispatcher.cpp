@@ -0,0 +1,279 @@
+#include "beatrice/FlowDispatcher.hpp"
+#include "beatrice/Logger.hpp"
+#include "beatrice/Metrics.hpp"
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+namespace beatrice {
+
+namespace {
+
+constexpr uint16_t kEtherTypeIPv4 = 0x0800;
+constexpr uint16_t kEtherTypeIPv6 = 0x86DD;
+constexpr uint16_t kEtherTypeVLAN = 0x8100;
+constexpr uint16_t kEtherTypeQinQ = 0x88A8;
+constexpr size_t kEthernetHeaderSize = 14;
+constexpr size_t kIPv4HeaderSize = 20;
+constexpr size_t kIPv6HeaderSize = 40;
+
+// Headers are not necessarily aligned, read them bytewise in network order
+uint64_t loadBE(const uint8_t* p, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+bool hasPorts(uint8_t protocol) {
+    return protocol == 6 || protocol == 17 || protocol == 132;    // TCP, UDP, SCTP
+}
+
+struct Endpoint {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+    uint16_t port = 0;
+
+    bool operator<(const Endpoint& other) const {
+        return std::tie(hi, lo, port) < std::tie(other.hi, other.lo, other.port);
+    }
+};
+
+uint64_t mix(uint64_t hash, uint64_t value) {
+    return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+// MurmurHash3 finalizer, spreads the low bits used to pick a worker
+uint64_t finalize(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Ordering the endpoints first makes the hash the same in both directions
+uint64_t hashEndpoints(Endpoint a, Endpoint b, uint64_t kind) {
+    if (b < a) {
+        std::swap(a, b);
+    }
+    uint64_t hash = kind;
+    hash = mix(hash, a.hi);
+    hash = mix(hash, a.lo);
+    hash = mix(hash, b.hi);
+    hash = mix(hash, b.lo);
+    hash = mix(hash, (static_cast<uint64_t>(a.port) << 16) | b.port);
+    return finalize(hash);
+}
+
+} // anonymous namespace
+
+FlowDispatcher::FlowDispatcher(size_t workers, const Config& config, const std::string& name)
+    : config_(config) {
+    ICaptureBackend::Config queueConfig;
+    queueConfig.queueDepth = config_.queueDepth;
+    queueConfig.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::BLOCK;
+
+    workers_.reserve(std::max<size_t>(workers, 1));
+    for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->queue = std::make_unique<PacketQueue>(queueConfig, ICaptureBackend::OverflowPolicy::BLOCK,
+                                                      name.empty() ? "" : name + "_worker" + std::to_string(i),
+                                                      RingSync::SINGLE);
+        workers_.push_back(std::move(worker));
+    }
+
+    if (!name.empty()) {
+        heavyHittersCounter_ = metrics::counter(name + "_heavy_hitters_total",
+                                                "Flows flagged for carrying more than a worker can share");
+    }
+}
+
+uint64_t FlowDispatcher::flowHash(const Packet& packet) {
+    const uint8_t* data = packet.data();
+    const size_t length = packet.length();
+    if (data == nullptr || length < kEthernetHeaderSize) {
+        return 0;
+    }
+
+    size_t offset = kEthernetHeaderSize;
+    uint16_t etherType = static_cast<uint16_t>(loadBE(data + 12, 2));
+    for (int tags = 0; tags < 2 && (etherType == kEtherTypeVLAN || etherType == kEtherTypeQinQ) &&
+                       length >= offset + 4; ++tags) {
+        etherType = static_cast<uint16_t>(loadBE(data + offset + 2, 2));
+        offset += 4;
+    }
+
+    Endpoint src;
+    Endpoint dst;
+    uint8_t protocol = 0;
+    size_t l4Offset = 0;
+    bool usePorts = false;
+
+    if (etherType == kEtherTypeIPv4 && length >= offset + kIPv4HeaderSize) {
+        const uint8_t* ip = data + offset;
+        const size_t headerSize = (ip[0] & 0x0F) * 4;
+        const bool fragment = (loadBE(ip + 6, 2) & 0x3FFF) != 0;
+        protocol = ip[9];
+        src.lo = loadBE(ip + 12, 4);
+        dst.lo = loadBE(ip + 16, 4);
+        l4Offset = offset + headerSize;
+        usePorts = !fragment && headerSize >= kIPv4HeaderSize;
+    } else if (etherType == kEtherTypeIPv6 && length >= offset + kIPv6HeaderSize) {
+        const uint8_t* ip = data + offset;
+        protocol = ip[6];
+        src.hi = loadBE(ip + 8, 8);
+        src.lo = loadBE(ip + 16, 8);
+        dst.hi = loadBE(ip + 24, 8);
+        dst.lo = loadBE(ip + 32, 8);
+        l4Offset = offset + kIPv6HeaderSize;
+        usePorts = true;
+    } else {
+        // Not IP: keep each MAC pair on one worker
+        src.lo = loadBE(data + 6, 6);
+        dst.lo = loadBE(data, 6);
+        return hashEndpoints(src, dst, etherType);
+    }
+
+    if (usePorts && hasPorts(protocol) && length >= l4Offset + 4) {
+        src.port = static_cast<uint16_t>(loadBE(data + l4Offset, 2));
+        dst.port = static_cast<uint16_t>(loadBE(data + l4Offset + 2, 2));
+    }
+    return hashEndpoints(src, dst, protocol);
+}
+
+size_t FlowDispatcher::dispatch(std::vector<Packet>& packets) {
+    for (auto& packet : packets) {
+        const uint64_t hash = flowHash(packet);
+        trackFlow(hash);
+        workers_[workerFor(hash)]->pending.push_back(std::move(packet));
+    }
+
+    // One push per worker and batch; a full queue blocks until its worker catches up
+    size_t queued = 0;
+    for (auto& worker : workers_) {
+        if (worker->pending.empty()) {
+            continue;
+        }
+        const size_t accepted = worker->queue->push(worker->pending);
+        worker->packets.fetch_add(accepted, std::memory_order_relaxed);
+        queued += accepted;
+        worker->pending.clear();
+    }
+
+    dispatched_.fetch_add(queued, std::memory_order_relaxed);
+    return queued;
+}
+
+size_t FlowDispatcher::pop(size_t worker, std::vector<Packet>& out, size_t maxPackets,
+                           std::chrono::milliseconds timeout) {
+    if (worker >= workers_.size()) {
+        return 0;
+    }
+    return workers_[worker]->queue->pop(out, maxPackets, timeout);
+}
+
+void FlowDispatcher::open() {
+    for (auto& worker : workers_) {
+        worker->queue->open();
+    }
+}
+
+void FlowDispatcher::close() {
+    for (auto& worker : workers_) {
+        worker->queue->close();
+    }
+}
+
+std::vector<FlowDispatcher::HeavyHitter> FlowDispatcher::getHeavyHitters() const {
+    std::lock_guard<std::mutex> lock(heavyHittersMutex_);
+    return heavyHitters_;
+}
+
+FlowDispatcher::Statistics FlowDispatcher::getStatistics() const {
+    Statistics stats;
+    stats.packetsDispatched = dispatched_.load(std::memory_order_relaxed);
+    stats.heavyHitters = heavyHitterCount_.load(std::memory_order_relaxed);
+    for (const auto& worker : workers_) {
+        stats.workerPackets.push_back(worker->packets.load(std::memory_order_relaxed));
+        stats.workerHighWatermark.push_back(worker->queue->getStatistics().highWatermark);
+    }
+    return stats;
+}
+
+void FlowDispatcher::trackFlow(uint64_t hash) {
+    // Space-saving: a new flow evicts the smallest counter and inherits its count
+    FlowCount* smallest = nullptr;
+    bool found = false;
+    for (size_t i = 0; i < trackedFlows_; ++i) {
+        if (flows_[i].hash == hash) {
+            ++flows_[i].count;
+            found = true;
+            break;
+        }
+        if (smallest == nullptr || flows_[i].count < smallest->count) {
+            smallest = &flows_[i];
+        }
+    }
+    if (!found) {
+        if (trackedFlows_ < kTrackedFlows) {
+            flows_[trackedFlows_++] = FlowCount{hash, 1};
+        } else {
+            smallest->hash = hash;
+            ++smallest->count;
+        }
+    }
+
+    if (++windowPackets_ >= config_.heavyHitterWindow) {
+        closeWindow();
+    }
+}
+
+void FlowDispatcher::closeWindow() {
+    const double evenShare = static_cast<double>(windowPackets_) / static_cast<double>(workers_.size());
+    const double threshold = config_.heavyHitterShare * evenShare;
+
+    std::vector<HeavyHitter> hitters;
+    for (size_t i = 0; i < trackedFlows_; ++i) {
+        if (static_cast<double>(flows_[i].count) > threshold) {
+            HeavyHitter hitter;
+            hitter.flowHash = flows_[i].hash;
+            hitter.worker = workerFor(flows_[i].hash);
+            hitter.packets = flows_[i].count;
+            hitter.share = static_cast<double>(flows_[i].count) / static_cast<double>(windowPackets_);
+            hitters.push_back(hitter);
+        }
+    }
+    std::sort(hitters.begin(), hitters.end(),
+              [](const HeavyHitter& a, const HeavyHitter& b) { return a.packets > b.packets; });
+
+    std::vector<HeavyHitter> flagged;
+    {
+        std::lock_guard<std::mutex> lock(heavyHittersMutex_);
+        for (const auto& hitter : hitters) {
+            const bool known = std::any_of(heavyHitters_.begin(), heavyHitters_.end(),
+                                           [&](const HeavyHitter& h) { return h.flowHash == hitter.flowHash; });
+            if (!known) {
+                flagged.push_back(hitter);
+            }
+        }
+        heavyHitters_ = std::move(hitters);
+    }
+
+    // Only flows that were not already heavy in the previous window are reported
+    for (const auto& hitter : flagged) {
+        heavyHitterCount_.fetch_add(1, std::memory_order_relaxed);
+        if (heavyHittersCounter_) {
+            heavyHittersCounter_->increment();
+        }
+        BEATRICE_WARN("Flow {:016x} carries {:.1f}% of traffic on its own, worker {} is overloaded",
+                      hitter.flowHash, hitter.share * 100.0, hitter.worker);
+    }
+
+    trackedFlows_ = 0;
+    windowPackets_ = 0;
+}
+
+} // namespace beatrice
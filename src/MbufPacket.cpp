@@ -0,0 +1,35 @@
+#include "beatrice/MbufPacket.hpp"
+#include <cstring>
+
+extern "C" {
+#include <rte_mbuf.h>
+}
+
+namespace beatrice {
+
+Packet packetFromMbuf(struct rte_mbuf* mbuf, bool zeroCopy, const MbufRefCount& inFlight,
+                      std::chrono::steady_clock::time_point timestamp) {
+    const uint32_t length = rte_pktmbuf_pkt_len(mbuf);
+
+    if (zeroCopy && (mbuf->nb_segs == 1 || rte_pktmbuf_linearize(mbuf) == 0)) {
+        inFlight->fetch_add(1, std::memory_order_relaxed);
+        return Packet(rte_pktmbuf_mtod(mbuf, const uint8_t*), length,
+                      [mbuf, inFlight](const uint8_t*) {
+                          rte_pktmbuf_free(mbuf);
+                          inFlight->fetch_sub(1, std::memory_order_relaxed);
+                      },
+                      timestamp);
+    }
+
+    // rte_pktmbuf_read() only copies when the data spans several segments
+    auto data = std::make_shared<uint8_t[]>(length);
+    const void* contiguous = rte_pktmbuf_read(mbuf, 0, length, data.get());
+    if (contiguous && contiguous != data.get()) {
+        std::memcpy(data.get(), contiguous, length);
+    }
+    rte_pktmbuf_free(mbuf);
+
+    return Packet(data, length, timestamp);
+}
+
+} // namespace beatrice
@@ -43,7 +43,12 @@ void Histogram::observe(double value) {
     
     // Store value for quantile calculation
     std::lock_guard<std::mutex> lock(valuesMutex_);
-    values_.push_back(value);
+    if (values_.size() < kWindowSize) {
+        values_.push_back(value);
+    } else {
+        values_[nextValue_] = value;
+        nextValue_ = (nextValue_ + 1) % kWindowSize;
+    }
 }
 
 double Histogram::getQuantile(double quantile) const {
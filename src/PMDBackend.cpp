@@ -1,6 +1,7 @@
 #include "beatrice/PMDBackend.hpp"
 #include "beatrice/Logger.hpp"
 #include "beatrice/Error.hpp"
+#include "beatrice/MbufPacket.hpp"
 #include <chrono>
 #include <algorithm>
 
@@ -26,10 +27,10 @@ PMDBackend::PMDBackend()
     , config_()
     , processingThread_()
     , packetQueue_()
-    , packetQueueMutex_()
-    , packetCondition_()
     , packetCallback_(nullptr)
     , callbackMutex_()
+    , rxBurst_()
+    , mbufsInFlight_(std::make_shared<std::atomic<uint64_t>>(0))
     , statsMutex_()
     , stats_()
     , errorMutex_()
@@ -59,6 +60,7 @@ Result<void> PMDBackend::initialize(const Config& config) {
     }
 
     config_ = config;
+    packetQueue_ = std::make_unique<PacketQueue>(config_, OverflowPolicy::DROP_NEWEST, "pmd_" + pmdType_);
     
     if (!validateInterface(config_.interface)) {
         return Result<void>::error(beatrice::ErrorCode::INVALID_ARGUMENT, "Invalid interface: " + config_.interface);
@@ -98,6 +100,7 @@ Result<void> PMDBackend::start() {
     }
 
     running_ = true;
+    packetQueue_->open();
     processingThread_ = std::thread(&PMDBackend::packetProcessingLoop, this);
 
     return Result<void>::success();
@@ -109,7 +112,7 @@ Result<void> PMDBackend::stop() {
     }
 
     running_ = false;
-    packetCondition_.notify_all();
+    packetQueue_->close();
 
     if (processingThread_.joinable()) {
         processingThread_.join();
@@ -124,44 +127,21 @@ bool PMDBackend::isRunning() const noexcept {
 }
 
 std::optional<Packet> PMDBackend::nextPacket(std::chrono::milliseconds timeout) {
-    std::unique_lock<std::mutex> lock(packetQueueMutex_);
-    
-    if (packetQueue_.empty()) {
-        if (packetCondition_.wait_for(lock, timeout, [this] { return !packetQueue_.empty() || !running_; })) {
-            if (!running_) {
-                return std::nullopt;
-            }
-        } else {
-            return std::nullopt;
-        }
-    }
-
-    if (packetQueue_.empty()) {
+    auto packets = getPackets(1, timeout);
+    if (packets.empty()) {
         return std::nullopt;
     }
-
-    Packet packet = std::move(packetQueue_.front());
-    packetQueue_.pop();
-    
-    return packet;
+    return std::move(packets.front());
 }
 
 std::vector<Packet> PMDBackend::getPackets(size_t maxPackets, std::chrono::milliseconds timeout) {
     std::vector<Packet> packets;
-    packets.reserve(maxPackets);
-
-    auto start = std::chrono::steady_clock::now();
-    auto end = start + timeout;
-
-    while (packets.size() < maxPackets && std::chrono::steady_clock::now() < end) {
-        auto packet = nextPacket(std::chrono::milliseconds(100));
-        if (packet) {
-            packets.push_back(std::move(*packet));
-        } else if (!running_) {
-            break;
-        }
+    if (!packetQueue_) {
+        return packets;
     }
 
+    // Return whatever arrived once anything is there instead of waiting to fill maxPackets
+    packetQueue_->pop(packets, maxPackets, timeout);
     return packets;
 }
 
@@ -176,13 +156,26 @@ void PMDBackend::removePacketCallback() {
 }
 
 PMDBackend::Statistics PMDBackend::getStatistics() const {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    return stats_;
+    Statistics stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = stats_;
+    }
+    if (packetQueue_) {
+        const auto queueStats = packetQueue_->getStatistics();
+        stats.packetsDropped += queueStats.dropped;
+        stats.bytesDropped += queueStats.bytesDropped;
+        stats.queueHighWatermark = queueStats.highWatermark;
+    }
+    return stats;
 }
 
 void PMDBackend::resetStatistics() {
     std::lock_guard<std::mutex> lock(statsMutex_);
     stats_ = Statistics{};
+    if (packetQueue_) {
+        packetQueue_->resetStatistics();
+    }
 }
 
 std::string PMDBackend::getName() const {
@@ -319,6 +312,13 @@ Result<void> PMDBackend::addVirtualDevice(const std::string& deviceType, const s
     }
     
     if (createVirtualDevice(deviceType, params)) {
+        // The EAL probes virtual devices from --vdev arguments, e.g. net_null0,size=64
+        std::string devargs = deviceType + std::to_string(virtualDevices_.size());
+        for (const auto& [key, value] : params) {
+            devargs += "," + key + "=" + value;
+        }
+        pmdArgs_.push_back("--vdev");
+        pmdArgs_.push_back(devargs);
         virtualDevices_.push_back(deviceType);
         return Result<void>::success();
     } else {
@@ -336,6 +336,12 @@ Result<void> PMDBackend::removeVirtualDevice(const std::string& deviceName) {
         if (it != virtualDevices_.end()) {
             virtualDevices_.erase(it);
         }
+        for (size_t i = 0; i + 1 < pmdArgs_.size(); ++i) {
+            if (pmdArgs_[i] == "--vdev" && pmdArgs_[i + 1].rfind(deviceName, 0) == 0) {
+                pmdArgs_.erase(pmdArgs_.begin() + i, pmdArgs_.begin() + i + 2);
+                break;
+            }
+        }
         return Result<void>::success();
     } else {
         return Result<void>::error(beatrice::ErrorCode::INITIALIZATION_FAILED, "Failed to destroy virtual device");
@@ -467,6 +473,7 @@ bool PMDBackend::setupQueues() {
         return false;
     }
 
+    rxBurst_.assign(mbufBurstSize(config_.batchSize), nullptr);
     return true;
 }
 
@@ -495,38 +502,79 @@ void PMDBackend::stopPort() {
 
 void PMDBackend::packetProcessingLoop() {
     while (running_) {
-        processPackets();
-        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        // Poll back-to-back while traffic flows, back off only when the queue is empty
+        if (processPackets() == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
     }
 }
 
-void PMDBackend::processPackets() {
+size_t PMDBackend::processPackets() {
     if (!running_ || !portInitialized_) {
-        return;
+        return 0;
     }
 
-    struct rte_mbuf* pkts[32];
-    uint16_t nbRx = rte_eth_rx_burst(portId_, 0, pkts, 32);
+    const uint16_t nbRx = rte_eth_rx_burst(portId_, 0, rxBurst_.data(), static_cast<uint16_t>(rxBurst_.size()));
+    if (nbRx == 0) {
+        return 0;
+    }
+
+    // Packets reference the mbufs directly; they go back to the mempool when
+    // the last consumer drops them
+    const auto now = std::chrono::steady_clock::now();
+    const bool zeroCopy = zeroCopyEnabled_ && config_.enableZeroCopy;
+    std::vector<Packet> batch;
+    batch.reserve(nbRx);
+    uint64_t bytes = 0;
 
     for (uint16_t i = 0; i < nbRx; i++) {
-        struct rte_mbuf* pkt = pkts[i];
-        
-        if (pkt) {
-            std::lock_guard<std::mutex> lock(statsMutex_);
-            stats_.packetsCaptured++;
-            stats_.bytesCaptured += pkt->data_len;
-            stats_.lastUpdate = std::chrono::steady_clock::now();
-            
-            rte_pktmbuf_free(pkt);
+        bytes += rte_pktmbuf_pkt_len(rxBurst_[i]);
+        batch.push_back(packetFromMbuf(rxBurst_[i], zeroCopy, mbufsInFlight_, now));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsCaptured += nbRx;
+        stats_.bytesCaptured += bytes;
+        stats_.lastUpdate = now;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        if (packetCallback_) {
+            for (const auto& packet : batch) {
+                try {
+                    packetCallback_(packet);
+                } catch (const std::exception& e) {
+                    BEATRICE_ERROR("Exception in packet callback: {}", e.what());
+                }
+            }
         }
     }
+
+    // Dropped packets free their mbufs when batch goes out of scope
+    packetQueue_->push(batch);
+
+    return nbRx;
 }
 
 void PMDBackend::shutdown() {
     stop();
     
+    if (packetQueue_) {
+        // Queued packets still hold mbufs from the RX mempool
+        std::vector<Packet> stale;
+        packetQueue_->pop(stale, packetQueue_->capacity(), std::chrono::milliseconds(0));
+    }
+    
     if (dpdkInitialized_) {
-        rte_eal_cleanup();
+        const uint64_t inFlight = mbufsInFlight_->load(std::memory_order_relaxed);
+        if (inFlight > 0) {
+            // Freeing these mbufs after EAL cleanup would touch unmapped hugepages
+            BEATRICE_WARN("{} packets still reference DPDK mbufs, skipping EAL cleanup", inFlight);
+        } else {
+            rte_eal_cleanup();
+        }
         dpdkInitialized_ = false;
     }
     
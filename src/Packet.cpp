@@ -5,7 +5,21 @@ namespace beatrice {
 
 Packet::Packet(std::shared_ptr<const uint8_t[]> data, size_t length, 
                std::chrono::steady_clock::time_point timestamp)
-    : data_(data), length_(length), timestamp_(timestamp) {
+    : data_(std::move(data)), view_(data_.get()), length_(length), timestamp_(timestamp) {
+}
+
+Packet::Packet(PacketBuffer buffer, size_t length,
+               std::chrono::steady_clock::time_point timestamp)
+    : buffer_(std::move(buffer)), view_(buffer_.data()), length_(length), timestamp_(timestamp) {
+}
+
+std::shared_ptr<const uint8_t[]> Packet::getData() const {
+    if (data_ || !buffer_) {
+        return data_;
+    }
+    
+    // Keep the pool buffer referenced for as long as the caller holds the pointer
+    return std::shared_ptr<const uint8_t[]>(view_, [buffer = buffer_](const uint8_t*) {});
 }
 
 // Other methods can be added here if needed
@@ -1,7 +1,13 @@
 #include "beatrice/PacketFilter.hpp"
 #include "beatrice/Logger.hpp"
+#include "beatrice/Metrics.hpp"
 #include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <optional>
 #include <sstream>
+#include <thread>
 #include <arpa/inet.h>
 #include <netinet/ip.h>
 #include <netinet/tcp.h>
@@ -10,13 +16,361 @@
 
 namespace beatrice {
 
-PacketFilter::PacketFilter() {
+namespace {
+
+// Hands each thread a distinct stats shard
+std::atomic<size_t> nextThreadSlot{0};
+
+size_t threadSlot() {
+    thread_local const size_t home = nextThreadSlot.fetch_add(1, std::memory_order_relaxed);
+    return home;
+}
+
+// Bytes of payload a PAYLOAD filter searches
+constexpr size_t kPayloadWindow = 100;
+
+const std::string kPassedReason = "Packet passed all filters";
+
+// Ports as "80" or "1000-2000"
+std::optional<std::pair<uint16_t, uint16_t>> parsePortRange(const std::string& range) {
+    try {
+        size_t dash = range.find('-');
+        unsigned long low = std::stoul(range.substr(0, dash));
+        unsigned long high = dash == std::string::npos ? low : std::stoul(range.substr(dash + 1));
+        if (low <= high && high <= 0xFFFF) {
+            return std::make_pair(static_cast<uint16_t>(low), static_cast<uint16_t>(high));
+        }
+    } catch (const std::exception&) {
+    }
+    return std::nullopt;
+}
+
+// Network as "10.0.0.0/8" or a single address
+std::optional<std::pair<uint32_t, uint8_t>> parseNetwork(const std::string& range) {
+    size_t slash = range.find('/');
+    in_addr address{};
+    if (inet_pton(AF_INET, range.substr(0, slash).c_str(), &address) != 1) {
+        return std::nullopt;
+    }
+
+    unsigned long prefixLength = 32;
+    if (slash != std::string::npos) {
+        try {
+            prefixLength = std::stoul(range.substr(slash + 1));
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+        if (prefixLength == 0 || prefixLength > 32) {
+            return std::nullopt;
+        }
+    }
+    return std::make_pair(ntohl(address.s_addr), static_cast<uint8_t>(prefixLength));
+}
+
+// IPv4 protocols a PROTOCOL filter lets through
+std::optional<std::vector<uint8_t>> parseProtocols(const std::string& expression) {
+    if (expression == "tcp") return std::vector<uint8_t>{IPPROTO_TCP};
+    if (expression == "udp") return std::vector<uint8_t>{IPPROTO_UDP};
+    if (expression == "icmp") return std::vector<uint8_t>{IPPROTO_ICMP};
+    if (expression == "ip") {
+        std::vector<uint8_t> protocols;
+        for (int protocol = 1; protocol <= 0xFF; ++protocol) {
+            protocols.push_back(static_cast<uint8_t>(protocol));
+        }
+        return protocols;
+    }
+    return std::nullopt;
+}
+
+// Table for a list or file IP_RANGE filter, nullptr for a single IPv4 network
+Result<std::shared_ptr<const PrefixTable>> loadPrefixTable(const std::string& name,
+                                                           const PacketFilter::FilterConfig& config) {
+    using TableResult = Result<std::shared_ptr<const PrefixTable>>;
+    
+    auto tagParameter = config.parameters.find("tag");
+    std::string tag = tagParameter != config.parameters.end() ? tagParameter->second : name;
+    
+    auto file = config.parameters.find("file");
+    if (file != config.parameters.end()) {
+        auto table = PrefixTable::loadFile(file->second, tag);
+        if (table.isError()) {
+            return TableResult::error(table.getErrorCode(), table.getErrorMessage());
+        }
+        return TableResult::success(std::make_shared<const PrefixTable>(table.getValue()));
+    }
+    
+    if (config.expression.find_first_of(",:") == std::string::npos) {
+        return TableResult::success(nullptr);
+    }
+    
+    std::vector<PrefixTable::Prefix> prefixes;
+    std::istringstream list(config.expression);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        size_t first = item.find_first_not_of(" \t");
+        if (first == std::string::npos) continue;
+        size_t last = item.find_last_not_of(" \t");
+        
+        auto prefix = PrefixTable::parsePrefix(item.substr(first, last - first + 1), tag);
+        if (prefix.isError()) {
+            return TableResult::error(prefix.getErrorCode(), prefix.getErrorMessage());
+        }
+        prefixes.push_back(prefix.getValue());
+    }
+    
+    auto table = PrefixTable::build(prefixes);
+    if (table.isError()) {
+        return TableResult::error(table.getErrorCode(), table.getErrorMessage());
+    }
+    return TableResult::success(std::make_shared<const PrefixTable>(table.getValue()));
+}
+
+// Matcher for a rule set PAYLOAD filter, nullptr for a regex
+Result<std::shared_ptr<const PatternMatcher>> loadPatternMatcher(const PacketFilter::FilterConfig& config) {
+    using MatcherResult = Result<std::shared_ptr<const PatternMatcher>>;
+    
+    auto file = config.parameters.find("file");
+    auto rules = config.parameters.find("patterns");
+    if (file == config.parameters.end() && rules == config.parameters.end()) {
+        return MatcherResult::success(nullptr);
+    }
+    
+    auto matcher = file != config.parameters.end() ? PatternMatcher::loadFile(file->second)
+                                                   : PatternMatcher::parseRules(rules->second);
+    if (matcher.isError()) {
+        return MatcherResult::error(matcher.getErrorCode(), matcher.getErrorMessage());
+    }
+    
+    auto compiled = std::make_shared<PatternMatcher>(matcher.getValue());
+    compiled->enablePrefilter();
+    return MatcherResult::success(std::move(compiled));
+}
+
+} // anonymous namespace
+
+struct PacketFilter::StreamTable {
+    // Flows followed when parameters["stream_flows"] is not set
+    static constexpr size_t kDefaultFlows = kShards * 4096;
+    
+    StreamTable(size_t maxFlows, std::shared_ptr<Counter> evictionCounter)
+        : flowsPerShard(std::max<size_t>(maxFlows / kShards, 1)), evictions(std::move(evictionCounter)) {}
+    
+    // One direction of a TCP connection
+    struct FlowKey {
+        uint64_t addresses = 0;
+        uint32_t ports = 0;
+        
+        bool operator==(const FlowKey& other) const {
+            return addresses == other.addresses && ports == other.ports;
+        }
+    };
+    
+    struct FlowHash {
+        size_t operator()(const FlowKey& key) const noexcept {
+            return static_cast<size_t>((key.addresses ^ (uint64_t{key.ports} << 17)) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+    
+    struct Flow {
+        PatternMatcher::StreamState state;
+        uint32_t nextSequence = 0;       // expected sequence number of the next segment
+        std::list<FlowKey>::iterator age;
+    };
+    
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<FlowKey, Flow, FlowHash> flows;
+        std::list<FlowKey> lru;          // most recently seen flow first
+    };
+    
+    const size_t flowsPerShard;
+    const std::shared_ptr<Counter> evictions;
+    std::array<Shard, kShards> shards;
+    
+    /**
+     * @brief Scan a TCP segment as the continuation of its flow
+     *
+     * In-order segments carry the automaton on; a retransmission is scanned
+     * on its own and a segment after a gap starts the flow over. FIN and RST
+     * end the flow; a new flow in a full shard evicts the one idle longest.
+     */
+    template <typename Callback>
+    void scan(const PatternMatcher& matcher, const PacketView& view, Callback&& onMatch) {
+        const FlowKey key{uint64_t{view.srcAddress} << 32 | view.dstAddress,
+                          uint32_t{view.srcPort} << 16 | view.dstPort};
+        Shard& shard = shards[(FlowHash()(key) >> 32) % kShards];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        
+        const bool closing = (view.tcpFlags & (TH_FIN | TH_RST)) != 0;
+        auto it = shard.flows.find(key);
+        if (it == shard.flows.end()) {
+            if (closing) {
+                matcher.scan(view.segment, view.segmentLength, onMatch);
+                return;
+            }
+            if (shard.flows.size() >= flowsPerShard) {
+                shard.flows.erase(shard.lru.back());
+                shard.lru.pop_back();
+                if (evictions) {
+                    evictions->increment();
+                }
+            }
+            shard.lru.push_front(key);
+            it = shard.flows.emplace(key, Flow{{}, view.sequence, shard.lru.begin()}).first;
+        } else {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.age);
+        }
+        
+        Flow& flow = it->second;
+        const auto distance = static_cast<int32_t>(view.sequence - flow.nextSequence);
+        if (distance < 0) {
+            matcher.scan(view.segment, view.segmentLength, onMatch);
+        } else {
+            // Nothing can be matched across bytes that never arrived
+            if (distance > 0) {
+                flow.state = {};
+            }
+            matcher.scan(flow.state, view.segment, view.segmentLength, onMatch);
+            flow.nextSequence = view.sequence + static_cast<uint32_t>(view.segmentLength) +
+                                ((view.tcpFlags & TH_SYN) ? 1 : 0);
+        }
+        
+        if (closing) {
+            shard.lru.erase(flow.age);
+            shard.flows.erase(it);
+        }
+    }
+};
+
+PacketFilter::PacketFilter() : chain_(new CompiledChain) {
+    chain_.load()->emptyDecisions = decisionCounterLocked("");
 }
 
 PacketFilter::~PacketFilter() {
+    delete chain_.exchange(nullptr);
+}
+
+std::shared_ptr<PacketFilter::ShardedCounter> PacketFilter::decisionCounterLocked(const std::string& name) {
+    // Kept across removals so getStats() still reports the filter's decisions
+    auto& counter = decisionCounts_[name];
+    if (!counter) {
+        counter = std::make_shared<ShardedCounter>();
+    }
+    return counter;
+}
+
+PacketFilter::CompiledRule PacketFilter::compileRule(const std::string& name, const FilterEntry& entry) {
+    const FilterConfig& config = entry.config;
+    
+    CompiledRule rule;
+    rule.name = name;
+    rule.rejectReason = "Filter " + name + " rejected packet";
+    rule.type = config.type;
+    rule.matchAll = config.expression.empty() && config.type != FilterType::CUSTOM &&
+                    !entry.prefixTable && !entry.patternMatcher;
+    rule.decisions = decisionCounterLocked(name);
+    if (rule.matchAll) {
+        return rule;
+    }
+    
+    switch (config.type) {
+        case FilterType::BPF:
+            rule.bpfProgram = entry.bpfProgram;
+            break;
+        case FilterType::PROTOCOL:
+            if (auto protocols = parseProtocols(config.expression)) {
+                for (uint8_t protocol : *protocols) {
+                    rule.protocols.set(protocol);
+                }
+            } else {
+                rule.valid = false;
+            }
+            break;
+        case FilterType::IP_RANGE:
+            if (entry.prefixTable) {
+                rule.prefixTable = entry.prefixTable;
+                rule.tagKey = name + ".tag";
+            } else if (auto network = parseNetwork(config.expression)) {
+                rule.netmask = network->second == 32 ? 0xFFFFFFFFu : ~(0xFFFFFFFFu >> network->second);
+                rule.network = network->first & rule.netmask;
+            } else {
+                rule.valid = false;
+            }
+            break;
+        case FilterType::PORT_RANGE:
+            if (auto ports = parsePortRange(config.expression)) {
+                rule.lowPort = ports->first;
+                rule.highPort = ports->second;
+            } else {
+                rule.valid = false;
+            }
+            break;
+        case FilterType::PAYLOAD:
+            if (entry.patternMatcher) {
+                rule.patternMatcher = entry.patternMatcher;
+                rule.streams = entry.streams;
+                rule.matchKey = name + ".matches";
+                break;
+            }
+            try {
+                rule.pattern = std::regex(config.expression);
+            } catch (const std::regex_error&) {
+                rule.valid = false;
+            }
+            break;
+        case FilterType::CUSTOM:
+            rule.customFunc = entry.customFunc;
+            break;
+    }
+    
+    if (!rule.valid) {
+        BEATRICE_WARN("Filter {} has an unusable expression '{}', it rejects every packet",
+                      name, config.expression);
+    }
+    return rule;
+}
+
+void PacketFilter::rebuildLocked() {
+    auto chain = std::make_unique<CompiledChain>();
+    chain->emptyDecisions = decisionCounterLocked("");
+    for (const auto& [name, entry] : enabledFiltersLocked()) {
+        chain->rules.push_back(compileRule(name, *entry));
+    }
+    
+    std::unique_ptr<CompiledChain> old(chain_.exchange(chain.release()));
+    readers_.synchronize();
 }
 
 Result<void> PacketFilter::addFilter(const std::string& name, const FilterConfig& config) {
+    // Large prefix lists and rule sets take a while, build them before taking the lock
+    std::shared_ptr<const PrefixTable> prefixTable;
+    if (config.type == FilterType::IP_RANGE) {
+        auto table = loadPrefixTable(name, config);
+        if (table.isError()) {
+            return Result<void>::error(table.getErrorCode(), table.getErrorMessage());
+        }
+        prefixTable = table.getValue();
+    }
+    
+    std::shared_ptr<const PatternMatcher> patternMatcher;
+    if (config.type == FilterType::PAYLOAD) {
+        auto matcher = loadPatternMatcher(config);
+        if (matcher.isError()) {
+            return Result<void>::error(matcher.getErrorCode(), matcher.getErrorMessage());
+        }
+        patternMatcher = matcher.getValue();
+    }
+    
+    size_t streamFlows = StreamTable::kDefaultFlows;
+    auto flows = config.parameters.find("stream_flows");
+    if (flows != config.parameters.end()) {
+        try {
+            streamFlows = std::stoul(flows->second);
+        } catch (const std::exception&) {
+            return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Invalid stream_flows: " + flows->second);
+        }
+    }
+    
     std::lock_guard<std::mutex> lock(filtersMutex_);
     
     if (filters_.find(name) != filters_.end()) {
@@ -25,7 +379,27 @@ Result<void> PacketFilter::addFilter(const std::string& name, const FilterConfig
     
     FilterEntry entry;
     entry.config = config;
+    entry.prefixTable = std::move(prefixTable);
+    entry.patternMatcher = std::move(patternMatcher);
+    
+    auto stream = config.parameters.find("stream");
+    if (entry.patternMatcher && stream != config.parameters.end() && stream->second == "true") {
+        entry.streams = std::make_shared<StreamTable>(
+            streamFlows, metrics::counter("packet_filter_" + name + "_stream_evictions_total",
+                                          "Followed TCP flows dropped to make room for new ones"));
+    }
+    
+    if (config.type == FilterType::BPF) {
+        auto program = BpfProgram::compile(config.expression);
+        if (program.isError()) {
+            return Result<void>::error(program.getErrorCode(), program.getErrorMessage());
+        }
+        entry.bpfProgram = program.getValue();
+        entry.bpfProgram.enableJit();
+    }
+    
     filters_[name] = entry;
+    rebuildLocked();
     
     return Result<void>::success();
 }
@@ -39,6 +413,7 @@ Result<void> PacketFilter::removeFilter(const std::string& name) {
     }
     
     filters_.erase(it);
+    rebuildLocked();
     return Result<void>::success();
 }
 
@@ -51,6 +426,7 @@ Result<void> PacketFilter::setFilterEnabled(const std::string& name, bool enable
     }
     
     it->second.config.enabled = enabled;
+    rebuildLocked();
     return Result<void>::success();
 }
 
@@ -58,62 +434,50 @@ PacketFilter::FilterResult PacketFilter::applyFilters(const Packet& packet) {
     FilterResult result;
     result.passed = true;
     
-    std::lock_guard<std::mutex> lock(filtersMutex_);
-    
-    std::vector<std::pair<std::string, FilterEntry*>> sortedFilters;
-    for (auto& [name, entry] : filters_) {
-        if (entry.config.enabled) {
-            sortedFilters.emplace_back(name, &entry);
-        }
+    // Reading the clock costs more than the rules, time a sample of packets
+    thread_local uint64_t tick = 0;
+    bool sample = ++tick % kTimingInterval == 0;
+    std::chrono::steady_clock::time_point startTime;
+    if (sample) {
+        startTime = std::chrono::steady_clock::now();
     }
     
-    std::sort(sortedFilters.begin(), sortedFilters.end(), 
-              [](const auto& a, const auto& b) {
-                  return a.second->config.priority > b.second->config.priority;
-              });
-    
-    auto startTime = std::chrono::high_resolution_clock::now();
+    ReadGuard guard(*this);
+    const CompiledChain& chain = guard.chain();
+    ShardedCounter* decisions = chain.emptyDecisions.get();
     
-    for (auto& [name, entry] : sortedFilters) {
-        if (!entry->config.enabled) continue;
+    if (!chain.rules.empty()) {
+        PacketView view = parsePacket(packet);
         
-        bool filterResult = false;
-        switch (entry->config.type) {
-            case FilterType::BPF:
-                filterResult = applyBPFFilter(packet, entry->config);
-                break;
-            case FilterType::PROTOCOL:
-                filterResult = applyProtocolFilter(packet, entry->config);
-                break;
-            case FilterType::IP_RANGE:
-                filterResult = applyIPRangeFilter(packet, entry->config);
-                break;
-            case FilterType::PORT_RANGE:
-                filterResult = applyPortRangeFilter(packet, entry->config);
-                break;
-            case FilterType::PAYLOAD:
-                filterResult = applyPayloadFilter(packet, entry->config);
-                break;
-            case FilterType::CUSTOM:
-                filterResult = applyCustomFilter(packet, *entry);
+        for (const auto& rule : chain.rules) {
+            decisions = rule.decisions.get();
+            if (!rule.matches(packet, view, result)) {
+                result.passed = false;
+                result.filterName = rule.name;
+                result.reason = rule.rejectReason;
                 break;
+            }
         }
         
-        if (!filterResult) {
-            result.passed = false;
-            result.filterName = name;
-            result.reason = "Filter " + name + " rejected packet";
-            break;
+        if (result.passed) {
+            result.filterName = chain.rules.back().name;
+            result.reason = kPassedReason;
         }
-        
-        result.filterName = name;
-        result.reason = "Packet passed all filters";
     }
     
-    auto endTime = std::chrono::high_resolution_clock::now();
-    result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
-    
-    updateStats(result.filterName, result.passed, result.processingTime);
+    // Each thread owns one shard, so these stay in its cache
+    const size_t shard = threadSlot() % kShards;
+    StatsShard& stats = stats_[shard];
+    (result.passed ? stats.packetsPassed : stats.packetsDropped).fetch_add(1, std::memory_order_relaxed);
+    (*decisions)[shard].value.fetch_add(1, std::memory_order_relaxed);
+    
+    if (sample) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - startTime);
+        result.processingTime = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+        stats.timedPackets.fetch_add(1, std::memory_order_relaxed);
+        stats.processingNanos.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+    }
     
     return result;
 }
@@ -143,13 +507,55 @@ std::vector<std::string> PacketFilter::getActiveFilters() const {
 }
 
 PacketFilter::FilterStats PacketFilter::getStats() const {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    return stats_;
+    FilterStats stats;
+    
+    uint64_t timedPackets = 0;
+    uint64_t processingNanos = 0;
+    for (const auto& shard : stats_) {
+        stats.packetsPassed += shard.packetsPassed.load(std::memory_order_relaxed);
+        stats.packetsDropped += shard.packetsDropped.load(std::memory_order_relaxed);
+        timedPackets += shard.timedPackets.load(std::memory_order_relaxed);
+        processingNanos += shard.processingNanos.load(std::memory_order_relaxed);
+    }
+    stats.packetsProcessed = stats.packetsPassed + stats.packetsDropped;
+    
+    // Scale the sampled time up to every packet
+    if (timedPackets > 0) {
+        double nanos = static_cast<double>(processingNanos) / static_cast<double>(timedPackets) *
+                       static_cast<double>(stats.packetsProcessed);
+        stats.totalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::duration<double, std::nano>(nanos));
+    }
+    
+    std::lock_guard<std::mutex> lock(filtersMutex_);
+    for (const auto& [name, counter] : decisionCounts_) {
+        uint64_t count = 0;
+        for (const auto& shard : *counter) {
+            count += shard.value.load(std::memory_order_relaxed);
+        }
+        if (count > 0) {
+            stats.filterCounts[name] = count;
+        }
+    }
+    
+    return stats;
 }
 
 void PacketFilter::resetStats() {
-    std::lock_guard<std::mutex> lock(statsMutex_);
-    stats_ = FilterStats{};
+    // Packets in flight may land on either side of the reset
+    for (auto& shard : stats_) {
+        shard.packetsPassed.store(0, std::memory_order_relaxed);
+        shard.packetsDropped.store(0, std::memory_order_relaxed);
+        shard.timedPackets.store(0, std::memory_order_relaxed);
+        shard.processingNanos.store(0, std::memory_order_relaxed);
+    }
+    
+    std::lock_guard<std::mutex> lock(filtersMutex_);
+    for (auto& [name, counter] : decisionCounts_) {
+        for (auto& shard : *counter) {
+            shard.value.store(0, std::memory_order_relaxed);
+        }
+    }
 }
 
 Result<void> PacketFilter::setCustomFilter(const std::string& name, 
@@ -162,226 +568,353 @@ Result<void> PacketFilter::setCustomFilter(const std::string& name,
     }
     
     it->second.customFunc = std::move(filterFunc);
+    rebuildLocked();
     return Result<void>::success();
 }
 
-bool PacketFilter::applyBPFFilter(const Packet& packet, const FilterConfig& config) {
-    if (config.expression.empty()) return true;
-    
-    const uint8_t* data = packet.data();
-    size_t length = packet.length();
+std::shared_ptr<const PrefixTable> PacketFilter::getPrefixTable(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(filtersMutex_);
     
-    if (length < sizeof(struct ether_header)) return false;
+    auto it = filters_.find(name);
+    return it != filters_.end() ? it->second.prefixTable : nullptr;
+}
+
+Result<void> PacketFilter::setPrefixTable(const std::string& name, std::shared_ptr<const PrefixTable> table) {
+    if (!table) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Prefix table is null");
+    }
     
-    struct ether_header* eth = (struct ether_header*)data;
-    uint16_t ethType = ntohs(eth->ether_type);
+    std::lock_guard<std::mutex> lock(filtersMutex_);
     
-    if (ethType == ETHERTYPE_IP) {
-        if (length < sizeof(struct ether_header) + sizeof(struct iphdr)) return false;
-        
-        struct iphdr* ip = (struct iphdr*)(data + sizeof(struct ether_header));
-        uint8_t protocol = ip->protocol;
-        
-        if (config.expression.find("tcp") != std::string::npos && protocol == IPPROTO_TCP) return true;
-        if (config.expression.find("udp") != std::string::npos && protocol == IPPROTO_UDP) return true;
-        if (config.expression.find("icmp") != std::string::npos && protocol == IPPROTO_ICMP) return true;
+    auto it = filters_.find(name);
+    if (it == filters_.end()) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Filter not found: " + name);
+    }
+    if (it->second.config.type != FilterType::IP_RANGE) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Not an IP_RANGE filter: " + name);
     }
     
-    return false;
+    // Readers still on the old table finish before it is released
+    it->second.prefixTable = std::move(table);
+    rebuildLocked();
+    return Result<void>::success();
 }
 
-bool PacketFilter::applyProtocolFilter(const Packet& packet, const FilterConfig& config) {
-    if (config.expression.empty()) return true;
-    
-    const uint8_t* data = packet.data();
-    size_t length = packet.length();
+std::shared_ptr<const PatternMatcher> PacketFilter::getPatternMatcher(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(filtersMutex_);
     
-    if (length < sizeof(struct ether_header)) return false;
+    auto it = filters_.find(name);
+    return it != filters_.end() ? it->second.patternMatcher : nullptr;
+}
+
+Result<void> PacketFilter::setPatternMatcher(const std::string& name, std::shared_ptr<const PatternMatcher> matcher) {
+    if (!matcher) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Pattern matcher is null");
+    }
     
-    struct ether_header* eth = (struct ether_header*)data;
-    uint16_t ethType = ntohs(eth->ether_type);
+    std::lock_guard<std::mutex> lock(filtersMutex_);
     
-    if (ethType == ETHERTYPE_IP) {
-        if (length < sizeof(struct ether_header) + sizeof(struct iphdr)) return false;
-        
-        struct iphdr* ip = (struct iphdr*)(data + sizeof(struct ether_header));
-        uint8_t protocol = ip->protocol;
-        
-        if (config.expression == "tcp" && protocol == IPPROTO_TCP) return true;
-        if (config.expression == "udp" && protocol == IPPROTO_UDP) return true;
-        if (config.expression == "icmp" && protocol == IPPROTO_ICMP) return true;
-        if (config.expression == "ip" && protocol != 0) return true;
+    auto it = filters_.find(name);
+    if (it == filters_.end()) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Filter not found: " + name);
+    }
+    if (it->second.config.type != FilterType::PAYLOAD) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Not a PAYLOAD filter: " + name);
     }
     
-    return false;
+    // Automaton states saved for the old matcher mean nothing to the new one
+    it->second.patternMatcher = std::move(matcher);
+    if (auto& streams = it->second.streams) {
+        streams = std::make_shared<StreamTable>(streams->flowsPerShard * kShards, streams->evictions);
+    }
+    rebuildLocked();
+    return Result<void>::success();
 }
 
-bool PacketFilter::applyIPRangeFilter(const Packet& packet, const FilterConfig& config) {
-    if (config.expression.empty()) return true;
-    
+PacketFilter::PacketView PacketFilter::parsePacket(const Packet& packet) {
+    PacketView view;
     const uint8_t* data = packet.data();
     size_t length = packet.length();
     
-    if (length < sizeof(struct ether_header) + sizeof(struct iphdr)) return false;
+    // Only prefix tables look at IPv6
+    if (length >= sizeof(struct ether_header) + 40 && data[12] == 0x86 && data[13] == 0xDD) {
+        view.ipv6 = true;
+        view.srcAddress6 = data + sizeof(struct ether_header) + 8;
+        view.dstAddress6 = data + sizeof(struct ether_header) + 24;
+        return view;
+    }
     
-    struct ether_header* eth = (struct ether_header*)data;
-    uint16_t ethType = ntohs(eth->ether_type);
+    if (length < sizeof(struct ether_header) + sizeof(struct iphdr) ||
+        data[12] != 0x08 || data[13] != 0x00) {
+        return view;
+    }
     
-    if (ethType == ETHERTYPE_IP) {
-        struct iphdr* ip = (struct iphdr*)(data + sizeof(struct ether_header));
-        uint32_t srcIP = ntohl(ip->saddr);
-        uint32_t dstIP = ntohl(ip->daddr);
-        
-        std::vector<uint8_t> srcIPBytes = {(uint8_t)(srcIP >> 24), (uint8_t)(srcIP >> 16), 
-                                          (uint8_t)(srcIP >> 8), (uint8_t)srcIP};
-        std::vector<uint8_t> dstIPBytes = {(uint8_t)(dstIP >> 24), (uint8_t)(dstIP >> 16), 
-                                          (uint8_t)(dstIP >> 8), (uint8_t)dstIP};
-        
-        if (isIPInRange(srcIPBytes, config.expression) || 
-            isIPInRange(dstIPBytes, config.expression)) {
-            return true;
-        }
+    // Headers may sit at any alignment in the frame, copy them out
+    struct iphdr ip;
+    std::memcpy(&ip, data + sizeof(struct ether_header), sizeof(ip));
+    view.ipv4 = true;
+    view.protocol = ip.protocol;
+    view.srcAddress = ntohl(ip.saddr);
+    view.dstAddress = ntohl(ip.daddr);
+    
+    // Ports at fixed offsets past a 20 byte header, as the kernel offloads assume
+    size_t transport = sizeof(struct ether_header) + sizeof(struct iphdr);
+    if ((ip.protocol == IPPROTO_TCP && length >= transport + sizeof(struct tcphdr)) ||
+        (ip.protocol == IPPROTO_UDP && length >= transport + sizeof(struct udphdr))) {
+        view.hasPorts = true;
+        view.srcPort = static_cast<uint16_t>(data[transport] << 8 | data[transport + 1]);
+        view.dstPort = static_cast<uint16_t>(data[transport + 2] << 8 | data[transport + 3]);
     }
     
-    return false;
-}
-
-bool PacketFilter::applyPortRangeFilter(const Packet& packet, const FilterConfig& config) {
-    if (config.expression.empty()) return true;
+    size_t payloadOffset = sizeof(struct ether_header) + (ip.ihl & 0x0F) * 4;
+    if (length > payloadOffset) {
+        view.payload = data + payloadOffset;
+        view.payloadLength = std::min(length - payloadOffset, kPayloadWindow);
+    }
     
-    const uint8_t* data = packet.data();
-    size_t length = packet.length();
+    // Rule set PAYLOAD filters search the whole segment, without Ethernet padding
+    size_t end = length;
+    size_t totalLength = ntohs(ip.tot_len);
+    if (totalLength >= sizeof(struct iphdr) && sizeof(struct ether_header) + totalLength < end) {
+        end = sizeof(struct ether_header) + totalLength;
+    }
     
-    if (length < sizeof(struct ether_header) + sizeof(struct iphdr)) return false;
+    size_t segmentOffset = 0;
+    if ((ip.ihl & 0x0F) < 5) {
+        return view;
+    } else if (ip.protocol == IPPROTO_TCP && end >= payloadOffset + sizeof(struct tcphdr)) {
+        view.tcp = true;
+        view.sequence = static_cast<uint32_t>(data[payloadOffset + 4]) << 24 | data[payloadOffset + 5] << 16 |
+                        data[payloadOffset + 6] << 8 | data[payloadOffset + 7];
+        view.tcpFlags = data[payloadOffset + 13];
+        segmentOffset = payloadOffset + (data[payloadOffset + 12] >> 4) * 4;
+        if (segmentOffset < payloadOffset + sizeof(struct tcphdr)) {
+            return view;
+        }
+    } else if (ip.protocol == IPPROTO_UDP && end >= payloadOffset + sizeof(struct udphdr)) {
+        segmentOffset = payloadOffset + sizeof(struct udphdr);
+    } else {
+        return view;
+    }
     
-    struct ether_header* eth = (struct ether_header*)data;
-    uint16_t ethType = ntohs(eth->ether_type);
+    if (end >= segmentOffset) {
+        view.segment = data + segmentOffset;
+        view.segmentLength = end - segmentOffset;
+    }
     
-    if (ethType == ETHERTYPE_IP) {
-        struct iphdr* ip = (struct iphdr*)(data + sizeof(struct ether_header));
-        uint8_t protocol = ip->protocol;
-        
-        if (protocol == IPPROTO_TCP && length >= sizeof(struct ether_header) + sizeof(struct iphdr) + sizeof(struct tcphdr)) {
-            struct tcphdr* tcp = (struct tcphdr*)(data + sizeof(struct ether_header) + sizeof(struct iphdr));
-            uint16_t srcPort = ntohs(tcp->source);
-            uint16_t dstPort = ntohs(tcp->dest);
-            
-            if (isPortInRange(srcPort, config.expression) || 
-                isPortInRange(dstPort, config.expression)) {
-                return true;
-            }
-        } else if (protocol == IPPROTO_UDP && length >= sizeof(struct ether_header) + sizeof(struct iphdr) + sizeof(struct udphdr)) {
-            struct udphdr* udp = (struct udphdr*)(data + sizeof(struct ether_header) + sizeof(struct iphdr));
-            uint16_t srcPort = ntohs(udp->source);
-            uint16_t dstPort = ntohs(udp->dest);
-            
-            if (isPortInRange(srcPort, config.expression) || 
-                isPortInRange(dstPort, config.expression)) {
+    return view;
+}
+
+bool PacketFilter::CompiledRule::matches(const Packet& packet, const PacketView& view,
+                                         FilterResult& result) const {
+    if (matchAll) return true;
+    if (!valid) return false;
+    
+    switch (type) {
+        case FilterType::BPF:
+            return bpfProgram.matches(packet);
+        case FilterType::PROTOCOL:
+            return view.ipv4 && protocols.test(view.protocol);
+        case FilterType::IP_RANGE:
+            if (prefixTable) {
+                std::optional<PrefixTable::Match> match;
+                if (view.ipv4) {
+                    match = prefixTable->lookupV4(view.srcAddress);
+                    if (!match) match = prefixTable->lookupV4(view.dstAddress);
+                } else if (view.ipv6) {
+                    match = prefixTable->lookupV6(view.srcAddress6);
+                    if (!match) match = prefixTable->lookupV6(view.dstAddress6);
+                }
+                if (!match) return false;
+                result.metadata[tagKey] = std::string(match->tag);
                 return true;
             }
-        }
+            return view.ipv4 && ((view.srcAddress & netmask) == network ||
+                                 (view.dstAddress & netmask) == network);
+        case FilterType::PORT_RANGE:
+            return view.hasPorts && ((view.srcPort >= lowPort && view.srcPort <= highPort) ||
+                                     (view.dstPort >= lowPort && view.dstPort <= highPort));
+        case FilterType::PAYLOAD:
+            if (patternMatcher) return matchPatterns(view, result);
+            if (view.payload == nullptr) return false;
+            return std::regex_search(reinterpret_cast<const char*>(view.payload),
+                                     reinterpret_cast<const char*>(view.payload + view.payloadLength),
+                                     pattern);
+        case FilterType::CUSTOM:
+            return customFunc ? customFunc(packet) : true;
     }
-    
     return false;
 }
 
-bool PacketFilter::applyPayloadFilter(const Packet& packet, const FilterConfig& config) {
-    if (config.expression.empty()) return true;
+bool PacketFilter::CompiledRule::matchPatterns(const PacketView& view, FilterResult& result) const {
+    if (view.segment == nullptr) return false;
     
-    const uint8_t* data = packet.data();
-    size_t length = packet.length();
+    std::vector<uint32_t> ids;
+    auto collect = [&ids](uint32_t id, uint64_t) {
+        ids.push_back(id);
+        return true;
+    };
     
-    if (length < sizeof(struct ether_header) + sizeof(struct iphdr)) return false;
+    if (streams && view.tcp) {
+        streams->scan(*patternMatcher, view, collect);
+    } else {
+        patternMatcher->scan(view.segment, view.segmentLength, collect);
+    }
+    if (ids.empty()) return false;
+    
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    std::string matched;
+    for (uint32_t id : ids) {
+        if (!matched.empty()) matched += ',';
+        matched += std::to_string(id);
+    }
+    result.metadata[matchKey] = std::move(matched);
+    return true;
+}
+
+std::vector<std::pair<std::string, const PacketFilter::FilterEntry*>> PacketFilter::enabledFiltersLocked() const {
+    std::vector<std::pair<std::string, const FilterEntry*>> enabled;
+    for (const auto& [name, entry] : filters_) {
+        if (entry.config.enabled) {
+            enabled.emplace_back(name, &entry);
+        }
+    }
     
-    struct ether_header* eth = (struct ether_header*)data;
-    uint16_t ethType = ntohs(eth->ether_type);
+    std::sort(enabled.begin(), enabled.end(), [](const auto& a, const auto& b) {
+        if (a.second->config.priority != b.second->config.priority) {
+            return a.second->config.priority > b.second->config.priority;
+        }
+        return a.first < b.first;
+    });
+    return enabled;
+}
+
+BpfProgram PacketFilter::compileSocketFilter() const {
+    std::vector<std::string> clauses;
     
-    if (ethType == ETHERTYPE_IP) {
-        struct iphdr* ip = (struct iphdr*)(data + sizeof(struct ether_header));
-        size_t ipHeaderLen = (ip->ihl & 0x0F) * 4;
-        size_t payloadOffset = sizeof(struct ether_header) + ipHeaderLen;
+    {
+        std::lock_guard<std::mutex> lock(filtersMutex_);
         
-        if (length > payloadOffset) {
-            size_t payloadLength = length - payloadOffset;
-            const uint8_t* payload = data + payloadOffset;
+        for (const auto& [name, entry] : enabledFiltersLocked()) {
+            const FilterConfig& config = entry->config;
+            if (config.expression.empty()) continue;
             
-            std::string payloadStr(reinterpret_cast<const char*>(payload), 
-                                 std::min(payloadLength, size_t(100)));
-            
-            try {
-                std::regex pattern(config.expression);
-                return std::regex_search(payloadStr, pattern);
-            } catch (const std::regex_error&) {
-                return false;
+            switch (config.type) {
+                case FilterType::BPF:
+                    // The kernel moves the 802.1Q tag out of the frame before
+                    // socket filters run, so "vlan" would never match there
+                    if (config.expression.find("vlan") == std::string::npos) {
+                        clauses.push_back("(" + config.expression + ")");
+                    }
+                    break;
+                case FilterType::PROTOCOL:
+                    if (config.expression == "ip") {
+                        clauses.push_back("(ip and ip[9] != 0)");
+                    } else if (auto protocols = parseProtocols(config.expression)) {
+                        clauses.push_back("ip proto " + std::to_string(protocols->front()));
+                    }
+                    break;
+                case FilterType::IP_RANGE:
+                    // Prefix tables stay in user space
+                    if (entry->prefixTable) {
+                        break;
+                    }
+                    if (auto network = parseNetwork(config.expression)) {
+                        std::string address = config.expression.substr(0, config.expression.find('/'));
+                        clauses.push_back("net " + address + "/" + std::to_string(network->second));
+                    }
+                    break;
+                case FilterType::PORT_RANGE:
+                    if (auto ports = parsePortRange(config.expression)) {
+                        // Fixed offsets like applyPortRangeFilter(); headers with
+                        // options and later fragments are left to user space
+                        std::string low = std::to_string(ports->first);
+                        std::string high = std::to_string(ports->second);
+                        clauses.push_back("(ip and (ip[9] = 6 or ip[9] = 17) and "
+                                          "(ip[0] & 0xf != 5 or ip[6:2] & 0x1fff != 0 or "
+                                          "(ether[34:2] >= " + low + " and ether[34:2] <= " + high + ") or "
+                                          "(ether[36:2] >= " + low + " and ether[36:2] <= " + high + ")))");
+                    }
+                    break;
+                case FilterType::PAYLOAD:
+                case FilterType::CUSTOM:
+                    break;
             }
         }
     }
     
-    return false;
-}
-
-bool PacketFilter::applyCustomFilter(const Packet& packet, const FilterEntry& entry) {
-    if (entry.customFunc) {
-        return entry.customFunc(packet);
+    if (clauses.empty()) {
+        return BpfProgram();
     }
-    return true;
-}
-
-std::vector<uint8_t> PacketFilter::parseIPAddress(const std::string& ipStr) {
-    std::vector<uint8_t> result;
-    std::stringstream ss(ipStr);
-    std::string token;
     
-    while (std::getline(ss, token, '.')) {
-        result.push_back(static_cast<uint8_t>(std::stoi(token)));
+    std::string expression = clauses.front();
+    for (size_t i = 1; i < clauses.size(); ++i) {
+        expression += " and " + clauses[i];
     }
     
-    return result;
+    auto program = BpfProgram::compile(expression);
+    if (program.isError()) {
+        BEATRICE_WARN("Filters stay in user space: {}", program.getErrorMessage());
+        return BpfProgram();
+    }
+    return program.getValue();
 }
 
-bool PacketFilter::isIPInRange(const std::vector<uint8_t>& ip, const std::string& range) {
-    if (range.find('/') != std::string::npos) {
-        size_t pos = range.find('/');
-        std::string networkStr = range.substr(0, pos);
-        int prefixLen = std::stoi(range.substr(pos + 1));
-        
-        auto network = parseIPAddress(networkStr);
-        if (network.size() != 4) return false;
+XDPLoader::FilterRules PacketFilter::compileXdpRules(std::vector<std::string>* userSpaceOnly) const {
+    XDPLoader::FilterRules rules;
+    std::lock_guard<std::mutex> lock(filtersMutex_);
+    
+    for (const auto& [name, entry] : enabledFiltersLocked()) {
+        const FilterConfig& config = entry->config;
+        bool offloaded = false;
         
-        uint32_t networkAddr = (network[0] << 24) | (network[1] << 16) | (network[2] << 8) | network[3];
-        uint32_t ipAddr = (ip[0] << 24) | (ip[1] << 16) | (ip[2] << 8) | ip[3];
+        switch (config.type) {
+            case FilterType::PROTOCOL:
+                if (auto protocols = parseProtocols(config.expression)) {
+                    if (!rules.matchProtocols) {
+                        rules.matchProtocols = true;
+                        rules.protocols = *protocols;
+                    } else {
+                        // Every PROTOCOL filter has to pass
+                        std::vector<uint8_t> both;
+                        std::set_intersection(rules.protocols.begin(), rules.protocols.end(),
+                                              protocols->begin(), protocols->end(), std::back_inserter(both));
+                        rules.protocols = std::move(both);
+                    }
+                    offloaded = true;
+                }
+                break;
+            case FilterType::IP_RANGE:
+                if (entry->prefixTable) {
+                    break;
+                }
+                // Two ranges would need both to match, which one table cannot express
+                if (auto network = parseNetwork(config.expression); network && !rules.matchNetworks) {
+                    rules.matchNetworks = true;
+                    rules.networks.push_back(*network);
+                    offloaded = true;
+                }
+                break;
+            case FilterType::PORT_RANGE:
+                if (auto ports = parsePortRange(config.expression); ports && !rules.matchPorts) {
+                    rules.matchPorts = true;
+                    rules.portRanges.push_back(*ports);
+                    offloaded = true;
+                }
+                break;
+            case FilterType::BPF:
+            case FilterType::PAYLOAD:
+            case FilterType::CUSTOM:
+                break;
+        }
         
-        uint32_t mask = (0xFFFFFFFF << (32 - prefixLen)) & 0xFFFFFFFF;
-        return (networkAddr & mask) == (ipAddr & mask);
-    } else {
-        auto rangeIP = parseIPAddress(range);
-        return ip == rangeIP;
-    }
-}
-
-bool PacketFilter::isPortInRange(uint16_t port, const std::string& range) {
-    if (range.find('-') != std::string::npos) {
-        size_t pos = range.find('-');
-        uint16_t startPort = static_cast<uint16_t>(std::stoi(range.substr(0, pos)));
-        uint16_t endPort = static_cast<uint16_t>(std::stoi(range.substr(pos + 1)));
-        return port >= startPort && port <= endPort;
-    } else {
-        uint16_t targetPort = static_cast<uint16_t>(std::stoi(range));
-        return port == targetPort;
+        if (!offloaded && userSpaceOnly) {
+            userSpaceOnly->push_back(name);
+        }
     }
-}
-
-void PacketFilter::updateStats(const std::string& filterName, bool passed, std::chrono::microseconds time) {
-    std::lock_guard<std::mutex> lock(statsMutex_);
     
-    stats_.packetsProcessed++;
-    if (passed) {
-        stats_.packetsPassed++;
-    } else {
-        stats_.packetsDropped++;
-    }
-    stats_.totalProcessingTime += time;
-    stats_.filterCounts[filterName]++;
+    return rules;
 }
 
-} // namespace beatrice 
\ No newline at end of file
+} // namespace beatrice
@@ -0,0 +1,139 @@
+#include "beatrice/PacketPool.hpp"
+#include "beatrice/Logger.hpp"
+#include "beatrice/Metrics.hpp"
+#include <cstring>
+#include <sys/mman.h>
+
+namespace beatrice {
+
+namespace {
+constexpr size_t kCacheLineSize = 64;
+}
+
+std::shared_ptr<PacketPool> PacketPool::create(size_t bufferSize, size_t bufferCount,
+                                               const std::string& name) {
+    if (bufferSize == 0 || bufferCount == 0) {
+        return nullptr;
+    }
+
+    auto* pool = new PacketPool(bufferSize, bufferCount, name);
+    if (!pool->map()) {
+        delete pool;
+        return nullptr;
+    }
+
+    // The owner's shared_ptr only drops the owner reference; the pool frees
+    // itself once every buffer handed out has come back as well
+    return std::shared_ptr<PacketPool>(pool, [](PacketPool* p) { p->unref(); });
+}
+
+PacketPool::PacketPool(size_t bufferSize, size_t bufferCount, const std::string& name)
+    : bufferSize_(bufferSize)
+    , stride_((bufferSize + kCacheLineSize - 1) & ~(kCacheLineSize - 1))
+    , capacity_(bufferCount)
+    , name_(name) {
+    if (!name_.empty()) {
+        inUseGauge_ = metrics::gauge(name_ + "_buffers_in_use", "Packet pool buffers currently referenced");
+        exhaustedCounter_ = metrics::counter(name_ + "_exhausted_total", "Packet pool acquisitions that found no free buffer");
+    }
+}
+
+PacketPool::~PacketPool() {
+    if (area_) {
+        munmap(area_, areaSize_);
+    }
+}
+
+bool PacketPool::map() {
+    areaSize_ = stride_ * capacity_;
+
+    // Pages are only committed once a buffer is first written to
+    void* area = mmap(nullptr, areaSize_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (area == MAP_FAILED) {
+        BEATRICE_ERROR("Failed to map packet pool {} ({} bytes): {}", name_, areaSize_, strerror(errno));
+        return false;
+    }
+    area_ = area;
+
+    slots_ = std::make_unique<PacketBufferSlot[]>(capacity_);
+    uint8_t* base = static_cast<uint8_t*>(area_);
+    for (size_t i = capacity_; i > 0; --i) {
+        PacketBufferSlot& slot = slots_[i - 1];
+        slot.pool = this;
+        slot.data = base + (i - 1) * stride_;
+        slot.next = localFree_;
+        localFree_ = &slot;
+    }
+
+    BEATRICE_DEBUG("Packet pool {} created: {} buffers of {} bytes", name_, capacity_, bufferSize_);
+    return true;
+}
+
+PacketBuffer PacketPool::acquire() {
+    if (!localFree_) {
+        // Take everything consumers have returned in one go
+        localFree_ = remoteFree_.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    if (!localFree_) {
+        exhausted_.fetch_add(1, std::memory_order_relaxed);
+        if (exhaustedCounter_) {
+            exhaustedCounter_->increment();
+        }
+        return PacketBuffer();
+    }
+
+    PacketBufferSlot* slot = localFree_;
+    localFree_ = slot->next;
+    slot->next = nullptr;
+    slot->refs.store(1, std::memory_order_relaxed);
+
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    acquired_.fetch_add(1, std::memory_order_relaxed);
+    if (inUseGauge_) {
+        inUseGauge_->set(static_cast<double>(inUse()));
+    }
+
+    return PacketBuffer(slot);
+}
+
+size_t PacketPool::inUse() const noexcept {
+    // refs_ counts outstanding buffers plus one for the owner while it is alive
+    size_t refs = refs_.load(std::memory_order_relaxed);
+    return refs > 0 ? refs - 1 : 0;
+}
+
+PacketPool::Statistics PacketPool::getStatistics() const {
+    Statistics stats;
+    stats.capacity = capacity_;
+    stats.bufferSize = bufferSize_;
+    stats.inUse = inUse();
+    stats.acquired = acquired_.load(std::memory_order_relaxed);
+    stats.exhausted = exhausted_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void PacketPool::publishMetrics() {
+    if (inUseGauge_) {
+        inUseGauge_->set(static_cast<double>(inUse()));
+    }
+}
+
+void PacketPool::recycle(PacketBufferSlot* slot) noexcept {
+    PacketBufferSlot* head = remoteFree_.load(std::memory_order_relaxed);
+    do {
+        slot->next = head;
+    } while (!remoteFree_.compare_exchange_weak(head, slot,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+    unref();
+}
+
+void PacketPool::unref() noexcept {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+} // namespace beatrice
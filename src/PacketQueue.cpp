@@ -0,0 +1,149 @@
+#include "beatrice/PacketQueue.hpp"
+#include "beatrice/Metrics.hpp"
+#include <algorithm>
+
+namespace beatrice {
+
+namespace {
+
+// A blocked producer re-checks for close() at least this often
+constexpr std::chrono::milliseconds kBlockedWaitSlice(100);
+
+size_t queueDepth(const ICaptureBackend::Config& config) {
+    if (config.queueDepth > 0) {
+        return config.queueDepth;
+    }
+    return std::max({config.numBuffers, config.batchSize, static_cast<size_t>(1024)});
+}
+
+ICaptureBackend::OverflowPolicy resolvePolicy(const ICaptureBackend::Config& config,
+                                              ICaptureBackend::OverflowPolicy fallback) {
+    return config.queueOverflowPolicy == ICaptureBackend::OverflowPolicy::DEFAULT ? fallback
+                                                                                  : config.queueOverflowPolicy;
+}
+
+} // anonymous namespace
+
+PacketQueue::PacketQueue(const ICaptureBackend::Config& config, OverflowPolicy fallback, const std::string& name,
+                         RingSync consumers)
+    : ring_(queueDepth(config), RingSync::SINGLE,
+            resolvePolicy(config, fallback) == OverflowPolicy::DROP_OLDEST ? RingSync::MULTI : consumers)
+    , policy_(resolvePolicy(config, fallback)) {
+    if (!name.empty()) {
+        highWatermarkGauge_ = metrics::gauge(name + "_queue_high_watermark", "Most packets waiting in the backend queue at once");
+        droppedCounter_ = metrics::counter(name + "_queue_dropped_total", "Packets discarded because the backend queue was full");
+    }
+}
+
+size_t PacketQueue::push(Packet* packets, size_t count) {
+    size_t queued = ring_.enqueueBurst(packets, count);
+
+    if (queued < count) {
+        switch (policy_) {
+            case OverflowPolicy::BLOCK:
+                while (queued < count && !closed_.load(std::memory_order_relaxed)) {
+                    dataNotifier_.notify();
+                    spaceNotifier_.wait([this] { return !ring_.full() || closed_.load(std::memory_order_relaxed); },
+                                        kBlockedWaitSlice);
+                    queued += ring_.enqueueBurst(packets + queued, count - queued);
+                }
+                break;
+            case OverflowPolicy::DROP_OLDEST:
+                // Evict as many of the oldest packets as the rest of the batch needs;
+                // consumers may race us, in which case there is simply room already
+                while (queued < count) {
+                    ring_.dequeueBurst(evicted_, count - queued);
+                    countDrops(evicted_.data(), evicted_.size());
+                    evicted_.clear();
+                    queued += ring_.enqueueBurst(packets + queued, count - queued);
+                }
+                break;
+            case OverflowPolicy::DROP_NEWEST:
+            case OverflowPolicy::DEFAULT:
+                countDrops(packets + queued, count - queued);
+                break;
+        }
+    }
+
+    if (queued > 0) {
+        updateHighWatermark();
+        dataNotifier_.notify();
+    }
+    return queued;
+}
+
+size_t PacketQueue::pop(std::vector<Packet>& out, size_t maxPackets, std::chrono::milliseconds timeout) {
+    const bool ready = dataNotifier_.wait([this] {
+        return !ring_.empty() || closed_.load(std::memory_order_relaxed) || finished_.load(std::memory_order_relaxed);
+    }, timeout);
+    if (!ready) {
+        return 0;
+    }
+
+    const size_t taken = ring_.dequeueBurst(out, maxPackets);
+    if (taken > 0 && policy_ == OverflowPolicy::BLOCK) {
+        spaceNotifier_.notify();
+    }
+    return taken;
+}
+
+void PacketQueue::open() {
+    finished_ = false;
+    closed_ = false;
+}
+
+void PacketQueue::finish() {
+    finished_ = true;
+    dataNotifier_.wakeAll();
+}
+
+void PacketQueue::close() {
+    closed_ = true;
+    dataNotifier_.wakeAll();
+    spaceNotifier_.wakeAll();
+}
+
+PacketQueue::Statistics PacketQueue::getStatistics() const {
+    Statistics stats;
+    stats.capacity = ring_.capacity();
+    stats.depth = ring_.size();
+    stats.highWatermark = highWatermark_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.bytesDropped = bytesDropped_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void PacketQueue::resetStatistics() {
+    dropped_.store(0, std::memory_order_relaxed);
+    bytesDropped_.store(0, std::memory_order_relaxed);
+    highWatermark_.store(ring_.size(), std::memory_order_relaxed);
+}
+
+void PacketQueue::countDrops(const Packet* packets, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        bytes += packets[i].length();
+    }
+    dropped_.fetch_add(count, std::memory_order_relaxed);
+    bytesDropped_.fetch_add(bytes, std::memory_order_relaxed);
+    if (droppedCounter_) {
+        droppedCounter_->increment(static_cast<double>(count));
+    }
+}
+
+void PacketQueue::updateHighWatermark() {
+    // Only the capture thread raises the mark, so a plain compare is enough
+    const size_t depth = ring_.size();
+    if (depth > highWatermark_.load(std::memory_order_relaxed)) {
+        highWatermark_.store(depth, std::memory_order_relaxed);
+        if (highWatermarkGauge_) {
+            highWatermarkGauge_->set(static_cast<double>(depth));
+        }
+    }
+}
+
+} // namespace beatrice
@@ -0,0 +1,351 @@
+#include "beatrice/PatternMatcher.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace beatrice {
+
+namespace {
+
+using NibbleMasks = std::array<std::array<uint8_t, 16>, 3>;
+
+// Prefilter hit rate, on random bytes, above which scanning byte by byte is cheaper
+constexpr double kMaxCandidateRate = 0.25;
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+Result<std::vector<PatternMatcher::Pattern>> parseRuleLines(std::istream& input, const std::string& source) {
+    using PatternsResult = Result<std::vector<PatternMatcher::Pattern>>;
+
+    std::vector<PatternMatcher::Pattern> patterns;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(input, line); ++lineNumber) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+
+        auto where = [&] { return source + ":" + std::to_string(lineNumber) + ": "; };
+        size_t idEnd = line.find_first_not_of("0123456789", start);
+        if (idEnd == start || idEnd == std::string::npos || (line[idEnd] != ' ' && line[idEnd] != '\t') ||
+            idEnd - start > 10 || std::stoull(line.substr(start, idEnd - start)) > UINT32_MAX) {
+            return PatternsResult::error(ErrorCode::INVALID_ARGUMENT, where() + "expected \"ID PATTERN\"");
+        }
+
+        size_t patternStart = line.find_first_not_of(" \t", idEnd);
+        if (patternStart == std::string::npos) {
+            return PatternsResult::error(ErrorCode::INVALID_ARGUMENT, where() + "missing pattern");
+        }
+        auto bytes = PatternMatcher::parsePattern(line.substr(patternStart));
+        if (bytes.isError()) {
+            return PatternsResult::error(ErrorCode::INVALID_ARGUMENT, where() + bytes.getErrorMessage());
+        }
+
+        PatternMatcher::Pattern pattern;
+        pattern.id = static_cast<uint32_t>(std::stoul(line.substr(start, idEnd - start)));
+        pattern.bytes = bytes.getValue();
+        patterns.push_back(std::move(pattern));
+    }
+
+    return PatternsResult::success(std::move(patterns));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// First position in [position, end of the last whole 16 byte block) whose
+// first width bytes fit the masks of some bucket
+__attribute__((target("ssse3")))
+size_t teddyNext(const NibbleMasks& low, const NibbleMasks& high, size_t width,
+                 const uint8_t* data, size_t position, size_t length) noexcept {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i lowMasks[3];
+    __m128i highMasks[3];
+    for (size_t j = 0; j < width; ++j) {
+        lowMasks[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low[j].data()));
+        highMasks[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high[j].data()));
+    }
+
+    while (position + 16 + width - 1 <= length) {
+        __m128i buckets = _mm_set1_epi8(-1);
+        for (size_t j = 0; j < width; ++j) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + j));
+            __m128i lowNibbles = _mm_and_si128(bytes, nibble);
+            __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+            buckets = _mm_and_si128(buckets, _mm_and_si128(_mm_shuffle_epi8(lowMasks[j], lowNibbles),
+                                                           _mm_shuffle_epi8(highMasks[j], highNibbles)));
+        }
+
+        unsigned candidates = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(buckets, zero))) ^ 0xFFFFu;
+        if (candidates != 0) {
+            return position + static_cast<size_t>(__builtin_ctz(candidates));
+        }
+        position += 16;
+    }
+    return position;
+}
+#endif
+
+} // anonymous namespace
+
+PatternMatcher::PatternMatcher() = default;
+
+Result<PatternMatcher> PatternMatcher::compile(const std::vector<Pattern>& patterns) {
+    PatternMatcher matcher;
+    if (patterns.empty()) {
+        return Result<PatternMatcher>::success(std::move(matcher));
+    }
+
+    // Bytes no pattern uses share class 0
+    std::array<bool, 256> used{};
+    for (const Pattern& pattern : patterns) {
+        if (pattern.bytes.empty()) {
+            return Result<PatternMatcher>::error(ErrorCode::INVALID_ARGUMENT,
+                "Empty pattern for id " + std::to_string(pattern.id));
+        }
+        for (unsigned char byte : pattern.bytes) {
+            used[byte] = true;
+        }
+        matcher.firstBytes_[static_cast<unsigned char>(pattern.bytes[0])] = true;
+    }
+    bool allUsed = std::all_of(used.begin(), used.end(), [](bool value) { return value; });
+    uint32_t classCount = allUsed ? 0 : 1;
+    for (size_t byte = 0; byte < used.size(); ++byte) {
+        if (used[byte]) {
+            matcher.classes_[byte] = static_cast<uint8_t>(classCount++);
+        }
+    }
+    matcher.classCount_ = classCount;
+
+    // Trie, goto function in rows of classCount entries, -1 for no edge
+    std::vector<int32_t> edges(classCount, -1);
+    std::vector<std::vector<uint32_t>> own(1);
+    for (const Pattern& pattern : patterns) {
+        uint32_t state = 0;
+        for (unsigned char byte : pattern.bytes) {
+            int32_t& edge = edges[state * classCount + matcher.classes_[byte]];
+            if (edge < 0) {
+                if (edges.size() + classCount > kMaxTransitions) {
+                    return Result<PatternMatcher>::error(ErrorCode::RESOURCE_UNAVAILABLE,
+                        "Pattern set needs more than " + std::to_string(kMaxTransitions) + " transitions");
+                }
+                edge = static_cast<int32_t>(own.size());
+                own.emplace_back();
+                edges.resize(edges.size() + classCount, -1);
+            }
+            state = static_cast<uint32_t>(edges[state * classCount + matcher.classes_[byte]]);
+        }
+        own[state].push_back(pattern.id);
+
+        std::string prefix = pattern.bytes.substr(0, kTeddyWidth);
+        matcher.prefixes_.push_back(prefix);
+    }
+
+    // Breadth first, so failure states are complete before they are used
+    const size_t stateCount = own.size();
+    std::vector<uint32_t> failure(stateCount, 0);
+    std::vector<uint32_t> order;
+    order.reserve(stateCount);
+    order.push_back(0);
+    for (size_t next = 0; next < order.size(); ++next) {
+        uint32_t state = order[next];
+        for (uint32_t c = 0; c < classCount; ++c) {
+            int32_t& edge = edges[state * classCount + c];
+            uint32_t fallback = state == 0 ? 0 : static_cast<uint32_t>(edges[failure[state] * classCount + c]);
+            if (edge >= 0) {
+                failure[edge] = fallback;
+                order.push_back(static_cast<uint32_t>(edge));
+            } else {
+                edge = static_cast<int32_t>(fallback);
+            }
+        }
+    }
+
+    // Every pattern ending at a state, including those of its failure chain
+    std::vector<std::vector<uint32_t>> outputs(stateCount);
+    for (uint32_t state : order) {
+        outputs[state] = own[state];
+        if (state != 0) {
+            const auto& inherited = outputs[failure[state]];
+            outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+        }
+    }
+    matcher.outputOffsets_.reserve(stateCount + 1);
+    matcher.outputOffsets_.push_back(0);
+    for (const auto& ids : outputs) {
+        matcher.outputs_.insert(matcher.outputs_.end(), ids.begin(), ids.end());
+        matcher.outputOffsets_.push_back(static_cast<uint32_t>(matcher.outputs_.size()));
+    }
+
+    matcher.transitions_.resize(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        uint32_t target = static_cast<uint32_t>(edges[i]);
+        matcher.transitions_[i] = target * classCount | (outputs[target].empty() ? 0 : kOutputFlag);
+    }
+    matcher.patternCount_ = patterns.size();
+
+    return Result<PatternMatcher>::success(std::move(matcher));
+}
+
+Result<std::string> PatternMatcher::parsePattern(const std::string& text) {
+    std::string bytes;
+    bool hex = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (hex) {
+            if (c == '|') {
+                hex = false;
+            } else if (c != ' ') {
+                int high = hexValue(c);
+                int low = i + 1 < text.size() ? hexValue(text[i + 1]) : -1;
+                if (high < 0 || low < 0) {
+                    return Result<std::string>::error(ErrorCode::INVALID_ARGUMENT, "Bad hex byte in pattern: " + text);
+                }
+                bytes.push_back(static_cast<char>(high << 4 | low));
+                ++i;
+            }
+        } else if (c == '|') {
+            hex = true;
+        } else if (c == '\\') {
+            if (++i == text.size()) {
+                return Result<std::string>::error(ErrorCode::INVALID_ARGUMENT, "Dangling escape in pattern: " + text);
+            }
+            bytes.push_back(text[i]);
+        } else {
+            bytes.push_back(c);
+        }
+    }
+
+    if (hex) {
+        return Result<std::string>::error(ErrorCode::INVALID_ARGUMENT, "Unterminated hex block in pattern: " + text);
+    }
+    if (bytes.empty()) {
+        return Result<std::string>::error(ErrorCode::INVALID_ARGUMENT, "Empty pattern");
+    }
+    return Result<std::string>::success(std::move(bytes));
+}
+
+Result<PatternMatcher> PatternMatcher::parseRules(const std::string& rules) {
+    std::istringstream input(rules);
+    auto patterns = parseRuleLines(input, "rules");
+    if (patterns.isError()) {
+        return Result<PatternMatcher>::error(patterns.getErrorCode(), patterns.getErrorMessage());
+    }
+    return compile(patterns.getValue());
+}
+
+Result<PatternMatcher> PatternMatcher::loadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return Result<PatternMatcher>::error(ErrorCode::RESOURCE_UNAVAILABLE, "Failed to open pattern file: " + path);
+    }
+
+    auto patterns = parseRuleLines(file, path);
+    if (patterns.isError()) {
+        return Result<PatternMatcher>::error(patterns.getErrorCode(), patterns.getErrorMessage());
+    }
+    if (file.bad()) {
+        return Result<PatternMatcher>::error(ErrorCode::RESOURCE_UNAVAILABLE, "Failed to read pattern file: " + path);
+    }
+    return compile(patterns.getValue());
+}
+
+bool PatternMatcher::enablePrefilter() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (prefixes_.empty() || !__builtin_cpu_supports("ssse3")) {
+        return false;
+    }
+
+    // Similar prefixes share a bucket, which keeps the masks selective
+    std::vector<std::string> prefixes = prefixes_;
+    size_t width = kTeddyWidth;
+    for (const auto& prefix : prefixes) {
+        width = std::min(width, prefix.size());
+    }
+    for (auto& prefix : prefixes) {
+        prefix.resize(width);
+    }
+    std::sort(prefixes.begin(), prefixes.end());
+    prefixes.erase(std::unique(prefixes.begin(), prefixes.end()), prefixes.end());
+
+    Teddy teddy;
+    teddy.width = width;
+    size_t perBucket = (prefixes.size() + kTeddyBuckets - 1) / kTeddyBuckets;
+    for (size_t i = 0; i < prefixes.size(); ++i) {
+        uint8_t bucket = static_cast<uint8_t>(1u << (i / perBucket));
+        for (size_t j = 0; j < width; ++j) {
+            unsigned char byte = static_cast<unsigned char>(prefixes[i][j]);
+            teddy.low[j][byte & 0x0F] |= bucket;
+            teddy.high[j][byte >> 4] |= bucket;
+        }
+    }
+
+    // Share of random positions each bucket would let through
+    double candidateRate = 0.0;
+    for (size_t b = 0; b < kTeddyBuckets; ++b) {
+        double bucketRate = 1.0;
+        for (size_t j = 0; j < width; ++j) {
+            size_t accepted = 0;
+            for (unsigned byte = 0; byte < 256; ++byte) {
+                if (teddy.low[j][byte & 0x0F] & teddy.high[j][byte >> 4] & (1u << b)) {
+                    ++accepted;
+                }
+            }
+            bucketRate *= static_cast<double>(accepted) / 256.0;
+        }
+        candidateRate += bucketRate;
+    }
+    if (candidateRate > kMaxCandidateRate) {
+        return false;
+    }
+
+    teddy_ = teddy;
+    prefiltered_ = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t PatternMatcher::nextCandidate(const uint8_t* data, size_t position, size_t length) const noexcept {
+    while (position < length) {
+#if defined(__x86_64__) || defined(__i386__)
+        if (prefiltered_ && position + 16 + teddy_.width - 1 <= length) {
+            position = teddyNext(teddy_.low, teddy_.high, teddy_.width, data, position, length);
+            if (position + 16 + teddy_.width - 1 > length) {
+                continue;
+            }
+        }
+#endif
+        // The nibble masks over-approximate, confirm the first byte
+        if (firstBytes_[data[position]]) {
+            return position;
+        }
+        ++position;
+    }
+    return length;
+}
+
+size_t PatternMatcher::memoryUsage() const noexcept {
+    size_t bytes = sizeof(*this);
+    bytes += transitions_.capacity() * sizeof(uint32_t);
+    bytes += outputOffsets_.capacity() * sizeof(uint32_t);
+    bytes += outputs_.capacity() * sizeof(uint32_t);
+    for (const auto& prefix : prefixes_) {
+        bytes += prefix.capacity();
+    }
+    return bytes;
+}
+
+} // namespace beatrice
@@ -0,0 +1,724 @@
+#include "beatrice/PcapFileBackend.hpp"
+#include "beatrice/Logger.hpp"
+#include "beatrice/Error.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace beatrice {
+
+namespace {
+
+// pcap global header magics as read in host byte order
+constexpr uint32_t kPcapMagicMicro = 0xa1b2c3d4;
+constexpr uint32_t kPcapMagicMicroSwapped = 0xd4c3b2a1;
+constexpr uint32_t kPcapMagicNano = 0xa1b23c4d;
+constexpr uint32_t kPcapMagicNanoSwapped = 0x4d3cb2a1;
+constexpr size_t kPcapHeaderSize = 24;
+constexpr size_t kPcapRecordHeaderSize = 16;
+
+// pcapng block types
+constexpr uint32_t kSectionHeaderBlock = 0x0a0d0d0a;
+constexpr uint32_t kInterfaceDescriptionBlock = 0x00000001;
+constexpr uint32_t kObsoletePacketBlock = 0x00000002;
+constexpr uint32_t kSimplePacketBlock = 0x00000003;
+constexpr uint32_t kEnhancedPacketBlock = 0x00000006;
+constexpr uint32_t kByteOrderMagic = 0x1a2b3c4d;
+constexpr uint32_t kByteOrderMagicSwapped = 0x4d3c2b1a;
+constexpr uint16_t kOptionEnd = 0;
+constexpr uint16_t kOptionTsResol = 9;
+
+constexpr uint32_t kLinkTypeEthernet = 1;
+
+// Long pacing gaps are slept in slices so stop() is not held up
+constexpr auto kMaxPacingSleep = std::chrono::milliseconds(100);
+
+uint64_t ticksToNanoseconds(uint64_t ticks, uint64_t ticksPerSecond) {
+    if (ticksPerSecond == 1000000000ULL) {
+        return ticks;
+    }
+    return (ticks / ticksPerSecond) * 1000000000ULL + (ticks % ticksPerSecond) * 1000000000ULL / ticksPerSecond;
+}
+
+} // anonymous namespace
+
+/**
+ * @brief Read-only mapping of the capture file
+ */
+struct PcapFileBackend::MappedFile {
+    const uint8_t* data{nullptr};
+    size_t size{0};
+
+    ~MappedFile() {
+        if (data) {
+            munmap(const_cast<uint8_t*>(data), size);
+        }
+    }
+};
+
+/**
+ * @brief Sequential record parser over a mapped pcap or pcapng file
+ *
+ * Only the owning reader thread touches it; records point into the mapping.
+ */
+class PcapFileBackend::Reader {
+public:
+    struct Record {
+        const uint8_t* data = nullptr;
+        uint32_t length = 0;
+        uint64_t timestampNs = 0;
+    };
+
+    Reader(const uint8_t* base, size_t size) : base_(base), size_(size) {}
+
+    bool open(std::string& error) {
+        if (size_ < 12) {
+            error = "File too short for a capture header";
+            return false;
+        }
+
+        uint32_t magic;
+        std::memcpy(&magic, base_, sizeof(magic));
+        if (magic == kSectionHeaderBlock) {
+            pcapng_ = true;
+            dataStart_ = 0;
+            offset_ = 0;
+            // Parse the first section so the link type is known up front
+            Record record;
+            if (!nextPcapng(record, true)) {
+                error = "Invalid pcapng section header";
+                return false;
+            }
+            dataStart_ = 0;
+            return true;
+        }
+
+        if (size_ < kPcapHeaderSize) {
+            error = "File too short for a pcap header";
+            return false;
+        }
+        switch (magic) {
+            case kPcapMagicMicro:        swap_ = false; ticksPerSecond_ = 1000000; break;
+            case kPcapMagicMicroSwapped: swap_ = true;  ticksPerSecond_ = 1000000; break;
+            case kPcapMagicNano:         swap_ = false; ticksPerSecond_ = 1000000000; break;
+            case kPcapMagicNanoSwapped:  swap_ = true;  ticksPerSecond_ = 1000000000; break;
+            default:
+                error = "Not a pcap or pcapng file";
+                return false;
+        }
+        // The upper bits carry the FCS length
+        linkType_ = read32(20) & 0x0fffffff;
+        dataStart_ = kPcapHeaderSize;
+        offset_ = dataStart_;
+        return true;
+    }
+
+    bool next(Record& record) {
+        return pcapng_ ? nextPcapng(record, false) : nextPcap(record);
+    }
+
+    void rewind() {
+        offset_ = dataStart_;
+        truncated_ = false;
+    }
+
+    bool truncated() const { return truncated_; }
+    bool isPcapng() const { return pcapng_; }
+    uint32_t linkType() const { return linkType_; }
+
+private:
+    struct Interface {
+        uint32_t linkType = 0;
+        uint64_t ticksPerSecond = 1000000;
+    };
+
+    uint16_t read16(size_t offset) const {
+        uint16_t value;
+        std::memcpy(&value, base_ + offset, sizeof(value));
+        return swap_ ? __builtin_bswap16(value) : value;
+    }
+
+    uint32_t read32(size_t offset) const {
+        uint32_t value;
+        std::memcpy(&value, base_ + offset, sizeof(value));
+        return swap_ ? __builtin_bswap32(value) : value;
+    }
+
+    bool nextPcap(Record& record) {
+        if (offset_ == size_) {
+            return false;
+        }
+        if (size_ - offset_ < kPcapRecordHeaderSize) {
+            truncated_ = true;
+            return false;
+        }
+
+        const uint64_t seconds = read32(offset_);
+        const uint64_t fraction = read32(offset_ + 4);
+        const uint32_t length = read32(offset_ + 8);
+        if (length > size_ - offset_ - kPcapRecordHeaderSize) {
+            truncated_ = true;
+            return false;
+        }
+
+        record.data = base_ + offset_ + kPcapRecordHeaderSize;
+        record.length = length;
+        record.timestampNs = seconds * 1000000000ULL + ticksToNanoseconds(fraction, ticksPerSecond_);
+        offset_ += kPcapRecordHeaderSize + length;
+        return true;
+    }
+
+    bool nextPcapng(Record& record, bool headerOnly) {
+        while (offset_ + 12 <= size_) {
+            uint32_t type;
+            std::memcpy(&type, base_ + offset_, sizeof(type));
+
+            // Every section fixes its own byte order and interface list
+            if (type == kSectionHeaderBlock) {
+                uint32_t magic;
+                std::memcpy(&magic, base_ + offset_ + 8, sizeof(magic));
+                if (magic == kByteOrderMagic) {
+                    swap_ = false;
+                } else if (magic == kByteOrderMagicSwapped) {
+                    swap_ = true;
+                } else {
+                    truncated_ = true;
+                    return false;
+                }
+                interfaces_.clear();
+            } else {
+                type = read32(offset_);
+            }
+
+            const uint32_t blockLength = read32(offset_ + 4);
+            if (blockLength < 12 || blockLength % 4 != 0 || blockLength > size_ - offset_) {
+                truncated_ = true;
+                return false;
+            }
+            const size_t block = offset_;
+            offset_ += blockLength;
+
+            switch (type) {
+                case kSectionHeaderBlock:
+                    if (headerOnly) {
+                        // Keep going until the first interface is known
+                        continue;
+                    }
+                    break;
+                case kInterfaceDescriptionBlock:
+                    if (blockLength >= 20) {
+                        parseInterface(block, blockLength);
+                        if (headerOnly) {
+                            offset_ = block;
+                            return true;
+                        }
+                    }
+                    break;
+                case kEnhancedPacketBlock:
+                case kObsoletePacketBlock:
+                    if (headerOnly) {
+                        offset_ = block;
+                        return true;
+                    }
+                    if (blockLength >= 32 && readPacketBlock(block, blockLength, type, record)) {
+                        return true;
+                    }
+                    break;
+                case kSimplePacketBlock:
+                    if (headerOnly) {
+                        offset_ = block;
+                        return true;
+                    }
+                    if (blockLength >= 16) {
+                        // No timestamp; the packet inherits the previous one
+                        const uint32_t original = read32(block + 8);
+                        record.data = base_ + block + 12;
+                        record.length = std::min<uint32_t>(original, blockLength - 16);
+                        record.timestampNs = lastTimestampNs_;
+                        return true;
+                    }
+                    break;
+                default:
+                    // Name resolution, statistics, custom blocks
+                    break;
+            }
+        }
+
+        if (offset_ != size_) {
+            truncated_ = true;
+        }
+        return headerOnly && offset_ == size_ && !truncated_;
+    }
+
+    void parseInterface(size_t block, uint32_t blockLength) {
+        Interface interface;
+        interface.linkType = read16(block + 8);
+
+        size_t option = block + 16;
+        const size_t end = block + blockLength - 4;
+        while (option + 4 <= end) {
+            const uint16_t code = read16(option);
+            const uint16_t length = read16(option + 2);
+            if (code == kOptionEnd || option + 4 + length > end) {
+                break;
+            }
+            if (code == kOptionTsResol && length >= 1) {
+                // MSB clear: negative power of 10, set: negative power of 2
+                const uint8_t resolution = base_[option + 4];
+                const uint8_t exponent = resolution & 0x7f;
+                uint64_t ticks = 1;
+                if (resolution & 0x80) {
+                    ticks = exponent < 64 ? (1ULL << exponent) : 1;
+                } else {
+                    for (uint8_t i = 0; i < exponent && i < 19; ++i) {
+                        ticks *= 10;
+                    }
+                }
+                interface.ticksPerSecond = ticks;
+            }
+            option += 4 + ((length + 3) & ~3u);
+        }
+
+        if (interfaces_.empty() && linkType_ == 0) {
+            linkType_ = interface.linkType;
+        }
+        interfaces_.push_back(interface);
+    }
+
+    bool readPacketBlock(size_t block, uint32_t blockLength, uint32_t type, Record& record) {
+        const uint32_t interfaceId = type == kEnhancedPacketBlock ? read32(block + 8) : read16(block + 8);
+        const uint64_t high = read32(block + 12);
+        const uint64_t low = read32(block + 16);
+        const uint32_t captured = read32(block + 20);
+        if (captured > blockLength - 32) {
+            truncated_ = true;
+            return false;
+        }
+
+        const uint64_t ticksPerSecond =
+            interfaceId < interfaces_.size() ? interfaces_[interfaceId].ticksPerSecond : 1000000;
+        record.data = base_ + block + 28;
+        record.length = captured;
+        record.timestampNs = ticksToNanoseconds((high << 32) | low, ticksPerSecond);
+        lastTimestampNs_ = record.timestampNs;
+        return true;
+    }
+
+    const uint8_t* base_;
+    size_t size_;
+    size_t offset_{0};
+    size_t dataStart_{0};
+    bool pcapng_{false};
+    bool swap_{false};
+    bool truncated_{false};
+    uint32_t linkType_{0};
+    uint64_t ticksPerSecond_{1000000};
+    uint64_t lastTimestampNs_{0};
+    std::vector<Interface> interfaces_;
+};
+
+PcapFileBackend::PcapFileBackend()
+    : running_(false)
+    , readerDone_(false)
+    , initialized_(false)
+    , zeroCopyEnabled_(true)
+    , config_()
+    , file_()
+    , reader_()
+    , readerThread_()
+    , packetQueue_()
+    , packetCallback_(nullptr)
+    , stats_()
+    , lastError_() {
+}
+
+PcapFileBackend::~PcapFileBackend() {
+    stop();
+}
+
+Result<void> PcapFileBackend::initialize(const Config& config) {
+    if (initialized_) {
+        return Result<void>::success();
+    }
+
+    config_ = config;
+    const std::string& path = config_.captureFile.empty() ? config_.interface : config_.captureFile;
+    if (path.empty()) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "No capture file given");
+    }
+    if (config_.replaySpeed < 0.0) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Replay speed must not be negative");
+    }
+
+    if (!mapFile(path)) {
+        return Result<void>::error(ErrorCode::RESOURCE_UNAVAILABLE, getLastError());
+    }
+
+    reader_ = std::make_unique<Reader>(file_->data, file_->size);
+    std::string error;
+    if (!reader_->open(error)) {
+        setLastError(path + ": " + error);
+        reader_.reset();
+        file_.reset();
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, getLastError());
+    }
+
+    if (reader_->linkType() != kLinkTypeEthernet) {
+        BEATRICE_WARN("{} has link type {}, packets are delivered as recorded", path, reader_->linkType());
+    }
+
+    // Files are replayed losslessly unless configured otherwise
+    packetQueue_ = std::make_unique<PacketQueue>(config_, OverflowPolicy::BLOCK, "pcap");
+    initialized_ = true;
+    BEATRICE_INFO("Opened {} capture {} ({} bytes)", getFileFormat(), path, file_->size);
+    return Result<void>::success();
+}
+
+Result<void> PcapFileBackend::start() {
+    if (!initialized_) {
+        return Result<void>::error(ErrorCode::INITIALIZATION_FAILED, "Pcap file backend not initialized");
+    }
+
+    if (running_) {
+        return Result<void>::success();
+    }
+
+    running_ = true;
+    readerDone_ = false;
+    packetQueue_->open();
+    readerThread_ = std::thread(&PcapFileBackend::replayLoop, this);
+    return Result<void>::success();
+}
+
+Result<void> PcapFileBackend::stop() {
+    if (!running_) {
+        return Result<void>::success();
+    }
+
+    running_ = false;
+    packetQueue_->close();
+
+    if (readerThread_.joinable()) {
+        readerThread_.join();
+    }
+    return Result<void>::success();
+}
+
+bool PcapFileBackend::isRunning() const noexcept {
+    return running_;
+}
+
+bool PcapFileBackend::isFinished() const {
+    return readerDone_ && (!packetQueue_ || packetQueue_->empty());
+}
+
+std::optional<Packet> PcapFileBackend::nextPacket(std::chrono::milliseconds timeout) {
+    auto packets = getPackets(1, timeout);
+    if (packets.empty()) {
+        return std::nullopt;
+    }
+    return std::move(packets.front());
+}
+
+std::vector<Packet> PcapFileBackend::getPackets(size_t maxPackets, std::chrono::milliseconds timeout) {
+    std::vector<Packet> packets;
+    if (!packetQueue_) {
+        return packets;
+    }
+
+    packetQueue_->pop(packets, maxPackets, timeout);
+    return packets;
+}
+
+void PcapFileBackend::setPacketCallback(std::function<void(Packet)> callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    packetCallback_ = callback;
+}
+
+void PcapFileBackend::removePacketCallback() {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    packetCallback_ = nullptr;
+}
+
+PcapFileBackend::Statistics PcapFileBackend::getStatistics() const {
+    Statistics stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = stats_;
+    }
+    if (packetQueue_) {
+        const auto queueStats = packetQueue_->getStatistics();
+        stats.packetsDropped += queueStats.dropped;
+        stats.bytesDropped += queueStats.bytesDropped;
+        stats.queueHighWatermark = queueStats.highWatermark;
+    }
+    return stats;
+}
+
+void PcapFileBackend::resetStatistics() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_ = Statistics{};
+    if (packetQueue_) {
+        packetQueue_->resetStatistics();
+    }
+}
+
+std::string PcapFileBackend::getName() const {
+    return "Pcap File";
+}
+
+std::string PcapFileBackend::getVersion() const {
+    return "1.0.0";
+}
+
+std::vector<std::string> PcapFileBackend::getSupportedFeatures() const {
+    return {
+        "zero_copy",
+        "offline",
+        "pcap",
+        "pcapng",
+        "timestamp_replay",
+        "batch_processing",
+        "run_to_completion"
+    };
+}
+
+bool PcapFileBackend::isFeatureSupported(const std::string& feature) const {
+    auto features = getSupportedFeatures();
+    return std::find(features.begin(), features.end(), feature) != features.end();
+}
+
+PcapFileBackend::Config PcapFileBackend::getConfig() const {
+    return config_;
+}
+
+Result<void> PcapFileBackend::updateConfig(const Config& config) {
+    if (running_) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Cannot update config while running");
+    }
+
+    config_ = config;
+    return Result<void>::success();
+}
+
+std::string PcapFileBackend::getLastError() const {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    return lastError_;
+}
+
+bool PcapFileBackend::isHealthy() const {
+    return initialized_ && file_ && reader_ && !reader_->truncated();
+}
+
+Result<void> PcapFileBackend::healthCheck() {
+    if (!initialized_) {
+        return Result<void>::error(ErrorCode::INITIALIZATION_FAILED, "Backend not initialized");
+    }
+
+    if (!isHealthy()) {
+        return Result<void>::error(ErrorCode::BACKEND_ERROR, "Capture file is truncated or malformed");
+    }
+
+    return Result<void>::success();
+}
+
+std::string PcapFileBackend::getFileFormat() const {
+    if (!reader_) {
+        return "";
+    }
+    return reader_->isPcapng() ? "pcapng" : "pcap";
+}
+
+uint32_t PcapFileBackend::getLinkType() const {
+    return reader_ ? reader_->linkType() : 0;
+}
+
+bool PcapFileBackend::mapFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        setLastError("Failed to open " + path + ": " + strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        setLastError("Failed to stat " + path + " or file is empty");
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        setLastError("Failed to map " + path + ": " + strerror(errno));
+        return false;
+    }
+
+    // Records are read front to back; let the kernel read ahead aggressively
+    madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL | MADV_WILLNEED);
+
+    file_ = std::make_shared<MappedFile>();
+    file_->data = static_cast<const uint8_t*>(data);
+    file_->size = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void PcapFileBackend::replayLoop() {
+    const double speed = config_.replaySpeed;
+    const size_t batchSize = std::max<size_t>(config_.batchSize, 1);
+    std::vector<Packet> batch;
+    batch.reserve(batchSize);
+
+    for (size_t loop = 0; running_ && (config_.replayLoops == 0 || loop < config_.replayLoops); ++loop) {
+        reader_->rewind();
+        const auto loopStart = std::chrono::steady_clock::now();
+        bool haveFirst = false;
+        uint64_t firstTimestampNs = 0;
+        Reader::Record record;
+
+        while (running_ && reader_->next(record)) {
+            if (!haveFirst) {
+                firstTimestampNs = record.timestampNs;
+                haveFirst = true;
+            }
+
+            // Out-of-order records (merged captures) are never scheduled in the past
+            const uint64_t offsetNs = record.timestampNs > firstTimestampNs ? record.timestampNs - firstTimestampNs : 0;
+            const auto scaled = speed > 0.0 ? static_cast<uint64_t>(static_cast<double>(offsetNs) / speed) : offsetNs;
+            const auto due = loopStart + std::chrono::nanoseconds(scaled);
+
+            if (speed > 0.0 && due > std::chrono::steady_clock::now()) {
+                // Hand over what is ready before waiting for the next packet's slot
+                deliver(batch);
+                while (running_ && std::chrono::steady_clock::now() < due) {
+                    std::this_thread::sleep_until(std::min(due, std::chrono::steady_clock::now() + kMaxPacingSleep));
+                }
+            }
+
+            batch.push_back(makePacket(record.data, record.length, due));
+            if (batch.size() >= batchSize) {
+                deliver(batch);
+            }
+        }
+        deliver(batch);
+
+        if (reader_->truncated()) {
+            BEATRICE_WARN("Capture file is truncated or malformed, stopped at the last complete record");
+            break;
+        }
+    }
+
+    readerDone_ = true;
+    packetQueue_->finish();
+    BEATRICE_INFO("Capture file replay finished");
+}
+
+Packet PcapFileBackend::makePacket(const uint8_t* data, size_t length,
+                                   std::chrono::steady_clock::time_point timestamp) {
+    if (zeroCopyEnabled_ && config_.enableZeroCopy) {
+        // The packet keeps the mapping alive; there is nothing to give back
+        return Packet(data, length, [file = file_](const uint8_t*) {}, timestamp);
+    }
+
+    auto copy = std::make_shared<uint8_t[]>(length);
+    std::memcpy(copy.get(), data, length);
+    return Packet(copy, length, timestamp);
+}
+
+void PcapFileBackend::deliver(std::vector<Packet>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    uint64_t bytes = 0;
+    for (const auto& packet : batch) {
+        bytes += packet.length();
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsCaptured += batch.size();
+        stats_.bytesCaptured += bytes;
+        stats_.lastUpdate = std::chrono::steady_clock::now();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        if (packetCallback_) {
+            for (const auto& packet : batch) {
+                try {
+                    packetCallback_(packet);
+                } catch (const std::exception& e) {
+                    BEATRICE_ERROR("Exception in packet callback: {}", e.what());
+                }
+            }
+            // Run-to-completion: the callback consumed the batch
+            if (config_.runToCompletion) {
+                batch.clear();
+                return;
+            }
+        }
+    }
+
+    packetQueue_->push(batch);
+    batch.clear();
+}
+
+void PcapFileBackend::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    lastError_ = error;
+    BEATRICE_ERROR("{}", error);
+}
+
+// Zero-copy DMA access methods implementation
+bool PcapFileBackend::isZeroCopyEnabled() const {
+    return zeroCopyEnabled_;
+}
+
+bool PcapFileBackend::isDMAAccessEnabled() const {
+    return false;
+}
+
+Result<void> PcapFileBackend::enableZeroCopy(bool enabled) {
+    if (running_) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT,
+                                 "Cannot change zero-copy mode while running");
+    }
+
+    zeroCopyEnabled_ = enabled;
+    return Result<void>::success();
+}
+
+Result<void> PcapFileBackend::enableDMAAccess(bool enabled, const std::string& device) {
+    (void)device;
+    if (enabled) {
+        return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, "DMA access is not available for capture files");
+    }
+    return Result<void>::success();
+}
+
+Result<void> PcapFileBackend::setDMABufferSize(size_t size) {
+    (void)size;
+    return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, "DMA access is not available for capture files");
+}
+
+size_t PcapFileBackend::getDMABufferSize() const {
+    return 0;
+}
+
+std::string PcapFileBackend::getDMADevice() const {
+    return "";
+}
+
+Result<void> PcapFileBackend::allocateDMABuffers(size_t count) {
+    (void)count;
+    return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, "DMA access is not available for capture files");
+}
+
+Result<void> PcapFileBackend::freeDMABuffers() {
+    return Result<void>::success();
+}
+
+} // namespace beatrice
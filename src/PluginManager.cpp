@@ -1,54 +1,111 @@
 #include "beatrice/PluginManager.hpp"
 #include "beatrice/Logger.hpp"
 #include "beatrice/Error.hpp"
+#include "beatrice/Telemetry.hpp"
 #include <filesystem>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 #include <dlfcn.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 namespace beatrice {
 
-PluginManager::PluginManager() {
+namespace {
+
+// TSC where available, nanoseconds elsewhere
+inline uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Measured once per process against the steady clock
+double nanosPerCycle() {
+    static const double value = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        auto startTime = std::chrono::steady_clock::now();
+        uint64_t startCycles = readCycles();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        uint64_t cycles = readCycles() - startCycles;
+        auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+        return cycles > 0 ? static_cast<double>(nanos) / static_cast<double>(cycles) : 1.0;
+#else
+        return 1.0;
+#endif
+    }();
+    return value;
+}
+
+} // anonymous namespace
+
+PluginManager::PluginManager() : chain_(new PluginChain) {
+    // Calibrate up front rather than on the first sampled packet
+    nanosPerCycle();
     BEATRICE_DEBUG("PluginManager initialized");
 }
 
 PluginManager::~PluginManager() {
-    BEATRICE_DEBUG("PluginManager shutting down, unloading {} plugins", plugins_.size());
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    std::unique_ptr<PluginChain> chain(chain_.exchange(nullptr));
+    
+    BEATRICE_DEBUG("PluginManager shutting down, unloading {} plugins", chain->plugins.size());
     
     // Unload all plugins in reverse order
-    for (auto it = plugins_.rbegin(); it != plugins_.rend(); ++it) {
+    for (auto it = chain->plugins.rbegin(); it != chain->plugins.rend(); ++it) {
         try {
-            (*it)->onStop();
+            (*it)->plugin->onStop();
         } catch (const std::exception& e) {
             BEATRICE_ERROR("Exception during plugin shutdown: {}", e.what());
         }
     }
     
-    // Close all handles
-    for (auto& [name, handle] : handles_) {
-        if (handle) {
-            dlclose(handle);
-            BEATRICE_DEBUG("Closed plugin handle: {}", name);
+    // Destroying the chain closes the shared library handles
+    chain.reset();
+}
+
+PluginManager::LoadedPlugin::~LoadedPlugin() {
+    // The plugin's code lives in the shared library, destroy it first
+    plugin.reset();
+    
+    if (handle) {
+        dlclose(handle);
+        BEATRICE_DEBUG("Closed plugin handle: {}", name);
+    }
+}
+
+void PluginManager::publish(std::unique_ptr<PluginChain> chain) {
+    std::unique_ptr<PluginChain> old(chain_.exchange(chain.release()));
+    readers_.synchronize();
+}
+
+void PluginManager::retire(std::vector<std::shared_ptr<LoadedPlugin>> removed) {
+    // Only called after a grace period, no thread can still be inside these plugins
+    for (auto& loaded : removed) {
+        try {
+            loaded->plugin->onStop();
+            BEATRICE_DEBUG("Plugin {} stopped successfully", loaded->name);
+        } catch (const std::exception& e) {
+            BEATRICE_ERROR("Exception during plugin shutdown for {}: {}", loaded->name, e.what());
         }
     }
-    
-    plugins_.clear();
-    handles_.clear();
 }
 
-bool PluginManager::loadPlugin(const std::string& path) {
+std::shared_ptr<PluginManager::LoadedPlugin> PluginManager::openPlugin(const std::string& path) {
     if (path.empty()) {
         BEATRICE_ERROR("Plugin path is empty");
-        return false;
+        return nullptr;
     }
     
     if (!std::filesystem::exists(path)) {
         BEATRICE_ERROR("Plugin file does not exist: {}", path);
-        return false;
-    }
-    
-    if (plugins_.size() >= maxPlugins_) {
-        BEATRICE_ERROR("Maximum number of plugins ({}) reached", maxPlugins_);
-        return false;
+        return nullptr;
     }
     
     BEATRICE_INFO("Loading plugin: {}", path);
@@ -57,9 +114,14 @@ bool PluginManager::loadPlugin(const std::string& path) {
     void* handle = dlopen(path.c_str(), RTLD_LAZY);
     if (!handle) {
         BEATRICE_ERROR("Failed to load plugin {}: {}", path, dlerror());
-        return false;
+        return nullptr;
     }
     
+    // From here on the handle is closed by LoadedPlugin
+    auto loaded = std::make_shared<LoadedPlugin>();
+    loaded->path = path;
+    loaded->handle = handle;
+    
     // Clear any previous error
     dlerror();
     
@@ -69,174 +131,500 @@ bool PluginManager::loadPlugin(const std::string& path) {
     
     if (!create) {
         BEATRICE_ERROR("Failed to find createPlugin symbol in {}: {}", path, dlerror());
-        dlclose(handle);
-        return false;
+        return nullptr;
     }
     
     // Create plugin instance
-    IPacketPlugin* rawPlugin = nullptr;
     try {
-        rawPlugin = create();
-        if (!rawPlugin) {
+        loaded->plugin.reset(create());
+        if (!loaded->plugin) {
             BEATRICE_ERROR("Plugin creation function returned null for {}", path);
-            dlclose(handle);
-            return false;
+            return nullptr;
         }
     } catch (const std::exception& e) {
         BEATRICE_ERROR("Exception during plugin creation for {}: {}", path, e.what());
-        dlclose(handle);
-        return false;
+        return nullptr;
     }
     
-    auto plugin = std::unique_ptr<IPacketPlugin>(rawPlugin);
+    loaded->name = loaded->plugin->getName();
+    if (loaded->name.empty()) {
+        loaded->name = std::filesystem::path(path).stem().string();
+    }
+    
+    return loaded;
+}
+
+bool PluginManager::startPlugin(LoadedPlugin& loaded) {
+    loaded.profile.latency = metrics::histogram("plugin_" + loaded.name + "_latency_ns",
+                                                "Sampled per-packet latency of plugin " + loaded.name);
     
-    // Initialize plugin
     try {
-        plugin->onStart();
-        BEATRICE_INFO("Plugin {} started successfully", plugin->getName());
+        loaded.plugin->onStart();
+        BEATRICE_INFO("Plugin {} started successfully", loaded.name);
+        return true;
     } catch (const std::exception& e) {
-        BEATRICE_ERROR("Failed to start plugin {}: {}", path, e.what());
-        dlclose(handle);
+        BEATRICE_ERROR("Failed to start plugin {}: {}", loaded.name, e.what());
         return false;
     }
+}
+
+bool PluginManager::loadPlugin(const std::string& path) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    const PluginChain& current = *chain_.load();
     
-    // Store plugin and handle
-    std::string pluginName = plugin->getName();
-    if (pluginName.empty()) {
-        pluginName = std::filesystem::path(path).stem().string();
+    if (current.plugins.size() >= maxPlugins_) {
+        BEATRICE_ERROR("Maximum number of plugins ({}) reached", maxPlugins_);
+        return false;
+    }
+    
+    auto loaded = openPlugin(path);
+    if (!loaded) {
+        return false;
     }
     
     // Check for duplicate names
-    if (std::any_of(plugins_.begin(), plugins_.end(), 
-                    [&pluginName](const auto& p) { return p->getName() == pluginName; })) {
-        BEATRICE_ERROR("Plugin with name '{}' already loaded", pluginName);
-        dlclose(handle);
+    if (hasPluginLocked(loaded->name)) {
+        BEATRICE_ERROR("Plugin with name '{}' already loaded", loaded->name);
         return false;
     }
     
-    plugins_.push_back(std::move(plugin));
-    handles_[pluginName] = handle;
+    if (!startPlugin(*loaded)) {
+        return false;
+    }
+    
+    auto next = std::make_unique<PluginChain>(current);
+    next->plugins.push_back(std::move(loaded));
+    size_t count = next->plugins.size();
+    publish(std::move(next));
     
-    BEATRICE_INFO("Plugin {} loaded successfully ({} total)", pluginName, plugins_.size());
+    BEATRICE_INFO("Plugin {} loaded successfully ({} total)", path, count);
+    return true;
+}
+
+bool PluginManager::addPlugin(std::unique_ptr<IPacketPlugin> plugin) {
+    if (!plugin) {
+        BEATRICE_ERROR("Cannot add a null plugin");
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    const PluginChain& current = *chain_.load();
+    
+    if (current.plugins.size() >= maxPlugins_) {
+        BEATRICE_ERROR("Maximum number of plugins ({}) reached", maxPlugins_);
+        return false;
+    }
+    
+    // In-process plugins have no shared library handle to close
+    auto loaded = std::make_shared<LoadedPlugin>();
+    loaded->name = plugin->getName();
+    loaded->plugin = std::move(plugin);
+    
+    if (loaded->name.empty() || hasPluginLocked(loaded->name)) {
+        BEATRICE_ERROR("Plugin name '{}' is empty or already loaded", loaded->name);
+        return false;
+    }
+    
+    if (!startPlugin(*loaded)) {
+        return false;
+    }
+    
+    auto next = std::make_unique<PluginChain>(current);
+    next->plugins.push_back(loaded);
+    size_t count = next->plugins.size();
+    publish(std::move(next));
+    
+    BEATRICE_INFO("Plugin {} added ({} total)", loaded->name, count);
     return true;
 }
 
 void PluginManager::unloadPlugin(const std::string& name) {
     BEATRICE_INFO("Unloading plugin: {}", name);
     
-    auto handleIt = handles_.find(name);
-    if (handleIt == handles_.end()) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    const PluginChain& current = *chain_.load();
+    
+    auto next = std::make_unique<PluginChain>();
+    std::vector<std::shared_ptr<LoadedPlugin>> removed;
+    for (const auto& loaded : current.plugins) {
+        if (loaded->name == name) {
+            removed.push_back(loaded);
+        } else {
+            next->plugins.push_back(loaded);
+        }
+    }
+    
+    if (removed.empty()) {
         BEATRICE_WARN("Plugin '{}' not found for unloading", name);
         return;
     }
     
-    // Find and remove plugin from plugins_ vector
-    auto pluginIt = std::find_if(plugins_.begin(), plugins_.end(),
-                                [&name](const auto& plugin) { return plugin->getName() == name; });
+    size_t remaining = next->plugins.size();
+    publish(std::move(next));
+    retire(std::move(removed));
     
-    if (pluginIt != plugins_.end()) {
-        try {
-            (*pluginIt)->onStop();
-            BEATRICE_DEBUG("Plugin {} stopped successfully", name);
-        } catch (const std::exception& e) {
-            BEATRICE_ERROR("Exception during plugin shutdown for {}: {}", name, e.what());
+    BEATRICE_INFO("Plugin {} unloaded successfully ({} remaining)", name, remaining);
+}
+
+bool PluginManager::replacePlugin(const std::string& name, const std::string& path) {
+    BEATRICE_INFO("Replacing plugin {} with {}", name, path);
+    
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    const PluginChain& current = *chain_.load();
+    
+    auto it = std::find_if(current.plugins.begin(), current.plugins.end(),
+                           [&name](const auto& loaded) { return loaded->name == name; });
+    if (it == current.plugins.end()) {
+        BEATRICE_ERROR("Cannot replace plugin '{}': not loaded", name);
+        return false;
+    }
+    
+    auto loaded = openPlugin(path);
+    if (!loaded) {
+        return false;
+    }
+    
+    if (loaded->name != name && hasPluginLocked(loaded->name)) {
+        BEATRICE_ERROR("Plugin with name '{}' already loaded", loaded->name);
+        return false;
+    }
+    
+    if (!startPlugin(*loaded)) {
+        return false;
+    }
+    
+    // The new plugin takes the old one's place in the chain in a single step,
+    // so no packet is processed without either of them
+    auto next = std::make_unique<PluginChain>(current);
+    size_t index = static_cast<size_t>(it - current.plugins.begin());
+    std::vector<std::shared_ptr<LoadedPlugin>> removed{next->plugins[index]};
+    next->plugins[index] = std::move(loaded);
+    publish(std::move(next));
+    retire(std::move(removed));
+    
+    BEATRICE_INFO("Plugin {} replaced successfully", name);
+    return true;
+}
+
+bool PluginManager::reloadPlugin(const std::string& name) {
+    BEATRICE_INFO("Reloading plugin: {}", name);
+    
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        const PluginChain& current = *chain_.load();
+        for (const auto& loaded : current.plugins) {
+            if (loaded->name == name) {
+                path = loaded->path;
+            }
         }
-        
-        plugins_.erase(pluginIt);
     }
     
-    // Close handle
-    if (handleIt->second) {
-        dlclose(handleIt->second);
-        BEATRICE_DEBUG("Plugin handle closed for {}", name);
+    // The dynamic loader keeps one copy of a library per path while it is
+    // open, so this gets a fresh plugin instance; new code goes through
+    // replacePlugin() with the new library's path
+    if (path.empty()) {
+        BEATRICE_ERROR("Cannot reload plugin '{}': not loaded from a shared library", name);
+        return false;
     }
     
-    handles_.erase(handleIt);
-    BEATRICE_INFO("Plugin {} unloaded successfully ({} remaining)", name, plugins_.size());
+    return replacePlugin(name, path);
 }
 
-void PluginManager::processPacket(Packet& packet) {
-    if (plugins_.empty()) {
+void PluginManager::VerdictCounters::record(PluginVerdict verdict, uint64_t count) {
+    if (count == 0) {
         return;
     }
     
-    for (auto& plugin : plugins_) {
+    switch (verdict) {
+        case PluginVerdict::Drop:
+            dropped.fetch_add(count, std::memory_order_relaxed);
+            break;
+        case PluginVerdict::StopChain:
+            stopped.fetch_add(count, std::memory_order_relaxed);
+            break;
+        case PluginVerdict::Forward:
+            forwarded.fetch_add(count, std::memory_order_relaxed);
+            break;
+        case PluginVerdict::Continue:
+            break;
+    }
+}
+
+bool PluginManager::shouldRun(const LoadedPlugin& loaded, uint64_t tick) {
+    if (loaded.profile.disabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    
+    uint32_t shedLevel = loaded.profile.shedLevel.load(std::memory_order_relaxed);
+    return shedLevel == 0 || (tick & ((uint64_t{1} << shedLevel) - 1)) == 0;
+}
+
+void PluginManager::recordSample(LoadedPlugin& loaded, uint64_t cycles, size_t packets) {
+    auto& profile = loaded.profile;
+    double nanos = static_cast<double>(cycles) * nanosPerCycle() / static_cast<double>(packets);
+    profile.latency->observe(nanos);
+    
+    // Moving average over the last few samples, only sampling threads write it
+    double average = profile.averageNanos.load(std::memory_order_relaxed);
+    average = profile.samples.fetch_add(1, std::memory_order_relaxed) == 0 ? nanos : average + (nanos - average) / 8.0;
+    profile.averageNanos.store(average, std::memory_order_relaxed);
+    
+    double budget = profile.budgetNanos.load(std::memory_order_relaxed);
+    if (budget <= 0.0) {
+        return;
+    }
+    
+    // Skipped calls are free, so shedding divides the cost per packet of traffic
+    uint32_t shedLevel = profile.shedLevel.load(std::memory_order_relaxed);
+    double cost = average / static_cast<double>(uint64_t{1} << shedLevel);
+    
+    if (cost > budget) {
+        if (profile.action.load(std::memory_order_relaxed) == PluginBudgetAction::Disable) {
+            if (!profile.disabled.exchange(true, std::memory_order_relaxed)) {
+                reportBudgetAction(loaded, "disabled", cost);
+            }
+        } else if (shedLevel < kMaxShedLevel &&
+                   profile.shedLevel.compare_exchange_strong(shedLevel, shedLevel + 1, std::memory_order_relaxed)) {
+            reportBudgetAction(loaded, "shed", cost);
+        }
+    } else if (shedLevel > 0 && cost * 2.0 < budget &&
+               profile.shedLevel.compare_exchange_strong(shedLevel, shedLevel - 1, std::memory_order_relaxed)) {
+        reportBudgetAction(loaded, "restored", cost);
+    }
+}
+
+void PluginManager::reportBudgetAction(const LoadedPlugin& loaded, const std::string& action, double nanos) {
+    uint32_t shedLevel = loaded.profile.shedLevel.load(std::memory_order_relaxed);
+    double budget = loaded.profile.budgetNanos.load(std::memory_order_relaxed);
+    BEATRICE_WARN("Plugin {} {}: {:.1f} ns per packet against a budget of {:.1f} ns (runs on 1 in {} calls)",
+                  loaded.name, action, nanos, budget, uint64_t{1} << shedLevel);
+    
+    TelemetryEvent event(TelemetryEvent::EventType::PLUGIN_BUDGET_EXCEEDED, "plugin_budget",
+                         "Plugin " + loaded.name + " " + action);
+    event.addLabel("plugin", loaded.name);
+    event.addLabel("action", action);
+    event.addMetric("nanos_per_packet", nanos);
+    event.addMetric("budget_nanos_per_packet", budget);
+    event.addMetric("shed_level", static_cast<double>(shedLevel));
+    TelemetryCollector::get().collectEvent(event);
+}
+
+PluginVerdict PluginManager::processPacket(Packet& packet) {
+    thread_local uint64_t tick = 0;
+    ++tick;
+    uint32_t interval = profilingInterval_.load(std::memory_order_relaxed);
+    bool sample = interval != 0 && tick % interval == 0;
+    
+    ReadGuard guard(*this);
+    
+    for (const auto& loaded : guard.chain().plugins) {
+        if (!shouldRun(*loaded, tick)) {
+            continue;
+        }
+    
+        PluginVerdict verdict = PluginVerdict::Continue;
+        uint64_t startCycles = sample ? readCycles() : 0;
         try {
-            plugin->onPacket(packet);
+            verdict = loaded->plugin->onPacket(packet);
         } catch (const std::exception& e) {
-            BEATRICE_ERROR("Exception in plugin {} while processing packet: {}", 
-                          plugin->getName(), e.what());
+            BEATRICE_ERROR("Exception in plugin {} while processing packet: {}",
+                          loaded->name, e.what());
+        }
+    
+        if (sample) {
+            recordSample(*loaded, readCycles() - startCycles, 1);
+        }
+    
+        if (verdict != PluginVerdict::Continue) {
+            loaded->counters.record(verdict);
+            return verdict;
         }
     }
+    
+    return PluginVerdict::Continue;
 }
 
-void PluginManager::processPackets(const std::vector<Packet>& packets) {
-    if (plugins_.empty() || packets.empty()) {
-        return;
-    }
+void PluginManager::processPackets(std::span<Packet> packets, std::span<PluginVerdict> verdicts) {
+    std::fill(verdicts.begin(), verdicts.begin() + packets.size(), PluginVerdict::Continue);
+    
+    // Packets that left the chain are parked here while the survivors are
+    // compacted, then moved in behind them
+    thread_local std::vector<Packet> finishedPackets;
+    thread_local std::vector<PluginVerdict> finishedVerdicts;
     
-    for (auto& plugin : plugins_) {
+    thread_local uint64_t tick = 0;
+    ++tick;
+    uint32_t interval = profilingInterval_.load(std::memory_order_relaxed);
+    bool sample = interval != 0 && tick % interval == 0;
+    
+    ReadGuard guard(*this);
+    const auto& plugins = guard.chain().plugins;
+    
+    // One call per plugin and batch, so plugins see the whole batch at once;
+    // each plugin only gets the packets every earlier plugin let through
+    size_t active = packets.size();
+    for (size_t p = 0; p < plugins.size() && active > 0; ++p) {
+        auto& loaded = *plugins[p];
+        if (!shouldRun(loaded, tick)) {
+            continue;
+        }
+    
+        uint64_t startCycles = sample ? readCycles() : 0;
         try {
-            for (const auto& packet : packets) {
-                plugin->onPacket(const_cast<Packet&>(packet));
-            }
+            loaded.plugin->onBatch(packets.first(active), verdicts.first(active));
         } catch (const std::exception& e) {
-            BEATRICE_ERROR("Exception in plugin {} while processing {} packets: {}", 
-                          plugin->getName(), packets.size(), e.what());
+            BEATRICE_ERROR("Exception in plugin {} while processing {} packets: {}",
+                          loaded.name, active, e.what());
         }
+    
+        if (sample) {
+            recordSample(loaded, readCycles() - startCycles, active);
+        }
+    
+        // Stable compaction of the packets that are still travelling the chain
+        size_t kept = 0;
+        uint64_t dropped = 0;
+        uint64_t stopped = 0;
+        uint64_t forwarded = 0;
+        for (size_t i = 0; i < active; ++i) {
+            PluginVerdict verdict = verdicts[i];
+            if (verdict == PluginVerdict::Continue) {
+                if (kept != i) {
+                    packets[kept] = std::move(packets[i]);
+                    verdicts[kept] = verdict;
+                }
+                ++kept;
+                continue;
+            }
+    
+            dropped += verdict == PluginVerdict::Drop;
+            stopped += verdict == PluginVerdict::StopChain;
+            forwarded += verdict == PluginVerdict::Forward;
+            finishedPackets.push_back(std::move(packets[i]));
+            finishedVerdicts.push_back(verdict);
+        }
+    
+        if (kept == active) {
+            continue;
+        }
+    
+        for (size_t i = 0; i < finishedPackets.size(); ++i) {
+            packets[kept + i] = std::move(finishedPackets[i]);
+            verdicts[kept + i] = finishedVerdicts[i];
+        }
+        finishedPackets.clear();
+        finishedVerdicts.clear();
+        active = kept;
+    
+        loaded.counters.record(PluginVerdict::Drop, dropped);
+        loaded.counters.record(PluginVerdict::StopChain, stopped);
+        loaded.counters.record(PluginVerdict::Forward, forwarded);
     }
 }
 
+PluginManager::LoadedPlugin* PluginManager::findPluginLocked(const std::string& name) const {
+    for (const auto& loaded : chain_.load()->plugins) {
+        if (loaded->name == name) {
+            return loaded.get();
+        }
+    }
+    return nullptr;
+}
+
+bool PluginManager::hasPluginLocked(const std::string& name) const {
+    const auto& plugins = chain_.load()->plugins;
+    return std::any_of(plugins.begin(), plugins.end(),
+                      [&name](const auto& loaded) { return loaded->name == name; });
+}
+
 bool PluginManager::hasPlugin(const std::string& name) const {
-    return std::any_of(plugins_.begin(), plugins_.end(),
-                      [&name](const auto& plugin) { return plugin->getName() == name; });
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    return hasPluginLocked(name);
 }
 
 std::vector<std::string> PluginManager::getLoadedPluginNames() const {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    const auto& plugins = chain_.load()->plugins;
+    
     std::vector<std::string> names;
-    names.reserve(plugins_.size());
+    names.reserve(plugins.size());
     
-    for (const auto& plugin : plugins_) {
-        names.push_back(plugin->getName());
+    for (const auto& loaded : plugins) {
+        names.push_back(loaded->name);
     }
     
     return names;
 }
 
 size_t PluginManager::getPluginCount() const {
-    return plugins_.size();
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    return chain_.load()->plugins.size();
 }
 
-void PluginManager::setMaxPlugins(size_t max) {
-    maxPlugins_ = max;
-    BEATRICE_DEBUG("Maximum plugins set to {}", maxPlugins_);
+PluginVerdictStats PluginManager::getVerdictStats(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    
+    PluginVerdictStats stats;
+    if (const LoadedPlugin* loaded = findPluginLocked(name)) {
+        stats.dropped = loaded->counters.dropped.load(std::memory_order_relaxed);
+        stats.stopped = loaded->counters.stopped.load(std::memory_order_relaxed);
+        stats.forwarded = loaded->counters.forwarded.load(std::memory_order_relaxed);
+    }
+    return stats;
 }
 
-size_t PluginManager::getMaxPlugins() const {
-    return maxPlugins_;
+void PluginManager::setProfilingInterval(uint32_t interval) {
+    profilingInterval_.store(interval, std::memory_order_relaxed);
+    BEATRICE_DEBUG("Plugin profiling interval set to {}", interval);
 }
 
-void PluginManager::reloadPlugin(const std::string& name) {
-    BEATRICE_INFO("Reloading plugin: {}", name);
+uint32_t PluginManager::getProfilingInterval() const {
+    return profilingInterval_.load(std::memory_order_relaxed);
+}
+
+bool PluginManager::setPluginBudget(const std::string& name, const PluginBudget& budget) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
     
-    if (!hasPlugin(name)) {
-        BEATRICE_ERROR("Cannot reload plugin '{}': not loaded", name);
-        return;
+    LoadedPlugin* loaded = findPluginLocked(name);
+    if (!loaded) {
+        BEATRICE_ERROR("Cannot set budget of plugin '{}': not loaded", name);
+        return false;
     }
     
-    // Get the original path from handle
-    auto handleIt = handles_.find(name);
-    if (handleIt == handles_.end()) {
-        BEATRICE_ERROR("Cannot find handle for plugin '{}'", name);
-        return;
-    }
+    // A new budget gives the plugin a fresh start
+    auto& profile = loaded->profile;
+    profile.budgetNanos.store(budget.maxNanosPerPacket, std::memory_order_relaxed);
+    profile.action.store(budget.action, std::memory_order_relaxed);
+    profile.shedLevel.store(0, std::memory_order_relaxed);
+    profile.disabled.store(false, std::memory_order_relaxed);
     
-    // Unload and reload
-    unloadPlugin(name);
+    BEATRICE_INFO("Plugin {} budget set to {:.1f} ns per packet", name, budget.maxNanosPerPacket);
+    return true;
+}
+
+PluginProfile PluginManager::getPluginProfile(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(writerMutex_);
     
-    // Note: We would need to store the original path to reload
-    // For now, this is a limitation - plugins need to be reloaded manually
-    BEATRICE_WARN("Plugin '{}' unloaded. Please reload manually with loadPlugin()", name);
+    PluginProfile profile;
+    if (const LoadedPlugin* loaded = findPluginLocked(name)) {
+        profile.samples = loaded->profile.samples.load(std::memory_order_relaxed);
+        profile.averageNanosPerPacket = loaded->profile.averageNanos.load(std::memory_order_relaxed);
+        profile.shedLevel = loaded->profile.shedLevel.load(std::memory_order_relaxed);
+        profile.disabled = loaded->profile.disabled.load(std::memory_order_relaxed);
+    }
+    return profile;
+}
+
+void PluginManager::setMaxPlugins(size_t max) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    maxPlugins_ = max;
+    BEATRICE_DEBUG("Maximum plugins set to {}", maxPlugins_);
+}
+
+size_t PluginManager::getMaxPlugins() const {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    return maxPlugins_;
 }
 
 } // namespace beatrice
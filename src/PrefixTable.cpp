@@ -0,0 +1,315 @@
+#include "beatrice/PrefixTable.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <arpa/inet.h>
+
+namespace beatrice {
+
+namespace {
+
+constexpr size_t kDirectSize = size_t{1} << 16;
+
+} // anonymous namespace
+
+// Turns a sorted, deduplicated prefix list into the two tries
+struct PrefixTable::Builder {
+    PrefixTable& table;
+    std::unordered_map<uint64_t, uint32_t> resultIndex;
+
+    // Leaf value for a prefix, 1-based so that 0 can mean no match
+    uint32_t leafFor(const Entry& entry) {
+        uint64_t id = static_cast<uint64_t>(entry.tag) << 8 | entry.length;
+        auto [it, inserted] = resultIndex.try_emplace(id, static_cast<uint32_t>(table.results_.size()) + 1);
+        if (inserted) {
+            table.results_.push_back(LeafResult{entry.tag, entry.length});
+        }
+        return it->second;
+    }
+
+    static unsigned slotOf(Key key, unsigned offset) {
+        return static_cast<unsigned>((key << offset) >> (128 - kStride));
+    }
+
+    void buildTrie(Trie& trie, std::vector<Entry>& entries, size_t begin, size_t end) {
+        if (begin == end) {
+            return;
+        }
+        trie.direct.assign(kDirectSize, kLeafFlag);
+
+        // Prefixes ending in the direct table, shortest first so longer ones win
+        auto longBegin = std::stable_partition(entries.begin() + begin, entries.begin() + end,
+                                               [](const Entry& entry) { return entry.length <= kDirectBits; });
+        std::stable_sort(entries.begin() + begin, longBegin,
+                         [](const Entry& a, const Entry& b) { return a.length < b.length; });
+        for (auto it = entries.begin() + begin; it != longBegin; ++it) {
+            size_t first = static_cast<size_t>(it->key >> (128 - kDirectBits));
+            size_t count = size_t{1} << (kDirectBits - it->length);
+            std::fill_n(trie.direct.begin() + first, count, kLeafFlag | leafFor(*it));
+        }
+
+        // Longer prefixes still sort by key, one subtree per direct slot
+        size_t group = static_cast<size_t>(longBegin - entries.begin());
+        while (group < end) {
+            size_t slot = static_cast<size_t>(entries[group].key >> (128 - kDirectBits));
+            size_t groupEnd = group + 1;
+            while (groupEnd < end && static_cast<size_t>(entries[groupEnd].key >> (128 - kDirectBits)) == slot) {
+                ++groupEnd;
+            }
+
+            uint32_t inherited = trie.direct[slot] & ~kLeafFlag;
+            uint32_t nodeIndex = static_cast<uint32_t>(trie.nodes.size());
+            trie.nodes.emplace_back();
+            trie.direct[slot] = nodeIndex;
+            buildNode(trie, nodeIndex, entries, group, groupEnd, kDirectBits, inherited);
+            group = groupEnd;
+        }
+    }
+
+    void buildNode(Trie& trie, uint32_t nodeIndex, std::vector<Entry>& entries,
+                   size_t begin, size_t end, unsigned offset, uint32_t inherited) {
+        std::array<uint32_t, 64> slotLeaves;
+        slotLeaves.fill(inherited);
+
+        // Leaf pushing: prefixes ending in this node expand over their slots
+        auto longBegin = std::stable_partition(entries.begin() + begin, entries.begin() + end,
+                                               [offset](const Entry& entry) { return entry.length <= offset + kStride; });
+        std::stable_sort(entries.begin() + begin, longBegin,
+                         [](const Entry& a, const Entry& b) { return a.length < b.length; });
+        for (auto it = entries.begin() + begin; it != longBegin; ++it) {
+            unsigned first = slotOf(it->key, offset);
+            unsigned count = 1u << (offset + kStride - it->length);
+            std::fill_n(slotLeaves.begin() + first, count, leafFor(*it));
+        }
+
+        // Children go in one block, in slot order, so a popcount finds them
+        std::vector<std::pair<size_t, size_t>> groups;
+        uint64_t vector = 0;
+        size_t group = static_cast<size_t>(longBegin - entries.begin());
+        while (group < end) {
+            unsigned slot = slotOf(entries[group].key, offset);
+            size_t groupEnd = group + 1;
+            while (groupEnd < end && slotOf(entries[groupEnd].key, offset) == slot) {
+                ++groupEnd;
+            }
+            vector |= uint64_t{1} << slot;
+            groups.emplace_back(group, groupEnd);
+            group = groupEnd;
+        }
+
+        // Only the first leaf of each run of equal leaves is stored
+        uint64_t leafvec = 0;
+        uint32_t base0 = static_cast<uint32_t>(trie.leaves.size());
+        bool first = true;
+        for (unsigned slot = 0; slot < 64; ++slot) {
+            if (vector & (uint64_t{1} << slot)) {
+                continue;
+            }
+            if (first || slotLeaves[slot] != trie.leaves.back()) {
+                leafvec |= uint64_t{1} << slot;
+                trie.leaves.push_back(slotLeaves[slot]);
+                first = false;
+            }
+        }
+
+        uint32_t base1 = static_cast<uint32_t>(trie.nodes.size());
+        trie.nodes.resize(trie.nodes.size() + groups.size());
+        trie.nodes[nodeIndex] = Node{vector, leafvec, base0, base1};
+
+        for (size_t i = 0; i < groups.size(); ++i) {
+            unsigned slot = slotOf(entries[groups[i].first].key, offset);
+            buildNode(trie, base1 + static_cast<uint32_t>(i), entries, groups[i].first, groups[i].second,
+                      offset + kStride, slotLeaves[slot]);
+        }
+    }
+};
+
+PrefixTable::PrefixTable() = default;
+
+Result<PrefixTable::Prefix> PrefixTable::parsePrefix(const std::string& text, const std::string& tag) {
+    Prefix prefix;
+    prefix.tag = tag;
+
+    size_t slash = text.find('/');
+    std::string address = text.substr(0, slash);
+    if (inet_pton(AF_INET, address.c_str(), prefix.address.data()) == 1) {
+        prefix.length = 32;
+    } else if (inet_pton(AF_INET6, address.c_str(), prefix.address.data()) == 1) {
+        prefix.ipv6 = true;
+        prefix.length = 128;
+    } else {
+        return Result<Prefix>::error(ErrorCode::INVALID_ARGUMENT, "Invalid address in prefix: " + text);
+    }
+
+    if (slash != std::string::npos) {
+        std::string length = text.substr(slash + 1);
+        if (length.empty() || length.size() > 3 ||
+            !std::all_of(length.begin(), length.end(), [](char c) { return c >= '0' && c <= '9'; }) ||
+            std::stoul(length) > prefix.length) {
+            return Result<Prefix>::error(ErrorCode::INVALID_ARGUMENT, "Invalid prefix length: " + text);
+        }
+        prefix.length = static_cast<uint8_t>(std::stoul(length));
+    }
+
+    // Clear the host bits so equal networks compare equal
+    for (size_t bit = prefix.length; bit < prefix.address.size() * 8; ++bit) {
+        prefix.address[bit / 8] &= static_cast<uint8_t>(~(0x80u >> (bit % 8)));
+    }
+    return Result<Prefix>::success(prefix);
+}
+
+Result<PrefixTable> PrefixTable::build(const std::vector<Prefix>& prefixes) {
+    return PrefixTable().update(prefixes, {});
+}
+
+Result<PrefixTable> PrefixTable::loadFile(const std::string& path, const std::string& defaultTag) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return Result<PrefixTable>::error(ErrorCode::RESOURCE_UNAVAILABLE, "Failed to open prefix list: " + path);
+    }
+
+    std::vector<Prefix> prefixes;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string text;
+        std::string tag;
+        if (!(fields >> text)) {
+            continue;
+        }
+        if (!(fields >> tag)) {
+            tag = defaultTag;
+        }
+
+        auto prefix = parsePrefix(text, tag);
+        if (prefix.isError()) {
+            return Result<PrefixTable>::error(ErrorCode::INVALID_ARGUMENT,
+                path + ":" + std::to_string(lineNumber) + ": " + prefix.getErrorMessage());
+        }
+        prefixes.push_back(std::move(prefix.getValue()));
+    }
+    if (file.bad()) {
+        return Result<PrefixTable>::error(ErrorCode::RESOURCE_UNAVAILABLE, "Failed to read prefix list: " + path);
+    }
+
+    return build(prefixes);
+}
+
+Result<PrefixTable> PrefixTable::update(const std::vector<Prefix>& additions,
+                                        const std::vector<Prefix>& removals) const {
+    PrefixTable table;
+    std::unordered_map<std::string, uint32_t> tagIndex;
+    auto internTag = [&](const std::string& tag) {
+        auto [it, inserted] = tagIndex.try_emplace(tag, static_cast<uint32_t>(table.tags_.size()));
+        if (inserted) {
+            table.tags_.push_back(tag);
+        }
+        return it->second;
+    };
+    auto toEntry = [](const Prefix& prefix) {
+        Entry entry;
+        for (uint8_t byte : prefix.address) {
+            entry.key = entry.key << 8 | byte;
+        }
+        entry.length = prefix.length;
+        entry.ipv6 = prefix.ipv6;
+        if (entry.length < 128) {
+            entry.key &= ~(~Key{0} >> entry.length);
+        }
+        return entry;
+    };
+    auto before = [](const Entry& a, const Entry& b) {
+        if (a.ipv6 != b.ipv6) return !a.ipv6;
+        if (a.key != b.key) return a.key < b.key;
+        return a.length < b.length;
+    };
+    auto same = [](const Entry& a, const Entry& b) {
+        return a.ipv6 == b.ipv6 && a.key == b.key && a.length == b.length;
+    };
+
+    // Existing prefixes first, so additions listed later replace them
+    std::vector<Entry> entries;
+    entries.reserve(prefixes_.size() + additions.size());
+    for (const Entry& existing : prefixes_) {
+        Entry entry = existing;
+        entry.tag = internTag(tags_[existing.tag]);
+        entries.push_back(entry);
+    }
+    for (const Prefix& prefix : additions) {
+        if (prefix.length > (prefix.ipv6 ? 128 : 32)) {
+            return Result<PrefixTable>::error(ErrorCode::INVALID_ARGUMENT,
+                "Prefix length " + std::to_string(prefix.length) + " too long");
+        }
+        Entry entry = toEntry(prefix);
+        entry.tag = internTag(prefix.tag);
+        entries.push_back(entry);
+    }
+
+    std::vector<Entry> removed;
+    for (const Prefix& prefix : removals) {
+        removed.push_back(toEntry(prefix));
+    }
+    std::sort(removed.begin(), removed.end(), before);
+
+    // Keep the last of each duplicate, skip removed ones
+    std::stable_sort(entries.begin(), entries.end(), before);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 1 < entries.size() && same(entries[i], entries[i + 1])) {
+            continue;
+        }
+        if (std::binary_search(removed.begin(), removed.end(), entries[i], before)) {
+            continue;
+        }
+        table.prefixes_.push_back(entries[i]);
+    }
+    table.prefixes_.shrink_to_fit();
+
+    // The builder reorders its working copy
+    std::vector<Entry> work = table.prefixes_;
+    auto v6Begin = std::find_if(work.begin(), work.end(), [](const Entry& entry) { return entry.ipv6; });
+    size_t split = static_cast<size_t>(v6Begin - work.begin());
+
+    Builder builder{table, {}};
+    builder.buildTrie(table.v4_, work, 0, split);
+    builder.buildTrie(table.v6_, work, split, work.size());
+
+    if (table.v4_.nodes.size() >= kLeafFlag || table.v6_.nodes.size() >= kLeafFlag) {
+        return Result<PrefixTable>::error(ErrorCode::RESOURCE_UNAVAILABLE, "Prefix table too large");
+    }
+    for (Trie* trie : {&table.v4_, &table.v6_}) {
+        trie->nodes.shrink_to_fit();
+        trie->leaves.shrink_to_fit();
+    }
+
+    return Result<PrefixTable>::success(std::move(table));
+}
+
+size_t PrefixTable::memoryUsage() const noexcept {
+    size_t bytes = 0;
+    for (const Trie* trie : {&v4_, &v6_}) {
+        bytes += trie->direct.capacity() * sizeof(uint32_t);
+        bytes += trie->nodes.capacity() * sizeof(Node);
+        bytes += trie->leaves.capacity() * sizeof(uint32_t);
+    }
+    return bytes + results_.capacity() * sizeof(LeafResult);
+}
+
+std::vector<PrefixTable::Prefix> PrefixTable::prefixes() const {
+    std::vector<Prefix> prefixes;
+    prefixes.reserve(prefixes_.size());
+    for (const Entry& entry : prefixes_) {
+        Prefix prefix;
+        for (size_t i = 0; i < prefix.address.size(); ++i) {
+            prefix.address[i] = static_cast<uint8_t>(entry.key >> (120 - 8 * i));
+        }
+        prefix.length = entry.length;
+        prefix.ipv6 = entry.ipv6;
+        prefix.tag = tags_[entry.tag];
+        prefixes.push_back(std::move(prefix));
+    }
+    return prefixes;
+}
+
+} // namespace beatrice
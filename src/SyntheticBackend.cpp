@@ -0,0 +1,646 @@
+#include "beatrice/SyntheticBackend.hpp"
+#include "beatrice/Logger.hpp"
+#include "beatrice/Error.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace beatrice {
+
+namespace {
+
+constexpr size_t kEthernetHeaderSize = 14;
+constexpr size_t kVlanTagSize = 4;
+constexpr size_t kIpv4HeaderSize = 20;
+constexpr size_t kTcpHeaderSize = 20;
+constexpr size_t kUdpHeaderSize = 8;
+constexpr size_t kIcmpHeaderSize = 8;
+constexpr size_t kVxlanHeaderSize = 8;
+constexpr size_t kGreHeaderSize = 4;
+
+constexpr uint8_t kProtoIcmp = 1;
+constexpr uint8_t kProtoTcp = 6;
+constexpr uint8_t kProtoUdp = 17;
+constexpr uint8_t kProtoGre = 47;
+constexpr uint16_t kVxlanPort = 4789;
+constexpr uint32_t kVxlanVni = 100;
+
+// Largest untagged frame without FCS, the upper bound for IMIX and pareto
+constexpr size_t kMaxStandardFrame = 1514;
+
+// Enough templates that sizes and payloads do not repeat in short cycles
+constexpr size_t kMinTemplates = 1024;
+constexpr size_t kMaxTemplates = 65536;
+constexpr size_t kTemplateAlignment = 64;
+
+constexpr auto kMaxPacingSleep = std::chrono::milliseconds(100);
+
+constexpr uint16_t kTcpPorts[] = {80, 443, 22, 25, 8080, 3306};
+constexpr uint16_t kUdpPorts[] = {53, 123, 443, 161, 514, 5353};
+
+struct Flow {
+    uint32_t srcIp;
+    uint32_t dstIp;
+    uint16_t srcPort;
+    uint16_t dstPort;
+    uint8_t protocol;
+};
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = static_cast<uint8_t>(value >> 8);
+    p[1] = static_cast<uint8_t>(value);
+}
+
+void put32(uint8_t* p, uint32_t value) {
+    put16(p, static_cast<uint16_t>(value >> 16));
+    put16(p + 2, static_cast<uint16_t>(value));
+}
+
+uint32_t checksumAdd(const uint8_t* data, size_t length, uint32_t sum = 0) {
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        sum += (static_cast<uint32_t>(data[i]) << 8) | data[i + 1];
+    }
+    if (length & 1) {
+        sum += static_cast<uint32_t>(data[length - 1]) << 8;
+    }
+    return sum;
+}
+
+uint16_t checksumFold(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+uint8_t* writeEthernet(uint8_t* p, uint8_t station, uint16_t vlanId, uint16_t etherType) {
+    const uint8_t dst[6] = {0x02, 0x00, 0x00, 0x00, station, 0x02};
+    const uint8_t src[6] = {0x02, 0x00, 0x00, 0x00, station, 0x01};
+    std::memcpy(p, dst, 6);
+    std::memcpy(p + 6, src, 6);
+    p += 12;
+    if (vlanId != 0) {
+        put16(p, 0x8100);
+        put16(p + 2, vlanId & 0x0fff);
+        p += kVlanTagSize;
+    }
+    put16(p, etherType);
+    return p + 2;
+}
+
+uint8_t* writeIpv4(uint8_t* p, size_t totalLength, uint8_t protocol, uint32_t src, uint32_t dst, uint16_t id) {
+    p[0] = 0x45;
+    p[1] = 0;
+    put16(p + 2, static_cast<uint16_t>(totalLength));
+    put16(p + 4, id);
+    put16(p + 6, 0x4000);     // don't fragment
+    p[8] = 64;
+    p[9] = protocol;
+    put16(p + 10, 0);
+    put32(p + 12, src);
+    put32(p + 16, dst);
+    put16(p + 10, checksumFold(checksumAdd(p, kIpv4HeaderSize)));
+    return p + kIpv4HeaderSize;
+}
+
+// L4 header plus payload of an inner IPv4 packet, payload already in place
+void writeTransport(uint8_t* p, size_t length, const Flow& flow, std::mt19937_64& rng) {
+    uint32_t pseudo = 0;
+    pseudo += (flow.srcIp >> 16) + (flow.srcIp & 0xffff);
+    pseudo += (flow.dstIp >> 16) + (flow.dstIp & 0xffff);
+    pseudo += flow.protocol + static_cast<uint32_t>(length);
+
+    switch (flow.protocol) {
+        case kProtoTcp:
+            put16(p, flow.srcPort);
+            put16(p + 2, flow.dstPort);
+            put32(p + 4, static_cast<uint32_t>(rng()));
+            put32(p + 8, static_cast<uint32_t>(rng()));
+            p[12] = 0x50;
+            p[13] = 0x18;             // PSH|ACK
+            put16(p + 14, 65535);
+            put16(p + 16, 0);
+            put16(p + 18, 0);
+            put16(p + 16, checksumFold(checksumAdd(p, length, pseudo)));
+            break;
+        case kProtoUdp:
+            put16(p, flow.srcPort);
+            put16(p + 2, flow.dstPort);
+            put16(p + 4, static_cast<uint16_t>(length));
+            put16(p + 6, 0);
+            if (uint16_t sum = checksumFold(checksumAdd(p, length, pseudo)); sum != 0) {
+                put16(p + 6, sum);
+            } else {
+                put16(p + 6, 0xffff);
+            }
+            break;
+        default:
+            p[0] = 8;                 // echo request
+            p[1] = 0;
+            put16(p + 2, 0);
+            put16(p + 4, flow.srcPort);
+            put16(p + 6, static_cast<uint16_t>(rng()));
+            put16(p + 2, checksumFold(checksumAdd(p, length)));
+            break;
+    }
+}
+
+size_t transportHeaderSize(uint8_t protocol) {
+    switch (protocol) {
+        case kProtoTcp: return kTcpHeaderSize;
+        case kProtoUdp: return kUdpHeaderSize;
+        default:        return kIcmpHeaderSize;
+    }
+}
+
+size_t encapsulationSize(ICaptureBackend::Encapsulation encapsulation) {
+    switch (encapsulation) {
+        case ICaptureBackend::Encapsulation::VXLAN:
+            return kIpv4HeaderSize + kUdpHeaderSize + kVxlanHeaderSize + kEthernetHeaderSize;
+        case ICaptureBackend::Encapsulation::GRE:
+            return kIpv4HeaderSize + kGreHeaderSize;
+        default:
+            return 0;
+    }
+}
+
+} // anonymous namespace
+
+SyntheticBackend::SyntheticBackend()
+    : running_(false)
+    , generatorDone_(false)
+    , initialized_(false)
+    , zeroCopyEnabled_(true)
+    , config_()
+    , arena_()
+    , templates_()
+    , generatorThread_()
+    , packetQueue_()
+    , packetCallback_(nullptr)
+    , stats_()
+    , lastError_() {
+}
+
+SyntheticBackend::~SyntheticBackend() {
+    stop();
+}
+
+Result<void> SyntheticBackend::initialize(const Config& config) {
+    if (initialized_) {
+        return Result<void>::success();
+    }
+
+    config_ = config;
+    if (config_.syntheticFlows == 0 || config_.syntheticFlows > kMaxTemplates) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT,
+                                   "Synthetic flow count must be between 1 and " + std::to_string(kMaxTemplates));
+    }
+    if (config_.syntheticTcpPercent + config_.syntheticUdpPercent > 100) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "TCP and UDP shares exceed 100 percent");
+    }
+    if (config_.syntheticPacketSize > config_.maxPacketSize || config_.syntheticPacketSize > 65535) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Synthetic packet size exceeds the maximum packet size");
+    }
+    if (config_.syntheticSizeDistribution == PacketSizeDistribution::PARETO && config_.syntheticParetoShape <= 0.0) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Pareto shape must be positive");
+    }
+
+    auto result = buildTemplates();
+    if (result.isError()) {
+        return result;
+    }
+
+    // A paced source behaves like a NIC and drops; unthrottled it applies backpressure
+    packetQueue_ = std::make_unique<PacketQueue>(config_, config_.syntheticRatePps > 0 ? OverflowPolicy::DROP_NEWEST : OverflowPolicy::BLOCK, "synthetic");
+    initialized_ = true;
+    BEATRICE_INFO("Synthetic backend ready: {} flows, {} templates, {:.1f} byte average frame, {}",
+                  config_.syntheticFlows, templates_.size(), getAverageFrameSize(),
+                  config_.syntheticRatePps > 0 ? std::to_string(config_.syntheticRatePps) + " pps" : "unthrottled");
+    return Result<void>::success();
+}
+
+Result<void> SyntheticBackend::start() {
+    if (!initialized_) {
+        return Result<void>::error(ErrorCode::INITIALIZATION_FAILED, "Synthetic backend not initialized");
+    }
+
+    if (running_) {
+        return Result<void>::success();
+    }
+
+    running_ = true;
+    generatorDone_ = false;
+    packetQueue_->open();
+    generatorThread_ = std::thread(&SyntheticBackend::generatorLoop, this);
+    return Result<void>::success();
+}
+
+Result<void> SyntheticBackend::stop() {
+    if (!running_) {
+        return Result<void>::success();
+    }
+
+    running_ = false;
+    packetQueue_->close();
+
+    if (generatorThread_.joinable()) {
+        generatorThread_.join();
+    }
+    return Result<void>::success();
+}
+
+bool SyntheticBackend::isRunning() const noexcept {
+    return running_;
+}
+
+bool SyntheticBackend::isFinished() const {
+    return generatorDone_ && (!packetQueue_ || packetQueue_->empty());
+}
+
+size_t SyntheticBackend::getTemplateCount() const {
+    return templates_.size();
+}
+
+double SyntheticBackend::getAverageFrameSize() const {
+    if (templates_.empty()) {
+        return 0.0;
+    }
+    size_t total = 0;
+    for (const auto& frame : templates_) {
+        total += frame.length;
+    }
+    return static_cast<double>(total) / static_cast<double>(templates_.size());
+}
+
+std::optional<Packet> SyntheticBackend::nextPacket(std::chrono::milliseconds timeout) {
+    auto packets = getPackets(1, timeout);
+    if (packets.empty()) {
+        return std::nullopt;
+    }
+    return std::move(packets.front());
+}
+
+std::vector<Packet> SyntheticBackend::getPackets(size_t maxPackets, std::chrono::milliseconds timeout) {
+    std::vector<Packet> packets;
+    if (!packetQueue_) {
+        return packets;
+    }
+
+    packetQueue_->pop(packets, maxPackets, timeout);
+    return packets;
+}
+
+void SyntheticBackend::setPacketCallback(std::function<void(Packet)> callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    packetCallback_ = callback;
+}
+
+void SyntheticBackend::removePacketCallback() {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    packetCallback_ = nullptr;
+}
+
+SyntheticBackend::Statistics SyntheticBackend::getStatistics() const {
+    Statistics stats;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = stats_;
+    }
+    if (packetQueue_) {
+        const auto queueStats = packetQueue_->getStatistics();
+        stats.packetsDropped += queueStats.dropped;
+        stats.bytesDropped += queueStats.bytesDropped;
+        stats.queueHighWatermark = queueStats.highWatermark;
+    }
+    return stats;
+}
+
+void SyntheticBackend::resetStatistics() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_ = Statistics{};
+    if (packetQueue_) {
+        packetQueue_->resetStatistics();
+    }
+}
+
+std::string SyntheticBackend::getName() const {
+    return "Synthetic";
+}
+
+std::string SyntheticBackend::getVersion() const {
+    return "1.0.0";
+}
+
+std::vector<std::string> SyntheticBackend::getSupportedFeatures() const {
+    return {
+        "zero_copy",
+        "synthetic",
+        "rate_control",
+        "vlan",
+        "vxlan",
+        "gre",
+        "batch_processing",
+        "run_to_completion"
+    };
+}
+
+bool SyntheticBackend::isFeatureSupported(const std::string& feature) const {
+    auto features = getSupportedFeatures();
+    return std::find(features.begin(), features.end(), feature) != features.end();
+}
+
+SyntheticBackend::Config SyntheticBackend::getConfig() const {
+    return config_;
+}
+
+Result<void> SyntheticBackend::updateConfig(const Config& config) {
+    if (running_) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Cannot update config while running");
+    }
+
+    config_ = config;
+    return Result<void>::success();
+}
+
+std::string SyntheticBackend::getLastError() const {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    return lastError_;
+}
+
+bool SyntheticBackend::isHealthy() const {
+    return initialized_ && !templates_.empty();
+}
+
+Result<void> SyntheticBackend::healthCheck() {
+    if (!initialized_) {
+        return Result<void>::error(ErrorCode::INITIALIZATION_FAILED, "Backend not initialized");
+    }
+    return Result<void>::success();
+}
+
+Result<void> SyntheticBackend::buildTemplates() {
+    std::mt19937_64 rng(config_.syntheticSeed);
+    const size_t outerSize = kEthernetHeaderSize + (config_.syntheticVlanId != 0 ? kVlanTagSize : 0) +
+                             encapsulationSize(config_.syntheticEncapsulation);
+
+    // Unique source address per flow, everything else drawn from the seed
+    std::vector<Flow> flows(config_.syntheticFlows);
+    for (size_t i = 0; i < flows.size(); ++i) {
+        Flow& flow = flows[i];
+        const unsigned pick = static_cast<unsigned>(rng() % 100);
+        flow.protocol = pick < config_.syntheticTcpPercent ? kProtoTcp
+                      : pick < config_.syntheticTcpPercent + config_.syntheticUdpPercent ? kProtoUdp
+                      : kProtoIcmp;
+        flow.srcIp = 0x0a000001 + static_cast<uint32_t>(i);
+        flow.dstIp = 0xc0a80000 | static_cast<uint32_t>(rng() & 0xffff);
+        flow.srcPort = static_cast<uint16_t>(1024 + rng() % (65536 - 1024));
+        flow.dstPort = flow.protocol == kProtoTcp ? kTcpPorts[rng() % std::size(kTcpPorts)]
+                                                  : kUdpPorts[rng() % std::size(kUdpPorts)];
+    }
+
+    size_t templateCount = flows.size();
+    if (config_.syntheticSizeDistribution != PacketSizeDistribution::FIXED) {
+        templateCount = std::clamp(flows.size(), kMinTemplates, kMaxTemplates);
+    }
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    auto sampleSize = [&]() -> size_t {
+        switch (config_.syntheticSizeDistribution) {
+            case PacketSizeDistribution::IMIX: {
+                const auto pick = rng() % 12;
+                return pick < 7 ? 60 : pick < 11 ? 590 : 1514;
+            }
+            case PacketSizeDistribution::PARETO: {
+                const double u = 1.0 - uniform(rng);
+                const double size = static_cast<double>(config_.syntheticPacketSize) /
+                                    std::pow(u, 1.0 / config_.syntheticParetoShape);
+                return static_cast<size_t>(std::min(size, static_cast<double>(kMaxStandardFrame)));
+            }
+            default:
+                return config_.syntheticPacketSize;
+        }
+    };
+
+    std::vector<Template> templates(templateCount);
+    size_t arenaSize = 0;
+    for (size_t i = 0; i < templateCount; ++i) {
+        const Flow& flow = flows[i % flows.size()];
+        const size_t minimum = outerSize + kIpv4HeaderSize + transportHeaderSize(flow.protocol);
+        templates[i].offset = arenaSize;
+        templates[i].length = std::max(sampleSize(), minimum);
+        arenaSize += (templates[i].length + kTemplateAlignment - 1) & ~(kTemplateAlignment - 1);
+    }
+
+    std::shared_ptr<uint8_t[]> arena(new (std::nothrow) uint8_t[arenaSize]);
+    if (!arena) {
+        setLastError("Failed to allocate " + std::to_string(arenaSize) + " bytes of packet templates");
+        return Result<void>::error(ErrorCode::RESOURCE_UNAVAILABLE, getLastError());
+    }
+
+    for (size_t i = 0; i < templateCount; ++i) {
+        const Flow& flow = flows[i % flows.size()];
+        uint8_t* frame = arena.get() + templates[i].offset;
+        const size_t length = templates[i].length;
+        const uint16_t id = static_cast<uint16_t>(i);
+
+        // Payload first, headers are written over its front
+        for (size_t j = 0; j < length; j += 8) {
+            const uint64_t bytes = rng();
+            std::memcpy(frame + j, &bytes, std::min<size_t>(8, length - j));
+        }
+
+        uint8_t* p = frame;
+        switch (config_.syntheticEncapsulation) {
+            case Encapsulation::VXLAN: {
+                p = writeEthernet(p, 0, config_.syntheticVlanId, 0x0800);
+                const size_t outerIpLength = length - static_cast<size_t>(p - frame);
+                p = writeIpv4(p, outerIpLength, kProtoUdp, 0xac100001, 0xac100002, id);
+                // Source port carries flow entropy, as VTEPs do for ECMP
+                put16(p, static_cast<uint16_t>(49152 + ((flow.srcIp ^ flow.srcPort) & 0x3fff)));
+                put16(p + 2, kVxlanPort);
+                put16(p + 4, static_cast<uint16_t>(outerIpLength - kIpv4HeaderSize));
+                put16(p + 6, 0);
+                p += kUdpHeaderSize;
+                put32(p, 0x08000000);
+                put32(p + 4, kVxlanVni << 8);
+                p += kVxlanHeaderSize;
+                p = writeEthernet(p, 1, 0, 0x0800);
+                break;
+            }
+            case Encapsulation::GRE: {
+                p = writeEthernet(p, 0, config_.syntheticVlanId, 0x0800);
+                p = writeIpv4(p, length - static_cast<size_t>(p - frame), kProtoGre, 0xac100001, 0xac100002, id);
+                put16(p, 0);
+                put16(p + 2, 0x0800);
+                p += kGreHeaderSize;
+                break;
+            }
+            default:
+                p = writeEthernet(p, 0, config_.syntheticVlanId, 0x0800);
+                break;
+        }
+
+        const size_t ipLength = length - static_cast<size_t>(p - frame);
+        p = writeIpv4(p, ipLength, flow.protocol, flow.srcIp, flow.dstIp, id);
+        writeTransport(p, ipLength - kIpv4HeaderSize, flow, rng);
+    }
+
+    arena_ = std::move(arena);
+    templates_ = std::move(templates);
+    return Result<void>::success();
+}
+
+void SyntheticBackend::generatorLoop() {
+    const uint64_t rate = config_.syntheticRatePps;
+    const uint64_t limit = config_.syntheticPacketLimit;
+    size_t batchSize = std::max<size_t>(config_.batchSize, 1);
+    if (rate > 0) {
+        // Keep bursts within about a millisecond of traffic at low rates
+        batchSize = std::min<size_t>(batchSize, std::max<uint64_t>(rate / 1000, 1));
+    }
+
+    std::vector<Packet> batch;
+    batch.reserve(batchSize);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t generated = 0;
+    size_t next = 0;
+
+    while (running_ && (limit == 0 || generated < limit)) {
+        const size_t count = limit == 0 ? batchSize : static_cast<size_t>(std::min<uint64_t>(batchSize, limit - generated));
+        auto timestamp = std::chrono::steady_clock::now();
+
+        if (rate > 0) {
+            // Absolute schedule, so oversleeping is caught up on the next batch
+            const auto due = start + std::chrono::nanoseconds(generated * 1000000000ULL / rate);
+            while (running_ && timestamp < due) {
+                std::this_thread::sleep_until(std::min(due, timestamp + kMaxPacingSleep));
+                timestamp = std::chrono::steady_clock::now();
+            }
+            if (!running_) {
+                break;
+            }
+            timestamp = due;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            auto packetTime = rate > 0 ? timestamp + std::chrono::nanoseconds(i * 1000000000ULL / rate) : timestamp;
+            batch.push_back(makePacket(templates_[next], packetTime));
+            if (++next == templates_.size()) {
+                next = 0;
+            }
+        }
+        generated += count;
+        deliver(batch);
+    }
+
+    generatorDone_ = limit != 0 && generated >= limit;
+    packetQueue_->finish();
+    BEATRICE_INFO("Synthetic generator stopped after {} packets", generated);
+}
+
+Packet SyntheticBackend::makePacket(const Template& frame, std::chrono::steady_clock::time_point timestamp) const {
+    if (zeroCopyEnabled_ && config_.enableZeroCopy) {
+        // Shares ownership of the arena, no copy and no allocation of packet data
+        return Packet(std::shared_ptr<const uint8_t[]>(arena_, arena_.get() + frame.offset), frame.length, timestamp);
+    }
+
+    auto copy = std::make_shared<uint8_t[]>(frame.length);
+    std::memcpy(copy.get(), arena_.get() + frame.offset, frame.length);
+    return Packet(copy, frame.length, timestamp);
+}
+
+void SyntheticBackend::deliver(std::vector<Packet>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    uint64_t bytes = 0;
+    for (const auto& packet : batch) {
+        bytes += packet.length();
+    }
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_.packetsCaptured += batch.size();
+        stats_.bytesCaptured += bytes;
+        stats_.lastUpdate = std::chrono::steady_clock::now();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex_);
+        if (packetCallback_) {
+            for (const auto& packet : batch) {
+                try {
+                    packetCallback_(packet);
+                } catch (const std::exception& e) {
+                    BEATRICE_ERROR("Exception in packet callback: {}", e.what());
+                }
+            }
+            // Run-to-completion: the callback consumed the batch
+            if (config_.runToCompletion) {
+                batch.clear();
+                return;
+            }
+        }
+    }
+
+    packetQueue_->push(batch);
+    batch.clear();
+}
+
+void SyntheticBackend::setLastError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    lastError_ = error;
+    BEATRICE_ERROR("{}", error);
+}
+
+// Zero-copy DMA access methods implementation
+bool SyntheticBackend::isZeroCopyEnabled() const {
+    return zeroCopyEnabled_;
+}
+
+bool SyntheticBackend::isDMAAccessEnabled() const {
+    return false;
+}
+
+Result<void> SyntheticBackend::enableZeroCopy(bool enabled) {
+    if (running_) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT,
+                                 "Cannot change zero-copy mode while running");
+    }
+
+    zeroCopyEnabled_ = enabled;
+    return Result<void>::success();
+}
+
+Result<void> SyntheticBackend::enableDMAAccess(bool enabled, const std::string& device) {
+    (void)device;
+    if (enabled) {
+        return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, "DMA access is not available for synthetic traffic");
+    }
+    return Result<void>::success();
+}
+
+Result<void> SyntheticBackend::setDMABufferSize(size_t size) {
+    (void)size;
+    return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, "DMA access is not available for synthetic traffic");
+}
+
+size_t SyntheticBackend::getDMABufferSize() const {
+    return 0;
+}
+
+std::string SyntheticBackend::getDMADevice() const {
+    return "";
+}
+
+Result<void> SyntheticBackend::allocateDMABuffers(size_t count) {
+    (void)count;
+    return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, "DMA access is not available for synthetic traffic");
+}
+
+Result<void> SyntheticBackend::freeDMABuffers() {
+    return Result<void>::success();
+}
+
+} // namespace beatrice
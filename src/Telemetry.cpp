@@ -64,6 +64,7 @@ std::string TelemetryEvent::toPrometheus() const {
         case EventType::BACKEND_ERROR: typeStr = "backend_error"; break;
         case EventType::PLUGIN_LOADED: typeStr = "plugin_loaded"; break;
         case EventType::PLUGIN_ERROR: typeStr = "plugin_error"; break;
+        case EventType::PLUGIN_BUDGET_EXCEEDED: typeStr = "plugin_budget_exceeded"; break;
         case EventType::PERFORMANCE_MEASUREMENT: typeStr = "performance_measurement"; break;
         case EventType::SYSTEM_HEALTH_CHECK: typeStr = "system_health_check"; break;
         case EventType::CUSTOM: typeStr = "custom"; break;
@@ -0,0 +1,181 @@
+#include "beatrice/UmemFrameAllocator.hpp"
+#include "beatrice/Logger.hpp"
+#include "beatrice/Metrics.hpp"
+
+namespace beatrice {
+
+std::shared_ptr<UmemFrameAllocator> UmemFrameAllocator::create(uint64_t baseAddr, size_t frameCount,
+                                                               size_t frameSize, const std::string& name,
+                                                               std::shared_ptr<void> umem) {
+    if (frameCount == 0 || frameSize == 0 || frameCount >= kNoFrame) {
+        return nullptr;
+    }
+    return std::shared_ptr<UmemFrameAllocator>(
+        new UmemFrameAllocator(baseAddr, frameCount, frameSize, name, std::move(umem)));
+}
+
+UmemFrameAllocator::UmemFrameAllocator(uint64_t baseAddr, size_t frameCount, size_t frameSize,
+                                       const std::string& name, std::shared_ptr<void> umem)
+    : baseAddr_(baseAddr)
+    , frameCount_(frameCount)
+    , frameSize_(frameSize)
+    , name_(name)
+    , umem_(std::move(umem))
+    , states_(std::make_unique<std::atomic<uint8_t>[]>(frameCount))
+    , next_(std::make_unique<uint32_t[]>(frameCount))
+    , free_(frameCount) {
+    // Lowest addresses are handed out first
+    for (size_t i = frameCount_; i > 0; --i) {
+        states_[i - 1].store(static_cast<uint8_t>(FrameState::FREE), std::memory_order_relaxed);
+        pushLocal(static_cast<uint32_t>(i - 1));
+    }
+
+    if (!name_.empty()) {
+        freeGauge_ = metrics::gauge(name_ + "_free_frames", "UMEM frames available for the fill ring");
+        applicationGauge_ = metrics::gauge(name_ + "_application_frames", "UMEM frames referenced by received packets");
+        starvationCounter_ = metrics::counter(name_ + "_starvation_total", "Times the fill ring ran dry with no free UMEM frame");
+        publishMetrics();
+    }
+}
+
+UmemFrameAllocator::~UmemFrameAllocator() = default;
+
+size_t UmemFrameAllocator::allocate(uint64_t* addrs, size_t maxFrames) {
+    size_t count = 0;
+    while (count < maxFrames) {
+        if (localFree_ == kNoFrame) {
+            // Take everything other threads have released in one go
+            localFree_ = remoteFree_.exchange(kNoFrame, std::memory_order_acquire);
+            if (localFree_ == kNoFrame) {
+                break;
+            }
+        }
+
+        const uint32_t index = localFree_;
+        localFree_ = next_[index];
+        states_[index].store(static_cast<uint8_t>(FrameState::KERNEL), std::memory_order_relaxed);
+        addrs[count++] = baseAddr_ + static_cast<uint64_t>(index) * frameSize_;
+    }
+
+    if (count > 0) {
+        free_.fetch_sub(count, std::memory_order_relaxed);
+        kernel_.fetch_add(count, std::memory_order_relaxed);
+        allocated_.fetch_add(count, std::memory_order_relaxed);
+        starved_ = false;
+    } else if (maxFrames > 0 && kernel_.load(std::memory_order_relaxed) == 0 && !starved_) {
+        // The NIC has nothing left to receive into; count each episode once
+        starved_ = true;
+        starvations_.fetch_add(1, std::memory_order_relaxed);
+        if (starvationCounter_) {
+            starvationCounter_->increment();
+        }
+    }
+
+    return count;
+}
+
+bool UmemFrameAllocator::onReceive(uint64_t addr) {
+    uint32_t index;
+    if (!frameIndex(addr, index) || !transition(index, FrameState::KERNEL, FrameState::APPLICATION)) {
+        return false;
+    }
+    kernel_.fetch_sub(1, std::memory_order_relaxed);
+    application_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void UmemFrameAllocator::release(uint64_t addr) noexcept {
+    uint32_t index;
+    if (!frameIndex(addr, index) || !transition(index, FrameState::APPLICATION, FrameState::FREE)) {
+        return;
+    }
+    application_.fetch_sub(1, std::memory_order_relaxed);
+
+    uint32_t head = remoteFree_.load(std::memory_order_relaxed);
+    do {
+        next_[index] = head;
+    } while (!remoteFree_.compare_exchange_weak(head, index,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed));
+    free_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool UmemFrameAllocator::submitTx(uint64_t addr) {
+    uint32_t index;
+    if (!frameIndex(addr, index) || !transition(index, FrameState::APPLICATION, FrameState::TX)) {
+        return false;
+    }
+    application_.fetch_sub(1, std::memory_order_relaxed);
+    tx_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void UmemFrameAllocator::onCompletion(uint64_t addr) {
+    uint32_t index;
+    if (!frameIndex(addr, index) || !transition(index, FrameState::TX, FrameState::FREE)) {
+        return;
+    }
+    tx_.fetch_sub(1, std::memory_order_relaxed);
+    pushLocal(index);
+    free_.fetch_add(1, std::memory_order_relaxed);
+}
+
+UmemFrameAllocator::FrameState UmemFrameAllocator::state(uint64_t addr) const {
+    uint32_t index;
+    if (!frameIndex(addr, index)) {
+        return FrameState::FREE;
+    }
+    return static_cast<FrameState>(states_[index].load(std::memory_order_acquire));
+}
+
+UmemFrameAllocator::Statistics UmemFrameAllocator::getStatistics() const {
+    Statistics stats;
+    stats.frameCount = frameCount_;
+    stats.frameSize = frameSize_;
+    stats.free = free_.load(std::memory_order_relaxed);
+    stats.kernel = kernel_.load(std::memory_order_relaxed);
+    stats.application = application_.load(std::memory_order_relaxed);
+    stats.tx = tx_.load(std::memory_order_relaxed);
+    stats.allocated = allocated_.load(std::memory_order_relaxed);
+    stats.starvations = starvations_.load(std::memory_order_relaxed);
+    stats.ownershipErrors = ownershipErrors_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void UmemFrameAllocator::publishMetrics() {
+    if (freeGauge_) {
+        freeGauge_->set(static_cast<double>(free_.load(std::memory_order_relaxed)));
+    }
+    if (applicationGauge_) {
+        applicationGauge_->set(static_cast<double>(application_.load(std::memory_order_relaxed)));
+    }
+}
+
+bool UmemFrameAllocator::frameIndex(uint64_t addr, uint32_t& index) const noexcept {
+    // Descriptor addresses point past the headroom, so round down to the frame
+    if (addr < baseAddr_ || (addr - baseAddr_) / frameSize_ >= frameCount_) {
+        ownershipErrors_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    index = static_cast<uint32_t>((addr - baseAddr_) / frameSize_);
+    return true;
+}
+
+bool UmemFrameAllocator::transition(uint32_t index, FrameState from, FrameState to) noexcept {
+    uint8_t expected = static_cast<uint8_t>(from);
+    if (!states_[index].compare_exchange_strong(expected, static_cast<uint8_t>(to),
+                                                std::memory_order_acq_rel)) {
+        ownershipErrors_.fetch_add(1, std::memory_order_relaxed);
+        BEATRICE_DEBUG("UMEM frame {} of {}: expected state {}, found {}",
+                       index, name_, static_cast<int>(from), static_cast<int>(expected));
+        return false;
+    }
+    return true;
+}
+
+void UmemFrameAllocator::pushLocal(uint32_t index) noexcept {
+    next_[index] = localFree_;
+    localFree_ = index;
+}
+
+} // namespace beatrice
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <algorithm>
 #include <cstring>
 #include <unistd.h>
 #include <fcntl.h>
@@ -14,9 +15,42 @@
 #include <bpf/bpf.h>
 #include <bpf/libbpf.h>
 #include <errno.h>
+#include <arpa/inet.h>
 
 namespace beatrice {
 
+namespace {
+
+// Layout of struct filter_rules in xdp_program.c
+constexpr uint32_t kFilterProtocols = 1u << 0;
+constexpr uint32_t kFilterNetworks = 1u << 1;
+constexpr uint32_t kFilterPorts = 1u << 2;
+
+struct XdpFilterRules {
+    uint32_t flags;
+    uint8_t protocols[256 / 8];
+    uint8_t ports[65536 / 8];
+};
+
+struct XdpNetworkKey {
+    uint32_t prefixLength;
+    uint32_t address;                    // network byte order
+};
+
+void setBit(uint8_t* bitmap, uint32_t bit) {
+    bitmap[bit >> 3] |= static_cast<uint8_t>(1u << (bit & 7));
+}
+
+void closeFilterMaps(const XDPLoader::FilterMaps& maps) {
+    for (int fd : {maps.rules, maps.active, maps.networks, maps.stats}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+} // anonymous namespace
+
 XDPLoader::XDPLoader() {
     BEATRICE_INFO("=== XDPLoader constructor called ===");
     BEATRICE_DEBUG("XDPLoader created");
@@ -45,7 +79,9 @@ Result<void> XDPLoader::loadProgram(const Config& config) {
     try {
         // STEP 1: Load BPF program into kernel
         BEATRICE_INFO("STEP 1: Loading BPF program into kernel...");
-        auto programFdResult = loadBpfProgram(config.programPath, config.programName);
+        int xskMapFd = -1;
+        FilterMaps filterMaps;
+        auto programFdResult = loadBpfProgram(config.programPath, config.programName, xskMapFd, filterMaps);
         if (!programFdResult.isSuccess()) {
             BEATRICE_ERROR("Failed to load BPF program: {}", programFdResult.getErrorMessage());
             return Result<void>::error(programFdResult.getErrorCode(), 
@@ -55,19 +91,25 @@ Result<void> XDPLoader::loadProgram(const Config& config) {
         int programFd = programFdResult.getValue();
         BEATRICE_INFO("STEP 1: BPF program loaded successfully, FD: {}", programFd);
         
-        // STEP 2: Create BPF map for XSK
-        BEATRICE_INFO("STEP 2: Creating BPF map for XSK...");
-        auto mapFdResult = createBpfMap();
-        if (!mapFdResult.isSuccess()) {
-            BEATRICE_ERROR("Failed to create BPF map: {}", mapFdResult.getErrorMessage());
-            close(programFd);
-            return Result<void>::error(mapFdResult.getErrorCode(), 
-                                     "Failed to create BPF map: " + mapFdResult.getErrorMessage());
+        // STEP 2: Use the program's own XSKMAP so queue sockets registered
+        // later are the ones it redirects to; create one only as a fallback
+        int mapFd = xskMapFd;
+        if (mapFd >= 0) {
+            BEATRICE_INFO("STEP 2: Using XSK map from BPF object, FD: {}", mapFd);
+        } else {
+            BEATRICE_INFO("STEP 2: Creating BPF map for XSK...");
+            auto mapFdResult = createBpfMap(config.maxQueues);
+            if (!mapFdResult.isSuccess()) {
+                BEATRICE_ERROR("Failed to create BPF map: {}", mapFdResult.getErrorMessage());
+                close(programFd);
+                return Result<void>::error(mapFdResult.getErrorCode(), 
+                                         "Failed to create BPF map: " + mapFdResult.getErrorMessage());
+            }
+            
+            mapFd = mapFdResult.getValue();
+            BEATRICE_INFO("STEP 2: BPF map created successfully, FD: {}", mapFd);
         }
         
-        int mapFd = mapFdResult.getValue();
-        BEATRICE_INFO("STEP 2: BPF map created successfully, FD: {}", mapFd);
-        
         // STEP 3: Pin program and map to BPF filesystem
         BEATRICE_INFO("STEP 3: Pinning program and map to BPF filesystem...");
         auto pinProgramResult = pinProgram(config.programName, programFd);
@@ -96,6 +138,7 @@ Result<void> XDPLoader::loadProgram(const Config& config) {
         ProgramInfo programInfo;
         programInfo.programFd = programFd;
         programInfo.mapFd = mapFd;
+        programInfo.filterMaps = filterMaps;
         programInfo.programName = config.programName;
         programInfo.interface = config.interface;
         programInfo.isAttached = false;
@@ -225,6 +268,7 @@ Result<void> XDPLoader::unloadProgram(const std::string& programName) {
         if (programInfo->mapFd >= 0) {
             close(programInfo->mapFd);
         }
+        closeFilterMaps(programInfo->filterMaps);
         
         // Remove pinned files
         removeBpfFile(programInfo->pinPath);
@@ -249,6 +293,142 @@ Result<void> XDPLoader::unloadProgram(const std::string& programName) {
     }
 }
 
+Result<void> XDPLoader::registerXskSocket(const std::string& programName, uint32_t queueId, int xskFd) {
+    auto programInfo = getProgramInfo(programName);
+    if (!programInfo || programInfo->mapFd < 0) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, 
+                                 "No XSK map for program " + programName);
+    }
+    
+    if (bpf_map_update_elem(programInfo->mapFd, &queueId, &xskFd, BPF_ANY) < 0) {
+        return Result<void>::error(ErrorCode::INTERNAL_ERROR, 
+                                 "Failed to update XSK map entry " + std::to_string(queueId) + ": " + std::string(strerror(errno)));
+    }
+    
+    BEATRICE_DEBUG("Queue {} redirected to AF_XDP socket {}", queueId, xskFd);
+    return Result<void>::success();
+}
+
+Result<void> XDPLoader::unregisterXskSocket(const std::string& programName, uint32_t queueId) {
+    auto programInfo = getProgramInfo(programName);
+    if (!programInfo || programInfo->mapFd < 0) {
+        return Result<void>::success();
+    }
+    
+    if (bpf_map_delete_elem(programInfo->mapFd, &queueId) < 0 && errno != ENOENT) {
+        return Result<void>::error(ErrorCode::INTERNAL_ERROR, 
+                                 "Failed to delete XSK map entry " + std::to_string(queueId) + ": " + std::string(strerror(errno)));
+    }
+    
+    return Result<void>::success();
+}
+
+Result<void> XDPLoader::setFilterRules(const std::string& programName, const FilterRules& rules) {
+    auto programInfo = getProgramInfo(programName);
+    if (!programInfo) {
+        return Result<void>::error(ErrorCode::INVALID_ARGUMENT, "Program not found: " + programName);
+    }
+    
+    const FilterMaps& maps = programInfo->filterMaps;
+    if (maps.rules < 0 || maps.active < 0 || maps.networks < 0) {
+        return Result<void>::error(ErrorCode::NOT_IMPLEMENTED, 
+                                 "Program " + programName + " has no filter maps");
+    }
+    
+    // Add the new networks first, the old table ignores them
+    std::vector<XdpNetworkKey> wanted;
+    for (const auto& [address, length] : rules.networks) {
+        uint8_t prefixLength = std::min<uint8_t>(length, 32);
+        uint32_t mask = prefixLength == 0 ? 0 : 0xFFFFFFFFu << (32 - prefixLength);
+        XdpNetworkKey key{prefixLength, htonl(address & mask)};
+        uint8_t allowed = 1;
+        if (bpf_map_update_elem(maps.networks, &key, &allowed, BPF_ANY) < 0) {
+            return Result<void>::error(ErrorCode::INTERNAL_ERROR, 
+                                     "Failed to add filter network: " + std::string(strerror(errno)));
+        }
+        wanted.push_back(key);
+    }
+    
+    XdpFilterRules table{};
+    if (rules.matchProtocols) {
+        table.flags |= kFilterProtocols;
+        for (uint8_t protocol : rules.protocols) {
+            setBit(table.protocols, protocol);
+        }
+    }
+    if (rules.matchNetworks) {
+        table.flags |= kFilterNetworks;
+    }
+    if (rules.matchPorts) {
+        table.flags |= kFilterPorts;
+        for (const auto& [low, high] : rules.portRanges) {
+            for (uint32_t port = low; port <= high; ++port) {
+                setBit(table.ports, port);
+            }
+        }
+    }
+    
+    // Write the idle table, then make it the live one
+    uint32_t zero = 0;
+    uint32_t active = 0;
+    bpf_map_lookup_elem(maps.active, &zero, &active);
+    uint32_t next = (active & 1) ^ 1;
+    if (bpf_map_update_elem(maps.rules, &next, &table, BPF_ANY) < 0 ||
+        bpf_map_update_elem(maps.active, &zero, &next, BPF_ANY) < 0) {
+        return Result<void>::error(ErrorCode::INTERNAL_ERROR, 
+                                 "Failed to update filter rules: " + std::string(strerror(errno)));
+    }
+    
+    // Remove networks the live table no longer allows
+    std::vector<XdpNetworkKey> stale;
+    XdpNetworkKey key{};
+    XdpNetworkKey nextKey{};
+    void* previous = nullptr;
+    while (bpf_map_get_next_key(maps.networks, previous, &nextKey) == 0) {
+        bool keep = std::any_of(wanted.begin(), wanted.end(), [&](const XdpNetworkKey& w) {
+            return w.prefixLength == nextKey.prefixLength && w.address == nextKey.address;
+        });
+        if (!keep) {
+            stale.push_back(nextKey);
+        }
+        key = nextKey;
+        previous = &key;
+    }
+    for (auto& staleKey : stale) {
+        bpf_map_delete_elem(maps.networks, &staleKey);
+    }
+    
+    BEATRICE_INFO("XDP filter rules of {} updated: {} protocols, {} networks, {} port ranges", programName,
+                  rules.matchProtocols ? std::to_string(rules.protocols.size()) : "all",
+                  rules.matchNetworks ? std::to_string(rules.networks.size()) : "all",
+                  rules.matchPorts ? std::to_string(rules.portRanges.size()) : "all");
+    return Result<void>::success();
+}
+
+uint64_t XDPLoader::getFilteredPacketCount(const std::string& programName) const {
+    auto programInfo = getProgramInfo(programName);
+    if (!programInfo || programInfo->filterMaps.stats < 0) {
+        return 0;
+    }
+    
+    int cpus = libbpf_num_possible_cpus();
+    if (cpus <= 0) {
+        return 0;
+    }
+    
+    uint32_t zero = 0;
+    std::vector<uint64_t> perCpu(static_cast<size_t>(cpus));
+    if (bpf_map_lookup_elem(programInfo->filterMaps.stats, &zero, perCpu.data()) < 0) {
+        return 0;
+    }
+    
+    uint64_t total = 0;
+    for (uint64_t count : perCpu) {
+        total += count;
+    }
+    return total;
+}
+
 std::optional<XDPLoader::ProgramInfo> XDPLoader::getProgramInfo(const std::string& programName) const {
     std::lock_guard<std::mutex> lock(programsMutex_);
     
@@ -299,6 +479,7 @@ void XDPLoader::cleanup() {
             if (program.mapFd >= 0) {
                 close(program.mapFd);
             }
+            closeFilterMaps(program.filterMaps);
         } catch (const std::exception& e) {
             BEATRICE_ERROR("Exception during cleanup of program {}: {}", program.programName, e.what());
         }
@@ -309,7 +490,8 @@ void XDPLoader::cleanup() {
 
 // Private implementation methods
 
-Result<int> XDPLoader::loadBpfProgram(const std::string& programPath, const std::string& programName) {
+Result<int> XDPLoader::loadBpfProgram(const std::string& programPath, const std::string& programName, int& xskMapFd,
+                                      FilterMaps& filterMaps) {
     BEATRICE_DEBUG("Loading BPF program from: {} with name: {}", programPath, programName);
     
     // Load BPF program using libbpf
@@ -368,6 +550,21 @@ Result<int> XDPLoader::loadBpfProgram(const std::string& programPath, const std:
     
     BEATRICE_DEBUG("Program file descriptor obtained: {}", progFd);
     
+    // The program redirects through its own XSKMAP, indexed by RX queue
+    xskMapFd = bpf_object__find_map_fd_by_name(obj, "xsks_map");
+    if (xskMapFd < 0) {
+        BEATRICE_WARN("BPF object has no xsks_map, a standalone XSK map will be used");
+    }
+    
+    // Rule tables of the generic program, custom programs may not have them
+    filterMaps.rules = bpf_object__find_map_fd_by_name(obj, "filter_rules");
+    filterMaps.active = bpf_object__find_map_fd_by_name(obj, "filter_active");
+    filterMaps.networks = bpf_object__find_map_fd_by_name(obj, "filter_networks");
+    filterMaps.stats = bpf_object__find_map_fd_by_name(obj, "filter_stats");
+    if (filterMaps.rules < 0 || filterMaps.active < 0 || filterMaps.networks < 0) {
+        BEATRICE_DEBUG("BPF object has no filter maps, filters stay in user space");
+    }
+    
     // Store the object for later cleanup
     // Note: In a production system, you'd want to manage this more carefully
     // For now, we'll keep it simple and let the kernel handle cleanup
@@ -375,9 +572,9 @@ Result<int> XDPLoader::loadBpfProgram(const std::string& programPath, const std:
     return Result<int>::success(progFd);
 }
 
-Result<int> XDPLoader::createBpfMap() {
-    // Create XSK map for redirecting packets to user space
-    int mapFd = bpf_map_create(BPF_MAP_TYPE_XSKMAP, nullptr, sizeof(int), sizeof(int), 1, nullptr);
+Result<int> XDPLoader::createBpfMap(uint32_t maxEntries) {
+    // Create XSK map for redirecting packets to user space, one entry per RX queue
+    int mapFd = bpf_map_create(BPF_MAP_TYPE_XSKMAP, nullptr, sizeof(int), sizeof(int), maxEntries, nullptr);
     if (mapFd < 0) {
         return Result<int>::error(ErrorCode::INITIALIZATION_FAILED, 
                                  "Failed to create XSK map: " + std::string(strerror(errno)));
@@ -3,6 +3,8 @@
 #include "beatrice/DPDKBackend.hpp"
 #include "beatrice/PMDBackend.hpp"
 #include "beatrice/AF_PacketBackend.hpp"
+#include "beatrice/PcapFileBackend.hpp"
+#include "beatrice/SyntheticBackend.hpp"
 #include "beatrice/PluginManager.hpp"
 #include "beatrice/Logger.hpp"
 #include "beatrice/Config.hpp"
@@ -71,8 +73,8 @@ void printCaptureHelp() {
     std::cout << "Capture Command - Capture network packets\n\n"
               << "Usage: beatrice capture [OPTIONS]\n\n"
               << "Options:\n"
-              << "  -b, --backend=BACKEND    Backend to use (af_packet, dpdk, pmd, af_xdp)\n"
-              << "  -i, --interface=IFACE    Network interface to capture from\n"
+              << "  -b, --backend=BACKEND    Backend to use (af_packet, dpdk, pmd, af_xdp, pcap)\n"
+              << "  -i, --interface=IFACE    Network interface to capture from (capture file for pcap)\n"
               << "  -d, --duration=SECONDS   Capture duration in seconds (0 = infinite)\n"
               << "  -c, --count=COUNT        Maximum packets to capture\n"
               << "  -s, --size=SIZE          Capture buffer size in bytes\n"
@@ -82,6 +84,18 @@ void printCaptureHelp() {
               << "  --dma-device=DEVICE      DMA device for zero-copy\n"
               << "  --dma-buffer-size=SIZE  DMA buffer size in bytes\n"
               << "  --dma-buffer-count=CNT  Number of DMA buffers\n"
+              << "  --rx-ring                Receive through a TPACKET_V3 ring (af_packet)\n"
+              << "  --fanout=N               Spread capture over N PACKET_FANOUT sockets (af_packet)\n"
+              << "  --fanout-mode=MODE       Fanout distribution (hash, cpu, lb, rollover)\n"
+              << "  --xdp-queues=N           Bind N NIC RX queues, 0 = all (af_xdp)\n"
+              << "  --xdp-per-queue-umem     Give every queue its own UMEM (af_xdp)\n"
+              << "  --busy-poll              Busy-poll the NIC instead of sleeping (af_xdp)\n"
+              << "  --busy-poll-budget=N     Packets per busy-poll call (af_xdp)\n"
+              << "  --no-need-wakeup         Do not bind with XDP_USE_NEED_WAKEUP (af_xdp)\n"
+              << "  --rx-queues=N            RSS receive queues, one worker each (dpdk)\n"
+              << "  --no-symmetric-rss       Keep the driver's RSS key (dpdk)\n"
+              << "  --queue-depth=N          Packets buffered per backend queue (default: num buffers)\n"
+              << "  --queue-policy=POLICY    Full queue behaviour (drop-newest, drop-oldest, block)\n"
               "  --output-file=FILE        Save captured packets to file\n"
               << "  --filter=EXPR           BPF filter expression\n"
               << "  --stats-interval=SEC    Statistics update interval\n\n"
@@ -95,7 +109,7 @@ void printBenchmarkHelp() {
     std::cout << "Benchmark Command - Run performance benchmarks\n\n"
               << "Usage: beatrice benchmark [OPTIONS]\n\n"
               << "Options:\n"
-              << "  -b, --backend=BACKEND    Backend to benchmark\n"
+              << "  -b, --backend=BACKEND    Backend to benchmark (all, synthetic, af_packet, dpdk, pmd, af_xdp)\n"
               << "  -i, --interface=IFACE    Network interface to use\n"
               << "  -p, --packets=COUNT      Number of packets to process\n"
               << "  -s, --size=SIZE          Packet size in bytes\n"
@@ -103,10 +117,28 @@ void printBenchmarkHelp() {
               << "  -d, --duration=SECONDS   Benchmark duration\n"
               << "  --zero-copy              Enable zero-copy mode\n"
               << "  --dma-access             Enable DMA access\n"
+              << "  --ring-block-size=BYTES  TPACKET_V3 block size for the af_packet ring run\n"
+              << "  --ring-block-count=N     TPACKET_V3 block count for the af_packet ring run\n"
+              << "  --ring-frame-size=BYTES  TPACKET_V3 frame size for the af_packet ring run\n"
+              << "  --flows=N                Distinct flows to generate (synthetic)\n"
+              << "  --size-dist=DIST         Frame sizes: fixed, imix, pareto (synthetic, default imix)\n"
+              << "  --rate=PPS               Target rate, 0 = unthrottled (synthetic)\n"
+              << "  --tcp-percent=N          Share of TCP flows (synthetic)\n"
+              << "  --udp-percent=N          Share of UDP flows, the rest is ICMP (synthetic)\n"
+              << "  --vlan=ID                Tag generated frames with an 802.1Q VLAN (synthetic)\n"
+              << "  --encap=TYPE             Tunnel generated frames: none, vxlan, gre (synthetic)\n"
+              << "  --seed=N                 Seed for reproducible traffic (synthetic)\n"
               << "  --output-format=FORMAT   Output format (text, json, csv)\n"
               << "  --save-results=FILE      Save benchmark results to file\n\n"
+              << "The af_packet backend captures live traffic on the interface twice, once\n"
+              << "through recv() and once through the TPACKET_V3 ring, and reports both\n"
+              << "rates. Generate load meanwhile, e.g. with ping -f or iperf3 on lo.\n"
+              << "The synthetic backend generates traffic itself and needs neither a NIC\n"
+              << "nor root; --size selects fixed-size frames unless --size-dist is given.\n\n"
               << "Examples:\n"
               << "  beatrice benchmark --backend all --packets 1000000\n"
+              << "  beatrice benchmark --backend=synthetic --packets=10000000 --flows=4096 --size-dist=imix\n"
+              << "  beatrice benchmark --backend af_packet --interface lo --duration 10\n"
               << "  beatrice benchmark --backend dpdk --interface eth0 --duration 30\n";
 }
 
@@ -141,22 +173,21 @@ void printInfoHelp() {
 }
 
 void printReplayHelp() {
-    std::cout << "Replay Command - Replay packets from PCAP file\n\n"
+    std::cout << "Replay Command - Replay packets from a pcap or pcapng file\n\n"
               << "Usage: beatrice replay [OPTIONS]\n\n"
               << "Options:\n"
-              << "  -f, --file=FILE          PCAP file to replay\n"
-              << "  -i, --interface=IFACE    Network interface to replay to\n"
-              << "  -r, --rate=RATE          Replay rate (packets per second, 0 = as fast as possible)\n"
-              << "  --loop=COUNT               Number of times to loop the file (0 = infinite)\n"
-              << "  -d, --delay=MS           Delay between packets in milliseconds\n"
-              << "  -s, --speed=FACTOR       Speed factor (1.0 = normal, 2.0 = 2x faster)\n"
-              << "  --filter=EXPR            BPF filter expression\n"
+              << "  -f, --file=FILE          pcap or pcapng file to replay\n"
+              << "  -s, --speed=FACTOR       Speed factor on recorded timestamps (1.0 = recorded pace, 2.0 = 2x faster)\n"
+              << "  --fast                   Ignore timestamps and replay as fast as packets are consumed\n"
+              << "  --loop=COUNT             Number of times to loop the file (0 = infinite)\n"
+              << "  --batch-size=N           Packets handed over per batch\n"
+              << "  --no-zero-copy           Copy packets out of the mapped file\n"
               << "  --output-file=FILE       Save replay statistics to file\n"
               << "  --stats-interval=SEC     Statistics update interval\n\n"
               << "Examples:\n"
-              << "  beatrice replay --file capture.pcap --interface eth0\n"
-              << "  beatrice replay --file capture.pcap --interface lo --rate 1000\n"
-              << "  beatrice replay --file capture.pcap --interface dpdk_tap0 --loop 5\n";
+              << "  beatrice replay --file capture.pcap\n"
+              << "  beatrice replay --file capture.pcapng --speed=10\n"
+              << "  beatrice replay --file capture.pcap --fast --loop=5\n";
 }
 
 void printConfigHelp() {
@@ -286,6 +317,10 @@ std::unique_ptr<ICaptureBackend> createBackend(const std::string& backendType) {
         return std::make_unique<PMDBackend>();
     } else if (backendType == "af_xdp") {
         return std::make_unique<AF_XDPBackend>();
+    } else if (backendType == "pcap") {
+        return std::make_unique<PcapFileBackend>();
+    } else if (backendType == "synthetic") {
+        return std::make_unique<SyntheticBackend>();
     } else {
         throw std::runtime_error("Unknown backend type: " + backendType);
     }
@@ -328,6 +363,104 @@ void configureBackend(ICaptureBackend* backend, const std::map<std::string, std:
             config.dmaBufferSize = std::stoul(value);
         } else if (key == "dma_device") {
             config.dmaDevice = value;
+        } else if (key == "rx_ring") {
+            config.enableRxRing = (value == "true" || value == "1");
+        } else if (key == "ring_block_size") {
+            config.ringBlockSize = std::stoul(value);
+        } else if (key == "ring_block_count") {
+            config.ringBlockCount = std::stoul(value);
+        } else if (key == "ring_frame_size") {
+            config.ringFrameSize = std::stoul(value);
+        } else if (key == "ring_block_timeout") {
+            config.ringBlockTimeoutMs = std::stoi(value);
+        } else if (key == "xdp_queues") {
+            config.xdpQueueCount = std::stoul(value);
+        } else if (key == "xdp_first_queue") {
+            config.xdpFirstQueue = std::stoul(value);
+        } else if (key == "xdp_shared_umem") {
+            config.xdpSharedUmem = (value == "true" || value == "1");
+        } else if (key == "xdp_need_wakeup") {
+            config.xdpNeedWakeup = (value == "true" || value == "1");
+        } else if (key == "busy_poll") {
+            config.busyPoll = (value == "true" || value == "1");
+        } else if (key == "busy_poll_timeout") {
+            config.busyPollTimeoutUs = std::stoi(value);
+        } else if (key == "busy_poll_budget") {
+            config.busyPollBudget = std::stoi(value);
+        } else if (key == "rx_queues") {
+            config.rxQueues = std::stoul(value);
+        } else if (key == "symmetric_rss") {
+            config.symmetricRss = (value == "true" || value == "1");
+        } else if (key == "capture_file") {
+            config.captureFile = value;
+        } else if (key == "replay_speed") {
+            config.replaySpeed = std::stod(value);
+        } else if (key == "replay_loops") {
+            config.replayLoops = std::stoul(value);
+        } else if (key == "flows") {
+            config.syntheticFlows = std::stoul(value);
+        } else if (key == "size_distribution") {
+            if (value == "fixed") {
+                config.syntheticSizeDistribution = ICaptureBackend::PacketSizeDistribution::FIXED;
+            } else if (value == "imix") {
+                config.syntheticSizeDistribution = ICaptureBackend::PacketSizeDistribution::IMIX;
+            } else if (value == "pareto") {
+                config.syntheticSizeDistribution = ICaptureBackend::PacketSizeDistribution::PARETO;
+            } else {
+                throw std::runtime_error("Unknown size distribution: " + value);
+            }
+        } else if (key == "packet_size") {
+            config.syntheticPacketSize = std::stoul(value);
+        } else if (key == "pareto_shape") {
+            config.syntheticParetoShape = std::stod(value);
+        } else if (key == "tcp_percent") {
+            config.syntheticTcpPercent = std::stoul(value);
+        } else if (key == "udp_percent") {
+            config.syntheticUdpPercent = std::stoul(value);
+        } else if (key == "vlan_id") {
+            config.syntheticVlanId = static_cast<uint16_t>(std::stoul(value));
+        } else if (key == "encapsulation") {
+            if (value == "none") {
+                config.syntheticEncapsulation = ICaptureBackend::Encapsulation::NONE;
+            } else if (value == "vxlan") {
+                config.syntheticEncapsulation = ICaptureBackend::Encapsulation::VXLAN;
+            } else if (value == "gre") {
+                config.syntheticEncapsulation = ICaptureBackend::Encapsulation::GRE;
+            } else {
+                throw std::runtime_error("Unknown encapsulation: " + value);
+            }
+        } else if (key == "rate_pps") {
+            config.syntheticRatePps = std::stoull(value);
+        } else if (key == "packet_limit") {
+            config.syntheticPacketLimit = std::stoull(value);
+        } else if (key == "seed") {
+            config.syntheticSeed = std::stoull(value);
+        } else if (key == "queue_depth") {
+            config.queueDepth = std::stoul(value);
+        } else if (key == "queue_policy") {
+            if (value == "drop-newest") {
+                config.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::DROP_NEWEST;
+            } else if (value == "drop-oldest") {
+                config.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::DROP_OLDEST;
+            } else if (value == "block") {
+                config.queueOverflowPolicy = ICaptureBackend::OverflowPolicy::BLOCK;
+            } else {
+                throw std::runtime_error("Unknown queue policy: " + value);
+            }
+        } else if (key == "fanout_sockets") {
+            config.fanoutSockets = std::stoul(value);
+        } else if (key == "fanout_mode") {
+            if (value == "hash") {
+                config.fanoutMode = ICaptureBackend::FanoutMode::HASH;
+            } else if (value == "cpu") {
+                config.fanoutMode = ICaptureBackend::FanoutMode::CPU;
+            } else if (value == "lb") {
+                config.fanoutMode = ICaptureBackend::FanoutMode::LOAD_BALANCE;
+            } else if (value == "rollover") {
+                config.fanoutMode = ICaptureBackend::FanoutMode::ROLLOVER;
+            } else {
+                throw std::runtime_error("Unknown fanout mode: " + value);
+            }
         }
     }
     
@@ -390,6 +523,31 @@ void captureCommand(const std::vector<std::string>& args) {
             options["dma_buffer_size"] = args[i].substr(18);
         } else if (args[i].substr(0, 19) == "--dma-buffer-count=") {
             // Handle DMA buffer count
+        } else if (args[i] == "--rx-ring") {
+            options["rx_ring"] = "true";
+        } else if (args[i].rfind("--fanout=", 0) == 0) {
+            options["fanout_sockets"] = args[i].substr(9);
+        } else if (args[i].rfind("--fanout-mode=", 0) == 0) {
+            options["fanout_mode"] = args[i].substr(14);
+        } else if (args[i].rfind("--xdp-queues=", 0) == 0) {
+            options["xdp_queues"] = args[i].substr(13);
+        } else if (args[i] == "--xdp-per-queue-umem") {
+            options["xdp_shared_umem"] = "false";
+        } else if (args[i] == "--busy-poll") {
+            options["busy_poll"] = "true";
+        } else if (args[i].rfind("--busy-poll-budget=", 0) == 0) {
+            options["busy_poll"] = "true";
+            options["busy_poll_budget"] = args[i].substr(19);
+        } else if (args[i] == "--no-need-wakeup") {
+            options["xdp_need_wakeup"] = "false";
+        } else if (args[i].rfind("--rx-queues=", 0) == 0) {
+            options["rx_queues"] = args[i].substr(12);
+        } else if (args[i] == "--no-symmetric-rss") {
+            options["symmetric_rss"] = "false";
+        } else if (args[i].rfind("--queue-depth=", 0) == 0) {
+            options["queue_depth"] = args[i].substr(14);
+        } else if (args[i].rfind("--queue-policy=", 0) == 0) {
+            options["queue_policy"] = args[i].substr(15);
         } else if (args[i].substr(0, 12) == "--output-file=") {
             outputFile = args[i].substr(12);
         } else if (args[i].substr(0, 9) == "--filter=") {
@@ -491,6 +649,44 @@ void captureCommand(const std::vector<std::string>& args) {
     }
 }
 
+struct CaptureRun {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t dropped = 0;
+    double seconds = 0.0;
+    
+    double packetsPerSecond() const { return seconds > 0.0 ? packets / seconds : 0.0; }
+};
+
+// Drain a live backend through getPackets() for the given time or packet count
+CaptureRun measureCapture(const std::string& backendType, std::map<std::string, std::string> options,
+                          std::chrono::seconds duration, uint64_t maxPackets = 0) {
+    auto backend = createBackend(backendType);
+    configureBackend(backend.get(), options);
+    
+    auto result = backend->start();
+    if (!result.isSuccess()) {
+        throw std::runtime_error("Failed to start backend: " + result.getErrorMessage());
+    }
+    
+    CaptureRun run;
+    auto startTime = std::chrono::steady_clock::now();
+    auto endTime = startTime + duration;
+    
+    while (g_running && std::chrono::steady_clock::now() < endTime && (maxPackets == 0 || run.packets < maxPackets)) {
+        auto packets = backend->getPackets(256, std::chrono::milliseconds(50));
+        run.packets += packets.size();
+        for (const auto& packet : packets) {
+            run.bytes += packet.size();
+        }
+    }
+    
+    run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    backend->stop();
+    run.dropped = backend->getStatistics().packetsDropped;
+    return run;
+}
+
 void benchmarkCommand(const std::vector<std::string>& args) {
     std::map<std::string, std::string> options;
     std::string backendType = "all";
@@ -503,32 +699,56 @@ void benchmarkCommand(const std::vector<std::string>& args) {
     bool enableDMAAccess = false;
     std::string outputFormat = "text";
     std::string outputFile = "";
+    bool sizeGiven = false;
     
     // Parse options
     for (size_t i = 0; i < args.size(); ++i) {
         if (args[i] == "--help" || args[i] == "-h") {
             printBenchmarkHelp();
             return;
-        } else if (args[i].substr(0, 9) == "--backend=") {
-            backendType = args[i].substr(9);
+        } else if (args[i].rfind("--backend=", 0) == 0) {
+            backendType = args[i].substr(10);
         } else if (args[i].substr(0, 12) == "--interface=") {
             interface = args[i].substr(12);
         } else if (args[i].substr(0, 10) == "--packets=") {
             packetCount = std::stoi(args[i].substr(10));
         } else if (args[i].substr(0, 7) == "--size=") {
             packetSize = std::stoi(args[i].substr(7));
-        } else if (args[i].substr(0, 9) == "--threads=") {
-            numThreads = std::stoi(args[i].substr(9));
+            sizeGiven = true;
+        } else if (args[i].rfind("--threads=", 0) == 0) {
+            numThreads = std::stoi(args[i].substr(10));
         } else if (args[i].substr(0, 11) == "--duration=") {
             duration = std::stoi(args[i].substr(11));
         } else if (args[i] == "--zero-copy") {
             enableZeroCopy = true;
         } else if (args[i] == "--dma-access") {
             enableDMAAccess = true;
-        } else if (args[i].substr(0, 15) == "--output-format=") {
-            outputFormat = args[i].substr(15);
-        } else if (args[i].substr(0, 16) == "--save-results=") {
-            outputFile = args[i].substr(16);
+        } else if (args[i].rfind("--output-format=", 0) == 0) {
+            outputFormat = args[i].substr(16);
+        } else if (args[i].rfind("--save-results=", 0) == 0) {
+            outputFile = args[i].substr(15);
+        } else if (args[i].rfind("--ring-block-size=", 0) == 0) {
+            options["ring_block_size"] = args[i].substr(18);
+        } else if (args[i].rfind("--ring-block-count=", 0) == 0) {
+            options["ring_block_count"] = args[i].substr(19);
+        } else if (args[i].rfind("--ring-frame-size=", 0) == 0) {
+            options["ring_frame_size"] = args[i].substr(18);
+        } else if (args[i].rfind("--flows=", 0) == 0) {
+            options["flows"] = args[i].substr(8);
+        } else if (args[i].rfind("--size-dist=", 0) == 0) {
+            options["size_distribution"] = args[i].substr(12);
+        } else if (args[i].rfind("--rate=", 0) == 0) {
+            options["rate_pps"] = args[i].substr(7);
+        } else if (args[i].rfind("--tcp-percent=", 0) == 0) {
+            options["tcp_percent"] = args[i].substr(14);
+        } else if (args[i].rfind("--udp-percent=", 0) == 0) {
+            options["udp_percent"] = args[i].substr(14);
+        } else if (args[i].rfind("--vlan=", 0) == 0) {
+            options["vlan_id"] = args[i].substr(7);
+        } else if (args[i].rfind("--encap=", 0) == 0) {
+            options["encapsulation"] = args[i].substr(8);
+        } else if (args[i].rfind("--seed=", 0) == 0) {
+            options["seed"] = args[i].substr(7);
         }
     }
     
@@ -545,7 +765,7 @@ void benchmarkCommand(const std::vector<std::string>& args) {
     
     std::vector<std::string> backends;
     if (backendType == "all") {
-        backends = {"af_packet", "dpdk", "pmd", "af_xdp"};
+        backends = {"synthetic", "af_packet", "dpdk", "pmd", "af_xdp"};
     } else {
         backends = {backendType};
     }
@@ -556,8 +776,6 @@ void benchmarkCommand(const std::vector<std::string>& args) {
         try {
             std::cout << "\n--- Benchmarking " << backendName << " Backend ---" << std::endl;
             
-            auto backend = createBackend(backendName);
-            
             // Configure backend
             options["interface"] = interface;
             if (enableZeroCopy) {
@@ -567,6 +785,86 @@ void benchmarkCommand(const std::vector<std::string>& args) {
                 options["dma_access"] = "true";
             }
             
+            if (backendName == "af_packet") {
+                // Live capture: recv() path against the TPACKET_V3 ring on the same traffic
+                auto phase = std::chrono::seconds(std::max(1, duration / 2));
+                
+                auto recvOptions = options;
+                recvOptions["rx_ring"] = "false";
+                std::cout << "Capturing with recv() for " << phase.count() << "s..." << std::endl;
+                CaptureRun recvRun = measureCapture(backendName, recvOptions, phase);
+                
+                auto ringOptions = options;
+                ringOptions["rx_ring"] = "true";
+                std::cout << "Capturing with TPACKET_V3 ring for " << phase.count() << "s..." << std::endl;
+                CaptureRun ringRun = measureCapture(backendName, ringOptions, phase);
+                
+                double recvPps = recvRun.packetsPerSecond();
+                double ringPps = ringRun.packetsPerSecond();
+                double deltaPercent = recvPps > 0.0 ? (ringPps - recvPps) * 100.0 / recvPps : 0.0;
+                double throughputMbps = ringRun.seconds > 0.0 ? ringRun.bytes * 8.0 / (1000000.0 * ringRun.seconds) : 0.0;
+                auto durationMs = static_cast<long>((recvRun.seconds + ringRun.seconds) * 1000.0);
+                
+                std::map<std::string, std::string> result;
+                result["backend"] = backendName;
+                result["packets_per_second"] = std::to_string(ringPps);
+                result["throughput_mbps"] = std::to_string(throughputMbps);
+                result["latency_ms"] = std::to_string(ringRun.packets > 0 ? ringRun.seconds * 1000.0 / ringRun.packets : 0.0);
+                result["total_packets"] = std::to_string(recvRun.packets + ringRun.packets);
+                result["total_bytes"] = std::to_string(recvRun.bytes + ringRun.bytes);
+                result["duration_ms"] = std::to_string(durationMs);
+                result["recv_packets_per_second"] = std::to_string(recvPps);
+                result["ring_packets_per_second"] = std::to_string(ringPps);
+                result["ring_speedup_percent"] = std::to_string(deltaPercent);
+                results.push_back(result);
+                
+                std::cout << "Results:" << std::endl;
+                std::cout << "  recv() path:     " << std::fixed << std::setprecision(2) << recvPps << " pps ("
+                          << recvRun.packets << " packets, " << recvRun.dropped << " dropped)" << std::endl;
+                std::cout << "  TPACKET_V3 ring: " << std::fixed << std::setprecision(2) << ringPps << " pps ("
+                          << ringRun.packets << " packets, " << ringRun.dropped << " dropped)" << std::endl;
+                std::cout << "  Difference:      " << std::showpos << std::fixed << std::setprecision(1)
+                          << deltaPercent << std::noshowpos << "%" << std::endl;
+                if (recvRun.packets == 0 && ringRun.packets == 0) {
+                    std::cout << "  (no traffic seen on " << interface << " - generate load while benchmarking)" << std::endl;
+                }
+                continue;
+            }
+            
+            if (backendName == "synthetic") {
+                // Generated load: measures what the pipeline sustains, no NIC involved
+                auto syntheticOptions = options;
+                syntheticOptions["packet_limit"] = std::to_string(packetCount);
+                syntheticOptions["packet_size"] = std::to_string(packetSize);
+                if (sizeGiven && !syntheticOptions.count("size_distribution")) {
+                    syntheticOptions["size_distribution"] = "fixed";
+                }
+                
+                CaptureRun run = measureCapture(backendName, syntheticOptions, std::chrono::seconds(duration),
+                                                static_cast<uint64_t>(packetCount));
+                double packetsPerSecond = run.packetsPerSecond();
+                double throughputMbps = run.seconds > 0.0 ? run.bytes * 8.0 / (1000000.0 * run.seconds) : 0.0;
+                
+                std::map<std::string, std::string> result;
+                result["backend"] = backendName;
+                result["packets_per_second"] = std::to_string(packetsPerSecond);
+                result["throughput_mbps"] = std::to_string(throughputMbps);
+                result["latency_ms"] = std::to_string(run.packets > 0 ? run.seconds * 1000.0 / run.packets : 0.0);
+                result["total_packets"] = std::to_string(run.packets);
+                result["total_bytes"] = std::to_string(run.bytes);
+                result["duration_ms"] = std::to_string(static_cast<long>(run.seconds * 1000.0));
+                results.push_back(result);
+                
+                std::cout << "Results:" << std::endl;
+                std::cout << "  Packets/sec: " << std::fixed << std::setprecision(2) << packetsPerSecond << std::endl;
+                std::cout << "  Throughput: " << std::fixed << std::setprecision(2) << throughputMbps << " Mbps" << std::endl;
+                std::cout << "  Total Packets: " << run.packets << " (" << run.dropped << " dropped)" << std::endl;
+                std::cout << "  Total Bytes: " << run.bytes << std::endl;
+                std::cout << "  Duration: " << static_cast<long>(run.seconds * 1000.0) << " ms" << std::endl;
+                continue;
+            }
+            
+            auto backend = createBackend(backendName);
             configureBackend(backend.get(), options);
             
             // Run benchmark
@@ -1012,7 +1310,7 @@ void infoCommand(const std::vector<std::string>& args) {
     if (showCapabilities || args.empty()) {
         std::cout << "\n--- Backend Capabilities ---" << std::endl;
         
-        std::vector<std::string> backends = {"af_packet", "dpdk", "pmd", "af_xdp"};
+        std::vector<std::string> backends = {"af_packet", "dpdk", "pmd", "af_xdp", "pcap", "synthetic"};
         if (backendType != "all") {
             backends = {backendType};
         }
@@ -1044,12 +1342,10 @@ void infoCommand(const std::vector<std::string>& args) {
 
 void replayCommand(const std::vector<std::string>& args) {
     std::string pcapFile = "";
-    std::string interface = "lo";
-    int rate = 0;  // 0 = as fast as possible
     int loopCount = 1;
-    int delayMs = 0;
     double speedFactor = 1.0;
-    std::string filter = "";
+    size_t batchSize = 64;
+    bool zeroCopy = true;
     std::string outputFile = "";
     int statsInterval = 5;
     
@@ -1060,20 +1356,18 @@ void replayCommand(const std::vector<std::string>& args) {
             return;
         } else if (args[i].substr(0, 7) == "--file=" || args[i].substr(0, 3) == "-f=") {
             pcapFile = args[i].find("--file=") == 0 ? args[i].substr(7) : args[i].substr(3);
-        } else if (args[i].substr(0, 12) == "--interface=" || args[i].substr(0, 3) == "-i=") {
-            interface = args[i].find("--interface=") == 0 ? args[i].substr(12) : args[i].substr(3);
-        } else if (args[i].substr(0, 6) == "--rate=" || args[i].substr(0, 3) == "-r=") {
-            rate = std::stoi(args[i].find("--rate=") == 0 ? args[i].substr(7) : args[i].substr(3));
         } else if (args[i].substr(0, 7) == "--loop=") {
             loopCount = std::stoi(args[i].substr(7));
-        } else if (args[i].substr(0, 8) == "--delay=" || args[i].substr(0, 3) == "-d=") {
-            delayMs = std::stoi(args[i].find("--delay=") == 0 ? args[i].substr(8) : args[i].substr(3));
         } else if (args[i].substr(0, 8) == "--speed=" || args[i].substr(0, 3) == "-s=") {
             speedFactor = std::stod(args[i].find("--speed=") == 0 ? args[i].substr(8) : args[i].substr(3));
-        } else if (args[i].substr(0, 9) == "--filter=") {
-            filter = args[i].substr(9);
-        } else if (args[i].substr(0, 12) == "--output-file=") {
-            outputFile = args[i].substr(12);
+        } else if (args[i] == "--fast") {
+            speedFactor = 0.0;
+        } else if (args[i].substr(0, 13) == "--batch-size=") {
+            batchSize = std::stoul(args[i].substr(13));
+        } else if (args[i] == "--no-zero-copy") {
+            zeroCopy = false;
+        } else if (args[i].substr(0, 14) == "--output-file=") {
+            outputFile = args[i].substr(14);
         } else if (args[i].substr(0, 17) == "--stats-interval=") {
             statsInterval = std::stoi(args[i].substr(17));
         }
@@ -1084,108 +1378,81 @@ void replayCommand(const std::vector<std::string>& args) {
         printReplayHelp();
         return;
     }
+    if (speedFactor < 0.0 || loopCount < 0) {
+        std::cout << "Error: speed and loop count must not be negative" << std::endl;
+        return;
+    }
     
-    std::cout << "=== Beatrice PCAP Replay ===" << std::endl;
-    std::cout << "PCAP File: " << pcapFile << std::endl;
-    std::cout << "Interface: " << interface << std::endl;
-    std::cout << "Rate: " << (rate > 0 ? std::to_string(rate) + " pps" : "as fast as possible") << std::endl;
-    std::cout << "Loop Count: " << (loopCount > 0 ? std::to_string(loopCount) : "infinite") << std::endl;
-    std::cout << "Delay: " << delayMs << "ms" << std::endl;
-    std::cout << "Speed Factor: " << std::fixed << std::setprecision(2) << speedFactor << "x" << std::endl;
-    if (!filter.empty()) std::cout << "Filter: " << filter << std::endl;
-    std::cout << "=============================" << std::endl;
+    ICaptureBackend::Config config;
+    config.captureFile = pcapFile;
+    config.replaySpeed = speedFactor;
+    config.replayLoops = static_cast<size_t>(loopCount);
+    config.batchSize = batchSize;
+    config.enableZeroCopy = zeroCopy;
     
-    // Check if PCAP file exists
-    std::ifstream fileCheck(pcapFile);
-    if (!fileCheck.good()) {
-        std::cout << "Error: PCAP file '" << pcapFile << "' not found or not readable" << std::endl;
+    PcapFileBackend backend;
+    auto result = backend.initialize(config);
+    if (!result.isSuccess()) {
+        std::cout << "Error: " << result.getErrorMessage() << std::endl;
         return;
     }
-    fileCheck.close();
+    
+    std::cout << "=== Beatrice PCAP Replay ===" << std::endl;
+    std::cout << "PCAP File: " << pcapFile << " (" << backend.getFileFormat()
+              << ", link type " << backend.getLinkType() << ")" << std::endl;
+    std::cout << "Speed: " << (speedFactor > 0.0 ? std::to_string(speedFactor) + "x recorded pace" : "as fast as possible") << std::endl;
+    std::cout << "Loop Count: " << (loopCount > 0 ? std::to_string(loopCount) : "infinite") << std::endl;
+    std::cout << "Zero-Copy: " << (zeroCopy ? "enabled" : "disabled") << std::endl;
+    std::cout << "=============================" << std::endl;
     
     std::cout << "Starting PCAP replay..." << std::endl;
     std::cout << "Press Ctrl+C to stop" << std::endl;
     
-    // Simulate PCAP replay
+    result = backend.start();
+    if (!result.isSuccess()) {
+        std::cout << "Error: " << result.getErrorMessage() << std::endl;
+        return;
+    }
+    
     auto startTime = std::chrono::steady_clock::now();
-    int totalPackets = 0;
-    int64_t totalBytes = 0;
-    int currentLoop = 0;
-    
-    while (g_running && (loopCount == 0 || currentLoop < loopCount)) {
-        currentLoop++;
-        if (loopCount > 0) {
-            std::cout << "\n--- Loop " << currentLoop << "/" << loopCount << " ---" << std::endl;
-        }
-        
-        // Simulate reading PCAP file
-        std::cout << "Reading PCAP file: " << pcapFile << std::endl;
-        
-        // Simulate packet replay
-        int loopPackets = 0;
-        int64_t loopBytes = 0;
-        
-        for (int i = 0; i < 1000 && g_running; ++i) {  // Simulate 1000 packets per loop
-            totalPackets++;
-            loopPackets++;
-            
-            int packetSize = 64 + (i % 1400);  // Simulate variable packet sizes
-            totalBytes += packetSize;
-            loopBytes += packetSize;
-            
-            // Apply rate limiting
-            if (rate > 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000 / rate));
-            }
-            
-            // Apply delay
-            if (delayMs > 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
-            }
-            
-            // Apply speed factor
-            if (speedFactor != 1.0) {
-                std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int>(1000 / speedFactor)));
-            }
-            
-            // Progress indicator
-            if (i % 100 == 0) {
-                std::cout << "Replayed: " << i << " packets" << std::endl;
-            }
+    auto lastStats = startTime;
+    uint64_t totalPackets = 0;
+    uint64_t totalBytes = 0;
+    
+    while (g_running && !backend.isFinished()) {
+        auto packets = backend.getPackets(batchSize, std::chrono::milliseconds(100));
+        for (const auto& packet : packets) {
+            totalBytes += packet.length();
         }
+        totalPackets += packets.size();
         
-        std::cout << "Loop " << currentLoop << " completed: " << loopPackets << " packets, " 
-                 << loopBytes << " bytes" << std::endl;
-        
-        // Statistics update
-        if (totalPackets % (statsInterval * 100) == 0) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - startTime);
-            double packetsPerSecond = totalPackets / elapsed.count();
-            double throughputMbps = (totalBytes * 8.0) / (1000000.0 * elapsed.count());
-            
+        auto now = std::chrono::steady_clock::now();
+        if (statsInterval > 0 && now - lastStats >= std::chrono::seconds(statsInterval)) {
+            double elapsed = std::chrono::duration<double>(now - startTime).count();
             std::cout << "Statistics: " << totalPackets << " packets, " 
                      << totalBytes << " bytes, " 
-                     << std::fixed << std::setprecision(2) << packetsPerSecond << " pps, "
-                     << std::fixed << std::setprecision(2) << throughputMbps << " Mbps" << std::endl;
-        }
-        
-        if (loopCount > 0 && currentLoop >= loopCount) {
-            break;
+                     << std::fixed << std::setprecision(2) << totalPackets / elapsed << " pps, "
+                     << std::fixed << std::setprecision(2) << (totalBytes * 8.0) / (1000000.0 * elapsed) << " Mbps" << std::endl;
+            lastStats = now;
         }
     }
     
+    backend.stop();
+    if (!backend.isHealthy()) {
+        std::cout << "Warning: " << pcapFile << " is truncated or malformed, replay stopped early" << std::endl;
+    }
+    
     // Final statistics
     auto endTime = std::chrono::steady_clock::now();
+    double seconds = std::max(std::chrono::duration<double>(endTime - startTime).count(), 1e-9);
     auto totalTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
     
     std::cout << "\n=== Replay Summary ===" << std::endl;
     std::cout << "Total Packets: " << totalPackets << std::endl;
     std::cout << "Total Bytes: " << totalBytes << std::endl;
-    std::cout << "Total Loops: " << currentLoop << std::endl;
     std::cout << "Duration: " << totalTime.count() << "ms" << std::endl;
-    std::cout << "Average Rate: " << (totalPackets * 1000.0 / totalTime.count()) << " packets/sec" << std::endl;
-    std::cout << "Average Throughput: " << (totalBytes * 8.0 / 1000000.0 / (totalTime.count() / 1000.0)) << " Mbps" << std::endl;
+    std::cout << "Average Rate: " << (totalPackets / seconds) << " packets/sec" << std::endl;
+    std::cout << "Average Throughput: " << (totalBytes * 8.0 / 1000000.0 / seconds) << " Mbps" << std::endl;
     
     // Save results if requested
     if (!outputFile.empty()) {
@@ -1195,14 +1462,14 @@ void replayCommand(const std::vector<std::string>& args) {
                 file << "PCAP Replay Results\n";
                 file << "==================\n\n";
                 file << "File: " << pcapFile << "\n";
-                file << "Interface: " << interface << "\n";
-                file << "Rate: " << (rate > 0 ? std::to_string(rate) + " pps" : "as fast as possible") << "\n";
-                file << "Loop Count: " << currentLoop << "\n";
+                file << "Format: " << backend.getFileFormat() << "\n";
+                file << "Speed: " << (speedFactor > 0.0 ? std::to_string(speedFactor) + "x" : "as fast as possible") << "\n";
+                file << "Loop Count: " << loopCount << "\n";
                 file << "Total Packets: " << totalPackets << "\n";
                 file << "Total Bytes: " << totalBytes << "\n";
                 file << "Duration: " << totalTime.count() << "ms\n";
-                file << "Average Rate: " << (totalPackets * 1000.0 / totalTime.count()) << " packets/sec\n";
-                file << "Average Throughput: " << (totalBytes * 8.0 / 1000000.0 / (totalTime.count() / 1000.0)) << " Mbps\n";
+                file << "Average Rate: " << (totalPackets / seconds) << " packets/sec\n";
+                file << "Average Throughput: " << (totalBytes * 8.0 / 1000000.0 / seconds) << " Mbps\n";
                 file.close();
                 std::cout << "Results saved to: " << outputFile << std::endl;
             }
@@ -10,14 +10,105 @@
 // XDP action: redirect to user space
 #define XDP_REDIRECT 4
 
-// Map to store redirect information
+// AF_XDP sockets indexed by RX queue, filled in by user space
 struct {
     __uint(type, BPF_MAP_TYPE_XSKMAP);
-    __uint(max_entries, 1);
+    __uint(max_entries, 64);
     __uint(key_size, sizeof(int));
     __uint(value_size, sizeof(int));
 } xsks_map SEC(".maps");
 
+// Filter rules pushed down from PacketFilter, see XDPLoader::setFilterRules
+#define FILTER_PROTOCOLS (1 << 0)
+#define FILTER_NETWORKS  (1 << 1)
+#define FILTER_PORTS     (1 << 2)
+
+struct filter_rules {
+    __u32 flags;                // FILTER_* tables to consult
+    __u8 protocols[256 / 8];    // bitmap of allowed IPv4 protocols
+    __u8 ports[65536 / 8];      // bitmap of allowed TCP/UDP ports
+};
+
+struct network_key {
+    __u32 prefixlen;
+    __u32 addr;
+};
+
+// Two rule tables; user space rewrites the idle one and then flips filter_active
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, 2);
+    __type(key, __u32);
+    __type(value, struct filter_rules);
+} filter_rules SEC(".maps");
+
+struct {
+    __uint(type, BPF_MAP_TYPE_ARRAY);
+    __uint(max_entries, 1);
+    __type(key, __u32);
+    __type(value, __u32);
+} filter_active SEC(".maps");
+
+// Allowed source or destination networks
+struct {
+    __uint(type, BPF_MAP_TYPE_LPM_TRIE);
+    __uint(max_entries, 16384);
+    __uint(map_flags, BPF_F_NO_PREALLOC);
+    __type(key, struct network_key);
+    __type(value, __u8);
+} filter_networks SEC(".maps");
+
+// Packets dropped by the rules
+struct {
+    __uint(type, BPF_MAP_TYPE_PERCPU_ARRAY);
+    __uint(max_entries, 1);
+    __type(key, __u32);
+    __type(value, __u64);
+} filter_stats SEC(".maps");
+
+static __always_inline int bitmap_test(const __u8 *bitmap, __u32 bit, __u32 bits)
+{
+    bit &= bits - 1;
+    return bitmap[bit >> 3] & (1 << (bit & 7));
+}
+
+static __always_inline int network_allowed(__u32 addr)
+{
+    struct network_key key = { .prefixlen = 32, .addr = addr };
+    return !!bpf_map_lookup_elem(&filter_networks, &key);
+}
+
+// Same checks as the PROTOCOL, IP_RANGE and PORT_RANGE filters in user space.
+// Whatever cannot be decided here, like ports behind IP options or in later
+// fragments, is let through for user space to judge.
+static __always_inline int filter_accepts(const struct filter_rules *rules,
+                                          struct iphdr *ip, void *data_end)
+{
+    if ((rules->flags & FILTER_PROTOCOLS) &&
+        !bitmap_test(rules->protocols, ip->protocol, 256))
+        return 0;
+
+    if ((rules->flags & FILTER_NETWORKS) &&
+        !network_allowed(ip->saddr) && !network_allowed(ip->daddr))
+        return 0;
+
+    if (rules->flags & FILTER_PORTS) {
+        if (ip->protocol != IPPROTO_TCP && ip->protocol != IPPROTO_UDP)
+            return 0;
+        if (ip->ihl != 5 || (ip->frag_off & bpf_htons(0x1fff)))
+            return 1;
+
+        __be16 *ports = (void *)(ip + 1);
+        if ((void *)(ports + 2) > data_end)
+            return 0;
+        if (!bitmap_test(rules->ports, bpf_ntohs(ports[0]), 65536) &&
+            !bitmap_test(rules->ports, bpf_ntohs(ports[1]), 65536))
+            return 0;
+    }
+
+    return 1;
+}
+
 // XDP program entry point
 SEC("xdp")
 int xdp_prog(struct xdp_md *ctx)
@@ -49,9 +140,25 @@ int xdp_prog(struct xdp_md *ctx)
     if (data + sizeof(struct ethhdr) + (ip->ihl * 4) > data_end)
         return XDP_PASS;
     
-    // Redirect to user space (queue 0)
-    int key = 0;
-    return bpf_redirect_map(&xsks_map, key, 0);
+    // Queues without a socket keep handing traffic to the host stack
+    int key = ctx->rx_queue_index;
+    if (!bpf_map_lookup_elem(&xsks_map, &key))
+        return XDP_PASS;
+    
+    // Drop what the filter rules reject before it costs a redirect
+    __u32 zero = 0;
+    __u32 *active = bpf_map_lookup_elem(&filter_active, &zero);
+    __u32 slot = active ? (*active & 1) : 0;
+    struct filter_rules *rules = bpf_map_lookup_elem(&filter_rules, &slot);
+    if (rules && rules->flags && !filter_accepts(rules, ip, data_end)) {
+        __u64 *dropped = bpf_map_lookup_elem(&filter_stats, &zero);
+        if (dropped)
+            *dropped += 1;
+        return XDP_DROP;
+    }
+    
+    // Redirect to the socket bound to this RX queue, pass if it went away
+    return bpf_redirect_map(&xsks_map, key, XDP_PASS);
 }
 
 // License for the program
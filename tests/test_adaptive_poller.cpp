@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "beatrice/AdaptivePoller.hpp"
+#include <memory>
+#include <vector>
+
+using beatrice::AdaptivePoller;
+using beatrice::Packet;
+
+namespace {
+
+AdaptivePoller::Config shortBudgets() {
+    AdaptivePoller::Config config;
+    config.spinBudget = std::chrono::microseconds(20);
+    config.yieldBudget = std::chrono::microseconds(20);
+    config.parkTimeout = std::chrono::milliseconds(5);
+    return config;
+}
+
+} // anonymous namespace
+
+TEST(AdaptivePollerTest, ReturnsReadyBatchWithoutWaiting) {
+    AdaptivePoller poller(shortBudgets());
+    std::vector<std::chrono::milliseconds> timeouts;
+
+    auto packets = poller.next([&](std::chrono::milliseconds timeout) {
+        timeouts.push_back(timeout);
+        std::vector<Packet> batch;
+        batch.emplace_back(std::make_shared<uint8_t[]>(64), 64);
+        return batch;
+    });
+
+    EXPECT_EQ(packets.size(), 1u);
+    ASSERT_EQ(timeouts.size(), 1u);
+    EXPECT_EQ(timeouts[0].count(), 0);
+
+    const auto& stats = poller.getStatistics();
+    EXPECT_EQ(stats.batches, 1u);
+    EXPECT_EQ(stats.parks, 0u);
+    EXPECT_EQ(stats.spinTime.count(), 0);
+}
+
+TEST(AdaptivePollerTest, ParksOnceSpinBudgetIsSpent) {
+    AdaptivePoller poller(shortBudgets());
+    size_t polls = 0;
+    std::chrono::milliseconds lastTimeout{0};
+
+    auto packets = poller.next([&](std::chrono::milliseconds timeout) {
+        ++polls;
+        lastTimeout = timeout;
+        return std::vector<Packet>();
+    });
+
+    EXPECT_TRUE(packets.empty());
+    EXPECT_GT(polls, 2u);
+    EXPECT_EQ(lastTimeout, std::chrono::milliseconds(5));
+
+    const auto& stats = poller.getStatistics();
+    EXPECT_EQ(stats.batches, 0u);
+    EXPECT_EQ(stats.parks, 1u);
+    EXPECT_GE(stats.spinTime, std::chrono::microseconds(40));
+}
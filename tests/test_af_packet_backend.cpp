@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "beatrice/AF_PacketBackend.hpp"
+#include "beatrice/Logger.hpp"
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+using beatrice::AF_PacketBackend;
+
+namespace {
+
+// Packet sockets need root or CAP_NET_RAW
+bool canOpenPacketSockets() {
+    int fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+void sendLoopbackDatagrams(const std::string& payload, int count) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(fd, 0);
+    sockaddr_in destination{};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(9);
+    inet_pton(AF_INET, "127.0.0.1", &destination.sin_addr);
+    for (int i = 0; i < count; ++i) {
+        sendto(fd, payload.data(), payload.size(), 0, reinterpret_cast<sockaddr*>(&destination), sizeof(destination));
+    }
+    close(fd);
+}
+
+} // namespace
+
+class AF_PacketBackendTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!beatrice::Logger::get().isInitialized()) {
+            beatrice::Logger::get().initialize("", "error");
+        }
+    }
+};
+
+TEST_F(AF_PacketBackendTest, CapturesLoopbackThroughRxRing) {
+    if (!canOpenPacketSockets()) {
+        GTEST_SKIP() << "AF_PACKET sockets need root or CAP_NET_RAW";
+    }
+
+    beatrice::ICaptureBackend::Config config;
+    config.interface = "lo";
+    config.enableRxRing = true;
+    config.ringBlockSize = 1 << 16;
+    config.ringBlockCount = 4;
+    config.ringBlockTimeoutMs = 5;
+
+    AF_PacketBackend backend;
+    ASSERT_TRUE(backend.initialize(config).isSuccess()) << backend.getLastError();
+    ASSERT_TRUE(backend.start().isSuccess());
+
+    const std::string marker = "beatrice-rx-ring-" + std::to_string(getpid());
+    const auto sent = std::chrono::steady_clock::now();
+    sendLoopbackDatagrams(marker, 5);
+
+    // lo hands a packet socket every datagram twice, outgoing and incoming
+    size_t seen = 0;
+    const auto deadline = sent + std::chrono::seconds(2);
+    while (seen < 5 && std::chrono::steady_clock::now() < deadline) {
+        for (const auto& packet : backend.getPackets(64, std::chrono::milliseconds(100))) {
+            std::string_view data(reinterpret_cast<const char*>(packet.data()), packet.length());
+            if (data.find(marker) == std::string_view::npos) {
+                continue;
+            }
+            ++seen;
+            // Kernel receive time, not the time the block was read
+            EXPECT_GE(packet.timestamp(), sent - std::chrono::milliseconds(50));
+            EXPECT_LE(packet.timestamp(), std::chrono::steady_clock::now());
+        }
+    }
+    EXPECT_GE(seen, 5u);
+
+    auto stats = backend.getStatistics();
+    EXPECT_GE(stats.packetsCaptured, 5u);
+    EXPECT_TRUE(backend.stop().isSuccess());
+}
+
+TEST_F(AF_PacketBackendTest, MapsFanoutModesToKernelFlags) {
+    using FanoutMode = beatrice::ICaptureBackend::FanoutMode;
+
+    // Hashing defragments first so every fragment of a datagram lands on one socket
+    EXPECT_EQ(AF_PacketBackend::fanoutArgument(0x1234, FanoutMode::HASH),
+              0x1234 | ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16));
+    EXPECT_EQ(AF_PacketBackend::fanoutArgument(7, FanoutMode::CPU), 7 | (PACKET_FANOUT_CPU << 16));
+    EXPECT_EQ(AF_PacketBackend::fanoutArgument(7, FanoutMode::LOAD_BALANCE), 7 | (PACKET_FANOUT_LB << 16));
+    EXPECT_EQ(AF_PacketBackend::fanoutArgument(0xFFFF, FanoutMode::ROLLOVER), 0xFFFF | (PACKET_FANOUT_ROLLOVER << 16));
+}
+
+TEST_F(AF_PacketBackendTest, DerivesFanoutGroupFromProcessId) {
+    EXPECT_EQ(AF_PacketBackend::fanoutGroup(1, 7, 1234), std::nullopt);
+    EXPECT_EQ(AF_PacketBackend::fanoutGroup(3, 7, 1234), 7);
+    EXPECT_EQ(AF_PacketBackend::fanoutGroup(3, 0, 1234), 1234);
+    EXPECT_EQ(AF_PacketBackend::fanoutGroup(3, 0, 0x12345), 0x2345);
+
+    // A pid that is a multiple of 65536 still fans out, as group 0
+    EXPECT_EQ(AF_PacketBackend::fanoutGroup(3, 0, 0x30000), 0);
+}
+
+TEST_F(AF_PacketBackendTest, SpreadsLoopbackOverFanoutGroup) {
+    if (!canOpenPacketSockets()) {
+        GTEST_SKIP() << "AF_PACKET sockets need root or CAP_NET_RAW";
+    }
+
+    beatrice::ICaptureBackend::Config config;
+    config.interface = "lo";
+    config.fanoutSockets = 3;
+    config.fanoutMode = beatrice::ICaptureBackend::FanoutMode::LOAD_BALANCE;
+
+    AF_PacketBackend backend;
+    ASSERT_TRUE(backend.initialize(config).isSuccess()) << backend.getLastError();
+    ASSERT_EQ(backend.getQueueCount(), 3u);
+    ASSERT_TRUE(backend.start().isSuccess());
+
+    const std::string marker = "beatrice-fanout-" + std::to_string(getpid());
+    sendLoopbackDatagrams(marker, 30);
+
+    // lo shows every datagram going out and coming in, and the ICMP port
+    // unreachable that quotes it; round-robin spreads those over every socket
+    std::vector<size_t> perQueue(backend.getQueueCount());
+    size_t seen = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (seen < 30 * 4 && std::chrono::steady_clock::now() < deadline) {
+        for (size_t queue = 0; queue < perQueue.size(); ++queue) {
+            for (const auto& packet : backend.getPackets(queue, 64, std::chrono::milliseconds(10))) {
+                std::string_view data(reinterpret_cast<const char*>(packet.data()), packet.length());
+                if (data.find(marker) != std::string_view::npos) {
+                    ++perQueue[queue];
+                    ++seen;
+                }
+            }
+        }
+    }
+    EXPECT_GE(seen + backend.getStatistics().packetsDropped, 30u);
+    for (size_t count : perQueue) {
+        EXPECT_GT(count, 0u);
+    }
+    EXPECT_TRUE(backend.stop().isSuccess());
+}
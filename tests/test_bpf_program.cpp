@@ -0,0 +1,321 @@
+#include <gtest/gtest.h>
+#include "beatrice/BpfProgram.hpp"
+#include "beatrice/PacketFilter.hpp"
+#include <arpa/inet.h>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace beatrice;
+
+namespace {
+
+struct FrameSpec {
+    uint16_t vlan = 0;                 // 0 for untagged
+    bool ipv6 = false;
+    uint8_t protocol = IPPROTO_TCP;
+    const char* src = "10.0.0.1";
+    const char* dst = "192.168.1.20";
+    uint16_t srcPort = 40000;
+    uint16_t dstPort = 80;
+    uint16_t fragmentOffset = 0;
+    size_t payload = 16;
+};
+
+void put16(std::vector<uint8_t>& frame, size_t offset, uint16_t value) {
+    frame[offset] = static_cast<uint8_t>(value >> 8);
+    frame[offset + 1] = static_cast<uint8_t>(value);
+}
+
+std::vector<uint8_t> makeFrame(const FrameSpec& spec) {
+    std::vector<uint8_t> frame(14);
+    const uint8_t dstMac[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x02};
+    const uint8_t srcMac[] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    std::memcpy(frame.data(), dstMac, 6);
+    std::memcpy(frame.data() + 6, srcMac, 6);
+
+    size_t l3 = 14;
+    if (spec.vlan) {
+        frame.resize(18);
+        put16(frame, 12, 0x8100);
+        put16(frame, 14, spec.vlan);
+        l3 = 18;
+    }
+    put16(frame, l3 - 2, spec.ipv6 ? 0x86dd : 0x0800);
+
+    size_t l4;
+    if (spec.ipv6) {
+        frame.resize(l3 + 40);
+        frame[l3] = 0x60;
+        frame[l3 + 6] = spec.protocol;
+        inet_pton(AF_INET6, spec.src, frame.data() + l3 + 8);
+        inet_pton(AF_INET6, spec.dst, frame.data() + l3 + 24);
+        l4 = l3 + 40;
+    } else {
+        frame.resize(l3 + 20);
+        frame[l3] = 0x45;
+        put16(frame, l3 + 6, spec.fragmentOffset);
+        frame[l3 + 9] = spec.protocol;
+        inet_pton(AF_INET, spec.src, frame.data() + l3 + 12);
+        inet_pton(AF_INET, spec.dst, frame.data() + l3 + 16);
+        l4 = l3 + 20;
+    }
+
+    frame.resize(l4 + 20 + spec.payload);
+    put16(frame, l4, spec.srcPort);
+    put16(frame, l4 + 2, spec.dstPort);
+    frame[l4 + 13] = 0x12;             // TCP flags SYN|ACK
+    return frame;
+}
+
+bool matches(const std::string& expression, const std::vector<uint8_t>& frame) {
+    auto program = BpfProgram::compile(expression);
+    EXPECT_TRUE(program.isSuccess()) << expression << ": " << program.getErrorMessage();
+    if (program.isError()) {
+        return false;
+    }
+    return program.getValue().run(frame.data(), frame.size()) != 0;
+}
+
+} // namespace
+
+TEST(BpfProgramTest, ProtocolsAndHosts) {
+    auto tcp = makeFrame({});
+    FrameSpec udpSpec;
+    udpSpec.protocol = IPPROTO_UDP;
+    auto udp = makeFrame(udpSpec);
+
+    EXPECT_TRUE(matches("", tcp));
+    EXPECT_TRUE(matches("ip", tcp));
+    EXPECT_FALSE(matches("ip6", tcp));
+    EXPECT_TRUE(matches("tcp", tcp));
+    EXPECT_FALSE(matches("tcp", udp));
+    EXPECT_TRUE(matches("udp or icmp", udp));
+    EXPECT_TRUE(matches("ip proto 17", udp));
+    EXPECT_TRUE(matches("host 10.0.0.1", tcp));
+    EXPECT_TRUE(matches("src host 10.0.0.1 and dst host 192.168.1.20", tcp));
+    EXPECT_FALSE(matches("dst host 10.0.0.1", tcp));
+    EXPECT_TRUE(matches("net 192.168.0.0/16", tcp));
+    EXPECT_FALSE(matches("src net 192.168.0.0/16", tcp));
+    EXPECT_TRUE(matches("dst net 192.168.1.0 mask 255.255.255.0", tcp));
+    EXPECT_TRUE(matches("ether src 02:00:00:00:00:01", tcp));
+    EXPECT_FALSE(matches("ether dst 02:00:00:00:00:01", tcp));
+    EXPECT_TRUE(matches("not (udp or arp) && !icmp", tcp));
+}
+
+TEST(BpfProgramTest, AndOrGroupLeftToRight) {
+    auto tcp = makeFrame({});
+
+    // (tcp or udp) and port 53, not tcp or (udp and port 53)
+    EXPECT_FALSE(matches("tcp or udp and port 53", tcp));
+    EXPECT_TRUE(matches("tcp or (udp and port 53)", tcp));
+    EXPECT_TRUE(matches("udp and port 53 or tcp", tcp));
+    EXPECT_FALSE(matches("udp || tcp && port 53 || arp", tcp));
+    EXPECT_TRUE(matches("udp || tcp && port 53 || port 80", tcp));
+    EXPECT_FALSE(matches("not udp and port 53 or arp", tcp));
+}
+
+TEST(BpfProgramTest, PortsAndOffsets) {
+    auto web = makeFrame({});
+    FrameSpec fragmentSpec;
+    fragmentSpec.fragmentOffset = 100;
+    auto fragment = makeFrame(fragmentSpec);
+
+    EXPECT_TRUE(matches("port 80", web));
+    EXPECT_TRUE(matches("tcp dst port 80", web));
+    EXPECT_FALSE(matches("udp port 80", web));
+    EXPECT_FALSE(matches("src port 80", web));
+    EXPECT_TRUE(matches("portrange 39000-41000", web));
+    EXPECT_FALSE(matches("dst portrange 81-443", web));
+    EXPECT_FALSE(matches("port 80", fragment));
+
+    EXPECT_TRUE(matches("tcp[13] & 0x02 != 0", web));
+    EXPECT_TRUE(matches("tcp[2:2] == 80", web));
+    EXPECT_TRUE(matches("ip[9] = 6", web));
+    EXPECT_TRUE(matches("ether[12:2] = 0x800", web));
+    EXPECT_TRUE(matches("greater 60 and less 100", web));
+    EXPECT_TRUE(matches("len >= 70", web));
+    EXPECT_FALSE(matches("len < 70", web));
+}
+
+TEST(BpfProgramTest, IPv6AndVlan) {
+    FrameSpec v6Spec;
+    v6Spec.ipv6 = true;
+    v6Spec.src = "2001:db8::1";
+    v6Spec.dst = "2001:db8:1::443";
+    v6Spec.dstPort = 443;
+    auto v6 = makeFrame(v6Spec);
+
+    EXPECT_TRUE(matches("ip6 and tcp port 443", v6));
+    EXPECT_TRUE(matches("src host 2001:db8::1", v6));
+    EXPECT_TRUE(matches("dst net 2001:db8:1::/48", v6));
+    EXPECT_FALSE(matches("dst net 2001:db8:2::/48", v6));
+    EXPECT_FALSE(matches("ip", v6));
+
+    FrameSpec taggedSpec;
+    taggedSpec.vlan = 42;
+    auto tagged = makeFrame(taggedSpec);
+
+    EXPECT_FALSE(matches("tcp", tagged));
+    EXPECT_TRUE(matches("vlan and tcp port 80", tagged));
+    EXPECT_TRUE(matches("vlan 42 and host 10.0.0.1", tagged));
+    EXPECT_FALSE(matches("vlan 7", tagged));
+}
+
+TEST(BpfProgramTest, RejectsInvalidInput) {
+    for (const char* expression : {"tcp and", "foo", "port 70000", "net 10.0.0.0/33",
+                                   "host 10.0.0.300", "(tcp", "tcp[1:3] = 0", "ip[0] ~ 1"}) {
+        auto program = BpfProgram::compile(expression);
+        EXPECT_TRUE(program.isError()) << expression;
+        EXPECT_EQ(program.getErrorCode(), ErrorCode::INVALID_ARGUMENT);
+    }
+
+    EXPECT_TRUE(BpfProgram::fromInstructions({}).isError());
+    EXPECT_TRUE(BpfProgram::fromInstructions({BPF_STMT(BPF_LD | BPF_IMM, 1)}).isError());
+    EXPECT_TRUE(BpfProgram::fromInstructions({BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 5, 0),
+                                              BPF_STMT(BPF_RET | BPF_K, 0)}).isError());
+    EXPECT_TRUE(BpfProgram::fromInstructions({BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, 0),
+                                              BPF_STMT(BPF_RET | BPF_A, 0)}).isError());
+
+    BpfProgram empty;
+    auto frame = makeFrame({});
+    EXPECT_EQ(empty.run(frame.data(), frame.size()), 0u);
+}
+
+TEST(BpfProgramTest, JitMatchesInterpreter) {
+    FrameSpec v6Spec;
+    v6Spec.ipv6 = true;
+    v6Spec.src = "2001:db8::1";
+    v6Spec.dst = "2001:db8::2";
+    FrameSpec udpSpec;
+    udpSpec.protocol = IPPROTO_UDP;
+    udpSpec.dstPort = 53;
+    FrameSpec taggedSpec;
+    taggedSpec.vlan = 42;
+    std::vector<std::vector<uint8_t>> frames = {makeFrame({}), makeFrame(v6Spec), makeFrame(udpSpec),
+                                                makeFrame(taggedSpec)};
+
+    // Truncated copies exercise the bounds checks
+    std::mt19937 rng(7);
+    for (size_t i = 0, n = frames.size(); i < n; ++i) {
+        const auto original = frames[i];
+        for (size_t length : {0, 13, 20, 34, 40, 54}) {
+            frames.emplace_back(original.begin(), original.begin() + std::min(length, original.size()));
+        }
+        auto mutated = original;
+        for (auto& byte : mutated) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        frames.push_back(mutated);
+    }
+
+    for (const char* expression : {"tcp port 80", "udp dst port 53 or vlan 42", "ip6 and net 2001:db8::/32",
+                                   "tcp[13] & 0x12 = 0x12", "not host 10.0.0.1", "len > 60",
+                                   "portrange 1-1024 and ip[8] > 0"}) {
+        auto compiled = BpfProgram::compile(expression);
+        ASSERT_TRUE(compiled.isSuccess()) << compiled.getErrorMessage();
+        BpfProgram program = compiled.getValue();
+#if defined(__x86_64__)
+        ASSERT_TRUE(program.enableJit()) << expression;
+        EXPECT_TRUE(program.isJitted());
+#endif
+        for (const auto& frame : frames) {
+            EXPECT_EQ(program.run(frame.data(), frame.size()), program.interpret(frame.data(), frame.size()))
+                << expression << " on " << frame.size() << " bytes";
+        }
+    }
+
+    // Arithmetic and X-register paths
+    auto handWritten = BpfProgram::fromInstructions({
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),
+        BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),
+        BPF_STMT(BPF_ALU | BPF_SUB | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, 3),
+        BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, 2),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_IMM, 1000),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_X, 0),
+        BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 4),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_K, 0x55),
+        BPF_JUMP(BPF_JMP | BPF_JGT | BPF_X, 0, 0, 1),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+        BPF_STMT(BPF_MISC | BPF_TXA, 0),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    });
+    ASSERT_TRUE(handWritten.isSuccess()) << handWritten.getErrorMessage();
+    BpfProgram program = handWritten.getValue();
+#if defined(__x86_64__)
+    ASSERT_TRUE(program.enableJit());
+#endif
+    for (const auto& frame : frames) {
+        EXPECT_EQ(program.run(frame.data(), frame.size()), program.interpret(frame.data(), frame.size()));
+    }
+}
+
+TEST(BpfProgramTest, LongOrChainsJumpThroughTrampolines) {
+    std::string ports = "port 1";
+    for (int port = 2; port <= 10; ++port) {
+        ports += " or port " + std::to_string(port);
+    }
+    std::string hosts = "host 10.1.0.1";
+    for (int host = 2; host <= 44; ++host) {
+        hosts += " or host 10.1.0." + std::to_string(host);
+    }
+
+    FrameSpec firstSpec;
+    firstSpec.dstPort = 1;
+    firstSpec.src = "10.1.0.1";
+    FrameSpec lastSpec;
+    lastSpec.dstPort = 10;
+    lastSpec.dst = "10.1.0.44";
+    FrameSpec v6Spec;
+    v6Spec.ipv6 = true;
+    v6Spec.src = "2001:db8::1";
+    v6Spec.dst = "2001:db8::2";
+    v6Spec.srcPort = 5;
+    const std::vector<std::vector<uint8_t>> frames = {makeFrame(firstSpec), makeFrame(lastSpec), makeFrame({}),
+                                                      makeFrame(v6Spec)};
+
+    // Expected verdict on each frame above
+    const std::vector<std::pair<std::string, std::vector<bool>>> cases = {
+        {ports, {true, true, false, true}},
+        {hosts, {true, true, false, false}},
+        {"not (" + ports + ")", {false, false, true, false}},
+    };
+    for (const auto& [expression, expected] : cases) {
+        auto compiled = BpfProgram::compile(expression);
+        ASSERT_TRUE(compiled.isSuccess()) << compiled.getErrorMessage();
+        BpfProgram program = compiled.getValue();
+        EXPECT_GT(program.instructions().size(), 256u);
+#if defined(__x86_64__)
+        ASSERT_TRUE(program.enableJit());
+#endif
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const auto& frame = frames[i];
+            EXPECT_EQ(program.interpret(frame.data(), frame.size()) != 0, expected[i]) << expression << " frame " << i;
+            EXPECT_EQ(program.run(frame.data(), frame.size()), program.interpret(frame.data(), frame.size()));
+        }
+    }
+}
+
+TEST(BpfProgramTest, PacketFilterUsesCompiledProgram) {
+    PacketFilter filter;
+    PacketFilter::FilterConfig config;
+    config.type = PacketFilter::FilterType::BPF;
+    config.expression = "tcp dst port 80";
+    ASSERT_TRUE(filter.addFilter("web", config).isSuccess());
+
+    config.expression = "tcp port";
+    EXPECT_TRUE(filter.addFilter("broken", config).isError());
+
+    auto web = makeFrame({});
+    FrameSpec sshSpec;
+    sshSpec.dstPort = 22;
+    auto ssh = makeFrame(sshSpec);
+
+    auto borrow = [](const uint8_t*) {};
+    EXPECT_TRUE(filter.applyFilters(Packet(web.data(), web.size(), borrow)).passed);
+    EXPECT_FALSE(filter.applyFilters(Packet(ssh.data(), ssh.size(), borrow)).passed);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "beatrice/DPDKBackend.hpp"
+#include "beatrice/MbufPacket.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace beatrice;
+
+namespace {
+
+// Software Toeplitz hash over source/destination address and port, as a NIC
+// computes it for RSS on IPv4 TCP/UDP
+uint32_t toeplitzHash(const std::vector<uint8_t>& key, uint32_t srcAddr, uint32_t dstAddr, uint16_t srcPort,
+                      uint16_t dstPort) {
+    const std::array<uint8_t, 12> input = {
+        static_cast<uint8_t>(srcAddr >> 24), static_cast<uint8_t>(srcAddr >> 16), static_cast<uint8_t>(srcAddr >> 8),
+        static_cast<uint8_t>(srcAddr),       static_cast<uint8_t>(dstAddr >> 24), static_cast<uint8_t>(dstAddr >> 16),
+        static_cast<uint8_t>(dstAddr >> 8),  static_cast<uint8_t>(dstAddr),       static_cast<uint8_t>(srcPort >> 8),
+        static_cast<uint8_t>(srcPort),       static_cast<uint8_t>(dstPort >> 8),  static_cast<uint8_t>(dstPort)};
+    uint32_t hash = 0;
+    for (size_t bit = 0; bit < input.size() * 8; ++bit) {
+        if (input[bit / 8] & (0x80 >> (bit % 8))) {
+            // The 32 key bits starting at this input bit
+            uint32_t window = 0;
+            for (size_t k = 0; k < 32; ++k) {
+                const size_t keyBit = bit + k;
+                window = (window << 1) | ((key[keyBit / 8] >> (7 - keyBit % 8)) & 1);
+            }
+            hash ^= window;
+        }
+    }
+    return hash;
+}
+
+} // namespace
+
+// The receive path itself needs an EAL and a port; these cover the sizing
+// decisions made before either exists
+
+TEST(DPDKBackendTest, ClampsBurstToRxBurstCount) {
+    EXPECT_EQ(mbufBurstSize(0), 1u);
+    EXPECT_EQ(mbufBurstSize(1), 1u);
+    EXPECT_EQ(mbufBurstSize(32), 32u);
+    EXPECT_EQ(mbufBurstSize(UINT16_MAX), static_cast<size_t>(UINT16_MAX));
+    EXPECT_EQ(mbufBurstSize(size_t{1} << 20), static_cast<size_t>(UINT16_MAX));
+
+    ICaptureBackend::Config config;
+    EXPECT_EQ(mbufBurstSize(config.batchSize), config.batchSize);
+}
+
+TEST(DPDKBackendTest, CapsRxQueuesAtPortLimit) {
+    EXPECT_EQ(DPDKBackend::rxQueueCount(4, 16), 4u);
+    EXPECT_EQ(DPDKBackend::rxQueueCount(16, 4), 4u);
+    EXPECT_EQ(DPDKBackend::rxQueueCount(0, 4), 1u);
+    EXPECT_EQ(DPDKBackend::rxQueueCount(4, 0), 1u);
+}
+
+TEST(DPDKBackendTest, HashesBothFlowDirectionsToOneQueue) {
+    const std::vector<uint8_t> key = DPDKBackend::symmetricRssKey(40);
+    ASSERT_EQ(key.size(), 40u);
+    EXPECT_EQ(key[0], 0x6d);
+    EXPECT_EQ(key[1], 0x5a);
+    EXPECT_EQ(DPDKBackend::symmetricRssKey(52).size(), 52u);
+
+    const uint32_t client = 0xC0A80001;
+    const uint32_t server = 0x0A000002;
+    size_t distinct = 0;
+    const uint32_t first = toeplitzHash(key, client, server, 40000, 443);
+    for (uint16_t port = 40000; port < 40064; ++port) {
+        const uint32_t forward = toeplitzHash(key, client, server, port, 443);
+        EXPECT_EQ(forward, toeplitzHash(key, server, client, 443, port)) << "client port " << port;
+        distinct += forward != first;
+    }
+    // Still a hash: different flows spread out
+    EXPECT_GT(distinct, 0u);
+}
+
+TEST(DPDKBackendTest, GivesEachQueueItsOwnLcore) {
+    EXPECT_EQ(DPDKBackend::workerLcores({2, 3, 5, 7}, 3), (std::vector<unsigned>{2, 3, 5}));
+    EXPECT_EQ(DPDKBackend::workerLcores({2, 3}, 2), (std::vector<unsigned>{2, 3}));
+    // Too few lcores: every queue falls back to a pinned thread
+    EXPECT_TRUE(DPDKBackend::workerLcores({2}, 2).empty());
+    EXPECT_TRUE(DPDKBackend::workerLcores({}, 1).empty());
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "beatrice/EpochDomain.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using beatrice::EpochDomain;
+
+TEST(EpochDomainTest, SynchronizeWithoutReadersReturns) {
+    EpochDomain domain;
+    domain.synchronize();
+    {
+        EpochDomain::Guard guard(domain);
+    }
+    domain.synchronize();
+}
+
+TEST(EpochDomainTest, WaitsForEarlierReaders) {
+    EpochDomain domain;
+    std::atomic<bool> entered{false};
+    std::atomic<bool> release{false};
+    std::thread reader([&] {
+        EpochDomain::Guard guard(domain);
+        entered.store(true);
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+    });
+    while (!entered.load()) {
+        std::this_thread::yield();
+    }
+
+    std::atomic<bool> synchronized{false};
+    std::thread writer([&] {
+        domain.synchronize();
+        synchronized.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(synchronized.load());
+
+    // A guard entered after the grace period started does not hold it up
+    {
+        EpochDomain::Guard late(domain);
+        release.store(true);
+        reader.join();
+        writer.join();
+    }
+    EXPECT_TRUE(synchronized.load());
+}
+
+TEST(EpochDomainTest, ProtectsSnapshotsFromReclamation) {
+    EpochDomain domain;
+    std::atomic<std::vector<int>*> snapshot{new std::vector<int>(16, 0)};
+    std::atomic<bool> running{true};
+    std::atomic<size_t> torn{0};
+    std::atomic<size_t> reads{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&] {
+            while (running.load()) {
+                ++reads;
+                EpochDomain::Guard guard(domain);
+                const std::vector<int>& values = *snapshot.load();
+                for (int value : values) {
+                    torn += value != values.front();
+                }
+            }
+        });
+    }
+
+    while (reads.load() < 100) {
+        std::this_thread::yield();
+    }
+    for (int version = 1; version <= 100; ++version) {
+        std::unique_ptr<std::vector<int>> old(snapshot.exchange(new std::vector<int>(16, version)));
+        domain.synchronize();
+        // Freed here, after which readers must no longer see it
+        std::fill(old->begin(), old->end(), -1);
+    }
+    running.store(false);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    delete snapshot.load();
+
+    EXPECT_EQ(torn.load(), 0u);
+}
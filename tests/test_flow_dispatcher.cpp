@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "beatrice/FlowDispatcher.hpp"
+#include "beatrice/Logger.hpp"
+#include <cstring>
+#include <map>
+#include <memory>
+#include <vector>
+
+using beatrice::FlowDispatcher;
+using beatrice::Packet;
+
+namespace {
+
+// Ethernet + IPv4 + UDP, with a sequence number in the payload
+Packet makeUdpPacket(uint32_t srcIp, uint32_t dstIp, uint16_t srcPort, uint16_t dstPort, uint32_t seq) {
+    const size_t length = 14 + 20 + 8 + 4;
+    auto data = std::make_shared<uint8_t[]>(length);
+    uint8_t* p = data.get();
+    p[12] = 0x08;                                   // IPv4
+    p[14] = 0x45;                                   // version 4, 20 byte header
+    p[14 + 9] = 17;                                 // UDP
+    for (int i = 0; i < 4; ++i) {
+        p[14 + 12 + i] = static_cast<uint8_t>(srcIp >> (24 - 8 * i));
+        p[14 + 16 + i] = static_cast<uint8_t>(dstIp >> (24 - 8 * i));
+    }
+    p[34] = static_cast<uint8_t>(srcPort >> 8);
+    p[35] = static_cast<uint8_t>(srcPort);
+    p[36] = static_cast<uint8_t>(dstPort >> 8);
+    p[37] = static_cast<uint8_t>(dstPort);
+    std::memcpy(p + 42, &seq, sizeof(seq));
+    return Packet(data, length);
+}
+
+uint32_t sequenceOf(const Packet& packet) {
+    uint32_t seq = 0;
+    std::memcpy(&seq, packet.data() + 42, sizeof(seq));
+    return seq;
+}
+
+} // anonymous namespace
+
+class FlowDispatcherTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!beatrice::Logger::get().isInitialized()) {
+            beatrice::Logger::get().initialize("", "error");
+        }
+    }
+};
+
+TEST_F(FlowDispatcherTest, HashIsSymmetric) {
+    auto forward = makeUdpPacket(0x0a000001, 0x0a000002, 40000, 53, 0);
+    auto reverse = makeUdpPacket(0x0a000002, 0x0a000001, 53, 40000, 0);
+    auto other = makeUdpPacket(0x0a000001, 0x0a000002, 40001, 53, 0);
+
+    EXPECT_EQ(FlowDispatcher::flowHash(forward), FlowDispatcher::flowHash(reverse));
+    EXPECT_NE(FlowDispatcher::flowHash(forward), FlowDispatcher::flowHash(other));
+}
+
+TEST_F(FlowDispatcherTest, KeepsEachFlowOnOneWorkerInOrder) {
+    FlowDispatcher::Config config;
+    config.queueDepth = 1024;
+    FlowDispatcher dispatcher(4, config, "");
+    dispatcher.open();
+
+    // 16 flows, both directions, interleaved
+    std::vector<Packet> packets;
+    for (uint32_t seq = 0; seq < 32; ++seq) {
+        for (uint16_t flow = 0; flow < 16; ++flow) {
+            packets.push_back(seq % 2 == 0
+                ? makeUdpPacket(0x0a000001, 0x0a000002, 40000 + flow, 80, seq)
+                : makeUdpPacket(0x0a000002, 0x0a000001, 80, 40000 + flow, seq));
+        }
+    }
+    ASSERT_EQ(dispatcher.dispatch(packets), 512u);
+
+    std::map<uint64_t, size_t> flowWorker;
+    std::map<uint64_t, uint32_t> nextSeq;
+    size_t total = 0;
+    for (size_t worker = 0; worker < dispatcher.workerCount(); ++worker) {
+        std::vector<Packet> out;
+        dispatcher.pop(worker, out, 1024, std::chrono::milliseconds(0));
+        total += out.size();
+        for (const auto& packet : out) {
+            const uint64_t hash = FlowDispatcher::flowHash(packet);
+            auto [it, inserted] = flowWorker.emplace(hash, worker);
+            EXPECT_EQ(it->second, worker);
+            EXPECT_EQ(sequenceOf(packet), nextSeq[hash]++);
+        }
+    }
+    EXPECT_EQ(total, 512u);
+    EXPECT_EQ(flowWorker.size(), 16u);
+
+    auto stats = dispatcher.getStatistics();
+    EXPECT_EQ(stats.packetsDispatched, 512u);
+    ASSERT_EQ(stats.workerPackets.size(), 4u);
+    EXPECT_EQ(stats.heavyHitters, 0u);
+}
+
+TEST_F(FlowDispatcherTest, FlagsHeavyHitter) {
+    FlowDispatcher::Config config;
+    config.queueDepth = 4096;
+    config.heavyHitterWindow = 1000;
+    FlowDispatcher dispatcher(4, config, "");
+    dispatcher.open();
+
+    // One flow carries half the traffic, the rest is spread over 100 flows
+    std::vector<Packet> packets;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        packets.push_back(i % 2 == 0
+            ? makeUdpPacket(0x0a000001, 0x0a000002, 5000, 5001, i)
+            : makeUdpPacket(0x0a000003, 0x0a000004, 10000 + (i % 100), 80, i));
+    }
+    dispatcher.dispatch(packets);
+
+    auto hitters = dispatcher.getHeavyHitters();
+    ASSERT_EQ(hitters.size(), 1u);
+    EXPECT_EQ(hitters[0].flowHash, FlowDispatcher::flowHash(makeUdpPacket(0x0a000001, 0x0a000002, 5000, 5001, 0)));
+    EXPECT_NEAR(hitters[0].share, 0.5, 0.05);
+    EXPECT_EQ(dispatcher.getStatistics().heavyHitters, 1u);
+}
@@ -12,4 +12,24 @@ TEST(PacketTest, PacketSize) {
     std::copy(data.begin(), data.end(), dataPtr.get());
     beatrice::Packet packet(dataPtr, data.size());
     EXPECT_EQ(packet.size(), 5);
-} 
\ No newline at end of file
+} 
+TEST(PacketTest, ZeroCopyReleaseOnLastReference) {
+    uint8_t frame[64] = {0xaa, 0xbb};
+    int releases = 0;
+    const uint8_t* releasedPtr = nullptr;
+    {
+        beatrice::Packet packet(frame, sizeof(frame), [&](const uint8_t* ptr) {
+            ++releases;
+            releasedPtr = ptr;
+        });
+        EXPECT_TRUE(packet.isZeroCopy());
+        EXPECT_EQ(packet.data(), frame);
+
+        beatrice::Packet copy = packet;
+        packet = beatrice::Packet();
+        EXPECT_EQ(releases, 0);
+        EXPECT_EQ(copy.data()[1], 0xbb);
+    }
+    EXPECT_EQ(releases, 1);
+    EXPECT_EQ(releasedPtr, frame);
+}
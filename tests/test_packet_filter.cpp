@@ -0,0 +1,399 @@
+#include <gtest/gtest.h>
+#include "beatrice/PacketFilter.hpp"
+#include "beatrice/Logger.hpp"
+#include "beatrice/Metrics.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace beatrice;
+
+namespace {
+
+std::vector<uint8_t> makeIPv4Frame(uint8_t protocol, const char* src, const char* dst,
+                                   uint16_t srcPort, uint16_t dstPort) {
+    std::vector<uint8_t> frame(14 + 20 + 20 + 8, 0);
+    frame[12] = 0x08;
+    frame[14] = 0x45;
+    frame[14 + 9] = protocol;
+    inet_pton(AF_INET, src, frame.data() + 26);
+    inet_pton(AF_INET, dst, frame.data() + 30);
+    frame[34] = static_cast<uint8_t>(srcPort >> 8);
+    frame[35] = static_cast<uint8_t>(srcPort);
+    frame[36] = static_cast<uint8_t>(dstPort >> 8);
+    frame[37] = static_cast<uint8_t>(dstPort);
+    return frame;
+}
+
+std::vector<uint8_t> makeIPv6Frame(const char* src, const char* dst) {
+    std::vector<uint8_t> frame(14 + 40 + 8, 0);
+    frame[12] = 0x86;
+    frame[13] = 0xDD;
+    frame[14] = 0x60;
+    frame[14 + 6] = IPPROTO_UDP;
+    inet_pton(AF_INET6, src, frame.data() + 22);
+    inet_pton(AF_INET6, dst, frame.data() + 38);
+    return frame;
+}
+
+std::vector<uint8_t> makeTcpSegment(uint32_t sequence, uint8_t flags, const std::string& payload,
+                                    uint16_t srcPort = 40000) {
+    std::vector<uint8_t> frame = makeIPv4Frame(IPPROTO_TCP, "10.0.0.1", "10.0.0.2", srcPort, 80);
+    frame.resize(14 + 20 + 20);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    uint16_t totalLength = static_cast<uint16_t>(frame.size() - 14);
+    frame[16] = static_cast<uint8_t>(totalLength >> 8);
+    frame[17] = static_cast<uint8_t>(totalLength);
+    for (int i = 0; i < 4; ++i) {
+        frame[38 + i] = static_cast<uint8_t>(sequence >> (24 - 8 * i));
+    }
+    frame[46] = 0x50;
+    frame[47] = flags;
+    return frame;
+}
+
+PacketFilter::FilterConfig makeConfig(PacketFilter::FilterType type, const std::string& expression,
+                                      int priority = 0) {
+    PacketFilter::FilterConfig config;
+    config.type = type;
+    config.expression = expression;
+    config.priority = priority;
+    return config;
+}
+
+} // namespace
+
+class PacketFilterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!Logger::get().isInitialized()) {
+            Logger::get().initialize("", "error");
+        }
+    }
+};
+
+TEST_F(PacketFilterTest, SocketFilterMatchesUserSpaceChain) {
+    PacketFilter filter;
+    ASSERT_TRUE(filter.addFilter("proto", makeConfig(PacketFilter::FilterType::PROTOCOL, "tcp")).isSuccess());
+    ASSERT_TRUE(filter.addFilter("net", makeConfig(PacketFilter::FilterType::IP_RANGE, "10.0.0.0/8")).isSuccess());
+    ASSERT_TRUE(filter.addFilter("ports", makeConfig(PacketFilter::FilterType::PORT_RANGE, "80-443")).isSuccess());
+
+    BpfProgram program = filter.compileSocketFilter();
+    ASSERT_FALSE(program.empty());
+
+    std::vector<std::vector<uint8_t>> frames = {
+        makeIPv4Frame(IPPROTO_TCP, "10.1.2.3", "192.168.0.1", 40000, 443),
+        makeIPv4Frame(IPPROTO_TCP, "192.168.0.1", "10.9.9.9", 80, 40000),
+        makeIPv4Frame(IPPROTO_UDP, "10.1.2.3", "192.168.0.1", 40000, 443),
+        makeIPv4Frame(IPPROTO_TCP, "172.16.0.1", "192.168.0.1", 40000, 443),
+        makeIPv4Frame(IPPROTO_TCP, "10.1.2.3", "192.168.0.1", 40000, 22),
+    };
+    auto borrow = [](const uint8_t*) {};
+    for (const auto& frame : frames) {
+        Packet packet(frame.data(), frame.size(), borrow);
+        EXPECT_EQ(program.matches(packet), filter.applyFilters(packet).passed);
+    }
+}
+
+TEST_F(PacketFilterTest, SocketFilterLeavesUserSpaceOnlyFiltersOut) {
+    PacketFilter filter;
+    EXPECT_TRUE(filter.compileSocketFilter().empty());
+
+    ASSERT_TRUE(filter.addFilter("payload", makeConfig(PacketFilter::FilterType::PAYLOAD, "GET")).isSuccess());
+    EXPECT_TRUE(filter.compileSocketFilter().empty());
+
+    ASSERT_TRUE(filter.addFilter("udp", makeConfig(PacketFilter::FilterType::BPF, "udp")).isSuccess());
+    BpfProgram program = filter.compileSocketFilter();
+    ASSERT_FALSE(program.empty());
+
+    // Looser than the chain: the payload check is left to user space
+    auto frame = makeIPv4Frame(IPPROTO_UDP, "10.0.0.1", "10.0.0.2", 5353, 5353);
+    Packet packet(frame.data(), frame.size(), [](const uint8_t*) {});
+    EXPECT_TRUE(program.matches(packet));
+    EXPECT_FALSE(filter.applyFilters(packet).passed);
+
+    ASSERT_TRUE(filter.setFilterEnabled("udp", false).isSuccess());
+    EXPECT_TRUE(filter.compileSocketFilter().empty());
+
+    // Socket filters see frames with the 802.1Q tag already stripped
+    ASSERT_TRUE(filter.addFilter("tagged", makeConfig(PacketFilter::FilterType::BPF, "vlan 42")).isSuccess());
+    EXPECT_TRUE(filter.compileSocketFilter().empty());
+}
+
+TEST_F(PacketFilterTest, CompilesXdpRules) {
+    PacketFilter filter;
+    EXPECT_TRUE(filter.compileXdpRules().empty());
+
+    ASSERT_TRUE(filter.addFilter("ip", makeConfig(PacketFilter::FilterType::PROTOCOL, "ip")).isSuccess());
+    ASSERT_TRUE(filter.addFilter("udp", makeConfig(PacketFilter::FilterType::PROTOCOL, "udp")).isSuccess());
+    ASSERT_TRUE(filter.addFilter("dns", makeConfig(PacketFilter::FilterType::PORT_RANGE, "53", 1)).isSuccess());
+    ASSERT_TRUE(filter.addFilter("high", makeConfig(PacketFilter::FilterType::PORT_RANGE, "1024-65535")).isSuccess());
+    ASSERT_TRUE(filter.addFilter("lan", makeConfig(PacketFilter::FilterType::IP_RANGE, "192.168.1.77/24")).isSuccess());
+    ASSERT_TRUE(filter.addFilter("bpf", makeConfig(PacketFilter::FilterType::BPF, "tcp")).isSuccess());
+
+    std::vector<std::string> userSpaceOnly;
+    auto rules = filter.compileXdpRules(&userSpaceOnly);
+    EXPECT_TRUE(rules.matchProtocols);
+    EXPECT_EQ(rules.protocols, std::vector<uint8_t>{IPPROTO_UDP});
+
+    // Only the highest priority port range fits the port table
+    EXPECT_TRUE(rules.matchPorts);
+    ASSERT_EQ(rules.portRanges.size(), 1u);
+    EXPECT_EQ(rules.portRanges[0], std::make_pair(uint16_t(53), uint16_t(53)));
+
+    EXPECT_TRUE(rules.matchNetworks);
+    ASSERT_EQ(rules.networks.size(), 1u);
+    EXPECT_EQ(rules.networks[0].first, 0xC0A8014Du);
+    EXPECT_EQ(rules.networks[0].second, 24);
+
+    // The second port range and the BPF filter stay in user space
+    std::sort(userSpaceOnly.begin(), userSpaceOnly.end());
+    EXPECT_EQ(userSpaceOnly, (std::vector<std::string>{"bpf", "high"}));
+}
+
+TEST_F(PacketFilterTest, AppliesFiltersInPriorityOrder) {
+    PacketFilter filter;
+    ASSERT_TRUE(filter.addFilter("ports", makeConfig(PacketFilter::FilterType::PORT_RANGE, "53", 1)).isSuccess());
+    ASSERT_TRUE(filter.addFilter("proto", makeConfig(PacketFilter::FilterType::PROTOCOL, "udp", 5)).isSuccess());
+    ASSERT_TRUE(filter.addFilter("net", makeConfig(PacketFilter::FilterType::IP_RANGE, "10.0.0.0/8")).isSuccess());
+
+    auto borrow = [](const uint8_t*) {};
+    auto tcp = makeIPv4Frame(IPPROTO_TCP, "10.0.0.1", "10.0.0.2", 40000, 53);
+    auto result = filter.applyFilters(Packet(tcp.data(), tcp.size(), borrow));
+    EXPECT_FALSE(result.passed);
+    EXPECT_EQ(result.filterName, "proto");
+
+    auto http = makeIPv4Frame(IPPROTO_UDP, "10.0.0.1", "10.0.0.2", 40000, 80);
+    result = filter.applyFilters(Packet(http.data(), http.size(), borrow));
+    EXPECT_FALSE(result.passed);
+    EXPECT_EQ(result.filterName, "ports");
+
+    auto dns = makeIPv4Frame(IPPROTO_UDP, "10.0.0.1", "10.0.0.2", 40000, 53);
+    result = filter.applyFilters(Packet(dns.data(), dns.size(), borrow));
+    EXPECT_TRUE(result.passed);
+    EXPECT_EQ(result.filterName, "net");
+
+    // Recompiled on every change
+    ASSERT_TRUE(filter.setFilterEnabled("proto", false).isSuccess());
+    EXPECT_TRUE(filter.applyFilters(Packet(tcp.data(), tcp.size(), borrow)).passed);
+    ASSERT_TRUE(filter.addFilter("custom", makeConfig(PacketFilter::FilterType::CUSTOM, "", 10)).isSuccess());
+    ASSERT_TRUE(filter.setCustomFilter("custom", [](const Packet&) { return false; }).isSuccess());
+    EXPECT_EQ(filter.applyFilters(Packet(tcp.data(), tcp.size(), borrow)).filterName, "custom");
+    ASSERT_TRUE(filter.removeFilter("custom").isSuccess());
+    EXPECT_TRUE(filter.applyFilters(Packet(tcp.data(), tcp.size(), borrow)).passed);
+}
+
+TEST_F(PacketFilterTest, MergesStatsAcrossThreads) {
+    PacketFilter filter;
+    ASSERT_TRUE(filter.addFilter("udp", makeConfig(PacketFilter::FilterType::PROTOCOL, "udp")).isSuccess());
+
+    auto udp = makeIPv4Frame(IPPROTO_UDP, "10.0.0.1", "10.0.0.2", 1, 2);
+    auto tcp = makeIPv4Frame(IPPROTO_TCP, "10.0.0.1", "10.0.0.2", 1, 2);
+    constexpr int kThreads = 4;
+    constexpr int kPackets = 1000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            auto borrow = [](const uint8_t*) {};
+            for (int i = 0; i < kPackets; ++i) {
+                const auto& frame = i % 4 == 0 ? tcp : udp;
+                filter.applyFilters(Packet(frame.data(), frame.size(), borrow));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto stats = filter.getStats();
+    EXPECT_EQ(stats.packetsProcessed, uint64_t(kThreads * kPackets));
+    EXPECT_EQ(stats.packetsDropped, uint64_t(kThreads * kPackets / 4));
+    EXPECT_EQ(stats.packetsPassed, uint64_t(kThreads * kPackets * 3 / 4));
+    EXPECT_EQ(stats.filterCounts["udp"], uint64_t(kThreads * kPackets));
+
+    filter.resetStats();
+    stats = filter.getStats();
+    EXPECT_EQ(stats.packetsProcessed, 0u);
+    EXPECT_TRUE(stats.filterCounts.empty());
+}
+
+TEST_F(PacketFilterTest, AppliesFiltersWhileRulesChange) {
+    PacketFilter filter;
+    ASSERT_TRUE(filter.addFilter("net", makeConfig(PacketFilter::FilterType::IP_RANGE, "10.0.0.0/8")).isSuccess());
+
+    auto frame = makeIPv4Frame(IPPROTO_TCP, "10.0.0.1", "10.0.0.2", 40000, 80);
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> wrongVerdicts{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&] {
+            auto borrow = [](const uint8_t*) {};
+            while (running.load()) {
+                // "net" always passes, "tcp" and "port" come and go but pass too
+                if (!filter.applyFilters(Packet(frame.data(), frame.size(), borrow)).passed) {
+                    wrongVerdicts.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(filter.addFilter("tcp", makeConfig(PacketFilter::FilterType::PROTOCOL, "tcp", i % 3)).isSuccess());
+        ASSERT_TRUE(filter.addFilter("port", makeConfig(PacketFilter::FilterType::PORT_RANGE, "1-1024")).isSuccess());
+        ASSERT_TRUE(filter.removeFilter("tcp").isSuccess());
+        ASSERT_TRUE(filter.removeFilter("port").isSuccess());
+    }
+    running.store(false);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(wrongVerdicts.load(), 0u);
+    EXPECT_EQ(filter.getStats().packetsDropped, 0u);
+}
+
+TEST_F(PacketFilterTest, MatchesPrefixListsAndReportsTags) {
+    PacketFilter filter;
+    auto config = makeConfig(PacketFilter::FilterType::IP_RANGE, "198.51.100.0/24, 2001:db8::/32");
+    config.parameters["tag"] = "watchlist";
+    ASSERT_TRUE(filter.addFilter("intel", config).isSuccess());
+    ASSERT_TRUE(filter.getPrefixTable("intel"));
+    EXPECT_EQ(filter.getPrefixTable("intel")->size(), 2u);
+
+    // Prefix tables are left to user space
+    EXPECT_TRUE(filter.compileSocketFilter().empty());
+    std::vector<std::string> userSpaceOnly;
+    EXPECT_FALSE(filter.compileXdpRules(&userSpaceOnly).matchNetworks);
+    EXPECT_EQ(userSpaceOnly, std::vector<std::string>{"intel"});
+
+    auto borrow = [](const uint8_t*) {};
+    auto v4 = makeIPv4Frame(IPPROTO_TCP, "10.0.0.1", "198.51.100.7", 40000, 443);
+    auto result = filter.applyFilters(Packet(v4.data(), v4.size(), borrow));
+    EXPECT_TRUE(result.passed);
+    EXPECT_EQ(result.metadata["intel.tag"], "watchlist");
+
+    auto v6 = makeIPv6Frame("2001:db8::1", "2001:db9::1");
+    EXPECT_TRUE(filter.applyFilters(Packet(v6.data(), v6.size(), borrow)).passed);
+
+    auto other = makeIPv4Frame(IPPROTO_TCP, "10.0.0.1", "10.0.0.2", 40000, 443);
+    EXPECT_FALSE(filter.applyFilters(Packet(other.data(), other.size(), borrow)).passed);
+
+    // Bulk reload, built off to the side and swapped in
+    auto internal = PrefixTable::parsePrefix("10.0.0.0/8", "internal");
+    auto removed = PrefixTable::parsePrefix("2001:db8::/32");
+    ASSERT_TRUE(internal.isSuccess() && removed.isSuccess());
+    auto table = filter.getPrefixTable("intel")->update({internal.getValue()}, {removed.getValue()});
+    ASSERT_TRUE(table.isSuccess());
+    ASSERT_TRUE(filter.setPrefixTable("intel", std::make_shared<const PrefixTable>(table.getValue())).isSuccess());
+
+    result = filter.applyFilters(Packet(other.data(), other.size(), borrow));
+    EXPECT_TRUE(result.passed);
+    EXPECT_EQ(result.metadata["intel.tag"], "internal");
+    EXPECT_FALSE(filter.applyFilters(Packet(v6.data(), v6.size(), borrow)).passed);
+
+    EXPECT_TRUE(filter.setPrefixTable("missing", std::make_shared<const PrefixTable>()).isError());
+    EXPECT_TRUE(filter.addFilter("bad", makeConfig(PacketFilter::FilterType::IP_RANGE, "10.0.0.0/8, nonsense")).isError());
+
+    auto fromFile = makeConfig(PacketFilter::FilterType::IP_RANGE, "");
+    fromFile.parameters["file"] = "/nonexistent/prefixes.txt";
+    EXPECT_EQ(filter.addFilter("file", fromFile).getErrorCode(), ErrorCode::RESOURCE_UNAVAILABLE);
+}
+
+TEST_F(PacketFilterTest, MatchesRuleSetsAcrossSegments) {
+    auto rules = makeConfig(PacketFilter::FilterType::PAYLOAD, "");
+    rules.parameters["patterns"] = "100 /etc/passwd\n200 cmd.exe\n300 |de ad|\n";
+    PacketFilter filter;
+    ASSERT_TRUE(filter.addFilter("sigs", rules).isSuccess());
+    ASSERT_TRUE(filter.getPatternMatcher("sigs"));
+    EXPECT_EQ(filter.getPatternMatcher("sigs")->size(), 3u);
+
+    auto borrow = [](const uint8_t*) {};
+    auto apply = [&](const std::vector<uint8_t>& frame) {
+        return filter.applyFilters(Packet(frame.data(), frame.size(), borrow));
+    };
+
+    auto both = makeTcpSegment(1, 0x18, "GET /etc/passwd?x=cmd.exe HTTP/1.1");
+    auto result = apply(both);
+    EXPECT_TRUE(result.passed);
+    EXPECT_EQ(result.metadata["sigs.matches"], "100,200");
+    EXPECT_FALSE(apply(makeTcpSegment(1, 0x18, "GET /index.html")).passed);
+
+    // Without stream mode each segment stands alone
+    EXPECT_FALSE(apply(makeTcpSegment(1, 0x18, "GET /etc/pa")).passed);
+    EXPECT_FALSE(apply(makeTcpSegment(12, 0x18, "sswd")).passed);
+
+    auto streamed = rules;
+    streamed.parameters["stream"] = "true";
+    PacketFilter stream;
+    ASSERT_TRUE(stream.addFilter("sigs", streamed).isSuccess());
+    auto applyStream = [&](const std::vector<uint8_t>& frame) {
+        return stream.applyFilters(Packet(frame.data(), frame.size(), borrow));
+    };
+
+    EXPECT_FALSE(applyStream(makeTcpSegment(1000, 0x02, "")).passed);
+    EXPECT_FALSE(applyStream(makeTcpSegment(1001, 0x18, "GET /etc/pa")).passed);
+    // A retransmission neither matches nor disturbs the flow
+    EXPECT_FALSE(applyStream(makeTcpSegment(1001, 0x18, "GET /etc/pa")).passed);
+    result = applyStream(makeTcpSegment(1012, 0x18, "sswd"));
+    EXPECT_TRUE(result.passed);
+    EXPECT_EQ(result.metadata["sigs.matches"], "100");
+
+    // After a gap the partial match is dropped
+    EXPECT_FALSE(applyStream(makeTcpSegment(1016, 0x18, "cmd.")).passed);
+    EXPECT_FALSE(applyStream(makeTcpSegment(1100, 0x11, "exe")).passed);
+
+    // The flow ended with FIN, a new one starts clean
+    EXPECT_FALSE(applyStream(makeTcpSegment(5000, 0x18, "\xde")).passed);
+    EXPECT_TRUE(applyStream(makeTcpSegment(5001, 0x18, "\xad")).passed);
+
+    // Regex PAYLOAD filters keep working, other filters cannot take a matcher
+    PacketFilter regex;
+    ASSERT_TRUE(regex.addFilter("re", makeConfig(PacketFilter::FilterType::PAYLOAD, "pass+wd")).isSuccess());
+    EXPECT_FALSE(regex.getPatternMatcher("re"));
+    EXPECT_TRUE(regex.applyFilters(Packet(both.data(), both.size(), borrow)).passed);
+    ASSERT_TRUE(regex.addFilter("net", makeConfig(PacketFilter::FilterType::IP_RANGE, "10.0.0.0/8")).isSuccess());
+    EXPECT_TRUE(regex.setPatternMatcher("net", filter.getPatternMatcher("sigs")).isError());
+
+    ASSERT_TRUE(regex.setPatternMatcher("re", filter.getPatternMatcher("sigs")).isSuccess());
+    EXPECT_EQ(regex.applyFilters(Packet(both.data(), both.size(), borrow)).metadata["re.matches"], "100,200");
+
+    auto bad = rules;
+    bad.parameters["patterns"] = "oops";
+    EXPECT_EQ(filter.addFilter("bad", bad).getErrorCode(), ErrorCode::INVALID_ARGUMENT);
+}
+
+TEST_F(PacketFilterTest, EvictsLeastRecentlySeenFlow) {
+    auto rules = makeConfig(PacketFilter::FilterType::PAYLOAD, "");
+    rules.parameters["patterns"] = "100 /etc/passwd\n";
+    rules.parameters["stream"] = "true";
+    rules.parameters["stream_flows"] = "128";
+    PacketFilter filter;
+    ASSERT_TRUE(filter.addFilter("lru", rules).isSuccess());
+
+    auto borrow = [](const uint8_t*) {};
+    auto apply = [&](const std::vector<uint8_t>& frame) {
+        return filter.applyFilters(Packet(frame.data(), frame.size(), borrow));
+    };
+
+    // Two flows per shard, so a thousand short flows evict plenty, but never
+    // the one that keeps being seen in between
+    EXPECT_FALSE(apply(makeTcpSegment(1001, 0x18, "GET /etc/pa")).passed);
+    for (uint16_t port = 41000; port < 42000; ++port) {
+        EXPECT_FALSE(apply(makeTcpSegment(1, 0x18, "x", port)).passed);
+        EXPECT_FALSE(apply(makeTcpSegment(1001, 0x18, "GET /etc/pa")).passed);
+    }
+    EXPECT_TRUE(apply(makeTcpSegment(1012, 0x18, "sswd")).passed);
+
+    auto evictions = MetricsRegistry::get().getMetric("packet_filter_lru_stream_evictions_total");
+    ASSERT_TRUE(evictions);
+    EXPECT_GT(std::static_pointer_cast<Counter>(evictions)->getValue(), 0.0);
+
+    rules.parameters["stream_flows"] = "many";
+    EXPECT_EQ(filter.addFilter("bad", rules).getErrorCode(), ErrorCode::INVALID_ARGUMENT);
+}
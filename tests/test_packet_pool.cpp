@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "beatrice/PacketPool.hpp"
+#include "beatrice/Packet.hpp"
+#include <thread>
+#include <vector>
+
+TEST(PacketPoolTest, AcquireAndRecycle) {
+    auto pool = beatrice::PacketPool::create(2048, 2);
+    ASSERT_NE(pool, nullptr);
+
+    auto first = pool->acquire();
+    auto second = pool->acquire();
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    EXPECT_EQ(first.capacity(), 2048);
+    EXPECT_EQ(pool->inUse(), 2);
+
+    // Exhausted pool hands out empty buffers and counts the miss
+    EXPECT_FALSE(pool->acquire());
+    EXPECT_EQ(pool->getStatistics().exhausted, 1);
+
+    first = beatrice::PacketBuffer();
+    EXPECT_EQ(pool->inUse(), 1);
+    EXPECT_TRUE(pool->acquire());
+}
+
+TEST(PacketPoolTest, PacketHoldsPoolBuffer) {
+    auto pool = beatrice::PacketPool::create(128, 1);
+    ASSERT_NE(pool, nullptr);
+
+    auto buffer = pool->acquire();
+    buffer.data()[0] = 0x42;
+    beatrice::Packet packet(std::move(buffer), 1);
+    EXPECT_TRUE(packet.isPooled());
+    EXPECT_EQ(packet.data()[0], 0x42);
+
+    {
+        beatrice::Packet copy = packet;
+        packet = beatrice::Packet();
+        EXPECT_EQ(pool->inUse(), 1);
+    }
+    EXPECT_EQ(pool->inUse(), 0);
+}
+
+TEST(PacketPoolTest, BuffersOutliveOwnerAndReturnFromOtherThreads) {
+    std::vector<beatrice::Packet> packets;
+    {
+        auto pool = beatrice::PacketPool::create(64, 8);
+        ASSERT_NE(pool, nullptr);
+        for (int i = 0; i < 8; ++i) {
+            packets.emplace_back(pool->acquire(), 64);
+        }
+    }
+
+    std::thread consumer([&packets] { packets.clear(); });
+    consumer.join();
+    EXPECT_TRUE(packets.empty());
+}
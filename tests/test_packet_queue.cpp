@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "beatrice/PacketQueue.hpp"
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+using beatrice::ICaptureBackend;
+using beatrice::Packet;
+using beatrice::PacketQueue;
+
+namespace {
+
+std::vector<Packet> makePackets(size_t count, size_t firstLength) {
+    std::vector<Packet> packets;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t length = firstLength + i;
+        packets.emplace_back(std::make_shared<uint8_t[]>(length), length);
+    }
+    return packets;
+}
+
+ICaptureBackend::Config queueConfig(size_t depth, ICaptureBackend::OverflowPolicy policy) {
+    ICaptureBackend::Config config;
+    config.queueDepth = depth;
+    config.queueOverflowPolicy = policy;
+    return config;
+}
+
+} // anonymous namespace
+
+TEST(PacketQueueTest, DropNewestCountsLossAndHighWatermark) {
+    PacketQueue queue(queueConfig(8, ICaptureBackend::OverflowPolicy::DEFAULT),
+                      ICaptureBackend::OverflowPolicy::DROP_NEWEST);
+    EXPECT_EQ(queue.policy(), ICaptureBackend::OverflowPolicy::DROP_NEWEST);
+    queue.open();
+
+    auto packets = makePackets(10, 100);
+    EXPECT_EQ(queue.push(packets), 8u);
+
+    auto stats = queue.getStatistics();
+    EXPECT_EQ(stats.capacity, 8u);
+    EXPECT_EQ(stats.depth, 8u);
+    EXPECT_EQ(stats.highWatermark, 8u);
+    EXPECT_EQ(stats.dropped, 2u);
+    EXPECT_EQ(stats.bytesDropped, 108u + 109u);
+
+    std::vector<Packet> out;
+    EXPECT_EQ(queue.pop(out, 64, std::chrono::milliseconds(0)), 8u);
+    EXPECT_EQ(out.front().length(), 100u);
+    EXPECT_EQ(queue.getStatistics().highWatermark, 8u);
+
+    queue.resetStatistics();
+    stats = queue.getStatistics();
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.highWatermark, 0u);
+}
+
+TEST(PacketQueueTest, DropOldestKeepsNewestPackets) {
+    PacketQueue queue(queueConfig(4, ICaptureBackend::OverflowPolicy::DROP_OLDEST),
+                      ICaptureBackend::OverflowPolicy::DROP_NEWEST);
+    queue.open();
+
+    auto first = makePackets(4, 100);
+    auto second = makePackets(3, 200);
+    EXPECT_EQ(queue.push(first), 4u);
+    EXPECT_EQ(queue.push(second), 3u);
+    EXPECT_EQ(queue.getStatistics().dropped, 3u);
+
+    std::vector<Packet> out;
+    ASSERT_EQ(queue.pop(out, 64, std::chrono::milliseconds(0)), 4u);
+    EXPECT_EQ(out[0].length(), 103u);
+    EXPECT_EQ(out[1].length(), 200u);
+    EXPECT_EQ(out[3].length(), 202u);
+}
+
+TEST(PacketQueueTest, BlockWaitsForConsumers) {
+    PacketQueue queue(queueConfig(4, ICaptureBackend::OverflowPolicy::BLOCK),
+                      ICaptureBackend::OverflowPolicy::DROP_NEWEST);
+    queue.open();
+
+    std::atomic<size_t> pushed{0};
+    std::thread producer([&] {
+        auto packets = makePackets(64, 64);
+        pushed = queue.push(packets);
+        queue.finish();
+    });
+
+    std::vector<Packet> out;
+    while (out.size() < 64) {
+        std::vector<Packet> batch;
+        if (queue.pop(batch, 3, std::chrono::seconds(5)) == 0) {
+            break;
+        }
+        EXPECT_LE(queue.size(), 4u);
+        std::move(batch.begin(), batch.end(), std::back_inserter(out));
+    }
+    producer.join();
+
+    EXPECT_EQ(pushed.load(), 64u);
+    ASSERT_EQ(out.size(), 64u);
+    EXPECT_EQ(out.back().length(), 127u);
+    EXPECT_EQ(queue.getStatistics().dropped, 0u);
+}
+
+TEST(PacketQueueTest, CloseReleasesBlockedProducer) {
+    PacketQueue queue(queueConfig(2, ICaptureBackend::OverflowPolicy::BLOCK),
+                      ICaptureBackend::OverflowPolicy::DROP_NEWEST);
+    queue.open();
+
+    std::atomic<size_t> pushed{0};
+    std::thread producer([&] {
+        auto packets = makePackets(8, 64);
+        pushed = queue.push(packets);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.close();
+    producer.join();
+
+    EXPECT_EQ(pushed.load(), 2u);
+    std::vector<Packet> out;
+    EXPECT_EQ(queue.pop(out, 64, std::chrono::seconds(5)), 2u);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "beatrice/PacketRing.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using beatrice::PacketRing;
+using beatrice::RingNotifier;
+using beatrice::RingSync;
+
+TEST(PacketRingTest, BurstsStopAtCapacity) {
+    PacketRing<int> ring(6);
+    EXPECT_EQ(ring.capacity(), 8u);
+
+    std::vector<int> items(10);
+    for (int i = 0; i < 10; ++i) {
+        items[i] = i;
+    }
+    EXPECT_EQ(ring.enqueueBurst(items.data(), items.size()), 8u);
+    EXPECT_FALSE(ring.enqueue(42));
+    EXPECT_EQ(ring.size(), 8u);
+
+    std::vector<int> out;
+    EXPECT_EQ(ring.dequeueBurst(out, 3), 3u);
+    EXPECT_EQ(out, (std::vector<int>{0, 1, 2}));
+    EXPECT_TRUE(ring.enqueue(8));
+
+    int value;
+    for (int expected = 3; expected <= 8; ++expected) {
+        ASSERT_TRUE(ring.dequeue(value));
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_FALSE(ring.dequeue(value));
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(PacketRingTest, SingleProducerSingleConsumerKeepsOrder) {
+    constexpr int kItems = 200000;
+    PacketRing<int> ring(256);
+    RingNotifier notifier;
+
+    std::thread producer([&] {
+        int next = 0;
+        while (next < kItems) {
+            int burst[32];
+            int count = 0;
+            while (count < 32 && next + count < kItems) {
+                burst[count] = next + count;
+                ++count;
+            }
+            next += static_cast<int>(ring.enqueueBurst(burst, count));
+            notifier.notify();
+        }
+    });
+
+    int expected = 0;
+    std::vector<int> out;
+    while (expected < kItems) {
+        notifier.wait([&] { return !ring.empty(); }, std::chrono::milliseconds(100));
+        out.clear();
+        ring.dequeueBurst(out, 64);
+        for (int value : out) {
+            ASSERT_EQ(value, expected++);
+        }
+    }
+    producer.join();
+}
+
+TEST(PacketRingTest, MultiProducerMultiConsumerDeliversEverythingOnce) {
+    constexpr int kThreads = 4;
+    constexpr int kPerProducer = 20000;
+    PacketRing<int> ring(1024, RingSync::MULTI, RingSync::MULTI);
+    std::atomic<long long> sum{0};
+    std::atomic<int> consumed{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kThreads; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < kPerProducer;) {
+                int value = p * kPerProducer + i + 1;
+                if (ring.enqueue(std::move(value))) {
+                    ++i;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < kThreads; ++c) {
+        threads.emplace_back([&] {
+            std::vector<int> out;
+            while (consumed.load() < kThreads * kPerProducer) {
+                out.clear();
+                size_t n = ring.dequeueBurst(out, 16);
+                for (int value : out) {
+                    sum += value;
+                }
+                consumed += static_cast<int>(n);
+                if (n == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const long long total = static_cast<long long>(kThreads) * kPerProducer;
+    EXPECT_EQ(consumed.load(), total);
+    EXPECT_EQ(sum.load(), total * (total + 1) / 2);
+}
+
+TEST(PacketRingTest, NotifierTimesOutAndWakes) {
+    RingNotifier notifier;
+    std::atomic<bool> flag{false};
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(notifier.wait([&] { return flag.load(); }, std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    std::thread waker([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        flag = true;
+        notifier.notify();
+    });
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(notifier.wait([&] { return flag.load(); }, std::chrono::seconds(5)));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    waker.join();
+}
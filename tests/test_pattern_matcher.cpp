@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "beatrice/PatternMatcher.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace beatrice;
+
+namespace {
+
+using Matches = std::vector<std::pair<uint32_t, uint64_t>>;
+
+Matches scanAll(const PatternMatcher& matcher, const std::string& text) {
+    Matches matches;
+    matcher.scan(reinterpret_cast<const uint8_t*>(text.data()), text.size(), [&](uint32_t id, uint64_t end) {
+        matches.emplace_back(id, end);
+        return true;
+    });
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+// Every occurrence of every pattern, the reference for scans
+Matches naiveScan(const std::vector<PatternMatcher::Pattern>& patterns, const std::string& text) {
+    Matches matches;
+    for (const auto& pattern : patterns) {
+        for (size_t at = text.find(pattern.bytes); at != std::string::npos; at = text.find(pattern.bytes, at + 1)) {
+            matches.emplace_back(pattern.id, at + pattern.bytes.size());
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+} // namespace
+
+TEST(PatternMatcherTest, FindsOverlappingPatterns) {
+    std::vector<PatternMatcher::Pattern> patterns = {{1, "he"}, {2, "she"}, {3, "his"}, {4, "hers"}};
+    auto compiled = PatternMatcher::compile(patterns);
+    ASSERT_TRUE(compiled.isSuccess());
+    PatternMatcher matcher = compiled.getValue();
+    EXPECT_EQ(matcher.size(), 4u);
+
+    Matches expected = {{1, 4}, {2, 4}, {4, 6}};
+    EXPECT_EQ(scanAll(matcher, "ushers"), expected);
+    EXPECT_TRUE(matcher.matches(reinterpret_cast<const uint8_t*>("this"), 4));
+    EXPECT_FALSE(matcher.matches(reinterpret_cast<const uint8_t*>("HERS"), 4));
+
+    EXPECT_FALSE(PatternMatcher().matches(reinterpret_cast<const uint8_t*>("hers"), 4));
+    EXPECT_TRUE(PatternMatcher::compile({{1, ""}}).isError());
+}
+
+TEST(PatternMatcherTest, PrefilterAgreesWithAutomaton) {
+    std::mt19937 random(11);
+    auto randomText = [&](size_t length, int alphabet) {
+        std::string text(length, '\0');
+        for (auto& c : text) c = static_cast<char>('a' + random() % alphabet);
+        return text;
+    };
+
+    for (size_t count : {1u, 5u, 40u, 2000u}) {
+        std::vector<PatternMatcher::Pattern> patterns;
+        for (size_t i = 0; i < count; ++i) {
+            patterns.push_back({static_cast<uint32_t>(i), randomText(1 + random() % 6, 8)});
+        }
+        auto compiled = PatternMatcher::compile(patterns);
+        ASSERT_TRUE(compiled.isSuccess());
+        PatternMatcher plain = compiled.getValue();
+        PatternMatcher prefiltered = compiled.getValue();
+        prefiltered.enablePrefilter();
+
+        for (int round = 0; round < 20; ++round) {
+            std::string text = randomText(random() % 300, round % 2 ? 8 : 26);
+            Matches expected = naiveScan(patterns, text);
+            EXPECT_EQ(scanAll(plain, text), expected);
+            EXPECT_EQ(scanAll(prefiltered, text), expected);
+        }
+    }
+}
+
+TEST(PatternMatcherTest, StreamsAcrossBuffers) {
+    auto compiled = PatternMatcher::parseRules("# exfiltration markers\n"
+                                               "10 password=\n"
+                                               "20 |de ad be ef|\n"
+                                               "30 \\|pipe\n");
+    ASSERT_TRUE(compiled.isSuccess()) << compiled.getErrorMessage();
+    PatternMatcher matcher = compiled.getValue();
+    matcher.enablePrefilter();
+
+    std::string text = "user=admin&password=hunter2 \xde\xad\xbe\xef |pipe";
+    Matches whole = scanAll(matcher, text);
+    ASSERT_EQ(whole.size(), 3u);
+
+    // Same matches and offsets wherever the stream is cut
+    for (size_t cut = 0; cut <= text.size(); ++cut) {
+        Matches pieces;
+        PatternMatcher::StreamState stream;
+        auto collect = [&](uint32_t id, uint64_t end) {
+            pieces.emplace_back(id, end);
+            return true;
+        };
+        matcher.scan(stream, reinterpret_cast<const uint8_t*>(text.data()), cut, collect);
+        matcher.scan(stream, reinterpret_cast<const uint8_t*>(text.data()) + cut, text.size() - cut, collect);
+        std::sort(pieces.begin(), pieces.end());
+        EXPECT_EQ(pieces, whole) << "cut at " << cut;
+        EXPECT_EQ(stream.offset, text.size());
+    }
+}
+
+TEST(PatternMatcherTest, ParsesRuleFiles) {
+    EXPECT_EQ(PatternMatcher::parsePattern("GET |2f 61|dmin").getValue(), "GET /admin");
+    EXPECT_TRUE(PatternMatcher::parsePattern("|0d 0").isError());
+    EXPECT_TRUE(PatternMatcher::parsePattern("|zz|").isError());
+    EXPECT_TRUE(PatternMatcher::parsePattern("||").isError());
+
+    char path[] = "/tmp/beatrice_patterns_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream file(path);
+        file << "1 cmd.exe\n2 /etc/passwd\n";
+    }
+    auto loaded = PatternMatcher::loadFile(path);
+    ASSERT_TRUE(loaded.isSuccess());
+    EXPECT_EQ(loaded.getValue().size(), 2u);
+    EXPECT_EQ(scanAll(loaded.getValue(), "cat /etc/passwd"), (Matches{{2, 15}}));
+
+    {
+        std::ofstream file(path);
+        file << "1 fine\nnot-a-number oops\n";
+    }
+    auto bad = PatternMatcher::loadFile(path);
+    EXPECT_EQ(bad.getErrorCode(), ErrorCode::INVALID_ARGUMENT);
+    EXPECT_NE(bad.getErrorMessage().find(":2:"), std::string::npos);
+    std::remove(path);
+
+    EXPECT_EQ(PatternMatcher::loadFile("/nonexistent/patterns.txt").getErrorCode(), ErrorCode::RESOURCE_UNAVAILABLE);
+}
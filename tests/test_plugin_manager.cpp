@@ -1,7 +1,227 @@
 #include <gtest/gtest.h>
 #include "beatrice/PluginManager.hpp"
+#include "beatrice/Logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+class CountingPlugin : public beatrice::IPacketPlugin {
+public:
+    void onStart() override {}
+    void onStop() override {}
+    explicit CountingPlugin(std::string name = "CountingPlugin") : name_(std::move(name)) {}
+
+    beatrice::PluginVerdict onPacket(beatrice::Packet& packet) override {
+        bytes_ += packet.length();
+        ++count_;
+        return beatrice::PluginVerdict::Continue;
+    }
+    std::string getName() const override { return name_; }
+    std::string getVersion() const override { return "1.0.0"; }
+    std::string getDescription() const override { return "Counts packets"; }
+    bool isEnabled() const override { return true; }
+    void setEnabled(bool) override {}
+    uint64_t getProcessedPacketCount() const override { return count_; }
+    uint64_t getErrorCount() const override { return 0; }
+    void resetStatistics() override { count_ = 0; bytes_ = 0; }
+
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    std::string name_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+// Drops odd-length packets, lets packets of 64 bytes skip the rest of the chain
+class ClassifierPlugin : public CountingPlugin {
+public:
+    ClassifierPlugin() : CountingPlugin("ClassifierPlugin") {}
+
+    beatrice::PluginVerdict onPacket(beatrice::Packet& packet) override {
+        CountingPlugin::onPacket(packet);
+        if (packet.length() % 2 != 0) {
+            return beatrice::PluginVerdict::Drop;
+        }
+        if (packet.length() == 64) {
+            return beatrice::PluginVerdict::StopChain;
+        }
+        return beatrice::PluginVerdict::Continue;
+    }
+};
+
+// Spends about 2us on every packet
+class SlowPlugin : public CountingPlugin {
+public:
+    SlowPlugin() : CountingPlugin("SlowPlugin") {}
+
+    beatrice::PluginVerdict onPacket(beatrice::Packet& packet) override {
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(2);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        return CountingPlugin::onPacket(packet);
+    }
+};
+
+std::vector<beatrice::Packet> makePackets() {
+    std::vector<beatrice::Packet> packets;
+    for (size_t length = 60; length < 70; ++length) {
+        packets.emplace_back(std::make_shared<uint8_t[]>(length), length);
+    }
+    return packets;
+}
+
+} // anonymous namespace
+
+class PluginChainTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!beatrice::Logger::get().isInitialized()) {
+            beatrice::Logger::get().initialize("", "error");
+        }
+    }
+};
 
 TEST(PluginManagerTest, PluginManagerCreation) {
     beatrice::PluginManager manager;
     EXPECT_NE(&manager, nullptr);
-} 
\ No newline at end of file
+}
+
+TEST(PluginManagerTest, DefaultOnBatchCallsOnPacket) {
+    auto packets = makePackets();
+    std::vector<beatrice::PluginVerdict> verdicts(packets.size());
+
+    CountingPlugin plugin;
+    plugin.onBatch(packets, verdicts);
+    EXPECT_EQ(plugin.getProcessedPacketCount(), 10u);
+    EXPECT_EQ(plugin.bytes(), 645u);
+
+    beatrice::PluginManager manager;
+    manager.processPackets(packets, verdicts);
+}
+
+TEST_F(PluginChainTest, ShortCircuitsBatch) {
+    auto packets = makePackets();
+    std::vector<beatrice::PluginVerdict> verdicts(packets.size());
+
+    auto classifier = std::make_unique<ClassifierPlugin>();
+    auto analyzer = std::make_unique<CountingPlugin>();
+    auto* analyzerPtr = analyzer.get();
+
+    beatrice::PluginManager manager;
+    ASSERT_TRUE(manager.addPlugin(std::move(classifier)));
+    ASSERT_TRUE(manager.addPlugin(std::move(analyzer)));
+    manager.processPackets(packets, verdicts);
+
+    // 60, 62, 66 and 68 reach the analyzer, 64 stops early, odd lengths drop
+    EXPECT_EQ(analyzerPtr->getProcessedPacketCount(), 4u);
+    EXPECT_EQ(analyzerPtr->bytes(), 256u);
+
+    size_t dropped = 0;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        bool odd = packets[i].length() % 2 != 0;
+        EXPECT_EQ(verdicts[i] == beatrice::PluginVerdict::Drop, odd);
+        dropped += odd;
+    }
+    EXPECT_EQ(dropped, 5u);
+
+    auto stats = manager.getVerdictStats("ClassifierPlugin");
+    EXPECT_EQ(stats.dropped, 5u);
+    EXPECT_EQ(stats.stopped, 1u);
+    EXPECT_EQ(stats.forwarded, 0u);
+    EXPECT_EQ(manager.getVerdictStats("CountingPlugin").dropped, 0u);
+}
+
+TEST_F(PluginChainTest, ShortCircuitsPacket) {
+    auto packets = makePackets();
+
+    beatrice::PluginManager manager;
+    ASSERT_TRUE(manager.addPlugin(std::make_unique<ClassifierPlugin>()));
+    ASSERT_TRUE(manager.addPlugin(std::make_unique<CountingPlugin>()));
+    EXPECT_FALSE(manager.addPlugin(std::make_unique<CountingPlugin>()));
+
+    EXPECT_EQ(manager.processPacket(packets[0]), beatrice::PluginVerdict::Continue);
+    EXPECT_EQ(manager.processPacket(packets[1]), beatrice::PluginVerdict::Drop);
+    EXPECT_EQ(manager.processPacket(packets[4]), beatrice::PluginVerdict::StopChain);
+    EXPECT_EQ(manager.getVerdictStats("ClassifierPlugin").dropped, 1u);
+    EXPECT_EQ(manager.getVerdictStats("ClassifierPlugin").stopped, 1u);
+}
+
+TEST_F(PluginChainTest, UnloadWhileProcessing) {
+    beatrice::PluginManager manager;
+    ASSERT_TRUE(manager.addPlugin(std::make_unique<CountingPlugin>("First")));
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&manager, &running] {
+            auto packets = makePackets();
+            std::vector<beatrice::PluginVerdict> verdicts(packets.size());
+            while (running.load()) {
+                manager.processPackets(packets, verdicts);
+            }
+        });
+    }
+
+    for (int round = 0; round < 50; ++round) {
+        ASSERT_TRUE(manager.addPlugin(std::make_unique<CountingPlugin>("Second")));
+        manager.unloadPlugin("Second");
+    }
+    EXPECT_EQ(manager.getLoadedPluginNames(), std::vector<std::string>{"First"});
+
+    running = false;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+TEST_F(PluginChainTest, ProfilesAndDisablesPluginOverBudget) {
+    auto packets = makePackets();
+    std::vector<beatrice::PluginVerdict> verdicts(packets.size());
+
+    beatrice::PluginManager manager;
+    manager.setProfilingInterval(1);
+    ASSERT_TRUE(manager.addPlugin(std::make_unique<SlowPlugin>()));
+    ASSERT_TRUE(manager.addPlugin(std::make_unique<CountingPlugin>()));
+    ASSERT_TRUE(manager.setPluginBudget("SlowPlugin", {500.0, beatrice::PluginBudgetAction::Disable}));
+
+    manager.processPackets(packets, verdicts);
+    auto profile = manager.getPluginProfile("SlowPlugin");
+    EXPECT_EQ(profile.samples, 1u);
+    EXPECT_GT(profile.averageNanosPerPacket, 1000.0);
+    EXPECT_TRUE(profile.disabled);
+    EXPECT_FALSE(manager.getPluginProfile("CountingPlugin").disabled);
+
+    auto latency = std::dynamic_pointer_cast<beatrice::Histogram>(
+        beatrice::MetricsRegistry::get().getMetric("plugin_SlowPlugin_latency_ns"));
+    ASSERT_NE(latency, nullptr);
+    EXPECT_EQ(latency->getCount(), 1u);
+
+    // Disabled plugins are skipped, the rest of the chain keeps running
+    manager.processPackets(packets, verdicts);
+    EXPECT_EQ(manager.getPluginProfile("SlowPlugin").samples, 1u);
+    EXPECT_EQ(manager.getPluginProfile("CountingPlugin").samples, 2u);
+}
+
+TEST_F(PluginChainTest, ShedsLoadUntilWithinBudget) {
+    auto packets = makePackets();
+    std::vector<beatrice::PluginVerdict> verdicts(packets.size());
+
+    beatrice::PluginManager manager;
+    manager.setProfilingInterval(1);
+    ASSERT_TRUE(manager.addPlugin(std::make_unique<SlowPlugin>()));
+    ASSERT_TRUE(manager.setPluginBudget("SlowPlugin", {500.0, beatrice::PluginBudgetAction::Shed}));
+
+    for (int i = 0; i < 256; ++i) {
+        manager.processPackets(packets, verdicts);
+    }
+
+    // About 2us per packet against 500ns needs the plugin on 1 in 4 or fewer calls
+    auto profile = manager.getPluginProfile("SlowPlugin");
+    EXPECT_FALSE(profile.disabled);
+    EXPECT_GE(profile.shedLevel, 2u);
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include "beatrice/PrefixTable.hpp"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace beatrice;
+
+namespace {
+
+PrefixTable::Prefix prefix(const std::string& text, const std::string& tag = "") {
+    auto result = PrefixTable::parsePrefix(text, tag);
+    EXPECT_TRUE(result.isSuccess()) << text;
+    return result.getValue();
+}
+
+uint32_t v4(const char* address) {
+    in_addr value{};
+    inet_pton(AF_INET, address, &value);
+    return ntohl(value.s_addr);
+}
+
+std::array<uint8_t, 16> v6(const char* address) {
+    std::array<uint8_t, 16> value{};
+    inet_pton(AF_INET6, address, value.data());
+    return value;
+}
+
+// Linear scan over the prefix list, the reference for lookups
+std::optional<std::pair<std::string, uint8_t>> bruteForce(const std::vector<PrefixTable::Prefix>& prefixes,
+                                                          const uint8_t* address, bool ipv6) {
+    std::optional<std::pair<std::string, uint8_t>> best;
+    for (const auto& candidate : prefixes) {
+        if (candidate.ipv6 != ipv6 || (best && best->second >= candidate.length)) continue;
+        bool covered = true;
+        for (size_t bit = 0; bit < candidate.length && covered; ++bit) {
+            uint8_t mask = static_cast<uint8_t>(0x80u >> (bit % 8));
+            covered = (candidate.address[bit / 8] & mask) == (address[bit / 8] & mask);
+        }
+        if (covered) {
+            best = std::make_pair(candidate.tag, candidate.length);
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+TEST(PrefixTableTest, LongestPrefixWins) {
+    auto table = PrefixTable::build({
+        prefix("0.0.0.0/0", "default"),
+        prefix("10.0.0.0/8", "corp"),
+        prefix("10.1.0.0/16", "lab"),
+        prefix("10.1.2.0/24", "rack"),
+        prefix("10.1.2.3", "host"),
+        prefix("2001:db8::/32", "doc"),
+        prefix("2001:db8:0:1::/64", "subnet"),
+    });
+    ASSERT_TRUE(table.isSuccess());
+    const PrefixTable& prefixes = table.getValue();
+    EXPECT_EQ(prefixes.size(), 7u);
+
+    EXPECT_EQ(prefixes.lookupV4(v4("10.1.2.3"))->tag, "host");
+    EXPECT_EQ(prefixes.lookupV4(v4("10.1.2.4"))->tag, "rack");
+    EXPECT_EQ(prefixes.lookupV4(v4("10.1.3.4"))->tag, "lab");
+    EXPECT_EQ(prefixes.lookupV4(v4("10.2.0.1"))->tag, "corp");
+    EXPECT_EQ(prefixes.lookupV4(v4("192.168.0.1"))->tag, "default");
+    EXPECT_EQ(prefixes.lookupV4(v4("10.1.2.3"))->prefixLength, 32);
+
+    EXPECT_EQ(prefixes.lookupV6(v6("2001:db8:0:1::42").data())->tag, "subnet");
+    EXPECT_EQ(prefixes.lookupV6(v6("2001:db8:ffff::1").data())->prefixLength, 32);
+    EXPECT_FALSE(prefixes.lookupV6(v6("2001:db9::1").data()));
+
+    EXPECT_FALSE(PrefixTable().lookupV4(v4("10.1.2.3")));
+}
+
+TEST(PrefixTableTest, MatchesLinearScan) {
+    std::mt19937 random(7);
+    std::vector<PrefixTable::Prefix> prefixes;
+    for (int i = 0; i < 2000; ++i) {
+        PrefixTable::Prefix entry;
+        entry.ipv6 = i % 2 == 1;
+        size_t bytes = entry.ipv6 ? 16 : 4;
+        // Few distinct leading bytes so prefixes nest
+        for (size_t b = 0; b < bytes; ++b) {
+            entry.address[b] = static_cast<uint8_t>(b < 2 ? random() % 3 : random());
+        }
+        entry.length = static_cast<uint8_t>(random() % (bytes * 8 + 1));
+        for (size_t bit = entry.length; bit < bytes * 8; ++bit) {
+            entry.address[bit / 8] &= static_cast<uint8_t>(~(0x80u >> (bit % 8)));
+        }
+        entry.tag = "t" + std::to_string(i);
+        prefixes.push_back(entry);
+    }
+
+    auto table = PrefixTable::build(prefixes);
+    ASSERT_TRUE(table.isSuccess());
+
+    // A prefix listed twice keeps its last tag, drop the earlier copies for the reference
+    std::vector<PrefixTable::Prefix> reference;
+    for (auto it = prefixes.rbegin(); it != prefixes.rend(); ++it) {
+        bool seen = std::any_of(reference.begin(), reference.end(), [&](const auto& other) {
+            return other.ipv6 == it->ipv6 && other.length == it->length && other.address == it->address;
+        });
+        if (!seen) reference.push_back(*it);
+    }
+    EXPECT_EQ(table.getValue().size(), reference.size());
+
+    for (int i = 0; i < 20000; ++i) {
+        std::array<uint8_t, 16> address{};
+        bool ipv6 = i % 2 == 1;
+        for (size_t b = 0; b < (ipv6 ? 16u : 4u); ++b) {
+            address[b] = static_cast<uint8_t>(b < 2 ? random() % 3 : random());
+        }
+        // Land on prefix boundaries now and then
+        if (i % 5 == 0) {
+            const auto& near = reference[random() % reference.size()];
+            if (near.ipv6 == ipv6) address = near.address;
+        }
+
+        auto expected = bruteForce(reference, address.data(), ipv6);
+        auto actual = ipv6 ? table.getValue().lookupV6(address.data())
+                           : table.getValue().lookupV4(static_cast<uint32_t>(address[0]) << 24 |
+                                                       address[1] << 16 | address[2] << 8 | address[3]);
+        ASSERT_EQ(actual.has_value(), expected.has_value());
+        if (expected) {
+            EXPECT_EQ(std::string(actual->tag), expected->first);
+            EXPECT_EQ(actual->prefixLength, expected->second);
+        }
+    }
+}
+
+TEST(PrefixTableTest, LoadsFilesAndAppliesUpdates) {
+    char path[] = "/tmp/beatrice_prefixes_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream file(path);
+        file << "# threat list\n"
+             << "198.51.100.0/24 scanner\n"
+             << "\n"
+             << "203.0.113.7      # untagged\n"
+             << "2001:db8::/48 botnet\n";
+    }
+
+    auto loaded = PrefixTable::loadFile(path, "intel");
+    ASSERT_TRUE(loaded.isSuccess()) << loaded.getErrorMessage();
+    const PrefixTable& table = loaded.getValue();
+    EXPECT_EQ(table.size(), 3u);
+    EXPECT_EQ(table.lookupV4(v4("198.51.100.9"))->tag, "scanner");
+    EXPECT_EQ(table.lookupV4(v4("203.0.113.7"))->tag, "intel");
+    EXPECT_EQ(table.lookupV6(v6("2001:db8::1").data())->tag, "botnet");
+
+    // The old table keeps answering while the new one is built
+    auto updated = table.update({prefix("198.51.100.0/25", "scanner-low"), prefix("203.0.113.7", "retagged")},
+                                {prefix("2001:db8::/48")});
+    ASSERT_TRUE(updated.isSuccess());
+    EXPECT_EQ(updated.getValue().size(), 3u);
+    EXPECT_EQ(updated.getValue().lookupV4(v4("198.51.100.9"))->tag, "scanner-low");
+    EXPECT_EQ(updated.getValue().lookupV4(v4("198.51.100.200"))->tag, "scanner");
+    EXPECT_EQ(updated.getValue().lookupV4(v4("203.0.113.7"))->tag, "retagged");
+    EXPECT_FALSE(updated.getValue().lookupV6(v6("2001:db8::1").data()));
+    EXPECT_EQ(table.lookupV6(v6("2001:db8::1").data())->tag, "botnet");
+
+    {
+        std::ofstream file(path);
+        file << "10.0.0.0/8\n10.0.0.0/33\n";
+    }
+    auto bad = PrefixTable::loadFile(path);
+    EXPECT_EQ(bad.getErrorCode(), ErrorCode::INVALID_ARGUMENT);
+    EXPECT_NE(bad.getErrorMessage().find(":2:"), std::string::npos);
+    std::remove(path);
+
+    EXPECT_EQ(PrefixTable::loadFile("/nonexistent/prefixes.txt").getErrorCode(), ErrorCode::RESOURCE_UNAVAILABLE);
+    EXPECT_TRUE(PrefixTable::parsePrefix("10.0.0.1/").isError());
+    EXPECT_TRUE(PrefixTable::parsePrefix("::1/129").isError());
+    EXPECT_TRUE(PrefixTable::parsePrefix("not-an-address").isError());
+}
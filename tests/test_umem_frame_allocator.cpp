@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "beatrice/UmemFrameAllocator.hpp"
+#include <thread>
+#include <vector>
+
+using beatrice::UmemFrameAllocator;
+
+TEST(UmemFrameAllocatorTest, FramesFollowOwnership) {
+    auto frames = UmemFrameAllocator::create(4096, 4, 2048);
+    ASSERT_NE(frames, nullptr);
+    EXPECT_EQ(frames->freeFrames(), 4);
+
+    uint64_t addrs[8];
+    ASSERT_EQ(frames->allocate(addrs, 8), 4);
+    EXPECT_EQ(addrs[0], 4096);
+    EXPECT_EQ(addrs[3], 4096 + 3 * 2048);
+    EXPECT_EQ(frames->freeFrames(), 0);
+    EXPECT_EQ(frames->state(addrs[1]), UmemFrameAllocator::FrameState::KERNEL);
+
+    // RX descriptors may point past the headroom
+    EXPECT_TRUE(frames->onReceive(addrs[1] + 256));
+    EXPECT_EQ(frames->state(addrs[1]), UmemFrameAllocator::FrameState::APPLICATION);
+
+    // A frame still held by the application is never handed out again
+    EXPECT_EQ(frames->allocate(addrs, 1), 0);
+
+    frames->release(addrs[1] + 256);
+    EXPECT_EQ(frames->freeFrames(), 1);
+    uint64_t again;
+    ASSERT_EQ(frames->allocate(&again, 1), 1);
+    EXPECT_EQ(again, addrs[1]);
+}
+
+TEST(UmemFrameAllocatorTest, RejectsInvalidTransitions) {
+    auto frames = UmemFrameAllocator::create(0, 2, 2048);
+    ASSERT_NE(frames, nullptr);
+
+    uint64_t addr;
+    ASSERT_EQ(frames->allocate(&addr, 1), 1);
+    ASSERT_TRUE(frames->onReceive(addr));
+    frames->release(addr);
+    frames->release(addr);                  // double release
+    EXPECT_FALSE(frames->onReceive(addr));  // frame is free, not with the kernel
+    EXPECT_FALSE(frames->onReceive(1 << 20)); // outside the slice
+
+    auto stats = frames->getStatistics();
+    EXPECT_EQ(stats.free, 2);
+    EXPECT_EQ(stats.ownershipErrors, 3);
+}
+
+TEST(UmemFrameAllocatorTest, TxFramesReturnOnCompletion) {
+    auto frames = UmemFrameAllocator::create(0, 1, 2048);
+    ASSERT_NE(frames, nullptr);
+
+    uint64_t addr;
+    ASSERT_EQ(frames->allocate(&addr, 1), 1);
+    ASSERT_TRUE(frames->onReceive(addr));
+    ASSERT_TRUE(frames->submitTx(addr));
+    EXPECT_EQ(frames->getStatistics().tx, 1);
+
+    frames->onCompletion(addr);
+    EXPECT_EQ(frames->freeFrames(), 1);
+    EXPECT_EQ(frames->state(addr), UmemFrameAllocator::FrameState::FREE);
+}
+
+TEST(UmemFrameAllocatorTest, CountsStarvationOncePerEpisode) {
+    auto frames = UmemFrameAllocator::create(0, 2, 2048);
+    ASSERT_NE(frames, nullptr);
+
+    uint64_t addrs[2];
+    ASSERT_EQ(frames->allocate(addrs, 2), 2);
+    ASSERT_TRUE(frames->onReceive(addrs[0]));
+    ASSERT_TRUE(frames->onReceive(addrs[1]));
+
+    // Kernel holds nothing and the application holds everything
+    EXPECT_EQ(frames->allocate(addrs, 2), 0);
+    EXPECT_EQ(frames->allocate(addrs, 2), 0);
+    EXPECT_EQ(frames->getStatistics().starvations, 1);
+}
+
+TEST(UmemFrameAllocatorTest, ReleaseFromOtherThreads) {
+    constexpr size_t kFrames = 1024;
+    auto frames = UmemFrameAllocator::create(0, kFrames, 2048);
+    ASSERT_NE(frames, nullptr);
+
+    std::vector<uint64_t> addrs(kFrames);
+    ASSERT_EQ(frames->allocate(addrs.data(), kFrames), kFrames);
+    for (uint64_t addr : addrs) {
+        ASSERT_TRUE(frames->onReceive(addr));
+    }
+
+    std::vector<std::thread> consumers;
+    for (size_t t = 0; t < 4; ++t) {
+        consumers.emplace_back([&, t] {
+            for (size_t i = t; i < kFrames; i += 4) {
+                frames->release(addrs[i]);
+            }
+        });
+    }
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    EXPECT_EQ(frames->freeFrames(), kFrames);
+    EXPECT_EQ(frames->allocate(addrs.data(), kFrames), kFrames);
+    EXPECT_EQ(frames->getStatistics().ownershipErrors, 0);
+}